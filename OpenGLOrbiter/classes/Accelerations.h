@@ -0,0 +1,48 @@
+//Author: Bernhard Luedtke
+#ifndef Accelerations_hpp
+#define Accelerations_hpp
+
+#include "OrbitConstants.h"
+
+// Force models of the RungeKuttaIntegrator, written against the lane operations of KeplerKernelsLanes.h (one L::reg holds one value
+// of L::width satellites). The model is a template parameter of the integrator, so every evaluation is inlined into the step.
+// Keep these free of standard library calls as well. A new model needs an explicit instantiation in RungeKuttaKernels.cpp
+// and in every KeplerKernels<instruction set>.cpp.
+
+// Point mass earth: a = -mu/r^3 * r
+struct TwoBodyAcceleration {
+	template <class L>
+	static void acceleration(typename L::reg x, typename L::reg y, typename L::reg z,
+		typename L::reg& ax, typename L::reg& ay, typename L::reg& az)
+	{
+		typedef typename L::reg reg;
+		const reg r2 = L::add(L::add(L::mul(x, x), L::mul(y, y)), L::mul(z, z));
+		const reg k = L::div(L::set1(-mu), L::mul(r2, L::sqrt(r2)));
+		ax = L::mul(k, x);
+		ay = L::mul(k, y);
+		az = L::mul(k, z);
+	}
+};
+
+// Point mass and earth's oblateness (Vallado 8.6.1). Earth's axis is y in this coordinate system:
+// a = -mu/r^3 * r * (1 + 3/2*J2*(R/r)^2 * (1 - 5*y^2/r^2)), with (3 - 5*y^2/r^2) for the y component
+struct J2Acceleration {
+	template <class L>
+	static void acceleration(typename L::reg x, typename L::reg y, typename L::reg z,
+		typename L::reg& ax, typename L::reg& ay, typename L::reg& az)
+	{
+		typedef typename L::reg reg;
+		const reg one = L::set1(1.0);
+		const reg r2 = L::add(L::add(L::mul(x, x), L::mul(y, y)), L::mul(z, z));
+		const reg k = L::div(L::set1(-mu), L::mul(r2, L::sqrt(r2)));
+		const reg j = L::div(L::set1(1.5 * j2 * earthRadius * earthRadius), r2);
+		const reg y2 = L::div(L::mul(L::set1(5.0), L::mul(y, y)), r2);
+		const reg equator = L::mul(k, L::add(one, L::mul(j, L::sub(one, y2))));
+		const reg axis = L::mul(k, L::add(one, L::mul(j, L::sub(L::set1(3.0), y2))));
+		ax = L::mul(equator, x);
+		ay = L::mul(axis, y);
+		az = L::mul(equator, z);
+	}
+};
+
+#endif /* Accelerations_hpp */
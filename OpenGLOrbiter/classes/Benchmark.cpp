@@ -0,0 +1,1369 @@
+//Author: Bernhard Luedtke
+
+#include "Benchmark.h"
+#include "ConstellationState.h"
+#include "KeplerKernels.h"
+#include "OrbitConstants.h"
+#include "CompiledOrbit.h"
+#include "Stumpff.h"
+#include "ThreadPool.h"
+#include "Timeline.h"
+#include "SteppedKeplerPropagator.h"
+#include "RungeKuttaIntegrator.h"
+#include "Sgp4Constellation.h"
+#include "TleCatalogLoader.h"
+#include "EphemerisFile.h"
+#include "ChebyshevEphemeris.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+
+using std::cout;
+
+// Random catalog with semi major axes between LEO and GEO and eccentricities in [minEcc, maxEcc)
+static void fillCatalog(ConstellationState& store, size_t n, double minEcc, double maxEcc, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double twoPi = 6.283185307179586;
+	store.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		const double e = minEcc + (maxEcc - minEcc) * unit(rng);
+		// keep the perigee above the surface
+		const double a = (6600.0 + 36000.0 * unit(rng)) / (1.0 - e);
+		store.add(OrbitEphemeris(a, e, unit(rng) * 3.14159, unit(rng) * twoPi, unit(rng) * twoPi, unit(rng) * twoPi));
+	}
+}
+
+// Average ns per satellite and tick. Starts a day after the epoch, so the times of flight are spread over the whole orbit
+static double timePropagation(ConstellationState& store, unsigned int ticks, double step)
+{
+	store.seek(86400.0);
+	store.resetSolveStats();
+	const auto t1 = std::chrono::steady_clock::now();
+	for (unsigned int k = 0; k < ticks; ++k) {
+		store.propagateBatch(step);
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+	const double ns = std::chrono::duration<double, std::nano>(t2 - t1).count();
+	return ns / (static_cast<double>(ticks) * static_cast<double>(store.size()));
+}
+
+// Largest distance in km between the positions of the two stores at a few times, backwards and forwards,
+// and how many satellites are more than 1 km apart at any of them
+static double maxDeviationKm(ConstellationState& a, ConstellationState& b, size_t& over1Km)
+{
+	const double times[] = { -2.5e7, -1234.5, 0.0, 60.0, 5400.0, 86400.0, 3.0e8 };
+	std::vector<bool> off(a.size(), false);
+	double maxDiff = 0.0;
+	for (double t : times) {
+		a.seek(t);
+		b.seek(t);
+		for (size_t i = 0; i < a.size(); ++i) {
+			const double d = (a.getR(i) - b.getR(i)).length() / sizeFactor;
+			maxDiff = (d > maxDiff) ? d : maxDiff;
+			off[i] = off[i] || d > 1.0;
+		}
+	}
+	over1Km = static_cast<size_t>(std::count(off.begin(), off.end(), true));
+	return maxDiff;
+}
+
+void benchmarkKeplerPaths()
+{
+	const size_t n = 10000;
+	const unsigned int ticks = 200;
+	// 10x timescale at 60 ticks per second
+	const double step = 10.0 / 60.0;
+	const SimdLevel detected = detectSimdLevel();
+	struct Catalog { const char* name; double minEcc; double maxEcc; };
+	const Catalog catalogs[] = { { "e in [0, 0.1)", 0.0, 0.1 }, { "e in [0.2, 0.9)", 0.2, 0.9 } };
+	const KeplerPath paths[] = { KeplerPath::Universal, KeplerPath::Elliptic, KeplerPath::Automatic };
+	const char* pathNames[] = { "universal", "elliptic", "automatic" };
+
+	cout << "Kepler paths, " << n << " satellites, " << ticks << " ticks\n";
+	for (const Catalog& c : catalogs) {
+		ConstellationState universal, elliptic;
+		fillCatalog(universal, n, c.minEcc, c.maxEcc, 42);
+		fillCatalog(elliptic, n, c.minEcc, c.maxEcc, 42);
+		universal.setKeplerPath(KeplerPath::Universal);
+		elliptic.setKeplerPath(KeplerPath::Elliptic);
+		size_t over1Km = 0;
+		const double maxDiff = maxDeviationKm(universal, elliptic, over1Km);
+		cout << "  " << c.name << ": max |r universal - r elliptic| = " << maxDiff << " km, " << over1Km << " satellites more than 1 km apart\n";
+		for (int level = 0; level <= static_cast<int>(detected); ++level) {
+			// SSE2 is always there on x64, skip it when something better is
+			if (level == static_cast<int>(SimdLevel::SSE2) && detected != SimdLevel::SSE2) {
+				continue;
+			}
+			setSimdLevel(static_cast<SimdLevel>(level));
+			cout << "    " << std::setw(8) << simdLevelName(getSimdLevel());
+			// Fastest of three runs, single runs of the same path vary by up to a third
+			for (int p = 0; p < 3; ++p) {
+				universal.setKeplerPath(paths[p]);
+				double ns = timePropagation(universal, ticks, step);
+				for (int run = 1; run < 3; ++run) {
+					ns = std::min(ns, timePropagation(universal, ticks, step));
+				}
+				cout << "  " << pathNames[p] << ": " << std::fixed << std::setprecision(1) << ns << " ns";
+			}
+			cout << std::defaultfloat << std::setprecision(6) << "\n";
+		}
+		setSimdLevel(detected);
+	}
+}
+
+static void printSolveStats(const char* name, const KeplerSolveStats& stats, double ns)
+{
+	cout << "  " << name << ": " << std::fixed << std::setprecision(2)
+		<< static_cast<double>(stats.iterations) / static_cast<double>(stats.solves) << " iterations/solve (max " << stats.maxIterations << "), "
+		<< std::setprecision(1) << ns << " ns/solve, " << std::defaultfloat << std::setprecision(6)
+		<< stats.warmStarts << " warm starts, " << stats.laguerreFallbacks << " Laguerre fallbacks, "
+		<< stats.unconverged << " unconverged, " << stats.fgCheckFailures << " f/g check failures (max deviation " << stats.maxFgDeviation << ")\n";
+}
+
+void benchmarkUniversalSolver()
+{
+	const size_t n = 10000;
+	const unsigned int ticks = 200;
+	const double step = 10.0 / 60.0;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 7);
+	store.setKeplerPath(KeplerPath::Universal);
+	cout << "Universal variable solver, " << n << " satellites with e in [0, 0.9), " << ticks << " ticks, " << simdLevelName(getSimdLevel()) << "\n";
+
+	store.setWarmStart(false);
+	double ns = timePropagation(store, ticks, step);
+	printSolveStats("cold start", store.getSolveStats(), ns);
+
+	store.setWarmStart(true);
+	ns = timePropagation(store, ticks, step);
+	printSolveStats("warm start", store.getSolveStats(), ns);
+
+	// Scrubbing hyperbolas far out and back: the warm started store has to end where a cold started one does
+	ConstellationState warm, cold;
+	for (int i = 0; i < 9; ++i) {
+		const OrbitEphemeris eph(-20000.0 - 1000.0 * i, 1.5, 0.3 + 0.1 * i, 0.2 * i, 0.1 * i, 0.1 * i);
+		warm.add(eph);
+		cold.add(eph);
+	}
+	warm.setKeplerPath(KeplerPath::Universal);
+	cold.setKeplerPath(KeplerPath::Universal);
+	cold.setWarmStart(false);
+	double maxDiff = 0.0;
+	size_t unconverged = 0;
+	const double seeks[][2] = { { 1e10, -1e8 }, { 1e6, -1e8 }, { -1e8, 1e6 } };
+	for (const auto& seek : seeks) {
+		warm.seek(seek[0]);
+		warm.resetSolveStats();
+		warm.seek(seek[1]);
+		cold.seek(seek[1]);
+		unconverged += warm.getSolveStats().unconverged;
+		for (size_t i = 0; i < warm.size(); ++i) {
+			double r[3], v[3], rC[3], vC[3];
+			warm.getStateKm(i, r, v);
+			cold.getStateKm(i, rC, vC);
+			for (int k = 0; k < 3; ++k) {
+				maxDiff = std::isfinite(r[k]) ? std::max(maxDiff, std::abs(r[k] - rC[k]) / std::abs(rC[k])) : HUGE_VAL;
+			}
+		}
+	}
+	cout << "  hyperbolas scrubbed far out and back: " << maxDiff << " relative to a cold start, " << unconverged << " unconverged\n";
+}
+
+/*
+	The universal variable Newton iteration the way Satellite used to run it: r0.dot(v0), |r0| and 1/a are taken
+	from the ephemeris again in every step (float Vectors, through the doR0V0exist check of getR0/getV0).
+	Only used as the baseline of benchmarkCompiledOrbit.
+*/
+static unsigned int solveFromEphemeris(OrbitEphemeris& eph, double t, double& x, double& c, double& s)
+{
+	for (unsigned int k = 0; k <= keplerNewtonMaxIterations; ++k) {
+		const double sig0 = eph.getR0().dot(eph.getV0()) / sqMU;
+		const double r0L = eph.getR0().length();
+		const double alpha = 1.0 / eph.semiMajorA;
+		const double z = (x * x) * alpha;
+		stumpffCS(z, c, s);
+		const double tn = ((sig0 * x * x) * c + ((1.0 - r0L * alpha) * (x * x * x)) * s + r0L * x) / sqMU;
+		if (!(std::abs(t - tn) >= keplerTimeTolerance * (1.0 + std::abs(t)))) {
+			return k;
+		}
+		const double dtdx = ((x * x) * c + (sig0 * x) * (1.0 - z * s) + r0L * (1.0 - z * c)) / sqMU;
+		x = x + (t - tn) / dtdx;
+	}
+	return keplerNewtonMaxIterations + 1;
+}
+
+void benchmarkCompiledOrbit()
+{
+	const size_t n = 10000;
+	const int rounds = 20;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double twoPi = 6.283185307179586;
+	std::vector<OrbitEphemeris> ephemerides;
+	std::vector<CompiledOrbit> orbits;
+	std::vector<double> times;
+	ephemerides.reserve(n);
+	orbits.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		const double e = 0.7 * unit(rng);
+		const double a = (6600.0 + 36000.0 * unit(rng)) / (1.0 - e);
+		ephemerides.push_back(OrbitEphemeris(a, e, unit(rng) * 3.14159, unit(rng) * twoPi, unit(rng) * twoPi, unit(rng) * twoPi));
+		orbits.push_back(CompiledOrbit::compile(ephemerides.back(), 0.0));
+		// within half a period, as after the reduction in ConstellationState
+		times.push_back((unit(rng) - 0.5) * orbits.back().period);
+	}
+	cout << "Compiled orbit, " << n << " scalar solves x " << rounds << ", e in [0, 0.7), cold start\n";
+
+	size_t iterations[2] = { 0, 0 };
+	double nsPerSolve[2] = { 0.0, 0.0 };
+	double checksum[2] = { 0.0, 0.0 };
+	double c, s;
+	for (int variant = 0; variant < 2; ++variant) {
+		const auto t1 = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			for (size_t i = 0; i < n; ++i) {
+				const CompiledOrbit& o = orbits[i];
+				double x = universalAnomalyGuess(o.alpha, o.r0Length, o.sigma0, times[i]);
+				iterations[variant] += (variant == 0) ? solveFromEphemeris(ephemerides[i], times[i], x, c, s) : solveUniversalAnomaly(o, times[i], x, c, s);
+				checksum[variant] += x;
+			}
+		}
+		const auto t2 = std::chrono::steady_clock::now();
+		nsPerSolve[variant] = std::chrono::duration<double, std::nano>(t2 - t1).count() / (static_cast<double>(n) * rounds);
+	}
+	const double solves = static_cast<double>(n) * rounds;
+	cout << std::fixed << std::setprecision(1)
+		<< "  through OrbitEphemeris: " << nsPerSolve[0] << " ns/solve, " << std::setprecision(2) << iterations[0] / solves << " iterations/solve\n"
+		<< std::setprecision(1)
+		<< "  CompiledOrbit:          " << nsPerSolve[1] << " ns/solve, " << std::setprecision(2) << iterations[1] / solves << " iterations/solve\n"
+		<< std::setprecision(1) << "  saved per solve:        " << nsPerSolve[0] - nsPerSolve[1] << " ns"
+		<< std::defaultfloat << std::setprecision(6) << " (sum of x differs by " << std::abs(checksum[0] - checksum[1]) / std::abs(checksum[1])
+		<< " relative, float against double r0/v0)\n";
+}
+
+// C(z), S(z) in long double: the exact forms where they do not cancel, the power series near 0.
+// With a 64 bit long double (MSVC) this is about as exact as double, still without the cancellation of stumpffC/stumpffS.
+static void stumpffReference(double z, long double& c, long double& s)
+{
+	const long double zl = z;
+	if (std::abs(z) > 1.0) {
+		const long double q = std::sqrt(std::abs(zl));
+		c = (z > 0.0) ? (1.0L - std::cos(q)) / zl : (1.0L - std::cosh(q)) / zl;
+		s = (z > 0.0) ? (q - std::sin(q)) / (zl * q) : (std::sinh(q) - q) / (-zl * q);
+		return;
+	}
+	long double termC = 0.5L, termS = 1.0L / 6.0L;
+	c = 0.0L;
+	s = 0.0L;
+	for (int k = 0; k < 30; ++k) {
+		c += termC;
+		s += termS;
+		termC *= -zl / ((2 * k + 3) * (2 * k + 4));
+		termS *= -zl / ((2 * k + 4) * (2 * k + 5));
+	}
+}
+
+void benchmarkStumpff()
+{
+	struct Range { const char* name; double min; double max; };
+	const Range ranges[] = { { "bound orbits [-4, 25]", stumpffChebyshevMin, stumpffChebyshevMax },
+		{ "near 0 [-1e-3, 1e-3]", -1e-3, 1e-3 }, { "hyperbolic [-400, -4)", -400.0, -4.0 } };
+	const StumpffMode modes[] = { StumpffMode::Series, StumpffMode::Chebyshev, StumpffMode::Exact };
+	const StumpffMode active = getStumpffMode();
+	const size_t samples = 200000;
+	const int rounds = 20;
+	std::vector<double> z(samples);
+	std::vector<long double> refC(samples), refS(samples);
+
+	cout << "Stumpff functions, max relative error of C / S and ns per C,S pair (" << samples << " z per range)\n";
+	for (const Range& r : ranges) {
+		for (size_t i = 0; i < samples; ++i) {
+			z[i] = r.min + (r.max - r.min) * static_cast<double>(i) / static_cast<double>(samples - 1);
+			stumpffReference(z[i], refC[i], refS[i]);
+		}
+		cout << "  " << r.name << "\n";
+		for (StumpffMode mode : modes) {
+			setStumpffMode(mode);
+			double maxC = 0.0, maxS = 0.0, sum = 0.0;
+			double c, s;
+			for (size_t i = 0; i < samples; ++i) {
+				stumpffCS(z[i], c, s);
+				const double errC = static_cast<double>(std::abs((c - refC[i]) / refC[i]));
+				const double errS = static_cast<double>(std::abs((s - refS[i]) / refS[i]));
+				maxC = (errC > maxC) ? errC : maxC;
+				maxS = (errS > maxS) ? errS : maxS;
+			}
+			const auto t1 = std::chrono::steady_clock::now();
+			for (int k = 0; k < rounds; ++k) {
+				for (size_t i = 0; i < samples; ++i) {
+					stumpffCS(z[i], c, s);
+					sum += c + s;
+				}
+			}
+			const auto t2 = std::chrono::steady_clock::now();
+			const double ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / (static_cast<double>(samples) * rounds);
+			cout << "    " << std::setw(9) << stumpffModeName(mode) << ": " << std::setprecision(3) << maxC << " / " << maxS
+				<< ", " << std::fixed << std::setprecision(1) << ns << " ns" << std::defaultfloat << std::setprecision(6)
+				<< ((sum == 0.0) ? " " : "") << "\n";
+		}
+	}
+
+	const size_t n = 10000;
+	const unsigned int ticks = 200;
+	const double step = 10.0 / 60.0;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 7);
+	store.setKeplerPath(KeplerPath::Universal);
+	cout << "  universal variable propagation, " << n << " satellites with e in [0, 0.9), " << simdLevelName(getSimdLevel()) << "\n";
+	for (StumpffMode mode : modes) {
+		setStumpffMode(mode);
+		const double ns = timePropagation(store, ticks, step);
+		const KeplerSolveStats& stats = store.getSolveStats();
+		cout << "    " << std::setw(9) << stumpffModeName(mode) << ": " << std::fixed << std::setprecision(1) << ns << " ns/solve, "
+			<< std::setprecision(2) << static_cast<double>(stats.iterations) / static_cast<double>(stats.solves) << " iterations/solve, "
+			<< std::defaultfloat << std::setprecision(6) << stats.unconverged << " unconverged, " << stats.fgCheckFailures << " f/g check failures\n";
+	}
+	setStumpffMode(active);
+}
+
+// Propagates the store on the pool (or without one) and returns ms per tick
+static double timeThreaded(ConstellationState& store, ThreadPool* pool, unsigned int ticks, double step)
+{
+	store.setThreadPool(pool);
+	const double ns = timePropagation(store, ticks, step);
+	store.setThreadPool(nullptr);
+	return ns * static_cast<double>(store.size()) * 1e-6;
+}
+
+// True if every position and speed of the two stores is bit identical
+static bool identicalStates(const ConstellationState& a, const ConstellationState& b)
+{
+	double ra[3], va[3], rb[3], vb[3];
+	for (size_t i = 0; i < a.size(); ++i) {
+		a.getStateKm(i, ra, va);
+		b.getStateKm(i, rb, vb);
+		if (std::memcmp(ra, rb, sizeof(ra)) != 0 || std::memcmp(va, vb, sizeof(va)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void benchmarkThreadPool()
+{
+	const size_t n = 100000;
+	const unsigned int ticks = 50;
+	const double step = 10.0 / 60.0;
+	const size_t chunk = 1024;
+	const unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+	ConstellationState reference;
+	fillCatalog(reference, n, 0.0, 0.9, 5);
+	reference.setChunkSize(chunk);
+	cout << "Thread pool, " << n << " satellites, chunks of " << chunk << ", " << ticks << " ticks, " << hardware << " hardware threads\n";
+
+	const double single = timeThreaded(reference, nullptr, ticks, step);
+	const KeplerSolveStats referenceStats = reference.getSolveStats();
+	cout << "  " << std::setw(2) << 1 << " thread:  " << std::fixed << std::setprecision(2) << single << " ms/tick\n" << std::defaultfloat << std::setprecision(6);
+	// At least 2 and 4 threads, so the parallel path (and its determinism) is checked on small machines too
+	std::vector<unsigned int> counts;
+	for (unsigned int threads = 2; threads <= std::max(4u, hardware); threads *= 2) {
+		counts.push_back(threads);
+	}
+	if (counts.back() != hardware && hardware > 4) {
+		counts.push_back(hardware);
+	}
+	for (unsigned int threads : counts) {
+		for (int pin = 0; pin < ((threads == hardware) ? 2 : 1); ++pin) {
+			// A fresh store for every run, the warm start would otherwise begin from the end of the previous one
+			ConstellationState store;
+			fillCatalog(store, n, 0.0, 0.9, 5);
+			store.setChunkSize(chunk);
+			ThreadPool pool(threads - 1, pin == 1);
+			const double ms = timeThreaded(store, &pool, ticks, step);
+			const KeplerSolveStats& stats = store.getSolveStats();
+			const bool identical = identicalStates(reference, store) && stats.iterations == referenceStats.iterations
+				&& stats.solves == referenceStats.solves && stats.maxFgDeviation == referenceStats.maxFgDeviation;
+			cout << "  " << std::setw(2) << threads << " threads" << (pin ? " (pinned)" : "") << ": " << std::fixed << std::setprecision(2) << ms
+				<< " ms/tick, speedup " << single / ms << ", efficiency " << std::setprecision(0) << 100.0 * single / (ms * threads) << "%, "
+				<< std::defaultfloat << std::setprecision(6) << pool.getSteals() << " chunks stolen, "
+				<< (identical ? "bit identical" : "DIFFERENT from 1 thread") << "\n";
+		}
+	}
+}
+
+// Mean and largest latency of the seeks to the given times
+// Returns the worst latency
+static double timeSeeks(Timeline& timeline, const std::vector<double>& targets, const char* name)
+{
+	double sum = 0.0, worst = 0.0;
+	for (double t : targets) {
+		timeline.seek(t);
+		sum += timeline.getLastSeek().latencyMs;
+		worst = std::max(worst, timeline.getLastSeek().latencyMs);
+	}
+	cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2) << sum / targets.size()
+		<< " ms mean, " << worst << " ms worst\n" << std::defaultfloat << std::setprecision(6);
+	return worst;
+}
+
+void benchmarkTimeline()
+{
+	const size_t n = 1000;
+	const double step = 60.0;
+	const double interval = 3600.0;
+	const double week = 7.0 * 86400.0;
+	// A seek integrates at most one checkpoint spacing. The budget holds a week of these satellites every 2 h (from 1 h, thinned once),
+	// which keeps every seek within three frames at 60 Hz.
+	const size_t budget = 4u << 20;
+	const double targetMs = 50.0;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 6);
+	SteppedKeplerPropagator propagator(store, step);
+	Timeline timeline(propagator, interval, budget);
+	cout << "Timeline, " << n << " satellites stepped every " << step << " s, checkpoints every " << interval << " s, budget "
+		<< (budget >> 10) << " KiB\n";
+
+	const auto t1 = std::chrono::steady_clock::now();
+	for (double t = 600.0; t <= week; t += 600.0) {
+		timeline.advanceTo(t);
+	}
+	const double forwardMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+	cout << "  one week forwards:     " << std::fixed << std::setprecision(1) << forwardMs << " ms, " << timeline.getCheckpointCount()
+		<< " checkpoints (" << (timeline.getMemoryUsage() >> 10) << " KiB), " << timeline.getEvictions() << " evicted, largest gap "
+		<< timeline.getLargestGap() / 3600.0 << " h (spacing " << timeline.getSpacing() / 3600.0 << " h)\n" << std::defaultfloat << std::setprecision(6);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> anywhere(0.0, week);
+	std::vector<double> randomTargets(200);
+	for (double& t : randomTargets) {
+		t = anywhere(rng);
+	}
+	double worst = timeSeeks(timeline, randomTargets, "random seeks:");
+	// Dragging the slider back over the week, an hour per frame
+	std::vector<double> scrub;
+	for (double t = week; t >= 0.0; t -= 3600.0) {
+		scrub.push_back(t);
+	}
+	worst = std::max(worst, timeSeeks(timeline, scrub, "scrubbing backwards:"));
+	cout << "  worst seek " << std::fixed << std::setprecision(2) << worst << " ms, target " << targetMs << " ms: "
+		<< ((worst <= targetMs) ? "pass" : "FAIL") << "\n" << std::defaultfloat << std::setprecision(6);
+
+	// A seek has to land exactly where the uninterrupted run is
+	const double probe = 3.5 * 86400.0 + 1234.5;
+	timeline.seek(probe);
+	ConstellationState direct;
+	fillCatalog(direct, n, 0.0, 0.9, 6);
+	SteppedKeplerPropagator directPropagator(direct, step);
+	directPropagator.advanceTo(probe);
+	cout << "  seek vs. uninterrupted: " << (identicalStates(store, direct) ? "bit identical" : "DIFFERENT") << "\n";
+}
+
+void benchmarkJ2Secular()
+{
+	const size_t n = 50000;
+	const unsigned int ticks = 100;
+	const double step = 10.0 / 60.0;
+	const double radToDegPerDay = 86400.0 * 180.0 / 3.14159265358979323846;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 8);
+	cout << "J2 secular drift, " << n << " satellites, " << ticks << " ticks\n";
+	const double twoBody = timePropagation(store, ticks, step);
+	for (size_t i = 0; i < n; ++i) {
+		store.setForceModel(i, ForceModel::J2Secular);
+	}
+	const double secular = timePropagation(store, ticks, step);
+	cout << "  two body:   " << std::fixed << std::setprecision(1) << twoBody << " ns/satellite\n"
+		<< "  J2 secular: " << secular << " ns/satellite (" << std::setprecision(0) << 100.0 * (secular / twoBody - 1.0) << "% more)\n"
+		<< std::defaultfloat << std::setprecision(6);
+
+	// Against the two body state of the drifted elements themselves, ten days after the epoch
+	const double t = 10.0 * 86400.0;
+	store.seek(t);
+	double maxDiff = 0.0;
+	for (size_t i = 0; i < n; i += 97) {
+		const OrbitEphemeris& eph = store.getEphemeris(i);
+		const CompiledOrbit& o = store.getCompiledOrbit(i);
+		double sinE, cosE;
+		const double E = solveEccentricAnomaly(eph.eccentricity, std::fmod(o.meanAnomaly0 + o.meanMotion * o.anomalyRateScale * t, 6.283185307179586), sinE, cosE);
+		const double trueAnomaly = 2.0 * std::atan2(std::sqrt(1.0 + eph.eccentricity) * std::sin(0.5 * E), std::sqrt(1.0 - eph.eccentricity) * std::cos(0.5 * E));
+		const OrbitEphemeris drifted(eph.semiMajorA, eph.eccentricity, eph.inclination, eph.longitudeAsc + o.nodeRate * t,
+			eph.argPeriaps + o.periapsisRate * t, trueAnomaly);
+		const CompiledOrbit expected = CompiledOrbit::compile(drifted, t);
+		double r[3], v[3];
+		store.getStateKm(i, r, v);
+		for (int k = 0; k < 3; ++k) {
+			maxDiff = std::max(maxDiff, std::abs(r[k] - expected.r0[k]));
+		}
+	}
+	cout << "  largest difference to the drifted elements after 10 days: " << maxDiff << " km\n";
+
+	// Known rates: the ISS orbit regresses about 5 deg/day, a sun synchronous orbit advances 0.9856 deg/day
+	ConstellationState known;
+	known.add(OrbitEphemeris(6778.0, 0.0005, 51.64 * 3.14159265358979323846 / 180.0, 0.0, 0.0, 0.0), ForceModel::J2Secular);
+	known.add(OrbitEphemeris(7078.0, 0.001, 98.19 * 3.14159265358979323846 / 180.0, 0.0, 0.0, 0.0), ForceModel::J2Secular);
+	cout << "  node drift: ISS " << known.getCompiledOrbit(0).nodeRate * radToDegPerDay << " deg/day, sun synchronous 700 km "
+		<< known.getCompiledOrbit(1).nodeRate * radToDegPerDay << " deg/day\n";
+}
+
+// Largest distance in km between the integrated and the Kepler positions
+static double maxDeviationKm(const RungeKuttaIntegrator<TwoBodyAcceleration>& integrator, const ConstellationState& store)
+{
+	double maxDiff = 0.0;
+	double r[3], v[3], rK[3], vK[3];
+	for (size_t i = 0; i < store.size(); ++i) {
+		integrator.getStateKm(i, r, v);
+		store.getStateKm(i, rK, vK);
+		const double d = std::sqrt((r[0] - rK[0]) * (r[0] - rK[0]) + (r[1] - rK[1]) * (r[1] - rK[1]) + (r[2] - rK[2]) * (r[2] - rK[2]));
+		maxDiff = std::max(maxDiff, d);
+	}
+	return maxDiff;
+}
+
+// ms for a day in frames of frameSeconds
+template <class Force>
+static double timeIntegration(RungeKuttaIntegrator<Force>& integrator, double frameSeconds)
+{
+	const auto t1 = std::chrono::steady_clock::now();
+	for (double t = frameSeconds; t <= 86400.0; t += frameSeconds) {
+		integrator.advanceTo(t);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+}
+
+void benchmarkRungeKutta()
+{
+	const size_t n = 2000;
+	const double frame = 60.0;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 9);
+	cout << "RKF45 integrator, " << n << " satellites with e in [0, 0.9), one day in frames of " << frame << " s\n";
+
+	const auto t1 = std::chrono::steady_clock::now();
+	for (double t = frame; t <= 86400.0; t += frame) {
+		store.propagateTo(t);
+	}
+	const double keplerMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+	cout << "  Kepler:          " << std::fixed << std::setprecision(1) << keplerMs << " ms\n" << std::defaultfloat << std::setprecision(6);
+
+	const SimdLevel active = getSimdLevel();
+	const SimdLevel levels[] = { SimdLevel::Scalar, active };
+	for (SimdLevel level : levels) {
+		setSimdLevel(level);
+		RungeKuttaIntegrator<TwoBodyAcceleration> integrator;
+		for (size_t i = 0; i < n; ++i) {
+			integrator.add(store.getEphemeris(i));
+		}
+		const double ms = timeIntegration(integrator, frame);
+		const RungeKuttaStats& stats = integrator.getStats();
+		cout << "  two body " << std::left << std::setw(8) << simdLevelName(level) << std::right << std::fixed << std::setprecision(1) << ms
+			<< " ms (" << ms / keplerMs << "x Kepler), " << static_cast<double>(stats.accepted) / n << " steps and "
+			<< static_cast<double>(stats.rejected) / n << " rejections per satellite, " << std::defaultfloat << std::setprecision(3)
+			<< maxDeviationKm(integrator, store) << " km from Kepler" << std::setprecision(6) << "\n";
+	}
+	{
+		RungeKuttaIntegrator<J2Acceleration> integrator;
+		for (size_t i = 0; i < n; ++i) {
+			integrator.add(store.getEphemeris(i));
+		}
+		const double ms = timeIntegration(integrator, frame);
+		cout << "  J2 " << std::left << std::setw(13) << simdLevelName(active) << std::right << std::fixed << std::setprecision(1) << ms
+			<< " ms (" << ms / keplerMs << "x Kepler), " << static_cast<double>(integrator.getStats().accepted) / n << " steps per satellite\n"
+			<< std::defaultfloat << std::setprecision(6);
+	}
+	setSimdLevel(active);
+
+	// Dense output between the steps, and a seek back through a Timeline, against integrating straight to the same time
+	RungeKuttaIntegrator<TwoBodyAcceleration> scrubbed;
+	RungeKuttaIntegrator<TwoBodyAcceleration> straight;
+	for (size_t i = 0; i < n; ++i) {
+		scrubbed.add(store.getEphemeris(i));
+		straight.add(store.getEphemeris(i));
+	}
+	Timeline timeline(scrubbed, 3600.0, 16u << 20);
+	timeline.advanceTo(6.0 * 3600.0);
+	const double probe = 2.3 * 3600.0 + 17.25;
+	timeline.seek(probe);
+	straight.advanceTo(probe);
+	store.seek(probe);
+	double r[3], v[3], rS[3], vS[3];
+	bool identical = true;
+	for (size_t i = 0; i < n; ++i) {
+		scrubbed.getStateKm(i, r, v);
+		straight.getStateKm(i, rS, vS);
+		identical = identical && std::memcmp(r, rS, sizeof(r)) == 0 && std::memcmp(v, vS, sizeof(v)) == 0;
+	}
+	cout << "  dense output at " << probe << " s: " << std::setprecision(3) << maxDeviationKm(straight, store) << " km from Kepler, seek back "
+		<< std::fixed << std::setprecision(1) << timeline.getLastSeek().latencyMs << " ms, " << (identical ? "bit identical" : "DIFFERENT")
+		<< " to integrating straight there\n" << std::defaultfloat << std::setprecision(6);
+}
+
+// Vallado et al., AIAA 2006-6753: element sets of SGP4-VER.TLE and the vectors of their tcppver.out (TEME, km and km/s)
+static const char* const ver00005[2] = { "1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+	"2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667" };
+static const char* const ver06251[2] = { "1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985",
+	"2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774" };
+static const char* const ver88888[2] = { "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0    87",
+	"2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518  1058" };
+// Deep space: 12 h resonant (Molniya)
+static const char* const ver08195[2] = { "1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+	"2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656" };
+static const char* const ver21897[2] = { "1 21897U 92011A   06176.02341244 -.00001273  00000-0 -13525-3 0  3044",
+	"2 21897  62.1749 198.0096 7421690 253.0462  20.1561  2.01269994104880" };
+static const char* const ver26975[2] = { "1 26975U 78066F   06174.85818871  .00000620  00000-0  10000-3 0  6809",
+	"2 26975  68.4714 236.1303 5602877 123.7484 302.5767  2.05657553 67521" };
+// Deep space: 24 h resonant (geosynchronous)
+static const char* const ver28626[2] = { "1 28626U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2190",
+	"2 28626   0.0019 286.9433 0000335  13.7918  55.6504  1.00270176  4891" };
+// Deep space without resonance, low inclinations (Lyddane) among them
+static const char* const ver23177[2] = { "1 23177U 94040C   06175.45752052  .00000386  00000-0  76590-3 0    95",
+	"2 23177   7.0496 179.8238 7258491 296.0482   8.3061  2.25906668 97438" };
+static const char* const ver23599[2] = { "1 23599U 95029B   06171.76535463  .00085586  12891-6  12956-2 0  2905",
+	"2 23599   6.9327   0.2849 5782022 274.4436  25.2425  4.47796565123555" };
+static const char* const ver28623[2] = { "1 28623U 05006B   06177.81079184  .00637644  69054-6  96390-3 0  6000",
+	"2 28623  28.5200 114.9834 6249053 170.2550 212.8965  3.79477162 12753" };
+static const char* const ver16925[2] = { "1 16925U 86065D   06151.67415771  .02550794 -30915-6  18784-3 0  4486",
+	"2 16925  62.0906 295.0239 5596327 245.1593  47.9690  4.88511875148616" };
+// Cases SGP4 has to stop on. 33333 to 33335 are made up from 28872, 26975 and 28626; their checksums are those of the lines
+// as printed here.
+static const char* const ver28872[2] = { "1 28872U 05037B   05333.02012661  .25992681  00000-0  24476-3 0  1534",
+	"2 28872  96.4736 157.9986 0303955 244.0492 110.6523 16.46015938 10708" };
+static const char* const ver29141[2] = { "1 29141U 85108AA  06170.26783845  .99999999  00000-0  13519-0 0   718",
+	"2 29141  82.4288 273.4882 0015848 277.2124  83.9133 15.93343074  6828" };
+static const char* const ver22312[2] = { "1 22312U 93002D   06094.46235912  .99999999  81888-5  49949-3 0  3953",
+	"2 22312  62.1486  77.4698 0308723 267.9229  88.7392 15.95744531 98783" };
+static const char* const ver33333[2] = { "1 33333U 05037B   05333.02012661  .25992681  00000-0  24476-3 0  1532",
+	"2 33333  96.4736 157.9986 9950000 244.0492 110.6523  4.00004038 10700" };
+static const char* const ver33334[2] = { "1 33334U 78066F   06174.85818871  .00000620  00000-0  10000-3 0  6806",
+	"2 33334  68.4714 236.1303 5602877 123.7484 302.5767  0.00001000 67521" };
+static const char* const ver33335[2] = { "1 33335U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2193",
+	"2 33335   0.0019 286.9433 0000004  13.7918  55.6504  0.00000000  4893" };
+
+// The published vectors are rounded to 1e-8 km and 1e-9 km/s
+static const double sgp4ToleranceKm = 1e-7;
+static const double sgp4ToleranceKmS = 1e-8;
+
+struct Sgp4Vector {
+	const char* const* tle;
+	double tsince;
+	double r[3];
+	double v[3];
+	bool hasVelocity;
+};
+
+static const Sgp4Vector sgp4Vectors[] = {
+	{ ver00005, 0.0, { 7022.46529266, -1400.08296755, 0.03995155 }, { 1.893841015, 6.405893759, 4.534807250 }, true },
+	{ ver00005, 360.0, { -7154.03120202, -3783.17682504, -3536.19412294 }, { 4.741887409, -4.151817765, -2.093935425 }, true },
+	{ ver00005, 720.0, { -7134.59340119, 6531.68641334, 3260.27186483 }, { -4.113793027, -2.911922039, -2.557327851 }, true },
+	{ ver00005, 1080.0, { 5568.53901181, 4492.06992591, 3863.87641983 }, { -4.209106476, 5.159719888, 2.744852980 }, true },
+	{ ver00005, 1440.0, { -938.55923943, -6268.18748831, -4294.02924751 }, { 7.536105209, -0.427127707, 0.989878080 }, true },
+	{ ver00005, 1800.0, { -9680.56121728, 2802.47771354, 124.10688038 }, { -0.905874102, -4.659467970, -3.227347517 }, true },
+	{ ver00005, 2160.0, { 190.19796988, 7746.96653614, 5110.00675412 }, { -6.112325142, 1.527008184, -0.139152358 }, true },
+	{ ver00005, 2520.0, { 5579.55640116, -3995.61396789, -1518.82108966 }, { 4.767927483, 5.123185301, 4.276837355 }, true },
+	{ ver00005, 2880.0, { -8650.73082219, -1914.93811525, -3007.03603443 }, { 3.067165127, -4.828384068, -2.515322836 }, true },
+	{ ver00005, 3240.0, { -5429.79204164, 7574.36493792, 3747.39305236 }, { -4.999442110, -1.800561422, -2.229392830 }, true },
+	{ ver00005, 3600.0, { 6759.04583722, 2001.58198220, 2783.55192533 }, { -2.180993947, 6.402085603, 3.644723952 }, true },
+	{ ver00005, 3960.0, { -3791.44531559, -5712.95617894, -4533.48630714 }, { 6.668817493, -2.516382327, -0.082384354 }, true },
+	{ ver00005, 4320.0, { -9060.47373569, 4658.70952502, 813.68673153 }, { -2.232832783, -4.110453490, -3.157345433 }, true },
+	{ ver06251, 0.0, { 3988.31022699, 5498.96657235, 0.90055879 }, { -3.290032738, 2.357652820, 6.496623475 }, true },
+	{ ver06251, 120.0, { -3935.69800083, 409.10980837, 5471.33577327 }, { -3.374784183, -6.635211043, -1.942056221 }, true },
+	{ ver06251, 240.0, { -1675.12766915, -5683.30432352, -3286.21510937 }, { 5.282496925, 1.508674259, -5.354872978 }, true },
+	{ ver06251, 360.0, { 4993.62642836, 2890.54969900, -3600.40145627 }, { 0.347333429, 5.707031557, 5.070699638 }, true },
+	{ ver06251, 480.0, { -1115.07959514, 4015.11691491, 5326.99727718 }, { -5.524279443, -4.765738774, 2.402255961 }, true },
+	{ ver06251, 600.0, { -4329.10008198, -5176.70287935, 409.65313857 }, { 2.858408303, -2.933091792, -6.509690397 }, true },
+	{ ver06251, 720.0, { 3692.60030028, -976.24265255, -5623.36447493 }, { 3.897257243, 6.415554948, 1.429112190 }, true },
+	{ ver88888, 0.0, { 2328.96975262, -5995.22051338, 1719.97297192 }, { 2.912073280, -0.983417956, -7.090816210 }, true },
+	{ ver08195, 0.0, { 2349.89483350, -14785.93811562, 0.02119378 }, { 2.721488096, -3.256811655, 4.498416672 }, true },
+	{ ver21897, 0.0, { -14464.72135182, -4699.19517587, 0.06681686 }, { -3.249312013, -3.281032707, 4.007046940 }, true },
+	{ ver26975, 0.0, { -14506.92313768, -21613.56043281, 10.05018894 }, { 2.212943308, 1.159970892, 3.020600202 }, true },
+	{ ver28626, 0.0, { 42080.71852213, -2646.86387436, 0.81851294 }, { 0.193105177, 3.068688251, 0.000438449 }, true },
+	{ ver28626, 120.0, { 37740.00085593, 18802.76872802, 3.45512584 }, { -1.371035206, 2.752105932, 0.000336883 }, true },
+	{ ver28626, 240.0, { 23232.82515008, 35187.33981802, 4.98927428 }, { 0.0, 0.0, 0.0 }, false },
+	{ ver23177, 0.0, { -8801.60046706, -0.03357557, -0.44522743 }, { -3.835279101, -7.662552175, 0.944561323 }, true },
+	{ ver23599, 0.0, { 9892.63794341, 35.76144969, -1.08228838 }, { 3.556643237, 6.456009375, 0.783610890 }, true },
+	{ ver28623, 0.0, { -11665.70902324, 24943.61433357, 25.80543633 }, { -1.596228621, -1.476127961, 1.126059754 }, true },
+	{ ver16925, 0.0, { 5559.11686836, -11941.04090781, -19.41235206 }, { 3.392116762, -1.946985124, 4.250755852 }, true }
+};
+
+// Propagated from start in steps to stop, as the verification driver does, these fail first at failsAt (0: already in sgp4Init)
+struct Sgp4ErrorCase {
+	const char* const* tle;
+	double start;
+	double stop;
+	double step;
+	double failsAt;
+	int code;
+};
+
+static const Sgp4ErrorCase sgp4ErrorCases[] = {
+	// Decays
+	{ ver28872, 0.0, 60.0, 5.0, 55.0, 6 },
+	{ ver29141, 0.0, 440.0, 20.0, 440.0, 6 },
+	// Eccentricity leaves [0, 1) through the drag
+	{ ver22312, 54.2028672, 1440.0, 20.0, 494.2028672, 1 },
+	// Semi-latus rectum below 0
+	{ ver33333, 0.0, 150.0, 5.0, 25.0, 4 },
+	// Eccentricity leaves [0, 1) through the lunar and solar terms
+	{ ver33334, 0.0, 1440.0, 1.0, 0.0, 3 },
+	// No mean motion
+	{ ver33335, 0.0, 1440.0, 20.0, 0.0, 2 }
+};
+
+// Deep space element sets run over several days, with how far their velocity may be off the rate of their position: SGP4 leaves
+// the short periodic terms and the drag out of the velocity, 23599 has a lot of drag
+struct Sgp4Track {
+	const char* const* tle;
+	double rateToleranceKmS;
+};
+
+static const Sgp4Track sgp4DeepSpaceTracks[] = { { ver08195, 1e-3 }, { ver21897, 1e-3 }, { ver26975, 1e-3 }, { ver28626, 1e-3 },
+	{ ver23599, 5e-3 } };
+
+// Size, shape and drag of one random orbit resembling the public catalog: mostly low earth orbits, some medium/highly elliptical
+// ones, geosynchronous ones. Perigees stay above 500 km, so none of them decays within the benchmarks.
+struct RandomOrbit {
+	double revPerDay;
+	// rad/min
+	double meanMotion;
+	double eccentricity;
+	double bstar;
+};
+
+static RandomOrbit drawRandomOrbit(std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	RandomOrbit o;
+	const double kind = unit(rng);
+	double maxEcc;
+	if (kind < 0.88) {
+		o.revPerDay = 11.5 + 3.0 * unit(rng);
+		maxEcc = 0.02;
+		o.bstar = 1e-4 * unit(rng);
+	}
+	else if (kind < 0.92) {
+		o.revPerDay = 2.0 + 4.0 * unit(rng);
+		maxEcc = 0.7;
+		o.bstar = 1e-4 * unit(rng);
+	}
+	else {
+		o.revPerDay = 0.99 + 0.02 * unit(rng);
+		maxEcc = 0.001;
+		o.bstar = 1e-5 * unit(rng);
+	}
+	o.meanMotion = o.revPerDay * 6.283185307179586 / 1440.0;
+	const double a = std::cbrt(sgp4Mu / (o.meanMotion * o.meanMotion / 3600.0));
+	o.eccentricity = std::max(0.0, std::min(maxEcc, 1.0 - (sgp4EarthRadius + 500.0) / a)) * unit(rng);
+	return o;
+}
+
+// Random elements of drawRandomOrbit, in random planes
+static void fillTleCatalog(Sgp4Constellation& catalog, size_t n, double epochJd, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double twoPi = 6.283185307179586;
+	catalog.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		TwoLineElements tle;
+		tle.catalogNumber = static_cast<unsigned int>(i + 1);
+		tle.epochJd = epochJd - 3.0 * unit(rng);
+		const RandomOrbit o = drawRandomOrbit(rng);
+		tle.meanMotion = o.meanMotion;
+		tle.eccentricity = o.eccentricity;
+		tle.bstar = o.bstar;
+		tle.inclination = unit(rng) * 3.14159;
+		tle.rightAscension = unit(rng) * twoPi;
+		tle.argPerigee = unit(rng) * twoPi;
+		tle.meanAnomaly = unit(rng) * twoPi;
+		catalog.add(tle);
+	}
+}
+
+// Largest difference of a state to a published vector (infinite if SGP4 failed on it)
+static void sgp4Deviation(const Sgp4Vector& test, int code, const double r[3], const double v[3], double& dr, double& dv)
+{
+	dr = (code == 0) ? 0.0 : HUGE_VAL;
+	dv = (code == 0 || !test.hasVelocity) ? 0.0 : HUGE_VAL;
+	for (int k = 0; k < 3 && code == 0; ++k) {
+		dr = std::max(dr, std::abs(r[k] - test.r[k]));
+		dv = std::max(dv, test.hasVelocity ? std::abs(v[k] - test.v[k]) : 0.0);
+	}
+}
+
+// Checks sgp4() and the batch on every instruction set against sgp4Vectors and sgp4ErrorCases, and the deep space integration
+// over several days. Prints a line per element set, returns the number of those that failed.
+static size_t verifySgp4(size_t& checked)
+{
+	const SimdLevel detected = getSimdLevel();
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+	size_t failed = 0;
+	checked = 0;
+	const size_t vectorCount = sizeof(sgp4Vectors) / sizeof(sgp4Vectors[0]);
+	for (size_t first = 0, last; first < vectorCount; first = last) {
+		last = first;
+		TwoLineElements tle;
+		const bool parsed = TwoLineElements::parse(sgp4Vectors[first].tle[0], sgp4Vectors[first].tle[1], tle);
+		double maxR = parsed ? 0.0 : HUGE_VAL, maxV = maxR, batchR = maxR, batchV = maxR;
+		for (; last < vectorCount && sgp4Vectors[last].tle == sgp4Vectors[first].tle; ++last) {
+			const Sgp4Vector& test = sgp4Vectors[last];
+			if (!parsed) {
+				continue;
+			}
+			Sgp4Record rec;
+			double r[3], v[3], dr, dv;
+			const int code = sgp4Init(tle, rec) ? sgp4(rec, test.tsince, r, v) : rec.error;
+			sgp4Deviation(test, code, r, v, dr, dv);
+			maxR = std::max(maxR, dr);
+			maxV = std::max(maxV, dv);
+			for (SimdLevel level : levels) {
+				setSimdLevel(level);
+				Sgp4Constellation single(tle.epochJd);
+				single.add(tle);
+				single.propagateTo(test.tsince * 60.0);
+				if (single.size() == 1) {
+					single.getStateKm(0, r, v);
+				}
+				sgp4Deviation(test, (single.size() == 1) ? single.getError(0) : -1, r, v, dr, dv);
+				batchR = std::max(batchR, dr);
+				batchV = std::max(batchV, dv);
+			}
+			setSimdLevel(detected);
+		}
+		const bool pass = std::max(maxR, batchR) <= sgp4ToleranceKm && std::max(maxV, batchV) <= sgp4ToleranceKmS;
+		failed += pass ? 0 : 1;
+		++checked;
+		cout << "  " << std::setw(5) << std::setfill('0') << tle.catalogNumber << std::setfill(' ') << ", " << (last - first)
+			<< " vectors: " << std::setprecision(2) << maxR << " km, " << maxV << " km/s off, batched " << batchR << " km, " << batchV
+			<< " km/s " << (pass ? "pass" : "FAIL") << "\n" << std::setprecision(6);
+	}
+
+	for (const Sgp4ErrorCase& test : sgp4ErrorCases) {
+		TwoLineElements tle;
+		const bool parsed = TwoLineElements::parse(test.tle[0], test.tle[1], tle);
+		Sgp4Record rec;
+		double t = 0.0, r[3], v[3];
+		int code = -1;
+		if (parsed && !sgp4Init(tle, rec)) {
+			code = rec.error;
+		}
+		else if (parsed) {
+			for (t = test.start; ; t = std::min(t + test.step, test.stop)) {
+				code = sgp4(rec, t, r, v);
+				if (code != 0 || t >= test.stop) {
+					break;
+				}
+			}
+		}
+		// add() refuses what sgp4Init() refuses, propagateTo() is still fine a step before the failure
+		bool batched = parsed;
+		if (test.failsAt == 0.0) {
+			Sgp4Constellation single(tle.epochJd);
+			batched = batched && !single.add(tle);
+		}
+		for (SimdLevel level : levels) {
+			if (test.failsAt == 0.0) {
+				break;
+			}
+			setSimdLevel(level);
+			Sgp4Constellation single(tle.epochJd);
+			batched = batched && single.add(tle);
+			if (batched) {
+				single.propagateTo((test.failsAt - test.step) * 60.0);
+				batched = single.getError(0) == 0;
+				single.propagateTo(test.failsAt * 60.0);
+				batched = batched && single.getError(0) == test.code;
+			}
+		}
+		setSimdLevel(detected);
+		const bool pass = code == test.code && std::abs(t - test.failsAt) < 1e-9 && batched;
+		failed += pass ? 0 : 1;
+		++checked;
+		cout << "  " << std::setw(5) << std::setfill('0') << tle.catalogNumber << std::setfill(' ') << ": error " << code << " at "
+			<< std::setprecision(10) << t << " min" << (batched ? "" : ", batched differently") << " " << (pass ? "pass" : "FAIL") << "\n"
+			<< std::setprecision(6);
+	}
+
+	// Resonant sets integrate their mean motion in the record (23599 is one without): going on from an earlier time (or back) must
+	// give what a fresh record gives, and the velocity has to be the rate of the position
+	for (const Sgp4Track& track : sgp4DeepSpaceTracks) {
+		TwoLineElements tle;
+		Sgp4Record stepped;
+		bool pass = TwoLineElements::parse(track.tle[0], track.tle[1], tle) && sgp4Init(tle, stepped);
+		double maxRate = 0.0;
+		const double h = 0.01;
+		for (int i = 0; i <= 36 + 12 && pass; ++i) {
+			// Three days on in 2 h steps, then back in 6 h ones
+			const double t = (i <= 36) ? 120.0 * i : 4320.0 - 360.0 * (i - 36);
+			Sgp4Record fresh, before, after;
+			sgp4Init(tle, fresh);
+			sgp4Init(tle, before);
+			sgp4Init(tle, after);
+			double r[3], v[3], rF[3], vF[3], rB[3], rA[3], unused[3];
+			pass = sgp4(stepped, t, r, v) == 0 && sgp4(fresh, t, rF, vF) == 0 && sgp4(before, t - h, rB, unused) == 0
+				&& sgp4(after, t + h, rA, unused) == 0;
+			pass = pass && std::memcmp(r, rF, sizeof(r)) == 0 && std::memcmp(v, vF, sizeof(v)) == 0;
+			for (int k = 0; k < 3; ++k) {
+				maxRate = std::max(maxRate, std::abs(v[k] - (rA[k] - rB[k]) / (2.0 * h * 60.0)));
+			}
+		}
+		pass = pass && stepped.deepSpace && maxRate <= track.rateToleranceKmS;
+		failed += pass ? 0 : 1;
+		++checked;
+		cout << "  " << std::setw(5) << std::setfill('0') << tle.catalogNumber << std::setfill(' ') << ", three days: "
+			<< (stepped.irez != 0 ? "resonant" : "not resonant") << ", velocity " << std::setprecision(2) << maxRate
+			<< " km/s off the rate of the position " << (pass ? "pass" : "FAIL") << "\n" << std::setprecision(6);
+	}
+	return failed;
+}
+
+// Average ms per propagateTo, a frame every 10 s
+static double timeSgp4Frames(Sgp4Constellation& catalog, unsigned int frames)
+{
+	catalog.propagateTo(0.0);
+	const auto t1 = std::chrono::steady_clock::now();
+	for (unsigned int f = 1; f <= frames; ++f) {
+		catalog.propagateTo(10.0 * f);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count() / frames;
+}
+
+void benchmarkSgp4()
+{
+	cout << "SGP4\n";
+	const SimdLevel detected = getSimdLevel();
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+	size_t checked;
+	const size_t failedChecks = verifySgp4(checked);
+	cout << "  verification: " << (checked - failedChecks) << " of " << checked << " passed\n";
+
+	const size_t n = 30000;
+	const unsigned int frames = 200;
+	const double referenceJd = 2461000.5;
+	Sgp4Constellation catalog(referenceJd);
+	fillTleCatalog(catalog, n, referenceJd, 10);
+	cout << "  " << catalog.size() << " element sets (" << catalog.getDeepSpaceCount() << " deep space), " << frames << " frames\n";
+	for (SimdLevel level : levels) {
+		setSimdLevel(level);
+		if (getSimdLevel() != level) {
+			continue;
+		}
+		cout << "  " << std::setw(8) << std::left << simdLevelName(level) << std::right << std::fixed << std::setprecision(2)
+			<< timeSgp4Frames(catalog, frames) << " ms/frame\n" << std::defaultfloat << std::setprecision(6);
+	}
+	setSimdLevel(detected);
+	ThreadPool pool;
+	catalog.setThreadPool(&pool);
+	cout << "  " << pool.getThreadCount() << " threads " << std::fixed << std::setprecision(2) << timeSgp4Frames(catalog, frames) << " ms/frame\n"
+		<< std::defaultfloat << std::setprecision(6);
+	catalog.setThreadPool(nullptr);
+
+	// Batched against sgp4() a day on
+	catalog.propagateTo(86400.0);
+	double maxDiff = 0.0;
+	size_t failed = 0;
+	for (size_t i = 0; i < n; ++i) {
+		Sgp4Record rec = catalog.getRecord(i);
+		double r[3], v[3], rb[3], vb[3];
+		const int code = sgp4(rec, 86400.0 / 60.0 - (rec.epochJd - referenceJd) * 1440.0, r, v);
+		catalog.getStateKm(i, rb, vb);
+		if (code != catalog.getError(i)) {
+			++failed;
+			continue;
+		}
+		// sgp4() leaves r and v as they were on these
+		if (code != 0 && code != 6) {
+			continue;
+		}
+		for (int k = 0; k < 3; ++k) {
+			maxDiff = std::max(maxDiff, std::abs(r[k] - rb[k]));
+		}
+	}
+	cout << "  after a day: largest difference of the batch to sgp4() " << maxDiff << " km, " << failed << " different error codes\n";
+}
+
+// Three line element sets in the CelesTrak format with the orbits of drawRandomOrbit. Every badEvery-th set gets a wrong checksum.
+static std::string makeTleCatalogText(size_t n, size_t badEvery, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::string text;
+	text.reserve(n * 166);
+	// 69 columns, room for the widest the formats below can print
+	char line[128];
+	for (size_t i = 0; i < n; ++i) {
+		const RandomOrbit o = drawRandomOrbit(rng);
+		const double revPerDay = o.revPerDay;
+		const double ecc = o.eccentricity;
+		const unsigned int number = static_cast<unsigned int>(i + 1);
+		std::snprintf(line, sizeof(line), "0 SAT-%05u\n", number);
+		text += line;
+		// Columns: 3-7 number, 19-32 epoch, 34-43 ndot, 45-52 nddot, 54-61 bstar, 65-68 element set number, 69 checksum
+		std::snprintf(line, sizeof(line), "1 %05uU 24001A   24%012.8f %c.%08d  00000-0  %05d-%d 0 %4d", number, 1.0 + 360.0 * unit(rng),
+			(unit(rng) < 0.5) ? '-' : ' ', static_cast<int>(unit(rng) * 10000.0), 10000 + static_cast<int>(unit(rng) * 89999.0),
+			4 + static_cast<int>(unit(rng) * 2.0), static_cast<int>(i % 1000));
+		int sum = TwoLineElements::checksum(line);
+		text.append(line, 68);
+		text += static_cast<char>('0' + sum);
+		text += '\n';
+		// Columns: 9-16 inclination, 18-25 node, 27-33 eccentricity, 35-42 perigee, 44-51 mean anomaly, 53-63 rev/day, 64-68 revolution
+		std::snprintf(line, sizeof(line), "2 %05u %8.4f %8.4f %07d %8.4f %8.4f %11.8f%5d", number, 180.0 * unit(rng), 359.0 * unit(rng),
+			static_cast<int>(ecc * 1e7), 359.0 * unit(rng), 359.0 * unit(rng), revPerDay, static_cast<int>(i % 100000));
+		sum = TwoLineElements::checksum(line);
+		if (badEvery > 0 && i % badEvery == badEvery - 1) {
+			sum = (sum + 1) % 10;
+		}
+		text.append(line, 68);
+		text += static_cast<char>('0' + sum);
+		text += '\n';
+	}
+	return text;
+}
+
+// ms to read the file line by line with std::getline and add every element set on its own
+static double loadTleWithStreams(const char* path, Sgp4Constellation& store)
+{
+	const auto t1 = std::chrono::steady_clock::now();
+	std::ifstream file(path);
+	std::string line, line1;
+	while (std::getline(file, line)) {
+		if (line.compare(0, 2, "1 ") == 0) {
+			line1 = line;
+		}
+		else if (line.compare(0, 2, "2 ") == 0 && !line1.empty()) {
+			TwoLineElements tle;
+			if (TwoLineElements::parse(line1.c_str(), line.c_str(), tle)) {
+				store.add(tle);
+			}
+			line1.clear();
+		}
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+}
+
+// Best of a few loads (a new store each time), the first one also warms the page cache
+static double timeTleLoads(TleCatalogLoader& loader, const char* path, unsigned int runs)
+{
+	// Each load reports the skipped element sets
+	std::streambuf* errors = std::cerr.rdbuf(nullptr);
+	double best = 1e30;
+	for (unsigned int k = 0; k < runs; ++k) {
+		Sgp4Constellation store(0.0);
+		loader.load(path, store);
+		best = std::min(best, loader.getStats().milliseconds);
+	}
+	std::cerr.rdbuf(errors);
+	return best;
+}
+
+void benchmarkTleLoader()
+{
+	cout << "TLE catalog loader\n";
+	const size_t n = 30000;
+	const size_t badEvery = 1000;
+	const std::string text = makeTleCatalogText(n, badEvery, 11);
+	const char* path = "benchmark_catalog.tle";
+	FILE* out = std::fopen(path, "wb");
+	if (out == nullptr || std::fwrite(text.data(), 1, text.size(), out) != text.size()) {
+		std::cerr << "Can not write " << path << std::endl;
+		if (out != nullptr) {
+			std::fclose(out);
+		}
+		return;
+	}
+	std::fclose(out);
+	const double megabytes = text.size() / (1024.0 * 1024.0);
+	cout << "  " << n << " element sets (3LE), " << std::fixed << std::setprecision(2) << megabytes << " MB, every " << badEvery
+		<< "th with a wrong checksum\n";
+
+	Sgp4Constellation streamed(0.0);
+	// The stream version reports every bad checksum on its own
+	std::streambuf* errors = std::cerr.rdbuf(nullptr);
+	const double streamMs = loadTleWithStreams(path, streamed);
+	std::cerr.rdbuf(errors);
+	cout << "  getline + parse + add " << streamMs << " ms\n";
+
+	TleCatalogLoader loader(nullptr);
+	const double sequentialMs = timeTleLoads(loader, path, 5);
+	cout << "  mapped, 1 thread      " << sequentialMs << " ms, " << megabytes / (sequentialMs / 1000.0) << " MB/s, "
+		<< std::setprecision(0) << loader.getStats().records / (sequentialMs / 1000.0) << " sets/s\n" << std::setprecision(2);
+	ThreadPool pool;
+	loader.setThreadPool(&pool);
+	const double pooledMs = timeTleLoads(loader, path, 5);
+	cout << "  mapped, " << std::setw(2) << pool.getThreadCount() << " threads    " << pooledMs << " ms, " << megabytes / (pooledMs / 1000.0)
+		<< " MB/s, " << std::setprecision(0) << loader.getStats().records / (pooledMs / 1000.0) << " sets/s\n" << std::defaultfloat << std::setprecision(6);
+
+	// The same satellites as the stream version, in the same order, with bit identical positions
+	Sgp4Constellation store(0.0);
+	loader.load(path, store);
+	const TleLoadStats& stats = loader.getStats();
+	bool identical = store.size() == streamed.size() && streamed.getRejectedCount() == stats.rejected;
+	store.setReferenceJd(stats.newestEpochJd);
+	streamed.setReferenceJd(stats.newestEpochJd);
+	store.propagateTo(3600.0);
+	streamed.propagateTo(3600.0);
+	for (size_t i = 0; identical && i < store.size(); ++i) {
+		double r[3], v[3], rs[3], vs[3];
+		store.getStateKm(i, r, v);
+		streamed.getStateKm(i, rs, vs);
+		identical = store.getRecord(i).catalogNumber == streamed.getRecord(i).catalogNumber && std::memcmp(r, rs, sizeof(r)) == 0
+			&& std::memcmp(v, vs, sizeof(v)) == 0;
+	}
+	cout << "  " << stats.records << " added, " << stats.checksumErrors << " checksum errors, " << stats.malformed << " malformed, "
+		<< stats.rejected << " rejected; first title \"" << loader.getName(0) << "\"; " << (identical ? "identical" : "DIFFERENT")
+		<< " to the stream version\n";
+	std::remove(path);
+}
+
+void benchmarkEphemerisFile()
+{
+	cout << "Ephemeris file\n";
+	const size_t n = 1000;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.5, 12);
+	std::vector<EphemerisTrack> tracks(n);
+	size_t points = 0;
+	const auto t1 = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < n; ++i) {
+		tracks[i].satelliteId = i;
+		tracks[i].elementsHash = EphemerisFile::hashElements(store.getEphemeris(i));
+		tracks[i].points = ConstellationState::sampleConic(store.getEphemeris(i));
+		points += tracks[i].points.size();
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+	const char* path = "benchmark_ephemeris.bin";
+	if (!EphemerisFile::write(path, tracks)) {
+		return;
+	}
+	const auto t3 = std::chrono::steady_clock::now();
+	EphemerisFile file;
+	file.open(path);
+	bool identical = file.isOpen();
+	for (size_t i = 0; i < n && identical; ++i) {
+		size_t count = 0;
+		const float* xyz = file.findTrack(i, tracks[i].elementsHash, count);
+		identical = xyz != nullptr && count == tracks[i].points.size() && std::memcmp(xyz, tracks[i].points.data(), count * 3 * sizeof(float)) == 0;
+	}
+	const auto t4 = std::chrono::steady_clock::now();
+	const auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+		return std::chrono::duration<double, std::milli>(b - a).count();
+	};
+	cout << "  " << n << " orbits, " << points << " points: live " << std::fixed << std::setprecision(2) << ms(t1, t2) << " ms, write "
+		<< ms(t2, t3) << " ms, open and check every track " << ms(t3, t4) << " ms" << std::defaultfloat << std::setprecision(6) << "; "
+		<< (identical ? "identical" : "DIFFERENT") << " to the live points\n";
+
+	// Changed elements and a damaged segment are computed live again, a damaged header makes the whole file unusable
+	size_t count = 0;
+	OrbitEphemeris moved = store.getEphemeris(1);
+	moved.inclination += 1e-9;
+	file.findTrack(1, EphemerisFile::hashElements(moved), count);
+	file.findTrack(n + 5, 0, count);
+	cout << "  changed elements: " << file.getStale() << " stale, unknown satellite: " << file.getMisses() << " missing\n";
+	file.close();
+	FILE* damaged = std::fopen(path, "r+b");
+	std::vector<char> bytes(8, 0x55);
+	if (damaged != nullptr) {
+		std::fseek(damaged, -64, SEEK_END);
+		std::fwrite(bytes.data(), 1, bytes.size(), damaged);
+		std::fclose(damaged);
+	}
+	file.open(path);
+	for (size_t i = 0; i < n; ++i) {
+		file.findTrack(i, tracks[i].elementsHash, count);
+	}
+	cout << "  after changing the last segment: " << file.getHits() << " found, " << file.getCorrupt() << " corrupt; ";
+	file.close();
+	damaged = std::fopen(path, "r+b");
+	if (damaged != nullptr) {
+		std::fseek(damaged, 20, SEEK_SET);
+		std::fwrite(bytes.data(), 1, 1, damaged);
+		std::fclose(damaged);
+	}
+	// The open reports it
+	std::streambuf* errors = std::cerr.rdbuf(nullptr);
+	const bool opened = file.open(path);
+	std::cerr.rdbuf(errors);
+	cout << "changed header " << (opened ? "OPENED" : "rejected") << "\n";
+	std::remove(path);
+}
+
+// Largest distance (km) between the Chebyshev positions and the Kepler solution at t
+static double maxChebyshevDeviation(ChebyshevEphemeris& cheb, ConstellationState& store, double t)
+{
+	cheb.update(t);
+	store.seek(t);
+	double maxDev = 0.0;
+	for (size_t i = 0; i < store.size(); ++i) {
+		double r[3], v[3], p[3];
+		store.getStateKm(i, r, v);
+		cheb.getPositionKm(i, p);
+		maxDev = std::max(maxDev, std::sqrt((p[0] - r[0]) * (p[0] - r[0]) + (p[1] - r[1]) * (p[1] - r[1]) + (p[2] - r[2]) * (p[2] - r[2])));
+	}
+	return maxDev;
+}
+
+void benchmarkChebyshev()
+{
+	cout << "Chebyshev ephemeris\n";
+	const size_t n = 20000;
+	const unsigned int frames = 200;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.7, 13);
+	for (size_t i = 0; i < n; i += 2) {
+		store.setForceModel(i, ForceModel::J2Secular);
+	}
+	const double keplerNs = timePropagation(store, frames, 10.0);
+	cout << "  " << n << " satellites (e < 0.7, half with J2 drift), Kepler " << std::fixed << std::setprecision(1)
+		<< keplerNs << " ns/satellite\n";
+	const double tolerances[] = { 1e-1, 1e-3, 1e-5 };
+	for (double tolerance : tolerances) {
+		ChebyshevEphemeris cheb(store);
+		cheb.setTolerance(tolerance);
+		const auto t1 = std::chrono::steady_clock::now();
+		cheb.fitNow(0.0);
+		const auto t2 = std::chrono::steady_clock::now();
+		for (unsigned int f = 1; f <= frames; ++f) {
+			cheb.update(10.0 * f);
+		}
+		const auto t3 = std::chrono::steady_clock::now();
+		const double fitMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		const double evalNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / (static_cast<double>(frames) * n);
+		// Within the first windows, at times between the nodes
+		double maxDev = 0.0;
+		for (double t : { 17.3, 333.3, 1234.5 }) {
+			maxDev = std::max(maxDev, maxChebyshevDeviation(cheb, store, t));
+		}
+		cout << "  tolerance " << std::scientific << std::setprecision(0) << tolerance << " km: fit " << std::fixed << std::setprecision(1)
+			<< fitMs << " ms (" << fitMs * 1000.0 / n << " us/window), " << evalNs
+			<< " ns/satellite, largest deviation " << std::scientific << std::setprecision(2) << maxDev << " km\n"
+			<< std::defaultfloat << std::setprecision(6);
+	}
+
+	// A day at 60 s per frame, a frame every 4 ms: the fitter thread refits ahead in between, frames only solve directly what it has
+	// not done yet. Unpaced, the frames would outrun a single fitter.
+	ChebyshevEphemeris cheb(store);
+	cheb.fitNow(0.0);
+	size_t directSolves = 0;
+	double updateMs = 0.0;
+	double worstFrameMs = 0.0;
+	for (double t = 0.0; t < 86400.0; t += 60.0) {
+		const auto f1 = std::chrono::steady_clock::now();
+		cheb.update(t);
+		const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - f1).count();
+		updateMs += frameMs;
+		worstFrameMs = std::max(worstFrameMs, frameMs);
+		directSolves += cheb.getStats().directSolves;
+		std::this_thread::sleep_until(f1 + std::chrono::milliseconds(4));
+	}
+	cheb.waitForFits();
+	const double endDev = maxChebyshevDeviation(cheb, store, 86400.0 - 30.0);
+	cout << "  one day in 1440 frames, one every 4 ms: updates " << std::fixed << std::setprecision(1) << updateMs << " ms, slowest frame "
+		<< worstFrameMs << " ms, " << directSolves << " direct solves, " << cheb.getStats().fits << " windows fitted, deviation at the end "
+		<< std::scientific << std::setprecision(2) << endDev << " km\n" << std::defaultfloat << std::setprecision(6);
+
+	// Satellites added to the store later on (as the scene does): taken without dropping the windows fitted so far
+	const size_t fitsBefore = cheb.getStats().fits;
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	for (size_t k = 0; k < 1000; ++k) {
+		store.add(OrbitEphemeris(7000.0 + 30000.0 * unit(rng), 0.5 * unit(rng), unit(rng) * 3.14159, unit(rng) * 6.28318, unit(rng) * 6.28318, 0.0));
+	}
+	cheb.addOrbits(store);
+	const double addedDev = maxChebyshevDeviation(cheb, store, 86400.0 - 20.0);
+	const size_t addedDirect = cheb.getStats().directSolves;
+	cheb.waitForFits();
+	const double fittedDev = maxChebyshevDeviation(cheb, store, 86400.0 - 10.0);
+	cout << "  1000 satellites added: " << cheb.size() << " tracked, " << addedDirect << " direct solves, deviation " << std::scientific
+		<< std::setprecision(2) << addedDev << " km, " << cheb.getStats().fits - fitsBefore << " windows fitted, then " << fittedDev << " km\n"
+		<< std::defaultfloat << std::setprecision(6);
+}
+
+// Largest distance (km) between the chords of an orbit line (render frame, closed) and the conic of o, 8 points per chord
+static double maxChordErrorKm(const CompiledOrbit& o, const std::vector<Vector>& points)
+{
+	const double hX = o.r0[1] * o.v0[2] - o.r0[2] * o.v0[1];
+	const double hY = o.r0[2] * o.v0[0] - o.r0[0] * o.v0[2];
+	const double hZ = o.r0[0] * o.v0[1] - o.r0[1] * o.v0[0];
+	const double p = (hX * hX + hY * hY + hZ * hZ) / mu;
+	const double twoPi = 6.283185307179586;
+	double maxError = 0.0;
+	for (size_t k = 0; k < points.size(); ++k) {
+		const Vector& a = points[k];
+		const Vector& b = points[(k + 1) % points.size()];
+		const double ax = a.X / sizeFactor, ay = a.Y / sizeFactor, az = a.Z / sizeFactor;
+		const double abx = b.X / sizeFactor - ax, aby = b.Y / sizeFactor - ay, abz = b.Z / sizeFactor - az;
+		const double abLength2 = abx * abx + aby * aby + abz * abz;
+		const double nuA = std::atan2(ax * o.q[0] + ay * o.q[1] + az * o.q[2], ax * o.p[0] + ay * o.p[1] + az * o.p[2]);
+		const double nuB = std::atan2(b.X * o.q[0] + b.Y * o.q[1] + b.Z * o.q[2], b.X * o.p[0] + b.Y * o.p[1] + b.Z * o.p[2]);
+		const double dNu = std::remainder(nuB - nuA, twoPi);
+		for (int j = 1; j < 8; ++j) {
+			const double nu = nuA + dNu * j / 8.0;
+			const double r = p / (1.0 + o.eccentricity * std::cos(nu));
+			const double c = std::cos(nu) * r, s = std::sin(nu) * r;
+			const double dx = c * o.p[0] + s * o.q[0] - ax, dy = c * o.p[1] + s * o.q[1] - ay, dz = c * o.p[2] + s * o.q[2] - az;
+			// distance to the segment from a to b
+			const double along = (abLength2 > 0.0) ? std::max(0.0, std::min(1.0, (dx * abx + dy * aby + dz * abz) / abLength2)) : 0.0;
+			const double ex = dx - along * abx, ey = dy - along * aby, ez = dz - along * abz;
+			maxError = std::max(maxError, std::sqrt(ex * ex + ey * ey + ez * ez));
+		}
+	}
+	return maxError;
+}
+
+void benchmarkOrbitLines()
+{
+	cout << "Orbit lines\n";
+	const size_t n = 1000;
+	ConstellationState store;
+	fillCatalog(store, n, 0.0, 0.9, 14);
+	const auto measure = [&store, n](const char* name, const std::function<std::vector<Vector>(const OrbitEphemeris&)>& sample) {
+		std::vector<std::vector<Vector>> lines(n);
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < n; ++i) {
+			lines[i] = sample(store.getEphemeris(i));
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		size_t points = 0;
+		double maxError = 0.0;
+		for (size_t i = 0; i < n; ++i) {
+			points += lines[i].size();
+			maxError = std::max(maxError, maxChordErrorKm(store.getCompiledOrbit(i), lines[i]));
+		}
+		cout << "  " << name << ": " << std::fixed << std::setprecision(1) << ms << " ms, " << static_cast<double>(points) / n
+			<< " points/orbit, largest chord error " << std::setprecision(3) << maxError << " km" << std::defaultfloat << std::setprecision(6) << "\n";
+	};
+	cout << "  " << n << " orbits, e < 0.9\n";
+	measure("Kepler solve every 120 s", [](const OrbitEphemeris& eph) { return ConstellationState::sampleOrbit(eph, 120.0); });
+	measure("Kepler solve every 30 s", [](const OrbitEphemeris& eph) { return ConstellationState::sampleOrbit(eph, 30.0); });
+	measure("conic, 10 km", [](const OrbitEphemeris& eph) { return ConstellationState::sampleConic(eph, 10.0); });
+	measure("conic, 2 km", [](const OrbitEphemeris& eph) { return ConstellationState::sampleConic(eph, 2.0); });
+	measure("conic, 0.5 km", [](const OrbitEphemeris& eph) { return ConstellationState::sampleConic(eph, 0.5); });
+}
+
+void runBenchmarks()
+{
+	cout << "Kepler kernels: " << simdLevelName(getSimdLevel()) << "\n";
+	benchmarkKeplerPaths();
+	benchmarkUniversalSolver();
+	benchmarkCompiledOrbit();
+	benchmarkStumpff();
+	benchmarkThreadPool();
+	benchmarkTimeline();
+	benchmarkJ2Secular();
+	benchmarkRungeKutta();
+	benchmarkSgp4();
+	benchmarkTleLoader();
+	benchmarkEphemerisFile();
+	benchmarkChebyshev();
+	benchmarkOrbitLines();
+}
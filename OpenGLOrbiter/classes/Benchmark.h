@@ -0,0 +1,57 @@
+//Author: Bernhard Luedtke
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+// Console benchmarks for the propagation code. Started with "OpenGLOrbiter --bench", no window is opened.
+// All catalogs are generated from a fixed seed, so runs are comparable.
+void runBenchmarks();
+
+// ns per propagation of the universal variable and the elliptic (eccentric anomaly) path, per instruction set
+void benchmarkKeplerPaths();
+
+// Iterations per solve of the universal variable solver with cold and warm starts, Laguerre fallbacks and f/g check failures
+void benchmarkUniversalSolver();
+
+// ns per scalar solve with the invariants read through OrbitEphemeris every Newton step, against the same solve on a CompiledOrbit
+void benchmarkCompiledOrbit();
+
+// Largest relative error of C(z), S(z) and ns per evaluation for every StumpffMode, and the universal variable propagation with each of them
+void benchmarkStumpff();
+
+// Propagation of 100k satellites on 1, 2, 4, ... threads of a ThreadPool: ms per tick, speedup, and whether every result
+// is bit identical to the single threaded one
+void benchmarkThreadPool();
+
+// Scrubbing through a week of checkpointed, stepped propagation: time to go forwards, checkpoints kept within the budget,
+// latency of random and backwards seeks, and whether a seek ends bit identical to the uninterrupted run
+void benchmarkTimeline();
+
+// ns per satellite with and without the J2 secular drift on the same catalog, the drifted state against the two body state
+// of the drifted elements, and the node drift of the ISS and of a sun synchronous orbit
+void benchmarkJ2Secular();
+
+// One day of the same catalog integrated with RKF45 (two body, scalar and vectorized, and J2) against the Kepler propagation:
+// time, steps per satellite, distance to the Kepler positions, and the dense output after a Timeline seek
+void benchmarkRungeKutta();
+
+// SGP4 against the published verification vectors (scalar and batched), and ms per frame for a catalog of 30k element sets
+// (about the size of the public one) per instruction set and on a ThreadPool
+void benchmarkSgp4();
+
+// Loading a generated catalog of 30k three line element sets: std::getline against the memory mapped loader on one thread and
+// on a ThreadPool (ms, MB/s, element sets/s), the skipped bad checksums, and whether both give the same satellites
+void benchmarkTleLoader();
+
+// Orbit lines of 1000 satellites sampled live against writing them to an EphemerisFile and reading them back (mapped):
+// ms for each, whether the points are the same, and how changed elements and damaged segments or headers are caught
+void benchmarkEphemerisFile();
+
+// Piecewise Chebyshev positions against the Kepler propagation of the same catalog: fit time, segments, ns per satellite and the
+// largest deviation per tolerance, and a simulated day with background refits (direct solves, slowest frame)
+void benchmarkChebyshev();
+
+// Orbit lines of 1000 satellites (e < 0.9) solved every 120 s and 30 s against the conic sampled by curvature for three
+// tolerances: ms, points per orbit and the largest distance of a chord from the conic
+void benchmarkOrbitLines();
+
+#endif /* Benchmark_hpp */
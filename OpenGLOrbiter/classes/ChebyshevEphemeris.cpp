@@ -0,0 +1,483 @@
+//Author: Bernhard Luedtke
+
+#include "ChebyshevEphemeris.h"
+#include "ConstellationState.h"
+#include "OrbitConstants.h"
+#include "ThreadPool.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <functional>
+
+// Segments are not made shorter than this (s), a segment that still misses the tolerance is kept anyway
+static const double chebyshevMinSegment = 1.0;
+// Jobs a fitter takes from the queue at once
+static const size_t fitterBatch = 64;
+
+ChebyshevEphemeris::ChebyshevEphemeris(const ConstellationState& source, unsigned int fitterThreads) : fitterCount((fitterThreads > 0) ? fitterThreads : 1)
+{
+	setOrbits(source);
+}
+
+ChebyshevEphemeris::~ChebyshevEphemeris()
+{
+	stopFitters();
+}
+
+void ChebyshevEphemeris::startFitters(unsigned int count)
+{
+	stopping = false;
+	for (unsigned int k = 0; k < count; ++k) {
+		fitters.emplace_back(&ChebyshevEphemeris::fitterLoop, this);
+	}
+}
+
+void ChebyshevEphemeris::stopFitters()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+		stopping = true;
+		queue.clear();
+	}
+	queueSignal.notify_all();
+	for (std::thread& t : fitters) {
+		t.join();
+	}
+	fitters.clear();
+}
+
+void ChebyshevEphemeris::setOrbits(const ConstellationState& source)
+{
+	stopFitters();
+	const size_t n = source.size();
+	orbits.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		orbits[i] = source.getCompiledOrbit(i);
+	}
+	// Tracks hold atomics, they are built in place
+	std::vector<Track> fresh(n);
+	tracks.swap(fresh);
+	rX.assign(n, 0.0); rY.assign(n, 0.0); rZ.assign(n, 0.0);
+	segmentStart.assign(n, 0.0); segmentLimit.assign(n, 0.0);
+	segmentMid.assign(n, 0.0); segmentScale.assign(n, 0.0);
+	missed.assign(n, 0.0);
+	for (std::vector<double>* axis : { columns[0], columns[1], columns[2] }) {
+		for (unsigned int k = 0; k <= chebyshevMaxDegree; ++k) {
+			axis[k].clear();
+		}
+		axis[0].assign(n, 0.0);
+	}
+	columnDegree = 0;
+	stats = ChebyshevStats();
+	fitCount = 0;
+	fitSegments = 0;
+	fitMaxError = 0.0;
+	fitMaxDegree = 0;
+	startFitters(fitterCount);
+}
+
+void ChebyshevEphemeris::addOrbits(const ConstellationState& source)
+{
+	const size_t old = orbits.size();
+	const size_t n = source.size();
+	if (n <= old) {
+		return;
+	}
+	// The fitters write into the tracks, nothing may be queued or in progress while they move
+	waitForFits();
+	orbits.resize(n);
+	for (size_t i = old; i < n; ++i) {
+		orbits[i] = source.getCompiledOrbit(i);
+	}
+	std::vector<Track> grown(n);
+	for (size_t i = 0; i < old; ++i) {
+		grown[i].windows[0] = std::move(tracks[i].windows[0]);
+		grown[i].windows[1] = std::move(tracks[i].windows[1]);
+		grown[i].current = tracks[i].current;
+		grown[i].nextState.store(tracks[i].nextState.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+	tracks.swap(grown);
+	rX.resize(n, 0.0); rY.resize(n, 0.0); rZ.resize(n, 0.0);
+	segmentStart.resize(n, 0.0); segmentLimit.resize(n, 0.0);
+	segmentMid.resize(n, 0.0); segmentScale.resize(n, 0.0);
+	missed.resize(n, 0.0);
+	for (std::vector<double>* axis : { columns[0], columns[1], columns[2] }) {
+		for (unsigned int k = 0; k <= columnDegree; ++k) {
+			axis[k].resize(n, 0.0);
+		}
+	}
+}
+
+void ChebyshevEphemeris::growColumns(unsigned int d)
+{
+	for (std::vector<double>* axis : { columns[0], columns[1], columns[2] }) {
+		for (unsigned int k = columnDegree + 1; k <= d; ++k) {
+			axis[k].assign(orbits.size(), 0.0);
+		}
+	}
+	columnDegree = d;
+}
+
+void ChebyshevEphemeris::loadSegment(size_t i, const Window& w, unsigned int s, double refitAt)
+{
+	const double length = w.segmentLength;
+	const double begin = w.start + s * length;
+	const double end = (s + 1 < w.segments) ? begin + length : w.end;
+	segmentStart[i] = begin;
+	segmentLimit[i] = (refitAt < end) ? refitAt : end;
+	segmentMid[i] = begin + 0.5 * length;
+	segmentScale[i] = 2.0 / length;
+	const unsigned int n = w.degree + 1;
+	const double* c = &w.coefficients[static_cast<size_t>(s) * 3 * n];
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		for (unsigned int k = 0; k <= columnDegree; ++k) {
+			columns[axis][k][i] = (k <= w.degree) ? c[axis * n + k] : 0.0;
+		}
+	}
+}
+
+void ChebyshevEphemeris::setTolerance(double km)
+{
+	std::lock_guard<std::mutex> lock(queueLock);
+	tolerance = (km > 0.0) ? km : tolerance;
+}
+
+void ChebyshevEphemeris::setDegree(unsigned int d)
+{
+	std::lock_guard<std::mutex> lock(queueLock);
+	degree = (d < 4) ? 4 : ((d > chebyshevMaxDegree) ? chebyshevMaxDegree : d);
+}
+
+// Sum of c[k] * T_k(tau) for k = 0..degree, for x, y and z of one segment at once.
+// Clenshaw's recurrence would be one chain of degree dependent steps per coordinate. Instead T_k comes from
+// T_2k = 2 T_k^2 - 1 and T_2k+1 = 2 T_k T_k+1 - tau (each only log2(k) steps deep, as exact as the recurrence on [-1, 1]),
+// shared by the three coordinates, and the sums run in two independent halves.
+static inline void evaluateSegment(const double* c, unsigned int degree, double tau, double r[3])
+{
+	const unsigned int n = degree + 1;
+	double t[chebyshevMaxDegree + 2];
+	t[0] = 1.0;
+	t[1] = tau;
+	for (unsigned int k = 2; k <= degree; ++k) {
+		const unsigned int h = k / 2;
+		t[k] = (k % 2 == 0) ? 2.0 * t[h] * t[h] - 1.0 : 2.0 * t[h] * t[h + 1] - tau;
+	}
+	double x0 = 0.0, x1 = 0.0, y0 = 0.0, y1 = 0.0, z0 = 0.0, z1 = 0.0;
+	unsigned int k = 0;
+	for (; k + 1 <= degree; k += 2) {
+		x0 += c[k] * t[k]; x1 += c[k + 1] * t[k + 1];
+		y0 += c[n + k] * t[k]; y1 += c[n + k + 1] * t[k + 1];
+		z0 += c[2 * n + k] * t[k]; z1 += c[2 * n + k + 1] * t[k + 1];
+	}
+	if (k <= degree) {
+		x0 += c[k] * t[k];
+		y0 += c[n + k] * t[k];
+		z0 += c[2 * n + k] * t[k];
+	}
+	r[0] = x0 + x1;
+	r[1] = y0 + y1;
+	r[2] = z0 + z1;
+}
+
+/*
+	Interpolation at the Chebyshev nodes tau_j = cos(pi (j + 1/2) / n), j = 0..n-1 (n = degree + 1):
+	c_k = 2/n * sum_j f(tau_j) cos(k pi (j + 1/2) / n), c_0 halved.
+	The error is largest near the extrema of T_n, tau_m = cos(pi m / n), m = 0..n (the segment ends included); it is checked there.
+*/
+void ChebyshevEphemeris::fitWindow(const CompiledOrbit& o, double start, double segmentLength, const FitSettings& settings, Window& w, ChunkResult& result) const
+{
+	const unsigned int n = settings.degree + 1;
+	double basis[(chebyshevMaxDegree + 1) * (chebyshevMaxDegree + 1)];
+	double nodes[chebyshevMaxDegree + 1];
+	double checks[chebyshevMaxDegree + 2];
+	for (unsigned int j = 0; j < n; ++j) {
+		nodes[j] = std::cos(M_PI * (j + 0.5) / n);
+		for (unsigned int k = 0; k < n; ++k) {
+			basis[k * n + j] = std::cos(M_PI * k * (j + 0.5) / n);
+		}
+	}
+	for (unsigned int m = 0; m <= n; ++m) {
+		checks[m] = std::cos(M_PI * m / n);
+	}
+	// The longest segment: half a period (or an hour for orbits that are not closed)
+	const double longest = (o.period > 0.0) ? 0.5 * o.period : 3600.0;
+	// First guess: a quarter period (10 minutes)
+	double length = (segmentLength > 0.0) ? segmentLength : ((o.period > 0.0) ? 0.25 * o.period : 600.0);
+	length = (length > longest) ? longest : length;
+	w.coefficients.resize(static_cast<size_t>(settings.segments) * 3 * n);
+	double values[3][chebyshevMaxDegree + 1];
+	double maxError = 0.0;
+	for (;;) {
+		bool accepted = true;
+		maxError = 0.0;
+		for (unsigned int s = 0; s < settings.segments && accepted; ++s) {
+			const double half = 0.5 * length;
+			const double mid = start + s * length + half;
+			for (unsigned int j = 0; j < n; ++j) {
+				double r[3], v[3];
+				ConstellationState::stateAt(o, mid + half * nodes[j], r, v);
+				values[0][j] = r[0]; values[1][j] = r[1]; values[2][j] = r[2];
+			}
+			double* c = &w.coefficients[static_cast<size_t>(s) * 3 * n];
+			for (unsigned int axis = 0; axis < 3; ++axis) {
+				for (unsigned int k = 0; k < n; ++k) {
+					double sum = 0.0;
+					for (unsigned int j = 0; j < n; ++j) {
+						sum += values[axis][j] * basis[k * n + j];
+					}
+					c[axis * n + k] = ((k == 0) ? 1.0 : 2.0) * sum / n;
+				}
+			}
+			for (unsigned int m = 0; m <= n; ++m) {
+				double p[3], r[3], v[3];
+				evaluateSegment(c, settings.degree, checks[m], p);
+				ConstellationState::stateAt(o, mid + half * checks[m], r, v);
+				const double error = std::sqrt((p[0] - r[0]) * (p[0] - r[0]) + (p[1] - r[1]) * (p[1] - r[1]) + (p[2] - r[2]) * (p[2] - r[2]));
+				maxError = (error > maxError) ? error : maxError;
+			}
+			accepted = maxError <= settings.tolerance;
+		}
+		if (accepted || length <= chebyshevMinSegment) {
+			break;
+		}
+		length *= 0.5;
+	}
+	w.start = start;
+	w.end = start + settings.segments * length;
+	w.segmentLength = length;
+	w.degree = settings.degree;
+	w.segments = settings.segments;
+	// Far below the tolerance: the next window tries segments twice as long
+	w.nextSegmentLength = (maxError < settings.tolerance / 64.0 && 2.0 * length <= longest) ? 2.0 * length : length;
+	result.segments += settings.segments;
+	result.maxError = (maxError > result.maxError) ? maxError : result.maxError;
+}
+
+void ChebyshevEphemeris::fitterLoop()
+{
+	std::vector<Job> batch;
+	ChunkResult result;
+	std::unique_lock<std::mutex> lock(queueLock);
+	for (;;) {
+		queueSignal.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (stopping) {
+			return;
+		}
+		batch.clear();
+		while (!queue.empty() && batch.size() < fitterBatch) {
+			batch.push_back(queue.front());
+			queue.pop_front();
+		}
+		const FitSettings settings = { tolerance, degree, windowSegments };
+		++busyFitters;
+		lock.unlock();
+		result.segments = 0;
+		result.maxError = 0.0;
+		for (const Job& job : batch) {
+			// The next window is the fitters' until it is flagged ready
+			Track& track = tracks[job.satellite];
+			fitWindow(orbits[job.satellite], job.start, job.segmentLength, settings, track.windows[1 - track.current], result);
+			track.nextState.store(NextReady, std::memory_order_release);
+		}
+		lock.lock();
+		--busyFitters;
+		fitCount += batch.size();
+		fitSegments += result.segments;
+		fitMaxError = (result.maxError > fitMaxError) ? result.maxError : fitMaxError;
+		fitMaxDegree = (settings.degree > fitMaxDegree) ? settings.degree : fitMaxDegree;
+		if (queue.empty() && busyFitters == 0) {
+			idleSignal.notify_all();
+		}
+	}
+}
+
+void ChebyshevEphemeris::waitForFits()
+{
+	std::unique_lock<std::mutex> lock(queueLock);
+	idleSignal.wait(lock, [this] { return stopping || (queue.empty() && busyFitters == 0); });
+}
+
+void ChebyshevEphemeris::fitNow(double t)
+{
+	waitForFits();
+	FitSettings settings;
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+		settings = { tolerance, degree, windowSegments };
+	}
+	const size_t n = orbits.size();
+	const size_t chunks = (n + chunkSize - 1) / chunkSize;
+	chunkResults.resize(chunks);
+	const std::function<void(size_t, size_t, size_t)> body = [this, t, &settings](size_t begin, size_t end, size_t chunk) {
+		ChunkResult& result = chunkResults[chunk];
+		result.segments = 0;
+		result.maxError = 0.0;
+		for (size_t i = begin; i < end; ++i) {
+			Track& track = tracks[i];
+			Window& w = track.windows[track.current];
+			fitWindow(orbits[i], t, w.nextSegmentLength, settings, w, result);
+			// A next window fitted before belongs to another time
+			track.nextState.store(NextEmpty, std::memory_order_relaxed);
+			// The columns still hold a segment of the window that was replaced
+			segmentStart[i] = 0.0;
+			segmentLimit[i] = 0.0;
+		}
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(n, chunkSize, body);
+	}
+	else {
+		for (size_t c = 0; c < chunks; ++c) {
+			const size_t begin = c * chunkSize;
+			body(begin, (begin + chunkSize < n) ? begin + chunkSize : n, c);
+		}
+	}
+	std::lock_guard<std::mutex> lock(queueLock);
+	fitCount += n;
+	fitMaxDegree = (settings.degree > fitMaxDegree) ? settings.degree : fitMaxDegree;
+	for (size_t c = 0; c < chunks; ++c) {
+		fitSegments += chunkResults[c].segments;
+		fitMaxError = (chunkResults[c].maxError > fitMaxError) ? chunkResults[c].maxError : fitMaxError;
+	}
+}
+
+void ChebyshevEphemeris::updateRange(const ChebyshevArrays& a, size_t begin, size_t end, double t, ChunkResult& result)
+{
+	size_t left = evaluateChebyshevBatch(a, begin, end, t);
+	result.evaluated += (end - begin) - left;
+	for (size_t i = begin; i < end && left > 0; ++i) {
+		if (missed[i] != 0.0) {
+			attend(i, t, result);
+			--left;
+		}
+	}
+}
+
+void ChebyshevEphemeris::attend(size_t i, double t, ChunkResult& result)
+{
+	Track& track = tracks[i];
+	unsigned char state = track.nextState.load(std::memory_order_acquire);
+	const Window* w = &track.windows[track.current];
+	const bool covered = t >= w->start && t < w->end;
+	if (state == NextReady) {
+		const Window& next = track.windows[1 - track.current];
+		if (t >= next.start && t < next.end) {
+			track.current ^= 1;
+			w = &next;
+			state = NextEmpty;
+		}
+		else if (!covered) {
+			// Fitted for a time that has been left already (seeking)
+			state = NextEmpty;
+		}
+		track.nextState.store(state, std::memory_order_relaxed);
+	}
+	double r[3];
+	if (t >= w->start && t < w->end) {
+		unsigned int s = static_cast<unsigned int>((t - w->start) / w->segmentLength);
+		s = (s < w->segments) ? s : w->segments - 1;
+		// Halfway through: the next window is fitted while this one is still in use
+		const double halfway = 0.5 * (w->start + w->end);
+		if (state == NextEmpty && t >= halfway) {
+			result.jobs.push_back(Job{ i, w->end, w->nextSegmentLength });
+			track.nextState.store(NextQueued, std::memory_order_relaxed);
+			state = NextQueued;
+		}
+		const double begin = w->start + s * w->segmentLength;
+		const double tau = (t - (begin + 0.5 * w->segmentLength)) * (2.0 / w->segmentLength);
+		evaluateSegment(&w->coefficients[static_cast<size_t>(s) * 3 * (w->degree + 1)], w->degree, tau, r);
+		++result.evaluated;
+		if (w->degree <= columnDegree) {
+			loadSegment(i, *w, s, (state == NextEmpty) ? halfway : HUGE_VAL);
+		}
+		else {
+			// Fitted with a higher degree since this update() started, the columns grow at the next one
+			segmentStart[i] = 0.0;
+			segmentLimit[i] = 0.0;
+		}
+	}
+	else {
+		double v[3];
+		ConstellationState::stateAt(orbits[i], t, r, v);
+		++result.directSolves;
+		if (state == NextEmpty) {
+			result.jobs.push_back(Job{ i, t, w->nextSegmentLength });
+			track.nextState.store(NextQueued, std::memory_order_relaxed);
+		}
+		// Back here every update() until a window covers t
+		segmentStart[i] = 0.0;
+		segmentLimit[i] = 0.0;
+	}
+	rX[i] = r[0]; rY[i] = r[1]; rZ[i] = r[2];
+}
+
+void ChebyshevEphemeris::update(double t)
+{
+	const size_t n = orbits.size();
+	const size_t chunks = (n + chunkSize - 1) / chunkSize;
+	chunkResults.resize(chunks);
+	unsigned int fitted;
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+		fitted = fitMaxDegree;
+	}
+	if (fitted > columnDegree) {
+		growColumns(fitted);
+	}
+	ChebyshevArrays a;
+	a.start = segmentStart.data(); a.limit = segmentLimit.data();
+	a.mid = segmentMid.data(); a.scale = segmentScale.data();
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		for (unsigned int k = 0; k <= columnDegree; ++k) {
+			a.c[axis][k] = columns[axis][k].data();
+		}
+	}
+	a.degree = columnDegree;
+	a.r[0] = rX.data(); a.r[1] = rY.data(); a.r[2] = rZ.data();
+	a.missed = missed.data();
+	// Each chunk only touches its own satellites and its own result
+	const std::function<void(size_t, size_t, size_t)> body = [this, t, &a](size_t begin, size_t end, size_t chunk) {
+		ChunkResult& result = chunkResults[chunk];
+		result.evaluated = 0;
+		result.directSolves = 0;
+		result.jobs.clear();
+		updateRange(a, begin, end, t, result);
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(n, chunkSize, body);
+	}
+	else {
+		for (size_t c = 0; c < chunks; ++c) {
+			const size_t begin = c * chunkSize;
+			body(begin, (begin + chunkSize < n) ? begin + chunkSize : n, c);
+		}
+	}
+	stats.evaluated = 0;
+	stats.directSolves = 0;
+	stats.queued = 0;
+	{
+		std::lock_guard<std::mutex> lock(queueLock);
+		for (size_t c = 0; c < chunks; ++c) {
+			const ChunkResult& result = chunkResults[c];
+			stats.evaluated += result.evaluated;
+			stats.directSolves += result.directSolves;
+			stats.queued += result.jobs.size();
+			queue.insert(queue.end(), result.jobs.begin(), result.jobs.end());
+		}
+		stats.fits = fitCount;
+		stats.segments = fitSegments;
+		stats.maxFitError = fitMaxError;
+	}
+	if (stats.queued > 0) {
+		queueSignal.notify_all();
+	}
+}
+
+void ChebyshevEphemeris::getPositionKm(size_t i, double r[3]) const
+{
+	r[0] = rX[i]; r[1] = rY[i]; r[2] = rZ[i];
+}
+
+Vector ChebyshevEphemeris::getR(size_t i) const
+{
+	return Vector(static_cast<float>(rX[i] * sizeFactor), static_cast<float>(rY[i] * sizeFactor), static_cast<float>(rZ[i] * sizeFactor));
+}
@@ -0,0 +1,165 @@
+//Author: Bernhard Luedtke
+#ifndef ChebyshevEphemeris_hpp
+#define ChebyshevEphemeris_hpp
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "Vector.h"
+#include "CompiledOrbit.h"
+#include "ChebyshevKernels.h"
+
+class ThreadPool;
+class ConstellationState;
+
+// Counters of the last update() and of the fits since the orbits were set
+struct ChebyshevStats {
+	// Satellites evaluated from a polynomial, solved directly because no fit covered the time yet, refits queued
+	size_t evaluated = 0;
+	size_t directSolves = 0;
+	size_t queued = 0;
+	// Windows fitted (background and fitNow), segments in them, largest error of an accepted segment at the check points (km)
+	size_t fits = 0;
+	size_t segments = 0;
+	double maxFitError = 0.0;
+};
+
+/*
+	Positions from piecewise Chebyshev polynomials, fitted to each satellite's trajectory (like the segments of a SPICE SPK type 2 file).
+	Every satellite has a window of setWindowSegments() segments of equal length. Each segment interpolates x, y and z at the
+	degree + 1 Chebyshev nodes; it is accepted if it stays within the tolerance at the degree + 2 extrema in between, otherwise
+	the segment length is halved. The segment each satellite is in is copied out of its window into columns per coefficient,
+	update() sums them in lane groups (ChebyshevKernels.h); only satellites that left their segment go through the windows.
+	Once the render time is halfway through a satellite's window, the next one (starting where it ends) is queued for the fitter
+	threads. They write it next to the window in use and flag it ready, update() switches over when the time reaches it.
+	A time outside both windows (seeking, a fitter that fell behind) is solved directly for that frame and refitted from there,
+	so the render loop never waits for a fit.
+	The orbits are a snapshot of the ConstellationState taken by setOrbits(), satellites added to the store later are taken by addOrbits().
+*/
+class ChebyshevEphemeris {
+public:
+	// fitterThreads: background threads for the refits (at least 1)
+	explicit ChebyshevEphemeris(const ConstellationState& source, unsigned int fitterThreads = 1);
+	~ChebyshevEphemeris();
+	ChebyshevEphemeris(const ChebyshevEphemeris&) = delete;
+	ChebyshevEphemeris& operator=(const ChebyshevEphemeris&) = delete;
+
+	// Takes the compiled orbits of source; all windows are dropped
+	void setOrbits(const ConstellationState& source);
+	// Takes the orbits source has gained since the snapshot (its satellites beyond size()), the windows fitted so far are kept.
+	// The new satellites are solved directly at their first update() and fitted in the background from there.
+	void addOrbits(const ConstellationState& source);
+	// Largest position error of a segment (km). Applies to fits from now on.
+	void setTolerance(double km);
+	double getTolerance() const noexcept { return tolerance; }
+	// Polynomial degree, 4..24. Higher degrees allow longer segments but cost more per evaluation.
+	void setDegree(unsigned int degree);
+	unsigned int getDegree() const noexcept { return degree; }
+	void setWindowSegments(unsigned int segments) { windowSegments = (segments > 0) ? segments : 1; }
+	// update() and fitNow() run in chunks on the pool (nullptr: on the calling thread)
+	void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+	void setChunkSize(size_t satellites) { chunkSize = (satellites > 0) ? satellites : 1; }
+
+	// Fits a window starting at t for every satellite and waits for it (at startup, or to measure the fit)
+	void fitNow(double t);
+	// Positions of every satellite at the absolute time t, queues the refits that are due
+	void update(double t);
+	// Blocks until the fitter threads have nothing left to do (no more fits pending)
+	void waitForFits();
+	size_t size() const noexcept { return orbits.size(); }
+
+	// Position in km at the last update()
+	void getPositionKm(size_t i, double r[3]) const;
+	// Position in the (scaled down) coordinate system used for rendering
+	Vector getR(size_t i) const;
+	const ChebyshevStats& getStats() const noexcept { return stats; }
+
+private:
+	struct Window {
+		double start = 0.0;
+		// start == end: nothing fitted
+		double end = 0.0;
+		double segmentLength = 0.0;
+		// Where the next window's fit starts: this length, or twice it if the error was far below the tolerance
+		double nextSegmentLength = 0.0;
+		unsigned int degree = 0;
+		unsigned int segments = 0;
+		// Per segment x[0..degree], y[0..degree], z[0..degree]
+		std::vector<double> coefficients;
+	};
+	enum NextState : unsigned char { NextEmpty, NextQueued, NextReady };
+	struct Track {
+		Window windows[2];
+		// Window in use, the other one is the next; it belongs to the fitters while nextState is NextQueued
+		unsigned char current = 0;
+		std::atomic<unsigned char> nextState{ NextEmpty };
+	};
+	struct Job {
+		size_t satellite;
+		double start;
+		double segmentLength;
+	};
+	// Tolerance, degree and window length a fit runs with (copied, they may change while the fitters work)
+	struct FitSettings {
+		double tolerance;
+		unsigned int degree;
+		unsigned int segments;
+	};
+	// Chunk results of update() and fitNow()
+	struct ChunkResult {
+		size_t evaluated = 0;
+		size_t directSolves = 0;
+		std::vector<Job> jobs;
+		size_t segments = 0;
+		double maxError = 0.0;
+	};
+
+	// Fits window w from start with segments of at most segmentLength (0: a quarter period). Adds its segments and error to result.
+	void fitWindow(const CompiledOrbit& o, double start, double segmentLength, const FitSettings& settings, Window& w, ChunkResult& result) const;
+	void updateRange(const ChebyshevArrays& a, size_t begin, size_t end, double t, ChunkResult& result);
+	// Satellite i left its segment: switches segments or windows, queues the next fit when due, or solves directly
+	void attend(size_t i, double t, ChunkResult& result);
+	// Copies segment s of w into the columns. refitAt: time the next window has to be queued (HUGE_VAL: done already)
+	void loadSegment(size_t i, const Window& w, unsigned int s, double refitAt);
+	// Columns for coefficients up to degree d (the new ones 0)
+	void growColumns(unsigned int d);
+	void fitterLoop();
+	void startFitters(unsigned int count);
+	void stopFitters();
+
+	std::vector<CompiledOrbit> orbits;
+	std::vector<Track> tracks;
+	std::vector<double> rX, rY, rZ;
+	// The segment each satellite is in (see ChebyshevArrays), start == limit: none
+	std::vector<double> segmentStart, segmentLimit, segmentMid, segmentScale;
+	std::vector<double> columns[3][chebyshevMaxDegree + 1];
+	unsigned int columnDegree = 0;
+	std::vector<double> missed;
+	double tolerance = 0.001;
+	unsigned int degree = 12;
+	unsigned int windowSegments = 8;
+	ThreadPool* threadPool = nullptr;
+	size_t chunkSize = 1024;
+	std::vector<ChunkResult> chunkResults;
+	ChebyshevStats stats;
+
+	// Refit queue, fitted windows and their counters are handed back through the Track flags and the counters below
+	std::vector<std::thread> fitters;
+	unsigned int fitterCount;
+	std::mutex queueLock;
+	std::condition_variable queueSignal;
+	std::condition_variable idleSignal;
+	std::deque<Job> queue;
+	size_t busyFitters = 0;
+	bool stopping = false;
+	// Counters of all fits, under queueLock
+	size_t fitCount = 0;
+	size_t fitSegments = 0;
+	double fitMaxError = 0.0;
+	unsigned int fitMaxDegree = 0;
+};
+
+#endif /* ChebyshevEphemeris_hpp */
@@ -0,0 +1,29 @@
+//Author: Bernhard Luedtke
+
+#include "ChebyshevKernels.h"
+#include "ChebyshevKernelsLanes.h"
+#include "KeplerKernels.h"
+#include "LanesScalar.h"
+
+size_t evaluateChebyshevBatch(const ChebyshevArrays& a, size_t begin, size_t end, double t)
+{
+	size_t done = 0;
+	size_t missed = 0;
+#ifdef KEPLER_KERNELS_X86
+	switch (getSimdLevel()) {
+	case SimdLevel::AVX512:
+		done = evaluateChebyshevAVX512(a, begin, end, t, missed);
+		break;
+	case SimdLevel::AVX2:
+		done = evaluateChebyshevAVX2(a, begin, end, t, missed);
+		break;
+	case SimdLevel::SSE2:
+		done = evaluateChebyshevSSE2(a, begin, end, t, missed);
+		break;
+	default:
+		break;
+	}
+#endif
+	evaluateChebyshevLanes<LanesScalar>(a, begin + done, end, t, missed);
+	return missed;
+}
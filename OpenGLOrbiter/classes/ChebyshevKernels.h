@@ -0,0 +1,33 @@
+//Author: Bernhard Luedtke
+#ifndef ChebyshevKernels_hpp
+#define ChebyshevKernels_hpp
+
+#include <stddef.h>
+
+constexpr unsigned int chebyshevMaxDegree = 24;
+
+// The Chebyshev segment each satellite of a ChebyshevEphemeris is in, one entry per satellite in every array.
+// A segment is evaluated at tau = (t - mid) * scale for times in [start, limit); limit is the segment end, or earlier
+// if the satellite's next window is due to be fitted by then. Coefficients above a satellite's own degree are 0.
+struct ChebyshevArrays {
+	const double* start; const double* limit;
+	const double* mid; const double* scale;
+	// Coefficient k of x, y and z, k = 0..degree
+	const double* c[3][chebyshevMaxDegree + 1];
+	unsigned int degree;
+	// Position (km)
+	double* r[3];
+	// 1 where t is outside [start, limit) and r was left as it was, 0 where r was evaluated
+	double* missed;
+};
+
+// Evaluates the satellites in [begin, end) at the time t (ChebyshevKernelsLanes.h). The instruction set versions only handle
+// complete lane groups and return how many satellites they did; evaluateChebyshevBatch picks one by getSimdLevel() and does the rest.
+// All add the number of satellites they left out to missed.
+size_t evaluateChebyshevSSE2(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed);
+size_t evaluateChebyshevAVX2(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed);
+size_t evaluateChebyshevAVX512(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed);
+// Returns the number of satellites left out
+size_t evaluateChebyshevBatch(const ChebyshevArrays& a, size_t begin, size_t end, double t);
+
+#endif /* ChebyshevKernels_hpp */
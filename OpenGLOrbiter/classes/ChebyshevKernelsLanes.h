@@ -0,0 +1,65 @@
+//Author: Bernhard Luedtke
+#ifndef ChebyshevKernelsLanes_hpp
+#define ChebyshevKernelsLanes_hpp
+
+// Lane group version of the Chebyshev segment sums, same rules as KeplerKernelsLanes.h: included by the instruction set specific
+// translation units (and ChebyshevKernels.cpp for the scalar one), no standard library calls in here.
+
+#include <stddef.h>
+#include "ChebyshevKernels.h"
+#include "LaneMasks.h"
+
+// Same operations as evaluateSegment in ChebyshevEphemeris.cpp: T_k from T_2k = 2 T_k^2 - 1 and T_2k+1 = 2 T_k T_k+1 - tau,
+// the sums in two halves. The satellites of a lane group share the degree (the higher coefficients of the others are 0).
+template <class L>
+static size_t evaluateChebyshevLanes(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const size_t stop = end - (end - begin) % L::width;
+	const unsigned int degree = a.degree;
+	const reg time = L::set1(t);
+	const reg zero = L::set1(0.0);
+	const reg one = L::set1(1.0);
+	const reg two = L::set1(2.0);
+	reg misses = zero;
+	reg T[chebyshevMaxDegree + 1];
+	for (size_t i = begin; i < stop; i += L::width) {
+		// Left the segment (or a refit is due): ChebyshevEphemeris goes through the windows for these one by one
+		const mask miss = maskOr<L>(L::cmplt(time, L::load(a.start + i)), L::andNot(L::allLanes(), L::cmplt(time, L::load(a.limit + i))));
+		const reg missLanes = L::blend(zero, one, miss);
+		L::store(a.missed + i, missLanes);
+		misses = L::add(misses, missLanes);
+		if (!L::any(L::andNot(L::allLanes(), miss))) {
+			continue;
+		}
+		const reg tau = L::mul(L::sub(time, L::load(a.mid + i)), L::load(a.scale + i));
+		T[0] = one;
+		T[1] = tau;
+		for (unsigned int k = 2; k <= degree; ++k) {
+			const unsigned int h = k / 2;
+			T[k] = (k % 2 == 0) ? L::sub(L::mul(L::mul(two, T[h]), T[h]), one) : L::sub(L::mul(L::mul(two, T[h]), T[h + 1]), tau);
+		}
+		for (int axis = 0; axis < 3; ++axis) {
+			const double* const* c = a.c[axis];
+			reg sum0 = zero, sum1 = zero;
+			unsigned int k = 0;
+			for (; k + 1 <= degree; k += 2) {
+				sum0 = L::add(sum0, L::mul(L::load(c[k] + i), T[k]));
+				sum1 = L::add(sum1, L::mul(L::load(c[k + 1] + i), T[k + 1]));
+			}
+			if (k <= degree) {
+				sum0 = L::add(sum0, L::mul(L::load(c[k] + i), T[k]));
+			}
+			L::store(a.r[axis] + i, L::blend(L::add(sum0, sum1), L::load(a.r[axis] + i), miss));
+		}
+	}
+	alignas(64) double laneMisses[L::width];
+	L::store(laneMisses, misses);
+	for (int l = 0; l < L::width; ++l) {
+		missed += static_cast<size_t>(laneMisses[l]);
+	}
+	return stop - begin;
+}
+
+#endif /* ChebyshevKernelsLanes_hpp */
@@ -0,0 +1,138 @@
+//Author: Bernhard Luedtke
+
+#include "CompiledOrbit.h"
+#include "OrbitConstants.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+/*
+	Same rotation as OrbitEphemeris::calcPQWMatrix, rotationY(Omega) * rotationX(i) * rotationY(w), multiplied out in double.
+	P is the first column of that matrix, Q the negated third one (Matrix::right() and Matrix::backward()).
+*/
+CompiledOrbit CompiledOrbit::compile(const OrbitEphemeris& eph, double epoch, ForceModel model)
+{
+	CompiledOrbit o;
+	o.epoch = epoch;
+	o.semiMajorA = eph.semiMajorA;
+	o.valid = (eph.semiMajorA != 0.0);
+	if (!o.valid) {
+		return o;
+	}
+	const double cosO = std::cos(eph.longitudeAsc), sinO = std::sin(eph.longitudeAsc);
+	const double cosI = std::cos(eph.inclination), sinI = std::sin(eph.inclination);
+	const double cosW = std::cos(eph.argPeriaps), sinW = std::sin(eph.argPeriaps);
+	o.p[0] = cosO * cosW - sinO * cosI * sinW;
+	o.p[1] = sinI * sinW;
+	o.p[2] = -sinO * cosW - cosO * cosI * sinW;
+	o.q[0] = -cosO * sinW - sinO * cosI * cosW;
+	o.q[1] = sinI * cosW;
+	o.q[2] = sinO * sinW - cosO * cosI * cosW;
+	o.w[0] = o.p[1] * o.q[2] - o.p[2] * o.q[1];
+	o.w[1] = o.p[2] * o.q[0] - o.p[0] * o.q[2];
+	o.w[2] = o.p[0] * o.q[1] - o.p[1] * o.q[0];
+
+	//r0 and v0 at the true anomaly, as in OrbitEphemeris::calcR0V0
+	const double e = eph.eccentricity;
+	const double cosT = std::cos(eph.trueAnomaly);
+	const double sinT = std::sin(eph.trueAnomaly);
+	const double semiLatRect = eph.semiMajorA * (1.0 - e * e);
+	const double rScal = semiLatRect / (1.0 + e * cosT);
+	const double vScal = std::sqrt(mu / semiLatRect);
+	for (int k = 0; k < 3; ++k) {
+		o.r0[k] = o.p[k] * (rScal * cosT) + o.q[k] * (rScal * sinT);
+		o.v0[k] = o.p[k] * (-sinT * vScal) + o.q[k] * ((e + cosT) * vScal);
+	}
+	o.r0Length = std::sqrt(o.r0[0] * o.r0[0] + o.r0[1] * o.r0[1] + o.r0[2] * o.r0[2]);
+	o.sigma0 = (o.r0[0] * o.v0[0] + o.r0[1] * o.v0[1] + o.r0[2] * o.v0[2]) / sqMU;
+	o.alpha = 1.0 / eph.semiMajorA;
+	o.eccentricity = e;
+	o.deriveEllipse();
+	o.setForceModel(model);
+	return o;
+}
+
+CompiledOrbit CompiledOrbit::fromState(const double r[3], const double v[3], double epoch, ForceModel model)
+{
+	CompiledOrbit o;
+	o.epoch = epoch;
+	for (int k = 0; k < 3; ++k) {
+		o.r0[k] = r[k];
+		o.v0[k] = v[k];
+	}
+	o.r0Length = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+	o.valid = (o.r0Length > 0.0);
+	if (!o.valid) {
+		return o;
+	}
+	const double v2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+	const double rDotV = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+	o.sigma0 = rDotV / sqMU;
+	//vis-viva
+	o.alpha = 2.0 / o.r0Length - v2 / mu;
+	o.semiMajorA = (o.alpha != 0.0) ? 1.0 / o.alpha : 0.0;
+	//eccentricity vector e = ((v^2 - mu/r) * r - r.dot(v) * v) / mu and angular momentum h = r x v
+	double eVec[3];
+	for (int k = 0; k < 3; ++k) {
+		eVec[k] = ((v2 - mu / o.r0Length) * r[k] - rDotV * v[k]) / mu;
+	}
+	o.eccentricity = std::sqrt(eVec[0] * eVec[0] + eVec[1] * eVec[1] + eVec[2] * eVec[2]);
+	const double h[3] = { r[1] * v[2] - r[2] * v[1], r[2] * v[0] - r[0] * v[2], r[0] * v[1] - r[1] * v[0] };
+	const double hLength = std::sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+	const bool circular = o.eccentricity < 1e-12;
+	for (int k = 0; k < 3; ++k) {
+		o.w[k] = (hLength > 0.0) ? h[k] / hLength : 0.0;
+		o.p[k] = circular ? r[k] / o.r0Length : eVec[k] / o.eccentricity;
+	}
+	o.q[0] = o.w[1] * o.p[2] - o.w[2] * o.p[1];
+	o.q[1] = o.w[2] * o.p[0] - o.w[0] * o.p[2];
+	o.q[2] = o.w[0] * o.p[1] - o.w[1] * o.p[0];
+	o.deriveEllipse();
+	o.setForceModel(model);
+	return o;
+}
+
+void CompiledOrbit::deriveEllipse()
+{
+	if (alpha <= 0.0) {
+		return;
+	}
+	const double a = 1.0 / alpha;
+	period = 2.0 * M_PI * std::sqrt((a * a * a) / mu);
+	meanMotion = std::sqrt(mu / (a * a * a));
+	// Position in the ellipse at the epoch: r0 = a*(1 - e*cos(E0)) and r0.dot(v0) = sqrt(mu*a)*e*sin(E0)
+	const double eCos = 1.0 - r0Length * alpha;
+	const double eSin = sigma0 / std::sqrt(a);
+	eccAnomaly0 = std::atan2(eSin, eCos);
+	cosE0 = std::cos(eccAnomaly0);
+	sinE0 = std::sin(eccAnomaly0);
+	meanAnomaly0 = eccAnomaly0 - eSin;
+}
+
+/*
+	Secular J2 rates of the mean elements (Vallado, Fundamentals of Astrodynamics and Applications, 9.6), with
+	n = sqrt(mu/a^3), p = a*(1 - e^2) and k = 3/2 * n * J2 * (R/p)^2:
+	dOmega/dt = -k * cos(i)
+	domega/dt = k * (2 - 5/2 * sin^2(i))
+	dM/dt = n + k * sqrt(1 - e^2) * (1 - 3/2 * sin^2(i))
+	Earth's axis is y in this coordinate system, so cos(i) is the y component of W.
+*/
+void CompiledOrbit::setForceModel(ForceModel model)
+{
+	forceModel = model;
+	nodeRate = 0.0;
+	periapsisRate = 0.0;
+	anomalyRateScale = 1.0;
+	// Only closed orbits have mean elements to drift
+	if (model != ForceModel::J2Secular || alpha <= 0.0 || eccentricity >= 1.0) {
+		return;
+	}
+	const double a = 1.0 / alpha;
+	const double oneMinusE2 = 1.0 - eccentricity * eccentricity;
+	const double semiLatRect = a * oneMinusE2;
+	const double k = 1.5 * meanMotion * j2 * (earthRadius / semiLatRect) * (earthRadius / semiLatRect);
+	const double cosI = w[1];
+	const double sin2I = 1.0 - cosI * cosI;
+	nodeRate = -k * cosI;
+	periapsisRate = k * (2.0 - 2.5 * sin2I);
+	anomalyRateScale = 1.0 + (k / meanMotion) * std::sqrt(oneMinusE2) * (1.0 - 1.5 * sin2I);
+}
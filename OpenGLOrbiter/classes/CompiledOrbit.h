@@ -0,0 +1,60 @@
+//Author: Bernhard Luedtke
+#ifndef CompiledOrbit_hpp
+#define CompiledOrbit_hpp
+
+#include "OrbitEphemeris.h"
+
+// Forces a satellite is propagated with.
+// TwoBody: Kepler's problem only. J2Secular: additionally the mean drift of the node, the periapsis and the mean anomaly
+// caused by earth's oblateness (no periodic terms), still solved in closed form from the epoch.
+enum class ForceModel { TwoBody, J2Secular };
+
+// Everything the propagator needs of one orbit, computed once from the elements in double precision.
+// OrbitEphemeris only keeps r0/v0 as float Vectors and recomputes them lazily; the kernels never touch it,
+// they only read a CompiledOrbit (or the columns ConstellationState copies out of it).
+// Built by compile() whenever the elements change and not modified afterwards.
+struct CompiledOrbit {
+	// Read by every solve, kept together at the front
+	double alpha = 0.0;			// 1/a, 0 for a parabola, negative for a hyperbola
+	double r0Length = 0.0;		// |r0|
+	double sigma0 = 0.0;		// r0.dot(v0) / sqrt(mu)
+	double period = 0.0;		// 0 for orbits that are not closed
+	double epoch = 0.0;			// absolute time of r0, v0
+	double eccentricity = 0.0;
+	double meanAnomaly0 = 0.0;
+	double meanMotion = 0.0;	// 0 for orbits that are not closed
+	// Mean anomaly rate / meanMotion: the Kepler solve runs with the time of flight scaled by this (1 for TwoBody)
+	double anomalyRateScale = 1.0;
+
+	// Epoch state in km and km/s, for f and g
+	double r0[3] = { 0.0, 0.0, 0.0 };
+	double v0[3] = { 0.0, 0.0, 0.0 };
+	double semiMajorA = 0.0;
+	double eccAnomaly0 = 0.0, cosE0 = 1.0, sinE0 = 0.0;
+
+	// Perifocal basis (Bate et al. 2.6): P towards periapsis, Q 90 degrees ahead in the orbital plane, W = P x Q
+	double p[3] = { 0.0, 0.0, 0.0 };
+	double q[3] = { 0.0, 0.0, 0.0 };
+	double w[3] = { 0.0, 0.0, 0.0 };
+
+	// J2 secular rates in rad/s (0 for TwoBody), the solved state is turned by periapsisRate*dt around W and nodeRate*dt around earth's axis (y)
+	double nodeRate = 0.0;
+	double periapsisRate = 0.0;
+	ForceModel forceModel = ForceModel::TwoBody;
+
+	// False for elements that can not be propagated (semi major axis 0)
+	bool valid = false;
+
+	static CompiledOrbit compile(const OrbitEphemeris& eph, double epoch, ForceModel model = ForceModel::TwoBody);
+	// From a state vector (km, km/s), e.g. to restart the propagation from an integrated state.
+	// P points to periapsis (along r for circular orbits), W along r x v.
+	static CompiledOrbit fromState(const double r[3], const double v[3], double epoch, ForceModel model = ForceModel::TwoBody);
+	// Sets the rates of the force model, for the orbit as it is at the epoch
+	void setForceModel(ForceModel model);
+
+private:
+	// period, mean motion and the eccentric anomaly values from alpha, |r0| and sigma0 (closed orbits only)
+	void deriveEllipse();
+};
+
+#endif /* CompiledOrbit_hpp */
@@ -0,0 +1,628 @@
+//Author: Bernhard Luedtke
+
+#include "ConstellationState.h"
+#include "OrbitConstants.h"
+#include "KeplerKernels.h"
+#include "Stumpff.h"
+#include "ThreadPool.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+void KeplerSolveStats::merge(const KeplerSolveStats& other)
+{
+	solves += other.solves;
+	iterations += other.iterations;
+	maxIterations = (other.maxIterations > maxIterations) ? other.maxIterations : maxIterations;
+	warmStarts += other.warmStarts;
+	laguerreFallbacks += other.laguerreFallbacks;
+	unconverged += other.unconverged;
+	fgCheckFailures += other.fgCheckFailures;
+	maxFgDeviation = (other.maxFgDeviation > maxFgDeviation) ? other.maxFgDeviation : maxFgDeviation;
+}
+
+ConstellationState::ConstellationState()
+{
+	;
+}
+
+ConstellationState::~ConstellationState()
+{
+	;
+}
+
+void ConstellationState::reserve(size_t n)
+{
+	orbits.reserve(n);
+	lastX.reserve(n); lastDt.reserve(n); lastRLength.reserve(n); lastValid.reserve(n);
+	rX.reserve(n); rY.reserve(n); rZ.reserve(n);
+	vX.reserve(n); vY.reserve(n); vZ.reserve(n);
+	prevX.reserve(n); prevY.reserve(n); prevZ.reserve(n);
+	ephemerides.reserve(n);
+	stepDt.reserve(n);
+	gatherIndex.reserve(n);
+	gatherAlpha.reserve(n); gatherR0Length.reserve(n); gatherSigma0.reserve(n); gatherDt.reserve(n);
+	solvedX.reserve(n); solvedC.reserve(n); solvedS.reserve(n);
+	solvedIterations.reserve(n);
+	ellipticIndex.reserve(n);
+	gatherEcc.reserve(n); gatherMean.reserve(n);
+	solvedE.reserve(n); solvedSinE.reserve(n); solvedCosE.reserve(n);
+}
+
+size_t ConstellationState::add(OrbitEphemeris eph, ForceModel model)
+{
+	orbits.push_back(CompiledOrbit());
+	lastX.push_back(0.0); lastDt.push_back(0.0); lastRLength.push_back(0.0); lastValid.push_back(0);
+	rX.push_back(0.0); rY.push_back(0.0); rZ.push_back(0.0);
+	vX.push_back(0.0); vY.push_back(0.0); vZ.push_back(0.0);
+	prevX.push_back(0.0); prevY.push_back(0.0); prevZ.push_back(0.0);
+	ephemerides.push_back(eph);
+	stepDt.push_back(0.0);
+	gatherIndex.push_back(0);
+	gatherAlpha.push_back(0.0); gatherR0Length.push_back(0.0); gatherSigma0.push_back(0.0); gatherDt.push_back(0.0);
+	solvedX.push_back(0.0); solvedC.push_back(0.0); solvedS.push_back(0.0);
+	solvedIterations.push_back(0);
+	ellipticIndex.push_back(0);
+	gatherEcc.push_back(0.0); gatherMean.push_back(0.0);
+	solvedE.push_back(0.0); solvedSinE.push_back(0.0); solvedCosE.push_back(0.0);
+	setEphemeris(orbits.size() - 1, eph);
+	setForceModel(orbits.size() - 1, model);
+	return orbits.size() - 1;
+}
+
+void ConstellationState::setEphemeris(size_t i, OrbitEphemeris eph)
+{
+	if (eph.semiMajorA == 0.0) {
+		std::cerr << "Semi Major Axis is 0, satellite can not be propagated" << std::endl;
+	}
+	const CompiledOrbit& o = orbits[i] = CompiledOrbit::compile(eph, currentTime, orbits[i].forceModel);
+	ephemerides[i] = eph;
+	// The last solution belongs to the old orbit
+	lastX[i] = 0.0; lastDt[i] = 0.0; lastRLength[i] = o.r0Length; lastValid[i] = 0;
+	rX[i] = o.r0[0]; rY[i] = o.r0[1]; rZ[i] = o.r0[2];
+	vX[i] = o.v0[0]; vY[i] = o.v0[1]; vZ[i] = o.v0[2];
+	prevX[i] = rX[i]; prevY[i] = rY[i]; prevZ[i] = rZ[i];
+}
+
+void ConstellationState::setForceModel(size_t i, ForceModel model)
+{
+	CompiledOrbit& o = orbits[i];
+	if (o.forceModel == model) {
+		return;
+	}
+	if (o.forceModel == ForceModel::J2Secular) {
+		--secularSatellites;
+	}
+	if (model == ForceModel::J2Secular) {
+		++secularSatellites;
+	}
+	o.setForceModel(model);
+	// The time of flight of the last solution was scaled differently
+	lastValid[i] = 0;
+}
+
+Vector ConstellationState::getR(size_t i) const
+{
+	return Vector(static_cast<float>(rX[i] * sizeFactor), static_cast<float>(rY[i] * sizeFactor), static_cast<float>(rZ[i] * sizeFactor));
+}
+
+Vector ConstellationState::getInterpolatedR(size_t i, double alpha) const
+{
+	const double x = prevX[i] + (rX[i] - prevX[i]) * alpha;
+	const double y = prevY[i] + (rY[i] - prevY[i]) * alpha;
+	const double z = prevZ[i] + (rZ[i] - prevZ[i]) * alpha;
+	return Vector(static_cast<float>(x * sizeFactor), static_cast<float>(y * sizeFactor), static_cast<float>(z * sizeFactor));
+}
+
+Vector ConstellationState::getV(size_t i) const
+{
+	return Vector(static_cast<float>(vX[i] * sizeFactor), static_cast<float>(vY[i] * sizeFactor), static_cast<float>(vZ[i] * sizeFactor));
+}
+
+void ConstellationState::getStateKm(size_t i, double r[3], double v[3]) const
+{
+	r[0] = rX[i]; r[1] = rY[i]; r[2] = rZ[i];
+	v[0] = vX[i]; v[1] = vY[i]; v[2] = vZ[i];
+}
+
+const OrbitEphemeris& ConstellationState::getEphemeris(size_t i) const
+{
+	return ephemerides[i];
+}
+
+void ConstellationState::copyStateKm(double* rv) const
+{
+	for (size_t i = 0; i < orbits.size(); ++i) {
+		double* row = rv + 6 * i;
+		row[0] = rX[i]; row[1] = rY[i]; row[2] = rZ[i];
+		row[3] = vX[i]; row[4] = vY[i]; row[5] = vZ[i];
+	}
+}
+
+void ConstellationState::restartFromState(const double* rv, double t)
+{
+	for (size_t i = 0; i < orbits.size(); ++i) {
+		const double* row = rv + 6 * i;
+		rX[i] = row[0]; rY[i] = row[1]; rZ[i] = row[2];
+		vX[i] = row[3]; vY[i] = row[4]; vZ[i] = row[5];
+		prevX[i] = rX[i]; prevY[i] = rY[i]; prevZ[i] = rZ[i];
+	}
+	currentTime = t;
+	rebaseEpochs();
+}
+
+void ConstellationState::rebaseEpochs()
+{
+	for (size_t i = 0; i < orbits.size(); ++i) {
+		const double r[3] = { rX[i], rY[i], rZ[i] };
+		const double v[3] = { vX[i], vY[i], vZ[i] };
+		orbits[i] = CompiledOrbit::fromState(r, v, currentTime, orbits[i].forceModel);
+		// Solutions so far were relative to the old epoch
+		lastX[i] = 0.0; lastDt[i] = 0.0; lastRLength[i] = orbits[i].r0Length; lastValid[i] = 0;
+	}
+}
+
+void ConstellationState::propagateTo(double t)
+{
+	// Keep the current state, so drawing can interpolate between it and the new one
+	propagateAll(t, true);
+	currentTime = t;
+}
+
+void ConstellationState::propagateBatch(double dt)
+{
+	propagateTo(currentTime + dt);
+}
+
+void ConstellationState::seek(double t)
+{
+	propagateAll(t, false);
+	currentTime = t;
+}
+
+void ConstellationState::propagateAll(double t, bool keepPrevious)
+{
+	const size_t n = size();
+	const size_t chunks = (n + chunkSize - 1) / chunkSize;
+	chunkStats.assign(chunks, KeplerSolveStats());
+	// Each chunk only writes its own satellites, its own part of the scratch arrays and its own counters
+	const std::function<void(size_t, size_t, size_t)> body = [this, t, keepPrevious](size_t begin, size_t end, size_t chunk) {
+		if (keepPrevious) {
+			std::copy(rX.begin() + begin, rX.begin() + end, prevX.begin() + begin);
+			std::copy(rY.begin() + begin, rY.begin() + end, prevY.begin() + begin);
+			std::copy(rZ.begin() + begin, rZ.begin() + end, prevZ.begin() + begin);
+		}
+		propagateRange(begin, end, t, chunkStats[chunk]);
+		// Nothing to interpolate from after a jump
+		if (!keepPrevious) {
+			std::copy(rX.begin() + begin, rX.begin() + end, prevX.begin() + begin);
+			std::copy(rY.begin() + begin, rY.begin() + end, prevY.begin() + begin);
+			std::copy(rZ.begin() + begin, rZ.begin() + end, prevZ.begin() + begin);
+		}
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(n, chunkSize, body);
+	}
+	else {
+		for (size_t c = 0; c < chunks; ++c) {
+			const size_t begin = c * chunkSize;
+			body(begin, (begin + chunkSize < n) ? begin + chunkSize : n, c);
+		}
+	}
+	for (const KeplerSolveStats& s : chunkStats) {
+		stats.merge(s);
+	}
+}
+
+/* From 'Fundamentals of Astrodynamics', R. Bate et al., pg. 193
+With the Kepler time-of-flight equations you can easily solve for the time-of-flight, t - to' if you are given a, e, Vo and v.
+The inverse problem of finding v when you are given a, e, Vo and t -to is not so simple, as we shall see.
+Small4,  in An  Account of the  Astronomical Discoveries of Kepler, relates:
+	"This problem has, ever since the time of Kepler, continued  to exercise  the ingenuity of the ablest geometers;
+	but no solution of it which is rigorously  accurate has been obtained.
+	Nor is there much reason to hope that the difficulty will ever be overcome ... "
+This problem classically involves the solution of Kepler's Equation and is often referred to as Kepler's problem.
+*/
+
+/*
+	Where Automatic takes the elliptic path, from the crossover measured by benchmarkKeplerPaths (e < 0.1, ns per propagation):
+	Scalar  universal 170-200  elliptic 140-160
+	SSE2    universal 100-115  elliptic 110-115
+	AVX2    universal  72-79   elliptic  80-86
+	AVX-512 universal  62-65   elliptic  78-84
+	The eccentric anomaly iteration only wins while the universal solve runs one satellite at a time (no lanes, or Exact Stumpff
+	functions). With lane groups the warm started Newton steps are as cheap, and one path per satellite keeps the groups full.
+*/
+static bool automaticUsesElliptic()
+{
+	return getSimdLevel() == SimdLevel::Scalar || getStumpffMode() == StumpffMode::Exact;
+}
+
+// How far the time of flight may move from the last solve for a warm start. x moves with dx/dt = sqrt(mu)/|r|, that holds while |r|
+// changes little: closed orbits not across the wrap at half a period (a jump of a whole orbit), open ones within an eighth of the
+// time their radius takes to double (about |dt| far out, r0/v0 near periapsis).
+static double warmStartReach(const CompiledOrbit& o, double lastDt)
+{
+	if (o.period > 0.0) {
+		return 0.125 * o.period;
+	}
+	const double v0 = std::sqrt(o.v0[0] * o.v0[0] + o.v0[1] * o.v0[1] + o.v0[2] * o.v0[2]);
+	return 0.125 * std::max(std::abs(lastDt), o.r0Length / v0);
+}
+
+bool ConstellationState::useElliptic(size_t i, bool automaticElliptic) const
+{
+	const CompiledOrbit& o = orbits[i];
+	if (o.period <= 0.0 || o.eccentricity >= 1.0 || keplerPath == KeplerPath::Universal) {
+		return false;
+	}
+	// Above ellipticBatchMaxEccentricity the elliptic iteration needs trig calls per step,
+	// the warm started universal variable kernel is faster there (see Benchmark.cpp)
+	return keplerPath == KeplerPath::Elliptic || (automaticElliptic && o.eccentricity < ellipticBatchMaxEccentricity);
+}
+
+/*
+	Solves Kepler's problem for every satellite in [begin, end).
+	We have, for every satellite (all in its CompiledOrbit):
+	r0	Vector r (position) at its epoch;
+	v0	Vector v (speed) at its epoch;
+	dt	t - epoch (times anomalyRateScale for J2Secular), reduced to (-period/2, period/2] for closed orbits
+
+	Closed orbits with a small eccentricity may solve Kepler's equation in eccentric anomaly,
+	everything else uses the universal variable formulation (see useElliptic).
+	r and v at t are written to rX.., vX..; the compiled orbits stay untouched.
+	J2Secular satellites are turned by the drift of their orbit afterwards (applySecularDrift).
+*/
+void ConstellationState::propagateRange(size_t begin, size_t end, double t, KeplerSolveStats& rangeStats)
+{
+	if (begin >= end) {
+		return;
+	}
+	size_t gathered = begin;
+	size_t gatheredElliptic = begin;
+	const bool automaticElliptic = automaticUsesElliptic();
+	for (size_t i = begin; i < end; ++i) {
+		const CompiledOrbit& o = orbits[i];
+		// J2Secular: the position in the (turned) ellipse moves with the drifted mean motion
+		double dt = (t - o.epoch) * o.anomalyRateScale;
+		// The position repeats every period, a short time of flight keeps x small and the iteration fast
+		if (o.period > 0.0) {
+			dt -= o.period * std::floor(dt / o.period + 0.5);
+		}
+		stepDt[i] = dt;
+		if (!o.valid) {
+			continue;
+		}
+		if (!useElliptic(i, automaticElliptic)) {
+			gatherIndex[gathered] = i;
+			gatherAlpha[gathered] = o.alpha;
+			gatherR0Length[gathered] = o.r0Length;
+			gatherSigma0[gathered] = o.sigma0;
+			gatherDt[gathered] = dt;
+			// Warm start from the last solution, if it is close enough and the guess stays finite
+			double x = 0.0;
+			bool warm = false;
+			if (warmStart && lastValid[i] && std::abs(dt - lastDt[i]) < warmStartReach(o, lastDt[i])) {
+				x = lastX[i] + sqMU * (dt - lastDt[i]) / lastRLength[i];
+				warm = std::isfinite(x);
+			}
+			if (warm) {
+				++rangeStats.warmStarts;
+			}
+			else {
+				x = universalAnomalyGuess(o.alpha, o.r0Length, o.sigma0, dt);
+			}
+			solvedX[gathered] = x;
+			++gathered;
+			continue;
+		}
+		// Not wrapped to [-pi, pi]: dE has to match dt in g. |M| stays below 2*pi since |dt| <= period/2.
+		const double M = o.meanAnomaly0 + o.meanMotion * dt;
+		if (o.eccentricity < ellipticBatchMaxEccentricity) {
+			ellipticIndex[gatheredElliptic] = i;
+			gatherEcc[gatheredElliptic] = o.eccentricity;
+			gatherMean[gatheredElliptic] = M;
+			++gatheredElliptic;
+		}
+		else {
+			double sinE, cosE;
+			const double E = solveEccentricAnomaly(o.eccentricity, M, sinE, cosE);
+			propagateElliptic(i, dt, E, sinE, cosE);
+		}
+	}
+	if (gatheredElliptic > begin) {
+		solveEccentricAnomalyBatch(gatheredElliptic - begin, &gatherEcc[begin], &gatherMean[begin],
+			&solvedE[begin], &solvedSinE[begin], &solvedCosE[begin]);
+		for (size_t k = begin; k < gatheredElliptic; ++k) {
+			const size_t i = ellipticIndex[k];
+			propagateElliptic(i, stepDt[i], solvedE[k], solvedSinE[k], solvedCosE[k]);
+		}
+	}
+	if (gathered > begin) {
+		solveUniversalRange(begin, gathered, rangeStats);
+	}
+	if (secularSatellites > 0) {
+		applySecularDrift(begin, end, t);
+	}
+}
+
+void ConstellationState::solveUniversalRange(size_t begin, size_t gathered, KeplerSolveStats& rangeStats)
+{
+	//Solve for the universal anomaly x of all remaining satellites at once (vectorized, see KeplerKernels.h)
+	solveUniversalAnomalyBatch(gathered - begin, &gatherAlpha[begin], &gatherR0Length[begin], &gatherSigma0[begin], &gatherDt[begin],
+		&solvedX[begin], &solvedC[begin], &solvedS[begin], &solvedIterations[begin]);
+
+	for (size_t k = begin; k < gathered; ++k) {
+		const size_t i = gatherIndex[k];
+		const CompiledOrbit& o = orbits[i];
+		const unsigned int iterations = solvedIterations[k];
+		++rangeStats.solves;
+		rangeStats.iterations += iterations;
+		rangeStats.maxIterations = (iterations > rangeStats.maxIterations) ? iterations : rangeStats.maxIterations;
+		if (iterations > keplerNewtonMaxIterations) {
+			++rangeStats.laguerreFallbacks;
+		}
+		bool converged = iterations <= keplerNewtonMaxIterations + keplerLaguerreMaxIterations;
+		const double r0L = o.r0Length;
+		const double sig0 = o.sigma0;
+		const double x = solvedX[k];
+		const double z = (x * x) * o.alpha;		//4.4-7
+		const double bigC = solvedC[k];
+		const double bigS = solvedS[k];
+
+		//Evaluate f and g from equations (4.4-31) and (4.4-32)
+		const double f = 1.0 - ((x * x) / r0L) * bigC;
+		const double g = (x * x * sig0 * bigC + r0L * x * (1.0 - z * bigS)) / sqMU;
+
+		//Now compute r by 4.4-18
+		const double rXi = o.r0[0] * f + o.v0[0] * g;
+		const double rYi = o.r0[1] * f + o.v0[1] * g;
+		const double rZi = o.r0[2] * f + o.v0[2] * g;
+		const double rL = std::sqrt(rXi * rXi + rYi * rYi + rZi * rZi);
+
+		//Evaluate fD and gD from equations 4.4-35 and 4.4-36
+		const double fD = (sqMU / (r0L * rL)) * x * (z * bigS - 1.0);
+		const double gD = 1.0 - ((x * x) / rL) * bigC;
+
+		//check for accuracy of f, g, fD, gD. The larger the difference to 1, the higher the error of the determined position
+		const double deviation = std::abs(f * gD - fD * g - 1.0);
+		if (!(deviation <= 1e-10)) {
+			++rangeStats.fgCheckFailures;
+		}
+		rangeStats.maxFgDeviation = (deviation > rangeStats.maxFgDeviation) ? deviation : rangeStats.maxFgDeviation;
+
+		// Now compute v from 4.4-19
+		const double vXi = o.r0[0] * fD + o.v0[0] * gD;
+		const double vYi = o.r0[1] * fD + o.v0[1] * gD;
+		const double vZi = o.r0[2] * fD + o.v0[2] * gD;
+		// A solve that ran off (overflow, NaN) did not converge either. The satellite keeps its last finite state.
+		converged = converged && rL > 0.0 && std::isfinite(rL) && std::isfinite(vXi) && std::isfinite(vYi) && std::isfinite(vZi);
+		if (!converged) {
+			++rangeStats.unconverged;
+			lastValid[i] = 0;
+			continue;
+		}
+		lastX[i] = x;
+		lastDt[i] = stepDt[i];
+		lastRLength[i] = rL;
+		lastValid[i] = 1;
+		rX[i] = rXi; rY[i] = rYi; rZ[i] = rZi;
+		vX[i] = vXi; vY[i] = vYi; vZ[i] = vZi;
+	}
+}
+
+/*
+	The solved state lies in the orbit as it was at the epoch. The drift of the argument of periapsis turns it by dw = periapsisRate*dt
+	around W (x' = x*cos(dw) + (W x x)*sin(dw), P towards Q), the drift of the node by dO = nodeRate*dt around earth's axis,
+	the same rotation about y that turns the node in OrbitEphemeris::calcPQWMatrix.
+*/
+// One state of applySecularDrift, dt = t - epoch
+static void turnBySecularDrift(const CompiledOrbit& o, double dt, double r[3], double v[3])
+{
+	const double cosW = std::cos(o.periapsisRate * dt), sinW = std::sin(o.periapsisRate * dt);
+	const double cosO = std::cos(o.nodeRate * dt), sinO = std::sin(o.nodeRate * dt);
+	const double* w = o.w;
+	// Around W: x*cos(dw) + (W x x)*sin(dw)
+	const double r0 = r[0] * cosW + (w[1] * r[2] - w[2] * r[1]) * sinW;
+	const double r1 = r[1] * cosW + (w[2] * r[0] - w[0] * r[2]) * sinW;
+	const double r2 = r[2] * cosW + (w[0] * r[1] - w[1] * r[0]) * sinW;
+	const double v0 = v[0] * cosW + (w[1] * v[2] - w[2] * v[1]) * sinW;
+	const double v1 = v[1] * cosW + (w[2] * v[0] - w[0] * v[2]) * sinW;
+	const double v2 = v[2] * cosW + (w[0] * v[1] - w[1] * v[0]) * sinW;
+	// Around y
+	r[0] = cosO * r0 + sinO * r2; r[1] = r1; r[2] = -sinO * r0 + cosO * r2;
+	v[0] = cosO * v0 + sinO * v2; v[1] = v1; v[2] = -sinO * v0 + cosO * v2;
+}
+
+void ConstellationState::applySecularDrift(size_t begin, size_t end, double t)
+{
+	for (size_t i = begin; i < end; ++i) {
+		const CompiledOrbit& o = orbits[i];
+		if (o.forceModel != ForceModel::J2Secular || !o.valid) {
+			continue;
+		}
+		double r[3] = { rX[i], rY[i], rZ[i] };
+		double v[3] = { vX[i], vY[i], vZ[i] };
+		turnBySecularDrift(o, t - o.epoch, r, v);
+		rX[i] = r[0]; rY[i] = r[1]; rZ[i] = r[2];
+		vX[i] = v[0]; vY[i] = v[1]; vZ[i] = v[2];
+	}
+}
+
+/*
+	Elliptic path: E solves M = E - e*sin(E) for M = M0 + n*dt, then f, g, fD, gD in terms of the change in eccentric anomaly dE = E - E0
+	(Bate et al. 4.5):
+	f = 1 - a/r0 * (1 - cos dE)		g = dt - (dE - sin dE) / n
+	fD = -sqrt(mu*a) * sin dE / (r*r0)	gD = 1 - a/r * (1 - cos dE)
+*/
+void ConstellationState::propagateElliptic(size_t i, double dt, double E, double sinE, double cosE)
+{
+	const CompiledOrbit& o = orbits[i];
+	const double a = o.semiMajorA;
+	const double n = o.meanMotion;
+	const double dE = E - o.eccAnomaly0;
+	const double cosDE = cosE * o.cosE0 + sinE * o.sinE0;
+	const double sinDE = sinE * o.cosE0 - cosE * o.sinE0;
+	const double r0L = o.r0Length;
+	const double rL = a * (1.0 - o.eccentricity * cosE);
+
+	const double f = 1.0 - (a / r0L) * (1.0 - cosDE);
+	const double g = dt - (dE - sinDE) / n;
+	// sqrt(mu*a) = n*a*a
+	const double fD = -(n * a * a) * sinDE / (rL * r0L);
+	const double gD = 1.0 - (a / rL) * (1.0 - cosDE);
+
+	rX[i] = o.r0[0] * f + o.v0[0] * g;
+	rY[i] = o.r0[1] * f + o.v0[1] * g;
+	rZ[i] = o.r0[2] * f + o.v0[2] * g;
+	vX[i] = o.r0[0] * fD + o.v0[0] * gD;
+	vY[i] = o.r0[1] * fD + o.v0[1] * gD;
+	vZ[i] = o.r0[2] * fD + o.v0[2] * gD;
+}
+
+void ConstellationState::stateAt(const CompiledOrbit& o, double t, double r[3], double v[3])
+{
+	if (!o.valid) {
+		r[0] = r[1] = r[2] = 0.0;
+		v[0] = v[1] = v[2] = 0.0;
+		return;
+	}
+	// As in propagateRange
+	double dt = (t - o.epoch) * o.anomalyRateScale;
+	if (o.period > 0.0) {
+		dt -= o.period * std::floor(dt / o.period + 0.5);
+	}
+	double f, g, fD, gD;
+	if (o.period > 0.0 && o.eccentricity < 1.0) {
+		// Elliptic path (propagateElliptic), the scalar iteration is fine for every e < 1
+		double sinE, cosE;
+		const double E = solveEccentricAnomaly(o.eccentricity, o.meanAnomaly0 + o.meanMotion * dt, sinE, cosE);
+		const double a = o.semiMajorA;
+		const double n = o.meanMotion;
+		const double dE = E - o.eccAnomaly0;
+		const double cosDE = cosE * o.cosE0 + sinE * o.sinE0;
+		const double sinDE = sinE * o.cosE0 - cosE * o.sinE0;
+		const double rL = a * (1.0 - o.eccentricity * cosE);
+		f = 1.0 - (a / o.r0Length) * (1.0 - cosDE);
+		g = dt - (dE - sinDE) / n;
+		fD = -(n * a * a) * sinDE / (rL * o.r0Length);
+		gD = 1.0 - (a / rL) * (1.0 - cosDE);
+	}
+	else {
+		// Universal variable path (solveUniversalRange) from a cold guess
+		double x = universalAnomalyGuess(o.alpha, o.r0Length, o.sigma0, dt);
+		double bigC, bigS;
+		solveUniversalAnomaly(o, dt, x, bigC, bigS);
+		const double z = (x * x) * o.alpha;
+		f = 1.0 - ((x * x) / o.r0Length) * bigC;
+		g = (x * x * o.sigma0 * bigC + o.r0Length * x * (1.0 - z * bigS)) / sqMU;
+		const double rXi = o.r0[0] * f + o.v0[0] * g;
+		const double rYi = o.r0[1] * f + o.v0[1] * g;
+		const double rZi = o.r0[2] * f + o.v0[2] * g;
+		const double rL = std::sqrt(rXi * rXi + rYi * rYi + rZi * rZi);
+		fD = (sqMU / (o.r0Length * rL)) * x * (z * bigS - 1.0);
+		gD = 1.0 - ((x * x) / rL) * bigC;
+	}
+	for (int k = 0; k < 3; ++k) {
+		r[k] = o.r0[k] * f + o.v0[k] * g;
+		v[k] = o.r0[k] * fD + o.v0[k] * gD;
+	}
+	if (o.forceModel == ForceModel::J2Secular) {
+		turnBySecularDrift(o, t - o.epoch, r, v);
+	}
+}
+
+std::vector<Vector> ConstellationState::sampleOrbit(OrbitEphemeris eph, double step)
+{
+	std::vector<Vector> points;
+	// On a separate store, every point is solved directly from periapsis
+	eph.trueAnomaly = 0.0;
+	ConstellationState orbitStore;
+	orbitStore.add(eph);
+	const double period = eph.getEllipseOrbitalPeriod();
+	int maxSteps = 10000;
+	//Required for orbits with periods >~333 hours
+	if (step * maxSteps < period) {
+		maxSteps = static_cast<int>(period / step) + 1;
+	}
+	double t = 0.0;
+	for (int k = 0; k < maxSteps; ++k) {
+		t += step;
+		orbitStore.seek(t);
+		const Vector r = orbitStore.getR(0);
+		if (r.lengthSquared() > 0.000001f) {
+			points.push_back(r);
+		}
+		if (t - step > period) {
+			//Stop after one orbit
+			break;
+		}
+	}
+	return points;
+}
+
+// True anomaly step from nu whose chord stays within maxError of the conic, for the radius of curvature at nu
+static double conicStep(double p, double e, double nu, double maxError)
+{
+	const double c = cos(nu);
+	const double q = 1.0 + e * c;
+	const double w = 1.0 + e * e + 2.0 * e * c;
+	// ds/dnu and the radius of curvature of r = p / (1 + e cos nu)
+	const double speed = p * sqrt(w) / (q * q);
+	const double rho = p * w * sqrt(w) / (q * q * q);
+	// Chord of a circle of radius rho whose sagitta is maxError
+	const double chord = (maxError < rho) ? 2.0 * sqrt(maxError * (2.0 * rho - maxError)) : 2.0 * rho;
+	return chord / speed;
+}
+
+std::vector<Vector> ConstellationState::sampleConic(const OrbitEphemeris& eph, double maxError)
+{
+	std::vector<Vector> points;
+	const CompiledOrbit o = CompiledOrbit::compile(eph, 0.0);
+	if (!o.valid || !(maxError > 0.0)) {
+		return points;
+	}
+	// Semi latus rectum h^2 / mu
+	const double hX = o.r0[1] * o.v0[2] - o.r0[2] * o.v0[1];
+	const double hY = o.r0[2] * o.v0[0] - o.r0[0] * o.v0[2];
+	const double hZ = o.r0[0] * o.v0[1] - o.r0[1] * o.v0[0];
+	const double p = (hX * hX + hY * hY + hZ * hZ) / mu;
+	const double e = o.eccentricity;
+	const double pi = 3.14159265358979323846;
+	// At least 16 points per turn, so tiny orbits with a large maxError are still round
+	const double maxStep = pi / 8.0;
+	const double minStep = 1e-6;
+	double nu = 0.0;
+	double nuEnd = 2.0 * pi;
+	if (e >= 1.0) {
+		//open conics: the arc between the two points at openConicRadius
+		const double cosEnd = (p / std::max(openConicRadius, p) - 1.0) / e;
+		nuEnd = acos(std::max(-1.0, std::min(1.0, cosEnd)));
+		nu = -nuEnd;
+	}
+	for (;;) {
+		const double c = cos(nu);
+		const double s = sin(nu);
+		const double r = p / (1.0 + e * c) * sizeFactor;
+		points.push_back(Vector(static_cast<float>(r * (c * o.p[0] + s * o.q[0])), static_cast<float>(r * (c * o.p[1] + s * o.q[1])),
+			static_cast<float>(r * (c * o.p[2] + s * o.q[2]))));
+		if (nu >= nuEnd) {
+			break;
+		}
+		// The curvature changes along the step, take the shorter step of both ends
+		double step = std::min(conicStep(p, e, nu, maxError), maxStep);
+		step = std::min(step, conicStep(p, e, nu + step, maxError));
+		nu += std::max(step, minStep);
+		if (nu >= nuEnd) {
+			if (e < 1.0) {
+				//closed: the line model connects the last point to the first
+				break;
+			}
+			nu = nuEnd;
+		}
+	}
+	return points;
+}
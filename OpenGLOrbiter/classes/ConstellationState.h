@@ -0,0 +1,148 @@
+//Author: Bernhard Luedtke
+#ifndef ConstellationState_hpp
+#define ConstellationState_hpp
+
+#include <vector>
+#include "OrbitEphemeris.h"
+#include "CompiledOrbit.h"
+
+class ThreadPool;
+
+// Solver used for a satellite. Automatic: eccentric anomaly (Kepler's equation) for closed orbits
+// with e < ellipticBatchMaxEccentricity while the universal solve runs without lanes (Scalar, or Exact Stumpff functions),
+// universal variable for everything else.
+// Universal/Elliptic force one of them, Elliptic is still only used for closed orbits.
+enum class KeplerPath { Automatic, Universal, Elliptic };
+
+// Counters of the universal variable solves since the last resetSolveStats()
+struct KeplerSolveStats {
+	size_t solves = 0;
+	size_t iterations = 0;
+	unsigned int maxIterations = 0;
+	size_t warmStarts = 0;			// solves that started from the satellite's previous solution
+	size_t laguerreFallbacks = 0;	// Newton gave up, Laguerre took over
+	size_t unconverged = 0;
+	size_t fgCheckFailures = 0;		// |f*gD - fD*g - 1| > 1e-10, the position is not trustworthy
+	double maxFgDeviation = 0.0;
+
+	void merge(const KeplerSolveStats& other);
+};
+
+// Propagation state of every satellite, stored as structure of arrays (the constant epoch values as one CompiledOrbit per satellite).
+// Satellites only hold an index into this store; propagateTo computes all of them in one loop
+// instead of going through one Satellite object (and its own OrbitEphemeris) at a time.
+// The state at each satellite's epoch is never changed: every position is solved directly from the epoch,
+// so any absolute time (forwards, backwards, far away) costs the same and no error builds up over many steps.
+class ConstellationState {
+public:
+	ConstellationState();
+	~ConstellationState();
+
+	// Adds a satellite whose elements are valid at the current time of the store, returns its index in the store
+	size_t add(OrbitEphemeris eph, ForceModel model = ForceModel::TwoBody);
+	// Replaces the elements of satellite i, they are valid from the current time of the store on. The force model stays.
+	void setEphemeris(size_t i, OrbitEphemeris eph);
+	// J2Secular costs one more rotation per satellite and propagation; the epoch stays, the drift counts from there
+	void setForceModel(size_t i, ForceModel model);
+	ForceModel getForceModel(size_t i) const { return orbits[i].forceModel; }
+	size_t size() const noexcept { return orbits.size(); }
+	void reserve(size_t n);
+
+	// Computes every satellite at the absolute time t (seconds). The previous state is kept for interpolation.
+	void propagateTo(double t);
+	// Advances every satellite by dt seconds (one fixed tick of the SimulationClock), same as propagateTo(getTime() + dt)
+	void propagateBatch(double dt);
+	// Jumps to t without anything to interpolate from, e.g. after scrubbing the time line
+	void seek(double t);
+	double getTime() const noexcept { return currentTime; }
+	void setKeplerPath(KeplerPath path) { keplerPath = path; }
+	KeplerPath getKeplerPath() const noexcept { return keplerPath; }
+	// Starting the universal variable solves from the previous solution of each satellite (default on)
+	void setWarmStart(bool enabled) { warmStart = enabled; }
+	// Propagates chunks of chunkSize satellites on the pool (nullptr: on the calling thread).
+	// The satellites are split into the same chunks with and without a pool, so results do not depend on the number of threads.
+	void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+	void setChunkSize(size_t satellites) { chunkSize = (satellites > 0) ? satellites : 1; }
+	size_t getChunkSize() const noexcept { return chunkSize; }
+	const KeplerSolveStats& getSolveStats() const noexcept { return stats; }
+	void resetSolveStats() { stats = KeplerSolveStats(); }
+
+	// Position/Speed in the (scaled down) coordinate system used for rendering
+	Vector getR(size_t i) const;
+	// Position between the state before the last propagateBatch (alpha = 0) and the current one (alpha = 1)
+	Vector getInterpolatedR(size_t i, double alpha) const;
+	Vector getV(size_t i) const;
+	// Unscaled state in km and km/s
+	void getStateKm(size_t i, double r[3], double v[3]) const;
+	const OrbitEphemeris& getEphemeris(size_t i) const;
+	// Whole state as 6 doubles per satellite (r km, v km/s), for checkpoints
+	void copyStateKm(double* rv) const;
+	// Makes the given state the epoch of every satellite at t (as written by copyStateKm), the elements in getEphemeris stay as they were.
+	// Nothing to interpolate from afterwards, like seek.
+	void restartFromState(const double* rv, double t);
+	// Makes the current state the epoch of every satellite: the next propagation starts from here
+	// instead of the original elements (a step of an integrator instead of a direct solve).
+	void rebaseEpochs();
+	const CompiledOrbit& getCompiledOrbit(size_t i) const { return orbits[i]; }
+
+	// State of one compiled orbit at the absolute time t (km, km/s), solved on its own from a cold start with the formulas of propagateTo.
+	// Reads nothing but o, for callers that need single states at arbitrary times (fitting, checks); 0 for invalid orbits.
+	static void stateAt(const CompiledOrbit& o, double t, double r[3], double v[3]);
+	// Render frame positions along one period of the orbit, every step seconds from periapsis + step on (orbit lines).
+	// Orbits longer than 10000 steps get as many steps as one period needs.
+	static std::vector<Vector> sampleOrbit(OrbitEphemeris eph, double step = 120.0);
+	// Render frame points of the orbit's conic, straight from the elements (no Kepler solve), from periapsis on.
+	// The true anomaly steps follow the radius of curvature so that no chord is farther than maxError (km) from the curve:
+	// short steps where the conic bends sharply, long ones on flat arcs. Open orbits end where they reach openConicRadius.
+	static std::vector<Vector> sampleConic(const OrbitEphemeris& eph, double maxError = 2.0);
+	static constexpr double openConicRadius = 200000.0;
+
+private:
+	// keepPrevious: the current positions become the previous ones (propagateTo), otherwise both are set to t (seek)
+	void propagateAll(double t, bool keepPrevious);
+	void propagateRange(size_t begin, size_t end, double t, KeplerSolveStats& rangeStats);
+	// Universal variable solve and f/g of the satellites gathered into [begin, gathered) of the scratch arrays
+	void solveUniversalRange(size_t begin, size_t gathered, KeplerSolveStats& rangeStats);
+	bool useElliptic(size_t i, bool automaticElliptic) const;
+	void propagateElliptic(size_t i, double dt, double E, double sinE, double cosE);
+	// Turns the two body state of the J2Secular satellites in [begin, end) by the drift of periapsis and node since their epoch
+	void applySecularDrift(size_t begin, size_t end, double t);
+
+	// Kepler's problem inputs at the epoch, compiled once per ephemeris in add()/setEphemeris().
+	// The propagation reads nothing else of a satellite's orbit.
+	std::vector<CompiledOrbit> orbits;
+	// Satellites with ForceModel::J2Secular, applySecularDrift is skipped while there are none
+	size_t secularSatellites = 0;
+
+	// State at currentTime
+	std::vector<double> rX, rY, rZ;
+	std::vector<double> vX, vY, vZ;
+	// Position before the last propagateTo, for interpolation
+	std::vector<double> prevX, prevY, prevZ;
+	// Last universal variable solution per satellite, the starting point of the next solve
+	std::vector<double> lastX, lastDt, lastRLength;
+	std::vector<unsigned char> lastValid;
+	double currentTime = 0.0;
+	KeplerPath keplerPath = KeplerPath::Automatic;
+	bool warmStart = true;
+	KeplerSolveStats stats;
+	ThreadPool* threadPool = nullptr;
+	size_t chunkSize = 1024;
+	// Counters of each chunk of the last propagation, merged into stats in chunk order
+	std::vector<KeplerSolveStats> chunkStats;
+
+	// Scratch arrays for the batched Kepler kernels, the satellites of each path are gathered into these
+	std::vector<double> stepDt;
+	std::vector<size_t> gatherIndex;
+	std::vector<double> gatherAlpha, gatherR0Length, gatherSigma0, gatherDt;
+	std::vector<double> solvedX, solvedC, solvedS;
+	std::vector<unsigned int> solvedIterations;
+	std::vector<size_t> ellipticIndex;
+	std::vector<double> gatherEcc, gatherMean;
+	std::vector<double> solvedE, solvedSinE, solvedCosE;
+
+	// Cold data, only needed when (re)initializing
+	std::vector<OrbitEphemeris> ephemerides;
+};
+
+#endif /* ConstellationState_hpp */
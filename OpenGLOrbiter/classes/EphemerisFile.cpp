@@ -0,0 +1,230 @@
+//Author: Bernhard Luedtke
+
+#include "EphemerisFile.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+static_assert(sizeof(EphemerisFileHeader) == 64, "the header is 64 bytes in the file");
+static_assert(sizeof(EphemerisIndexEntry) == 64, "index entries are 64 bytes in the file");
+
+static const char ephemerisMagic[8] = { 'O', 'G', 'L', 'O', 'E', 'P', 'H', '\0' };
+static const uint32_t ephemerisByteOrder = 0x01020304u;
+static const uint64_t segmentAlignment = 64;
+
+EphemerisFile::EphemerisFile()
+{
+	;
+}
+
+EphemerisFile::~EphemerisFile()
+{
+	close();
+}
+
+uint32_t EphemerisFile::checksum(const void* data, size_t bytes, uint32_t crc)
+{
+	// Table of the reflected polynomial 0xEDB88320, built once (thread safe since C++11)
+	static const std::vector<uint32_t> table = [] {
+		std::vector<uint32_t> t(256);
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k) {
+				c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			t[n] = c;
+		}
+		return t;
+	}();
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < bytes; ++i) {
+		crc = table[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+uint64_t EphemerisFile::hashElements(const OrbitEphemeris& eph)
+{
+	const double values[5] = { eph.semiMajorA, eph.eccentricity, eph.inclination, eph.longitudeAsc, eph.argPeriaps };
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(values);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < sizeof(values); ++i) {
+		hash = (hash ^ p[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool EphemerisFile::open(const char* path)
+{
+	close();
+	if (!file.open(path)) {
+		return false;
+	}
+	const char* data = file.data();
+	const size_t size = file.size();
+	EphemerisFileHeader header;
+	if (size < sizeof(header)) {
+		std::cerr << path << ": not an ephemeris file" << std::endl;
+		close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	const char* problem = nullptr;
+	if (std::memcmp(header.magic, ephemerisMagic, sizeof(ephemerisMagic)) != 0) {
+		problem = "not an ephemeris file";
+	}
+	else if (header.byteOrder != ephemerisByteOrder) {
+		problem = "written with another byte order";
+	}
+	else if (header.version != ephemerisFileVersion || header.headerBytes != sizeof(EphemerisFileHeader) || header.entryBytes != sizeof(EphemerisIndexEntry)) {
+		problem = "other version, write it again";
+	}
+	else if (checksum(data, offsetof(EphemerisFileHeader, headerChecksum)) != header.headerChecksum) {
+		problem = "header checksum wrong";
+	}
+	else if (header.fileBytes != size || header.indexOffset % segmentAlignment != 0
+		|| header.indexOffset > size || (size - header.indexOffset) / sizeof(EphemerisIndexEntry) < header.satelliteCount) {
+		problem = "truncated";
+	}
+	else if (checksum(data + header.indexOffset, header.satelliteCount * sizeof(EphemerisIndexEntry)) != header.indexChecksum) {
+		problem = "index checksum wrong";
+	}
+	if (problem == nullptr) {
+		const EphemerisIndexEntry* index = reinterpret_cast<const EphemerisIndexEntry*>(data + header.indexOffset);
+		for (size_t i = 0; i < header.satelliteCount && problem == nullptr; ++i) {
+			const EphemerisIndexEntry& e = index[i];
+			if (e.segmentOffset % segmentAlignment != 0 || e.segmentOffset > size || (size - e.segmentOffset) / (3 * sizeof(float)) < e.pointCount) {
+				problem = "segment outside the file";
+			}
+			else if (i > 0 && index[i - 1].satelliteId >= e.satelliteId) {
+				problem = "index not sorted";
+			}
+		}
+	}
+	if (problem != nullptr) {
+		std::cerr << path << ": " << problem << std::endl;
+		close();
+		return false;
+	}
+	entries = reinterpret_cast<const EphemerisIndexEntry*>(data + header.indexOffset);
+	count = header.satelliteCount;
+	segmentState.assign(count, 0);
+	return true;
+}
+
+void EphemerisFile::close()
+{
+	file.close();
+	entries = nullptr;
+	count = 0;
+	segmentState.clear();
+	hits = 0;
+	misses = 0;
+	stale = 0;
+	corrupt = 0;
+}
+
+const float* EphemerisFile::findTrack(uint64_t satelliteId, uint64_t elementsHash, size_t& pointCount)
+{
+	pointCount = 0;
+	const EphemerisIndexEntry* end = entries + count;
+	const EphemerisIndexEntry* e = std::lower_bound(entries, end, satelliteId,
+		[](const EphemerisIndexEntry& entry, uint64_t id) { return entry.satelliteId < id; });
+	if (e == end || e->satelliteId != satelliteId) {
+		++misses;
+		return nullptr;
+	}
+	if (e->elementsHash != elementsHash) {
+		++stale;
+		return nullptr;
+	}
+	const float* points = reinterpret_cast<const float*>(file.data() + e->segmentOffset);
+	unsigned char& state = segmentState[e - entries];
+	if (state == 0) {
+		state = (checksum(points, e->pointCount * 3 * sizeof(float)) == e->segmentChecksum) ? 1 : 2;
+	}
+	if (state == 2) {
+		++corrupt;
+		return nullptr;
+	}
+	++hits;
+	pointCount = e->pointCount;
+	return points;
+}
+
+bool EphemerisFile::write(const char* path, std::vector<EphemerisTrack> tracks)
+{
+	std::sort(tracks.begin(), tracks.end(), [](const EphemerisTrack& a, const EphemerisTrack& b) { return a.satelliteId < b.satelliteId; });
+	for (size_t i = 1; i < tracks.size(); ++i) {
+		if (tracks[i - 1].satelliteId == tracks[i].satelliteId) {
+			std::cerr << "Ephemeris file: satellite " << tracks[i].satelliteId << " twice" << std::endl;
+			return false;
+		}
+	}
+	// Layout: header, index, segments, each on a 64 byte boundary
+	const auto align = [](uint64_t offset) { return (offset + segmentAlignment - 1) / segmentAlignment * segmentAlignment; };
+	std::vector<EphemerisIndexEntry> index(tracks.size());
+	std::vector<std::vector<float>> segments(tracks.size());
+	uint64_t offset = align(sizeof(EphemerisFileHeader) + tracks.size() * sizeof(EphemerisIndexEntry));
+	for (size_t i = 0; i < tracks.size(); ++i) {
+		const EphemerisTrack& track = tracks[i];
+		std::vector<float>& segment = segments[i];
+		segment.reserve(track.points.size() * 3);
+		for (const Vector& p : track.points) {
+			segment.push_back(p.X);
+			segment.push_back(p.Y);
+			segment.push_back(p.Z);
+		}
+		EphemerisIndexEntry& e = index[i];
+		std::memset(&e, 0, sizeof(e));
+		e.satelliteId = track.satelliteId;
+		e.elementsHash = track.elementsHash;
+		e.segmentOffset = offset;
+		e.pointCount = static_cast<uint32_t>(track.points.size());
+		e.segmentChecksum = checksum(segment.data(), segment.size() * sizeof(float));
+		e.startTime = track.startTime;
+		e.step = track.step;
+		offset = align(offset + segment.size() * sizeof(float));
+	}
+	EphemerisFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, ephemerisMagic, sizeof(ephemerisMagic));
+	header.version = ephemerisFileVersion;
+	header.byteOrder = ephemerisByteOrder;
+	header.headerBytes = sizeof(EphemerisFileHeader);
+	header.entryBytes = sizeof(EphemerisIndexEntry);
+	header.satelliteCount = static_cast<uint32_t>(tracks.size());
+	header.indexChecksum = checksum(index.data(), index.size() * sizeof(EphemerisIndexEntry));
+	header.indexOffset = sizeof(EphemerisFileHeader);
+	header.fileBytes = offset;
+	header.headerChecksum = checksum(&header, offsetof(EphemerisFileHeader, headerChecksum));
+
+	FILE* out = std::fopen(path, "wb");
+	if (out == nullptr) {
+		std::cerr << "Can not write " << path << std::endl;
+		return false;
+	}
+	static const char padding[segmentAlignment] = {};
+	uint64_t written = 0;
+	const auto put = [&](const void* data, size_t bytes) {
+		written += std::fwrite(data, 1, bytes, out);
+	};
+	put(&header, sizeof(header));
+	put(index.data(), index.size() * sizeof(EphemerisIndexEntry));
+	// After a failed write the padding would not fit any more, written != offset then anyway
+	for (size_t i = 0; i < segments.size() && written <= index[i].segmentOffset && index[i].segmentOffset - written < segmentAlignment; ++i) {
+		put(padding, static_cast<size_t>(index[i].segmentOffset - written));
+		put(segments[i].data(), segments[i].size() * sizeof(float));
+	}
+	if (written <= offset && offset - written < segmentAlignment) {
+		put(padding, static_cast<size_t>(offset - written));
+	}
+	const bool ok = std::fclose(out) == 0 && written == offset;
+	if (!ok) {
+		std::cerr << "Writing " << path << " failed" << std::endl;
+	}
+	return ok;
+}
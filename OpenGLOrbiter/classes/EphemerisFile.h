@@ -0,0 +1,101 @@
+//Author: Bernhard Luedtke
+#ifndef EphemerisFile_hpp
+#define EphemerisFile_hpp
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "Vector.h"
+#include "OrbitEphemeris.h"
+#include "MappedFile.h"
+
+/*
+	Precomputed orbit lines, one track of points per satellite (little endian, everything 8 byte aligned):
+	offset 0					EphemerisFileHeader (64 bytes)
+	indexOffset					satelliteCount x EphemerisIndexEntry (64 bytes each), ascending satelliteId
+	segmentOffset of each entry	pointCount x 3 floats (x, y, z in the render frame), starting on a 64 byte boundary
+	The header, the index and every segment have their own CRC-32. Segments are checked the first time they are read.
+*/
+// 2: tracks sampled by curvature (step 0), version 1 had a point every 120 s
+const uint32_t ephemerisFileVersion = 2;
+
+struct EphemerisFileHeader {
+	char magic[8];				// "OGLOEPH" and a 0
+	uint32_t version;			// ephemerisFileVersion
+	uint32_t byteOrder;			// 0x01020304 as written
+	uint32_t headerBytes;		// sizeof(EphemerisFileHeader)
+	uint32_t entryBytes;		// sizeof(EphemerisIndexEntry)
+	uint32_t satelliteCount;
+	uint32_t indexChecksum;
+	uint64_t indexOffset;
+	uint64_t fileBytes;
+	uint32_t reserved[3];
+	uint32_t headerChecksum;	// of the 60 bytes before
+};
+
+struct EphemerisIndexEntry {
+	uint64_t satelliteId;
+	// EphemerisFile::hashElements of the orbit the track was computed from: another hash means the track is stale
+	uint64_t elementsHash;
+	uint64_t segmentOffset;
+	uint32_t pointCount;
+	uint32_t segmentChecksum;
+	// Seconds after the epoch (periapsis) of the first point, seconds between the points; both 0 for points that are not evenly timed
+	double startTime;
+	double step;
+	uint32_t reserved[4];
+};
+
+// One satellite's track, for writing
+struct EphemerisTrack {
+	uint64_t satelliteId = 0;
+	uint64_t elementsHash = 0;
+	double startTime = 0.0;
+	double step = 0.0;
+	std::vector<Vector> points;
+};
+
+// Read only, memory mapped ephemeris file. The points are used where they are in the mapping (no copy).
+// Satellites that are not in the file, whose elements changed since it was written or whose segment is corrupt
+// are reported as missing, the caller computes them live.
+class EphemerisFile {
+public:
+	EphemerisFile();
+	~EphemerisFile();
+	EphemerisFile(const EphemerisFile&) = delete;
+	EphemerisFile& operator=(const EphemerisFile&) = delete;
+
+	// Maps the file and checks header and index. Returns false (and reports why) if it is unusable: wrong version, byte order, checksums.
+	bool open(const char* path);
+	void close();
+	bool isOpen() const noexcept { return entries != nullptr; }
+	size_t getSatelliteCount() const noexcept { return count; }
+
+	// Points of the satellite's track (3 floats each) and their number, nullptr if the track is missing, stale or corrupt
+	const float* findTrack(uint64_t satelliteId, uint64_t elementsHash, size_t& pointCount);
+	// Lookups since open(): found, not in the file, other elements, segment checksum wrong
+	size_t getHits() const noexcept { return hits; }
+	size_t getMisses() const noexcept { return misses; }
+	size_t getStale() const noexcept { return stale; }
+	size_t getCorrupt() const noexcept { return corrupt; }
+
+	// Writes the tracks as a new file (sorted by satelliteId, ids must be unique). Returns false if it can not be written.
+	static bool write(const char* path, std::vector<EphemerisTrack> tracks);
+	// 64 bit FNV-1a of the orbit's shape and orientation (true anomaly left out, tracks start at periapsis)
+	static uint64_t hashElements(const OrbitEphemeris& eph);
+	// CRC-32 (IEEE 802.3), crc: the result for the bytes before, to continue it
+	static uint32_t checksum(const void* data, size_t bytes, uint32_t crc = 0);
+
+private:
+	MappedFile file;
+	const EphemerisIndexEntry* entries = nullptr;
+	size_t count = 0;
+	// Per entry: 0 not checked yet, 1 checksum fine, 2 wrong
+	std::vector<unsigned char> segmentState;
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t stale = 0;
+	size_t corrupt = 0;
+};
+
+#endif /* EphemerisFile_hpp */
@@ -3,6 +3,7 @@
     //  Created by Philipp Lensing on 19.09.16.
 
 #include "FlatColorShader.h"
+#include "ShaderProgramRegistry.h"
 
 const char *CVertexShaderCode =
 "#version 400\n"
@@ -24,9 +25,9 @@ const char *CFragmentShaderCode =
 
 FlatColorShader::FlatColorShader() : Col(0.2f,0.2f,1.0f)
 {
-	std::string* cv = new std::string(CVertexShaderCode);
-	std::string* cf = new std::string(CFragmentShaderCode);
-  ShaderProgram = createShaderProgram(cv, cf);
+	std::string cv(CVertexShaderCode);
+	std::string cf(CFragmentShaderCode);
+  ShaderProgram = createShaderProgram(&cv, &cf);
 	
   ColorLoc = glGetUniformLocation(ShaderProgram, "Color");
   assert(ColorLoc>=0);
@@ -36,14 +37,18 @@ FlatColorShader::FlatColorShader() : Col(0.2f,0.2f,1.0f)
 }
 FlatColorShader::FlatColorShader(const Color & c) : Col(c)
 {
-	std::string* cv = new std::string(CVertexShaderCode);
-	std::string* cf = new std::string(CFragmentShaderCode);
-	ShaderProgram = createShaderProgram(cv, cf);
+	std::string cv(CVertexShaderCode);
+	std::string cf(CFragmentShaderCode);
+	ShaderProgram = createShaderProgram(&cv, &cf);
 	ColorLoc = glGetUniformLocation(ShaderProgram, "Color");
 	assert(ColorLoc >= 0);
 	ModelViewProjLoc = glGetUniformLocation(ShaderProgram, "ModelViewProjMat");
 	assert(ModelViewProjLoc >= 0);
 }
+void FlatColorShader::precompile()
+{
+	ShaderProgramRegistry::precompile(CVertexShaderCode, CFragmentShaderCode);
+}
 void FlatColorShader::activate(const BaseCamera& Cam) const
 {
 	StandardShader::activate(Cam);
@@ -34,12 +34,13 @@ class FlatColorShader : public StandardShader
 public:
     FlatColorShader();
     FlatColorShader(const Color& c);
+    // Starts compiling the program of all FlatColorShaders (ShaderProgramRegistry::precompile)
+    static void precompile();
     void color( const Color& c);
     const Color& color() const { return Col; }
     virtual void activate(const BaseCamera& Cam) const;
 private:
     Color Col;
-    GLuint ShaderProgram;
     GLint ColorLoc;
     GLint ModelViewProjLoc;
 };
@@ -0,0 +1,57 @@
+//Author: Bernhard Luedtke
+
+#include "InstancedSphereModel.h"
+#include "PhongShaderInstanced.h"
+
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
+InstancedSphereModel::InstancedSphereModel(float Radius, int Stacks, int Slices) : TriangleSphereModel(Radius, Stacks, Slices),
+	Stream(std::make_unique<StreamBuffer>(GL_ARRAY_BUFFER, 4096 * sizeof(SphereInstance))), ReservedCount(0), InstanceCount(0), AttributesEnabled(false)
+{
+}
+
+InstancedSphereModel::~InstancedSphereModel()
+{
+}
+
+SphereInstance* InstancedSphereModel::reserve(size_t count)
+{
+	if (count > ReservedCount) {
+		Reserved = Stream->allocate(count * sizeof(SphereInstance));
+		ReservedCount = count;
+		InstanceCount = 0;
+	}
+	return instanceData();
+}
+
+void InstancedSphereModel::draw(const BaseCamera& Cam)
+{
+	if (InstanceCount == 0) {
+		return;
+	}
+	StandardModel::draw(Cam);
+
+	VB.activate();
+	Stream->commit(Reserved, InstanceCount * sizeof(SphereInstance));
+	if (!AttributesEnabled) {
+		// Stored in the mesh's vertex array object
+		glEnableVertexAttribArray(PhongShaderInstanced::instancePositionAttribute);
+		glVertexAttribDivisor(PhongShaderInstanced::instancePositionAttribute, 1);
+		glEnableVertexAttribArray(PhongShaderInstanced::instanceColorAttribute);
+		glVertexAttribDivisor(PhongShaderInstanced::instanceColorAttribute, 1);
+		AttributesEnabled = true;
+	}
+	// The region moves every frame (and the buffer when it grows)
+	glVertexAttribPointer(PhongShaderInstanced::instancePositionAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), BUFFER_OFFSET(Reserved.offset));
+	glVertexAttribPointer(PhongShaderInstanced::instanceColorAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+		BUFFER_OFFSET(Reserved.offset + 3 * sizeof(float)));
+
+	IB.activate();
+	glDrawElementsInstanced(GL_TRIANGLES, IB.indexCount(), IB.indexFormat(), 0, static_cast<GLsizei>(InstanceCount));
+	IB.deactivate();
+	VB.deactivate();
+	Stream->endFrame();
+	Reserved = StreamBuffer::Range();
+	ReservedCount = 0;
+	InstanceCount = 0;
+}
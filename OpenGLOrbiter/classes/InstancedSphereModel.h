@@ -0,0 +1,46 @@
+//Author: Bernhard Luedtke
+
+#ifndef InstancedSphereModel_hpp
+#define InstancedSphereModel_hpp
+
+#include <stdio.h>
+#include <memory>
+#include <algorithm>
+#include "TriangleSphereModel.h"
+#include "StreamBuffer.h"
+
+// One sphere of an InstancedSphereModel: center in the render frame and diffuse color (24 bytes, as in the instance buffer)
+struct SphereInstance {
+	float x, y, z;
+	float r, g, b;
+};
+
+/*
+	Draws one sphere mesh at any number of positions with a single glDrawElementsInstanced (use it with a PhongShaderInstanced).
+	The instances are read as per instance attributes (4 and 5, divisor 1) from a StreamBuffer. reserve() takes the space for the
+	next draw() from it on the thread with the GL context; the instances can then be written straight into the mapped buffer from
+	any thread, without a copy. Every draw() uses up the reserved space.
+*/
+class InstancedSphereModel : public TriangleSphereModel
+{
+public:
+	InstancedSphereModel(float Radius, int Stacks = 9, int Slices = 18);
+	virtual ~InstancedSphereModel();
+	// Room for count instances of the next draw() (GL thread). Keeps the space already reserved if it is large enough.
+	SphereInstance* reserve(size_t count);
+	SphereInstance* instanceData() const noexcept { return static_cast<SphereInstance*>(Reserved.data); }
+	size_t instanceCapacity() const noexcept { return ReservedCount; }
+	// Instances written into instanceData(), drawn by the next draw()
+	void setInstanceCount(size_t count) { InstanceCount = std::min(count, ReservedCount); }
+	size_t instanceCount() const noexcept { return InstanceCount; }
+	const StreamBuffer& stream() const { return *Stream; }
+	virtual void draw(const BaseCamera& Cam);
+protected:
+	std::unique_ptr<StreamBuffer> Stream;
+	StreamBuffer::Range Reserved;
+	size_t ReservedCount;
+	size_t InstanceCount;
+	bool AttributesEnabled;
+};
+
+#endif /* InstancedSphereModel_hpp */
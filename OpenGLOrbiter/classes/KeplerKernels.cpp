@@ -0,0 +1,311 @@
+//Author: Bernhard Luedtke
+
+#include "KeplerKernels.h"
+#include "KeplerKernelsLanes.h"
+#include "CompiledOrbit.h"
+#include "OrbitConstants.h"
+#include "Stumpff.h"
+#include <cmath>
+
+#ifdef KEPLER_KERNELS_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef KEPLER_KERNELS_X86
+static void cpuid(int info[4], int leaf, int subleaf)
+{
+#if defined(_MSC_VER)
+	__cpuidex(info, leaf, subleaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	info[0] = (int)a; info[1] = (int)b; info[2] = (int)c; info[3] = (int)d;
+#endif
+}
+
+// Which register states the OS saves on context switches (XCR0)
+static unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+#endif
+
+SimdLevel detectSimdLevel()
+{
+	SimdLevel level = SimdLevel::Scalar;
+#ifdef KEPLER_KERNELS_X86
+	int info[4];
+	cpuid(info, 0, 0);
+	const int maxLeaf = info[0];
+	cpuid(info, 1, 0);
+	const bool sse2 = (info[3] & (1 << 26)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (sse2) {
+		level = SimdLevel::SSE2;
+	}
+	if (osxsave && avx && maxLeaf >= 7) {
+		const unsigned long long xcr0 = xgetbv0();
+		cpuid(info, 7, 0);
+		// XMM and YMM state
+		if ((xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5))) {
+			level = SimdLevel::AVX2;
+			// additionally opmask and ZMM state, AVX-512F
+			if ((xcr0 & 0xE0) == 0xE0 && (info[1] & (1 << 16))) {
+				level = SimdLevel::AVX512;
+			}
+		}
+	}
+#endif
+	return level;
+}
+
+static const SimdLevel detectedLevel = detectSimdLevel();
+static SimdLevel activeLevel = detectedLevel;
+
+SimdLevel getSimdLevel()
+{
+	return activeLevel;
+}
+
+void setSimdLevel(SimdLevel level)
+{
+	activeLevel = (static_cast<int>(level) > static_cast<int>(detectedLevel)) ? detectedLevel : level;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::AVX512: return "AVX-512";
+	default: return "Scalar";
+	}
+}
+
+// 4.4-14
+static double timeOfFlight(double x, double alpha, double r0L, double sig0, double c, double s)
+{
+	const double x2 = x * x;
+	const double term1 = (sig0 * x2) * c;
+	const double term2 = ((1.0 - r0L * alpha) * (x2 * x)) * s;
+	const double term3 = r0L * x;
+	return ((term1 + term2) + term3) / sqMU;
+}
+
+double universalAnomalyGuess(double alpha, double r0L, double sig0, double dt)
+{
+	if (alpha > 0.0) {
+		//4.5-10
+		return (sqMU * dt) * alpha;
+	}
+	if (alpha < 0.0) {
+		//Hyperbola (Vallado, Fundamentals of Astrodynamics and Applications, algorithm 8)
+		const double a = 1.0 / alpha;
+		const double sign = (dt < 0.0) ? -1.0 : 1.0;
+		const double arg = (-2.0 * mu * dt * alpha) / (sig0 * sqMU + sign * std::sqrt(-mu * a) * (1.0 - r0L * alpha));
+		if (arg > 0.0) {
+			return sign * std::sqrt(-a) * std::log(arg);
+		}
+	}
+	return (sqMU * dt) / r0L;
+}
+
+// Convergence test of 4.4-15: relative to the time of flight, two-sided. False for NaN, the iteration then runs out of steps.
+static bool converged(double t, double tn)
+{
+	return std::abs(t - tn) < keplerTimeTolerance * (1.0 + std::abs(t));
+}
+
+static unsigned int solveUniversalAnomalyNewton(double alpha, double r0L, double sig0, double t, double& x, double& c, double& s)
+{
+	double z = (x * x) * alpha;
+	stumpffCS(z, c, s);
+	double tn = timeOfFlight(x, alpha, r0L, sig0, c, s);
+	unsigned int k = 0;
+	//4.4-15 Newton iteration
+	while (!converged(t, tn)) {
+		if (k == keplerNewtonMaxIterations) {
+			return keplerNewtonMaxIterations + 1;
+		}
+		//4.4-17
+		const double term1 = (x * x) * c;
+		const double term2 = (sig0 * x) * (1.0 - z * s);
+		const double term3 = r0L * (1.0 - z * c);
+		const double dtdx = ((term1 + term2) + term3) / sqMU;
+		x = x + (t - tn) / dtdx;
+		z = (x * x) * alpha;
+		stumpffCS(z, c, s);
+		tn = timeOfFlight(x, alpha, r0L, sig0, c, s);
+		++k;
+	}
+	return k;
+}
+
+/*
+	Laguerre's method for the universal Kepler equation (Conway 1986), converges from the cold guess where Newton cycles or diverges
+	(e.g. high eccentricities). With F(x) = t(x) - t:
+	x = x - n*F / (F' + sign(F') * sqrt(|(n-1)^2 * F'^2 - n*(n-1) * F * F''|)),  n = 5
+	F' = r(x)/sqrt(mu) (4.4-17) and F'' = (sigma0*(1 - z*C) + (1 - r0*alpha)*x*(1 - z*S)) / sqrt(mu)
+*/
+static unsigned int solveUniversalAnomalyLaguerre(double alpha, double r0L, double sig0, double t, double& x, double& c, double& s)
+{
+	const double n = 5.0;
+	x = universalAnomalyGuess(alpha, r0L, sig0, t);
+	double z = (x * x) * alpha;
+	stumpffCS(z, c, s);
+	double tn = timeOfFlight(x, alpha, r0L, sig0, c, s);
+	unsigned int k = 0;
+	while (!converged(t, tn)) {
+		if (k == keplerLaguerreMaxIterations) {
+			return keplerLaguerreMaxIterations + 1;
+		}
+		const double F = tn - t;
+		const double dF = ((x * x) * c + (sig0 * x) * (1.0 - z * s) + r0L * (1.0 - z * c)) / sqMU;
+		const double ddF = (sig0 * (1.0 - z * c) + (1.0 - r0L * alpha) * x * (1.0 - z * s)) / sqMU;
+		const double root = std::sqrt(std::abs((n - 1.0) * (n - 1.0) * dF * dF - n * (n - 1.0) * F * ddF));
+		x = x - n * F / (dF + ((dF < 0.0) ? -root : root));
+		z = (x * x) * alpha;
+		stumpffCS(z, c, s);
+		tn = timeOfFlight(x, alpha, r0L, sig0, c, s);
+		++k;
+	}
+	return k;
+}
+
+unsigned int solveUniversalAnomaly(double alpha, double r0L, double sig0, double t, double& x, double& c, double& s)
+{
+	const unsigned int newton = solveUniversalAnomalyNewton(alpha, r0L, sig0, t, x, c, s);
+	if (newton <= keplerNewtonMaxIterations) {
+		return newton;
+	}
+	return keplerNewtonMaxIterations + solveUniversalAnomalyLaguerre(alpha, r0L, sig0, t, x, c, s);
+}
+
+unsigned int solveUniversalAnomaly(const CompiledOrbit& orbit, double t, double& x, double& c, double& s)
+{
+	return solveUniversalAnomaly(orbit.alpha, orbit.r0Length, orbit.sigma0, t, x, c, s);
+}
+
+// sin(E), cos(E) from sin(M), cos(M) and the Taylor series of sin/cos(E - M), for |E - M| < 0.25 (error < 1e-17)
+static void sinCosFromMean(double delta, double sinM, double cosM, double& sinE, double& cosE)
+{
+	const double d2 = delta * delta;
+	const double sinD = delta * (1.0 + d2 * (-1.0 / 6.0 + d2 * (1.0 / 120.0 + d2 * (-1.0 / 5040.0 + d2 * (1.0 / 362880.0 + d2 * (-1.0 / 39916800.0))))));
+	const double cosD = 1.0 + d2 * (-1.0 / 2.0 + d2 * (1.0 / 24.0 + d2 * (-1.0 / 720.0 + d2 * (1.0 / 40320.0 + d2 * (-1.0 / 3628800.0 + d2 * (1.0 / 479001600.0))))));
+	sinE = sinM * cosD + cosM * sinD;
+	cosE = cosM * cosD - sinM * sinD;
+}
+
+static double solveEccentricAnomaly(double e, double meanAnomaly, double sinM, double cosM, double& sinE, double& cosE)
+{
+	//For small eccentricities E stays close to M (|E - M| <= e), then the only trig calls are the ones for M
+	const double nearMean = 0.25;
+	double E = meanAnomaly + ((sinM < 0.0) ? -0.85 : 0.85) * e;
+	for (unsigned int k = 0; k < keplerEllipticMaxIterations; k++) {
+		const double delta = E - meanAnomaly;
+		if (std::abs(delta) < nearMean) {
+			sinCosFromMean(delta, sinM, cosM, sinE, cosE);
+		}
+		else {
+			sinE = std::sin(E);
+			cosE = std::cos(E);
+		}
+		const double eSin = e * sinE;
+		const double eCos = e * cosE;
+		//f(E) and its derivatives: f0, f1 = 1 - e*cos(E), f2 = e*sin(E), f3 = e*cos(E)
+		const double f0 = (E - eSin) - meanAnomaly;
+		const double f1 = 1.0 - eCos;
+		const double d1 = -f0 / f1;
+		const double d2 = -f0 / (f1 + (0.5 * d1) * eSin);
+		const double d3 = -f0 / ((f1 + (0.5 * d2) * eSin) + ((d2 * d2) * eCos) * (1.0 / 6.0));
+		E = E + d3;
+		//Fourth order: once a correction is below 1e-4, the next one would be below double precision
+		if (std::abs(d3) < 1e-4) {
+			break;
+		}
+	}
+	const double delta = E - meanAnomaly;
+	if (std::abs(delta) < nearMean) {
+		sinCosFromMean(delta, sinM, cosM, sinE, cosE);
+	}
+	else {
+		sinE = std::sin(E);
+		cosE = std::cos(E);
+	}
+	return E;
+}
+
+double solveEccentricAnomaly(double e, double meanAnomaly, double& sinE, double& cosE)
+{
+	return solveEccentricAnomaly(e, meanAnomaly, std::sin(meanAnomaly), std::cos(meanAnomaly), sinE, cosE);
+}
+
+void solveEccentricAnomalyBatch(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE)
+{
+	//sin(M), cos(M) are the only trig calls, the iteration itself is vectorized
+	for (size_t i = 0; i < n; ++i) {
+		sinE[i] = std::sin(meanAnomaly[i]);
+		cosE[i] = std::cos(meanAnomaly[i]);
+	}
+	size_t done = 0;
+#ifdef KEPLER_KERNELS_X86
+	switch (activeLevel) {
+	case SimdLevel::AVX512:
+		done = solveEccentricAnomalyAVX512(n, e, meanAnomaly, E, sinE, cosE);
+		break;
+	case SimdLevel::AVX2:
+		done = solveEccentricAnomalyAVX2(n, e, meanAnomaly, E, sinE, cosE);
+		break;
+	case SimdLevel::SSE2:
+		done = solveEccentricAnomalySSE2(n, e, meanAnomaly, E, sinE, cosE);
+		break;
+	default:
+		break;
+	}
+#endif
+	for (size_t i = done; i < n; ++i) {
+		E[i] = solveEccentricAnomaly(e[i], meanAnomaly[i], sinE[i], cosE[i], sinE[i], cosE[i]);
+	}
+}
+
+void solveUniversalAnomalyBatch(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations)
+{
+	size_t done = 0;
+#ifdef KEPLER_KERNELS_X86
+	// Exact Stumpff functions need trig calls, which the lanes do not have
+	switch ((getStumpffMode() == StumpffMode::Exact) ? SimdLevel::Scalar : activeLevel) {
+	case SimdLevel::AVX512:
+		done = solveUniversalAnomalyAVX512(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+		break;
+	case SimdLevel::AVX2:
+		done = solveUniversalAnomalyAVX2(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+		break;
+	case SimdLevel::SSE2:
+		done = solveUniversalAnomalySSE2(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+		break;
+	default:
+		break;
+	}
+	//Lanes where Newton gave up are solved again with Laguerre
+	for (size_t i = 0; i < done; ++i) {
+		if (iterations[i] > keplerNewtonMaxIterations) {
+			iterations[i] = keplerNewtonMaxIterations + solveUniversalAnomalyLaguerre(alpha[i], r0Length[i], sigma0[i], dt[i], x[i], bigC[i], bigS[i]);
+		}
+	}
+#endif
+	for (size_t i = done; i < n; ++i) {
+		iterations[i] = solveUniversalAnomaly(alpha[i], r0Length[i], sigma0[i], dt[i], x[i], bigC[i], bigS[i]);
+	}
+}
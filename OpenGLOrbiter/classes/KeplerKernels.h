@@ -0,0 +1,69 @@
+//Author: Bernhard Luedtke
+#ifndef KeplerKernels_hpp
+#define KeplerKernels_hpp
+
+#include <stddef.h>
+
+struct CompiledOrbit;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define KEPLER_KERNELS_X86 1
+#endif
+
+// Instruction set used by the batched Kepler kernels. Detected once at startup via CPUID.
+enum class SimdLevel { Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+SimdLevel detectSimdLevel();
+SimdLevel getSimdLevel();
+// Forces a level, e.g. Scalar for comparisons. Levels the cpu/os does not support are clamped to the detected one.
+void setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+// Iteration settings for 4.4-15, shared by all kernels.
+// A solve has converged once |dt - t(x)| < keplerTimeTolerance * (1 + |dt|).
+// Newton gets keplerNewtonMaxIterations steps (1-3 from a warm start), then Laguerre starts over from the cold guess.
+constexpr unsigned int keplerNewtonMaxIterations = 20;
+constexpr unsigned int keplerLaguerreMaxIterations = 50;
+constexpr double keplerTimeTolerance = 0.0000000000001;
+
+// The vector kernels do the same operations in the same order as the scalar fallback, so results are usually bit identical.
+// Compilers may still contract a*b+c into fma differently per instruction set; the universal anomaly x then differs
+// from the scalar result by at most this much (relative).
+constexpr double keplerSimdTolerance = 1e-12;
+
+// Solves the universal variable form of Kepler's equation (4.4-14) for n satellites at once.
+// In:  alpha = 1/a, |r0|, r0.dot(v0)/sqrt(mu) and the time of flight dt per satellite (km, s), see CompiledOrbit
+// In/Out: universal anomaly x, the starting guess on input (universalAnomalyGuess, or the last solution for a warm start)
+// Out: the Stumpff values C(z), S(z) at z = x*x*alpha and the number of iterations per satellite:
+//   <= keplerNewtonMaxIterations                              Newton converged
+//   >  keplerNewtonMaxIterations                              Newton gave up, Laguerre converged (count includes the Newton steps)
+//   >  keplerNewtonMaxIterations + keplerLaguerreMaxIterations not converged
+// Lane groups of 2 (SSE2), 4 (AVX2) or 8 (AVX-512) satellites are solved together; a lane stops iterating once it converged.
+// The rest of n that does not fill a lane group, and the Laguerre fallback, run scalar.
+void solveUniversalAnomalyBatch(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations);
+
+// Scalar version for a single satellite, x is in/out as above. Returns the number of iterations.
+unsigned int solveUniversalAnomaly(double alpha, double r0Length, double sigma0, double dt, double& x, double& bigC, double& bigS);
+// Same, with the invariants taken from the compiled orbit
+unsigned int solveUniversalAnomaly(const CompiledOrbit& orbit, double dt, double& x, double& bigC, double& bigS);
+
+// Cold starting guess for x: 4.5-10 for ellipses, the logarithmic guess for hyperbolas
+double universalAnomalyGuess(double alpha, double r0Length, double sigma0, double dt);
+
+// Below e = 0.9 Danby's iteration needs at most 3 steps, up to e = 0.99 at most 5
+constexpr unsigned int keplerEllipticMaxIterations = 6;
+
+// Solves Kepler's equation M = E - e*sin(E) for the eccentric anomaly E (e < 1, M in radians).
+// Danby's starter E = M + 0.85*e*sign(sin M), then Danby's fourth order correction, usually 2 steps for e < 0.3.
+// sin(E) and cos(E) of the result are handed out as well, the caller needs them anyway.
+double solveEccentricAnomaly(double e, double meanAnomaly, double& sinE, double& cosE);
+
+// Below this eccentricity |E - M| <= e stays small enough that sin/cos(E) follow from sin/cos(M) by short series,
+// so the iteration needs no trig calls and runs in lane groups like the universal variable kernel.
+// Closed orbits below it are propagated in eccentric anomaly when the universal solve has no lanes (see KeplerPath).
+constexpr double ellipticBatchMaxEccentricity = 0.2;
+// solveEccentricAnomaly for n satellites at once, every e has to be < ellipticBatchMaxEccentricity
+void solveEccentricAnomalyBatch(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE);
+
+#endif /* KeplerKernels_hpp */
@@ -0,0 +1,66 @@
+//Author: Bernhard Luedtke
+// Compiled with /arch:AVX2 (see project settings), only called if detectSimdLevel() reported AVX2.
+
+#include "KeplerKernels.h"
+#ifdef KEPLER_KERNELS_X86
+#include <immintrin.h>
+#include "KeplerKernelsLanes.h"
+#include "RungeKuttaKernelsLanes.h"
+#include "Accelerations.h"
+#include "Sgp4KernelsLanes.h"
+#include "ChebyshevKernelsLanes.h"
+
+struct LanesAVX2 {
+	typedef __m256d reg;
+	typedef __m256d mask;
+	enum { width = 4 };
+	static reg load(const double* p) { return _mm256_loadu_pd(p); }
+	static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+	static reg set1(double v) { return _mm256_set1_pd(v); }
+	static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+	static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+	static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+	static reg abs(reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+	static mask cmplt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	// true where !(a >= b), also true for NaN
+	static mask cmpnge(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_NGE_UQ); }
+	static mask allLanes() { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+	// a && !b
+	static mask andNot(mask a, mask b) { return _mm256_andnot_pd(b, a); }
+	static bool any(mask m) { return _mm256_movemask_pd(m) != 0; }
+	// b where m is set, a otherwise
+	static reg blend(reg a, reg b, mask m) { return _mm256_blendv_pd(a, b, m); }
+};
+
+size_t solveUniversalAnomalyAVX2(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations)
+{
+	return solveUniversalAnomalyLanes<LanesAVX2>(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+}
+
+size_t solveEccentricAnomalyAVX2(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE)
+{
+	return solveEccentricAnomalyLanes<LanesAVX2>(n, e, meanAnomaly, E, sinE, cosE);
+}
+
+template <class Force>
+size_t advanceRungeKuttaAVX2(const RungeKuttaArrays& a, size_t begin, size_t end, double t, const RungeKuttaSettings& settings, RungeKuttaStats& stats)
+{
+	return advanceRungeKuttaLanes<LanesAVX2, Force>(a, begin, end, t, settings, stats);
+}
+
+template size_t advanceRungeKuttaAVX2<TwoBodyAcceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+template size_t advanceRungeKuttaAVX2<J2Acceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+
+size_t propagateSgp4AVX2(const Sgp4Arrays& a, size_t begin, size_t end)
+{
+	return propagateSgp4Lanes<LanesAVX2>(a, begin, end);
+}
+
+size_t evaluateChebyshevAVX2(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed)
+{
+	return evaluateChebyshevLanes<LanesAVX2>(a, begin, end, t, missed);
+}
+#endif
@@ -0,0 +1,66 @@
+//Author: Bernhard Luedtke
+// Compiled with /arch:AVX512 (see project settings), only called if detectSimdLevel() reported AVX-512.
+
+#include "KeplerKernels.h"
+#ifdef KEPLER_KERNELS_X86
+#include <immintrin.h>
+#include "KeplerKernelsLanes.h"
+#include "RungeKuttaKernelsLanes.h"
+#include "Accelerations.h"
+#include "Sgp4KernelsLanes.h"
+#include "ChebyshevKernelsLanes.h"
+
+struct LanesAVX512 {
+	typedef __m512d reg;
+	typedef __mmask8 mask;
+	enum { width = 8 };
+	static reg load(const double* p) { return _mm512_loadu_pd(p); }
+	static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+	static reg set1(double v) { return _mm512_set1_pd(v); }
+	static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+	static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+	static reg sqrt(reg a) { return _mm512_sqrt_pd(a); }
+	static reg abs(reg a) { return _mm512_abs_pd(a); }
+	static mask cmplt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+	// true where !(a >= b), also true for NaN
+	static mask cmpnge(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_NGE_UQ); }
+	static mask allLanes() { return (mask)0xFF; }
+	// a && !b
+	static mask andNot(mask a, mask b) { return (mask)(a & ~b); }
+	static bool any(mask m) { return m != 0; }
+	// b where m is set, a otherwise
+	static reg blend(reg a, reg b, mask m) { return _mm512_mask_blend_pd(m, a, b); }
+};
+
+size_t solveUniversalAnomalyAVX512(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations)
+{
+	return solveUniversalAnomalyLanes<LanesAVX512>(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+}
+
+size_t solveEccentricAnomalyAVX512(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE)
+{
+	return solveEccentricAnomalyLanes<LanesAVX512>(n, e, meanAnomaly, E, sinE, cosE);
+}
+
+template <class Force>
+size_t advanceRungeKuttaAVX512(const RungeKuttaArrays& a, size_t begin, size_t end, double t, const RungeKuttaSettings& settings, RungeKuttaStats& stats)
+{
+	return advanceRungeKuttaLanes<LanesAVX512, Force>(a, begin, end, t, settings, stats);
+}
+
+template size_t advanceRungeKuttaAVX512<TwoBodyAcceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+template size_t advanceRungeKuttaAVX512<J2Acceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+
+size_t propagateSgp4AVX512(const Sgp4Arrays& a, size_t begin, size_t end)
+{
+	return propagateSgp4Lanes<LanesAVX512>(a, begin, end);
+}
+
+size_t evaluateChebyshevAVX512(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed)
+{
+	return evaluateChebyshevLanes<LanesAVX512>(a, begin, end, t, missed);
+}
+#endif
@@ -0,0 +1,225 @@
+//Author: Bernhard Luedtke
+#ifndef KeplerKernelsLanes_hpp
+#define KeplerKernelsLanes_hpp
+
+// Lane group version of the Kepler kernels, written once against a small set of vector operations (L).
+// Included only by the instruction set specific translation units (KeplerKernelsSSE2.cpp, ...),
+// which are compiled with the matching /arch option. Keep this free of standard library calls:
+// inline functions instantiated in here would be compiled for that instruction set and might be picked by the linker for the rest of the program.
+
+#include <stddef.h>
+#include "OrbitConstants.h"
+#include "Stumpff.h"
+#include "KeplerKernels.h"
+
+// Same operations as stumpffSeriesCS, with a separate reduction step count per lane. Lanes with a z that is not finite get NaN.
+template <class L>
+static void stumpffSeriesLanes(typename L::reg z, typename L::reg& c, typename L::reg& s)
+{
+	typedef typename L::reg reg;
+	alignas(64) double zl[L::width];
+	alignas(64) double steps[L::width];
+	L::store(zl, z);
+	int maxSteps = 0;
+	for (int l = 0; l < L::width; ++l) {
+		int n = 0;
+		if (!(zl[l] - zl[l] == 0.0)) {
+			zl[l] = zl[l] - zl[l];
+		}
+		while (zl[l] > stumpffReduceLimit || zl[l] < -stumpffReduceLimit) {
+			zl[l] *= 0.25;
+			++n;
+		}
+		steps[l] = static_cast<double>(n);
+		if (n > maxSteps) {
+			maxSteps = n;
+		}
+	}
+	reg zr = L::load(zl);
+	c = L::set1(stumpffSeries.c[stumpffSeriesTerms - 1]);
+	s = L::set1(stumpffSeries.s[stumpffSeriesTerms - 1]);
+	for (int k = stumpffSeriesTerms - 2; k >= 0; --k) {
+		c = L::add(L::mul(c, zr), L::set1(stumpffSeries.c[k]));
+		s = L::add(L::mul(s, zr), L::set1(stumpffSeries.s[k]));
+	}
+	const reg laneSteps = L::load(steps);
+	const reg one = L::set1(1.0);
+	for (int j = 0; j < maxSteps; ++j) {
+		const typename L::mask m = L::cmplt(L::set1(static_cast<double>(j)), laneSteps);
+		const reg s4 = L::mul(L::add(c, L::mul(L::sub(one, L::mul(zr, c)), s)), L::set1(0.25));
+		const reg t = L::sub(one, L::mul(zr, s));
+		const reg c4 = L::mul(L::mul(L::set1(0.5), t), t);
+		c = L::blend(c, c4, m);
+		s = L::blend(s, s4, m);
+		zr = L::blend(zr, L::mul(zr, L::set1(4.0)), m);
+	}
+}
+
+// Same operations as stumpffChebyshevCS. A lane group with any z outside the Chebyshev range is evaluated with the series instead.
+template <class L>
+static void stumpffLanes(typename L::reg z, typename L::reg& c, typename L::reg& s, bool chebyshev)
+{
+	typedef typename L::reg reg;
+	if (!chebyshev || L::any(L::cmplt(z, L::set1(stumpffChebyshevMin))) || L::any(L::cmplt(L::set1(stumpffChebyshevMax), z))) {
+		stumpffSeriesLanes<L>(z, c, s);
+		return;
+	}
+	const reg t = L::sub(L::mul(z, L::set1(stumpffChebyshevScale)), L::set1(stumpffChebyshevShift));
+	const reg t2 = L::mul(L::set1(2.0), t);
+	reg c1 = L::set1(0.0), c2 = c1;
+	reg s1 = c1, s2 = c1;
+	for (int k = stumpffChebyshevTerms - 1; k >= 1; --k) {
+		const reg cK = L::add(L::sub(L::mul(t2, c1), c2), L::set1(stumpffChebyshev.c[k]));
+		const reg sK = L::add(L::sub(L::mul(t2, s1), s2), L::set1(stumpffChebyshev.s[k]));
+		c2 = c1;
+		c1 = cK;
+		s2 = s1;
+		s1 = sK;
+	}
+	c = L::add(L::sub(L::mul(t, c1), c2), L::set1(stumpffChebyshev.c[0]));
+	s = L::add(L::sub(L::mul(t, s1), s2), L::set1(stumpffChebyshev.s[0]));
+}
+
+// 4.4-14
+template <class L>
+static typename L::reg timeOfFlightLanes(typename L::reg x, typename L::reg alpha, typename L::reg r0L, typename L::reg sig0, typename L::reg c, typename L::reg s)
+{
+	const typename L::reg x2 = L::mul(x, x);
+	const typename L::reg term1 = L::mul(L::mul(sig0, x2), c);
+	const typename L::reg term2 = L::mul(L::mul(L::sub(L::set1(1.0), L::mul(r0L, alpha)), L::mul(x2, x)), s);
+	const typename L::reg term3 = L::mul(r0L, x);
+	return L::div(L::add(L::add(term1, term2), term3), L::set1(sqMU));
+}
+
+// Newton iteration for all complete lane groups of n, returns how many satellites were handled.
+// Lanes that did not converge within keplerNewtonMaxIterations report keplerNewtonMaxIterations + 1 iterations.
+template <class L>
+static size_t solveUniversalAnomalyLanes(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* xOut, double* cOut, double* sOut, unsigned int* iterations)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const size_t groups = n - (n % L::width);
+	const reg one = L::set1(1.0);
+	const reg zero = L::set1(0.0);
+	const bool chebyshev = (getStumpffMode() == StumpffMode::Chebyshev);
+	alignas(64) double laneIterations[L::width];
+	for (size_t i = 0; i < groups; i += L::width) {
+		const reg alph = L::load(alpha + i);
+		const reg r0L = L::load(r0Length + i);
+		const reg sig0 = L::load(sigma0 + i);
+		const reg t = L::load(dt + i);
+		const reg timeTolerance = L::mul(L::set1(keplerTimeTolerance), L::add(one, L::abs(t)));
+
+		//Starting guess from the caller
+		reg x = L::load(xOut + i);
+		reg z = L::mul(L::mul(x, x), alph);
+		reg c, s;
+		stumpffLanes<L>(z, c, s, chebyshev);
+		reg tn = timeOfFlightLanes<L>(x, alph, r0L, sig0, c, s);
+		reg count = zero;
+
+		// Lanes that reached the tolerance drop out, the others keep iterating. NaN never compares less, such lanes run out of steps
+		// and go to the Laguerre fallback like the other failures.
+		mask active = L::andNot(L::allLanes(), L::cmplt(L::abs(L::sub(t, tn)), timeTolerance));
+		for (unsigned int k = 0; k < keplerNewtonMaxIterations && L::any(active); k++) {
+			//4.4-17
+			const reg term1 = L::mul(L::mul(x, x), c);
+			const reg term2 = L::mul(L::mul(sig0, x), L::sub(one, L::mul(z, s)));
+			const reg term3 = L::mul(r0L, L::sub(one, L::mul(z, c)));
+			const reg dtdx = L::div(L::add(L::add(term1, term2), term3), L::set1(sqMU));
+			x = L::blend(x, L::add(x, L::div(L::sub(t, tn), dtdx)), active);
+			z = L::mul(L::mul(x, x), alph);
+			stumpffLanes<L>(z, c, s, chebyshev);
+			tn = timeOfFlightLanes<L>(x, alph, r0L, sig0, c, s);
+			count = L::blend(count, L::add(count, one), active);
+			active = L::andNot(active, L::cmplt(L::abs(L::sub(t, tn)), timeTolerance));
+		}
+		count = L::blend(count, L::set1(static_cast<double>(keplerNewtonMaxIterations + 1)), active);
+		L::store(xOut + i, x);
+		L::store(cOut + i, c);
+		L::store(sOut + i, s);
+		L::store(laneIterations, count);
+		for (int l = 0; l < L::width; ++l) {
+			iterations[i + l] = static_cast<unsigned int>(laneIterations[l]);
+		}
+	}
+	return groups;
+}
+
+// Same as sinCosFromMean in KeplerKernels.cpp
+template <class L>
+static void sinCosFromMeanLanes(typename L::reg delta, typename L::reg sinM, typename L::reg cosM, typename L::reg& sinE, typename L::reg& cosE)
+{
+	typedef typename L::reg reg;
+	const reg one = L::set1(1.0);
+	const reg d2 = L::mul(delta, delta);
+	reg sinD = L::add(L::set1(1.0 / 362880.0), L::mul(d2, L::set1(-1.0 / 39916800.0)));
+	sinD = L::add(L::set1(-1.0 / 5040.0), L::mul(d2, sinD));
+	sinD = L::add(L::set1(1.0 / 120.0), L::mul(d2, sinD));
+	sinD = L::add(L::set1(-1.0 / 6.0), L::mul(d2, sinD));
+	sinD = L::mul(delta, L::add(one, L::mul(d2, sinD)));
+	reg cosD = L::add(L::set1(-1.0 / 3628800.0), L::mul(d2, L::set1(1.0 / 479001600.0)));
+	cosD = L::add(L::set1(1.0 / 40320.0), L::mul(d2, cosD));
+	cosD = L::add(L::set1(-1.0 / 720.0), L::mul(d2, cosD));
+	cosD = L::add(L::set1(1.0 / 24.0), L::mul(d2, cosD));
+	cosD = L::add(L::set1(-1.0 / 2.0), L::mul(d2, cosD));
+	cosD = L::add(one, L::mul(d2, cosD));
+	sinE = L::add(L::mul(sinM, cosD), L::mul(cosM, sinD));
+	cosE = L::sub(L::mul(cosM, cosD), L::mul(sinM, sinD));
+}
+
+// Kepler's equation for complete lane groups of n, all e < ellipticBatchMaxEccentricity.
+// sinE/cosE hold sin(M)/cos(M) on input. Returns how many satellites were handled.
+template <class L>
+static size_t solveEccentricAnomalyLanes(size_t n, const double* e, const double* meanAnomaly, double* EOut, double* sinEOut, double* cosEOut)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const size_t groups = n - (n % L::width);
+	const reg one = L::set1(1.0);
+	const reg zero = L::set1(0.0);
+	const reg tolerance = L::set1(1e-4);
+	for (size_t i = 0; i < groups; i += L::width) {
+		const reg ecc = L::load(e + i);
+		const reg M = L::load(meanAnomaly + i);
+		const reg sinM = L::load(sinEOut + i);
+		const reg cosM = L::load(cosEOut + i);
+		reg E = L::add(M, L::mul(L::blend(L::set1(0.85), L::set1(-0.85), L::cmplt(sinM, zero)), ecc));
+		reg sinE, cosE;
+		mask active = L::allLanes();
+		for (unsigned int k = 0; k < keplerEllipticMaxIterations; k++) {
+			sinCosFromMeanLanes<L>(L::sub(E, M), sinM, cosM, sinE, cosE);
+			const reg eSin = L::mul(ecc, sinE);
+			const reg eCos = L::mul(ecc, cosE);
+			const reg f0 = L::sub(L::sub(E, eSin), M);
+			const reg f1 = L::sub(one, eCos);
+			const reg d1 = L::div(L::sub(zero, f0), f1);
+			const reg d2 = L::div(L::sub(zero, f0), L::add(f1, L::mul(L::mul(L::set1(0.5), d1), eSin)));
+			const reg d3 = L::div(L::sub(zero, f0), L::add(L::add(f1, L::mul(L::mul(L::set1(0.5), d2), eSin)), L::mul(L::mul(L::mul(d2, d2), eCos), L::set1(1.0 / 6.0))));
+			E = L::blend(E, L::add(E, d3), active);
+			active = L::andNot(active, L::cmplt(L::abs(d3), tolerance));
+			if (!L::any(active)) {
+				break;
+			}
+		}
+		sinCosFromMeanLanes<L>(L::sub(E, M), sinM, cosM, sinE, cosE);
+		L::store(EOut + i, E);
+		L::store(sinEOut + i, sinE);
+		L::store(cosEOut + i, cosE);
+	}
+	return groups;
+}
+
+// Implemented in KeplerKernelsSSE2.cpp, KeplerKernelsAVX2.cpp and KeplerKernelsAVX512.cpp
+size_t solveUniversalAnomalySSE2(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations);
+size_t solveUniversalAnomalyAVX2(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations);
+size_t solveUniversalAnomalyAVX512(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations);
+size_t solveEccentricAnomalySSE2(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE);
+size_t solveEccentricAnomalyAVX2(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE);
+size_t solveEccentricAnomalyAVX512(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE);
+
+#endif /* KeplerKernelsLanes_hpp */
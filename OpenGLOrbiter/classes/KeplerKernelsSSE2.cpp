@@ -0,0 +1,66 @@
+//Author: Bernhard Luedtke
+// Compiled without extra /arch flags, SSE2 is the baseline on x64.
+
+#include "KeplerKernels.h"
+#ifdef KEPLER_KERNELS_X86
+#include <emmintrin.h>
+#include "KeplerKernelsLanes.h"
+#include "RungeKuttaKernelsLanes.h"
+#include "Accelerations.h"
+#include "Sgp4KernelsLanes.h"
+#include "ChebyshevKernelsLanes.h"
+
+struct LanesSSE2 {
+	typedef __m128d reg;
+	typedef __m128d mask;
+	enum { width = 2 };
+	static reg load(const double* p) { return _mm_loadu_pd(p); }
+	static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+	static reg set1(double v) { return _mm_set1_pd(v); }
+	static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+	static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+	static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+	static reg abs(reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+	static mask cmplt(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+	// true where !(a >= b), also true for NaN
+	static mask cmpnge(reg a, reg b) { return _mm_cmpnge_pd(a, b); }
+	static mask allLanes() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+	// a && !b
+	static mask andNot(mask a, mask b) { return _mm_andnot_pd(b, a); }
+	static bool any(mask m) { return _mm_movemask_pd(m) != 0; }
+	// b where m is set, a otherwise
+	static reg blend(reg a, reg b, mask m) { return _mm_or_pd(_mm_and_pd(m, b), _mm_andnot_pd(m, a)); }
+};
+
+size_t solveUniversalAnomalySSE2(size_t n, const double* alpha, const double* r0Length, const double* sigma0,
+	const double* dt, double* x, double* bigC, double* bigS, unsigned int* iterations)
+{
+	return solveUniversalAnomalyLanes<LanesSSE2>(n, alpha, r0Length, sigma0, dt, x, bigC, bigS, iterations);
+}
+
+size_t solveEccentricAnomalySSE2(size_t n, const double* e, const double* meanAnomaly, double* E, double* sinE, double* cosE)
+{
+	return solveEccentricAnomalyLanes<LanesSSE2>(n, e, meanAnomaly, E, sinE, cosE);
+}
+
+template <class Force>
+size_t advanceRungeKuttaSSE2(const RungeKuttaArrays& a, size_t begin, size_t end, double t, const RungeKuttaSettings& settings, RungeKuttaStats& stats)
+{
+	return advanceRungeKuttaLanes<LanesSSE2, Force>(a, begin, end, t, settings, stats);
+}
+
+template size_t advanceRungeKuttaSSE2<TwoBodyAcceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+template size_t advanceRungeKuttaSSE2<J2Acceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+
+size_t propagateSgp4SSE2(const Sgp4Arrays& a, size_t begin, size_t end)
+{
+	return propagateSgp4Lanes<LanesSSE2>(a, begin, end);
+}
+
+size_t evaluateChebyshevSSE2(const ChebyshevArrays& a, size_t begin, size_t end, double t, size_t& missed)
+{
+	return evaluateChebyshevLanes<LanesSSE2>(a, begin, end, t, missed);
+}
+#endif
@@ -0,0 +1,18 @@
+//Author: Bernhard Luedtke
+#ifndef LaneMasks_hpp
+#define LaneMasks_hpp
+
+// a || b and a && b from the mask operations the lane structs have (KeplerKernelsSSE2.cpp, ...)
+template <class L>
+static typename L::mask maskOr(typename L::mask a, typename L::mask b)
+{
+	return L::andNot(L::allLanes(), L::andNot(L::andNot(L::allLanes(), a), b));
+}
+
+template <class L>
+static typename L::mask maskAnd(typename L::mask a, typename L::mask b)
+{
+	return L::andNot(a, L::andNot(L::allLanes(), b));
+}
+
+#endif /* LaneMasks_hpp */
@@ -0,0 +1,30 @@
+//Author: Bernhard Luedtke
+#ifndef LanesScalar_hpp
+#define LanesScalar_hpp
+
+#include <cmath>
+
+// One satellite per "lane", for the rest of n that does not fill a lane group and for cpus without SSE2.
+// Same operations as the lane structs of the instruction set specific translation units (KeplerKernelsSSE2.cpp, ...).
+struct LanesScalar {
+	typedef double reg;
+	typedef bool mask;
+	enum { width = 1 };
+	static reg load(const double* p) { return *p; }
+	static void store(double* p, reg v) { *p = v; }
+	static reg set1(double v) { return v; }
+	static reg add(reg a, reg b) { return a + b; }
+	static reg sub(reg a, reg b) { return a - b; }
+	static reg mul(reg a, reg b) { return a * b; }
+	static reg div(reg a, reg b) { return a / b; }
+	static reg sqrt(reg a) { return std::sqrt(a); }
+	static reg abs(reg a) { return std::abs(a); }
+	static mask cmplt(reg a, reg b) { return a < b; }
+	static mask cmpnge(reg a, reg b) { return !(a >= b); }
+	static mask allLanes() { return true; }
+	static mask andNot(mask a, mask b) { return a && !b; }
+	static bool any(mask m) { return m; }
+	static reg blend(reg a, reg b, mask m) { return m ? b : a; }
+};
+
+#endif /* LanesScalar_hpp */
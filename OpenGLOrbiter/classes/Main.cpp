@@ -15,7 +15,14 @@
 #endif
 #endif
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
 #include "Manager.h"
+#include "Benchmark.h"
+#include "EphemerisFile.h"
+#include "ThreadPool.h"
+#include "ShaderProgramRegistry.h"
+#include <chrono>
 #include "FreeImage.h"
 /*
 #include <stdint.h>
@@ -27,9 +34,31 @@
 #include "include/wglext.h"
 */
 void PrintOpenGLVersion();
+bool writeSceneEphemeris(const char* path);
 
 
-int main () {
+int main (int argc, char** argv) {
+	// Console benchmarks only, no window
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		runBenchmarks();
+		return 0;
+	}
+	// Generator of the precomputed orbit lines, no window either
+	if (argc > 2 && strcmp(argv[1], "--write-ephemeris") == 0) {
+		return writeSceneEphemeris(argv[2]) ? 0 : 1;
+	}
+	// --ephemeris <file>: orbit lines written with --write-ephemeris
+	const char* ephemerisPath = nullptr;
+	// --shader-cache <file>: binaries of the shader programs, from and for the next start
+	const char* shaderCachePath = "shaders.cache";
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (strcmp(argv[i], "--ephemeris") == 0) {
+			ephemerisPath = argv[i + 1];
+		}
+		if (strcmp(argv[i], "--shader-cache") == 0) {
+			shaderCachePath = argv[i + 1];
+		}
+	}
 	FreeImage_Initialise();
 	// start GL context and O/S window using the GLFW helper library
 	if (!glfwInit ()) {
@@ -63,10 +92,49 @@ int main () {
 #endif // !__APPLE__
 
 	PrintOpenGLVersion();
+	ShaderProgramRegistry::openCache(shaderCachePath);
+	// The driver compiles the programs while the Manager builds the scene; the shaders it creates take them
+	Manager::precompileShaders();
 	{
 		double lastTime = 0.0;
-		Manager App(window);
+		Manager App(window, ephemerisPath);
+		unsigned int drawBenchmarkSatellites = 0;
+		// --cpu-lines: orbit lines culled on the CPU and drawn one by one, even if the GPU could do it
+		for (int i = 1; i < argc; ++i) {
+			if (strcmp(argv[i], "--cpu-lines") == 0) {
+				App.setGpuDrivenLines(false);
+			}
+		}
+		// --catalog <file>: TLE/3LE catalog to propagate along
+		for (int i = 1; i + 1 < argc; ++i) {
+			if (strcmp(argv[i], "--catalog") == 0) {
+				App.loadCatalog(argv[i + 1]);
+			}
+			// --chebyshev <km>: scene satellites from Chebyshev fits with this tolerance
+			if (strcmp(argv[i], "--chebyshev") == 0) {
+				App.enableChebyshev(atof(argv[i + 1]));
+			}
+			// --line-vertices <n>: orbit line vertices per frame
+			if (strcmp(argv[i], "--line-vertices") == 0) {
+				App.setOrbitLineVertexBudget(static_cast<size_t>(atof(argv[i + 1])));
+			}
+			// --line-budget <MB>: GPU memory for the orbit lines
+			if (strcmp(argv[i], "--line-budget") == 0) {
+				App.setOrbitLineBudget(static_cast<size_t>(atof(argv[i + 1]) * 1024.0 * 1024.0));
+			}
+			// --bench-draw <n>: n more satellites, times both satellite draw paths and exits
+			if (strcmp(argv[i], "--bench-draw") == 0) {
+				drawBenchmarkSatellites = static_cast<unsigned int>(atoi(argv[i + 1]));
+			}
+		}
+		ShaderProgramRegistry::finishPending();
+		ShaderProgramRegistry::printStartupReport();
+		ShaderProgramRegistry::saveCache();
 		App.start();
+		if (drawBenchmarkSatellites > 0) {
+			App.benchmarkDraw(drawBenchmarkSatellites, 200);
+			glfwSetWindowShouldClose(window, GLFW_TRUE);
+		}
 		//glfwSwapInterval(1);
 		while (!glfwWindowShouldClose(window)) {
 			// once per frame
@@ -74,11 +142,12 @@ int main () {
 			double delta = now - lastTime;
 			lastTime = now;
 			glfwPollEvents();
-			App.update(delta);
-			App.draw();
-			glfwSwapBuffers(window);
+			// simulation of the next frame overlaps drawing and swapping this one
+			App.frame(delta);
 		}
 		App.end();
+		// Programs of shaders created later on
+		ShaderProgramRegistry::saveCache();
 	}
 	glfwTerminate();
 	return 0;
@@ -93,3 +162,26 @@ void PrintOpenGLVersion()
 		printf ("Renderer: %s\n", renderer);
 		printf ("OpenGL version supported %s\n", version);
 }
+
+// Samples the orbit of every satellite of the scene on a thread pool and writes them as an EphemerisFile
+bool writeSceneEphemeris(const char* path)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<OrbitEphemeris> orbits = Manager::sceneOrbits();
+	std::vector<EphemerisTrack> tracks(orbits.size());
+	ThreadPool pool;
+	pool.parallelFor(orbits.size(), 1, [&orbits, &tracks](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			// Same id and points as Manager::addSatellite would compute live
+			tracks[i].satelliteId = i;
+			tracks[i].elementsHash = EphemerisFile::hashElements(orbits[i]);
+			tracks[i].points = ConstellationState::sampleConic(orbits[i], Satellite::orbitVisTolerance);
+		}
+	});
+	if (!EphemerisFile::write(path, tracks)) {
+		return false;
+	}
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%u orbit lines written to %s in %.1f ms\n", static_cast<unsigned int>(tracks.size()), path, ms);
+	return true;
+}
@@ -18,14 +18,21 @@
 #endif
 
 #include "PhongShaderInstanced.h"
+#include "InstancedSphereModel.h"
+#include "ShaderProgramRegistry.h"
 #include "lineplanemodel.h"
 #include "trianglespheremodel.h"
 #include "Satellite.h"
 #include "FlatColorShader.h"
+#include "KeplerKernels.h"
+#include "TleCatalogLoader.h"
 
 //Debug/Time measurement
 #include <iostream>
 #include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
 #include <omp.h>
 
 #ifdef WIN32
@@ -45,14 +52,60 @@ using std::cout;
 
 
 
-Manager::Manager(GLFWwindow* pWin) : pWindow(pWin), Cam(pWin)
+// Worker threads: 0 = one per hardware thread besides this one; no thread pinning
+Manager::Manager(GLFWwindow* pWin, const char* ephemerisPath) : pWindow(pWin), Cam(pWin), workers(0, false)
 {
+	//precomputed orbit lines, the ones that are not in there are computed here
+	if (ephemerisPath != nullptr) {
+		ephemeris.open(ephemerisPath);
+	}
+	orbitLines.setEphemerisFile(&ephemeris);
+	setGpuDrivenLines(true);
 	//speedup, higher timescale = faster
-	//-> Using this to slow things down might cause numerical instability!
-	timeScale = 10.f;
-	cout << "Timescale: " << timeScale << "\n";
+	clock.setTimeScale(10.0);
+	//length of one physics tick in real seconds. Propagation runs at this rate no matter the frame rate, drawing interpolates in between.
+	clock.setTick(1.0 / 60.0);
+	cout << "Timescale: " << clock.getTimeScale() << "; Physics tick: " << clock.getTick() << "s\n";
+	cout << "Kepler kernels: " << simdLevelName(getSimdLevel()) << "\n";
+	//satellites per work item of the thread pool
+	constellation.setThreadPool(&workers);
+	constellation.setChunkSize(1024);
+	catalog.setThreadPool(&workers);
+	catalog.setChunkSize(1024);
+	cout << "Propagation threads: " << workers.getThreadCount() << "\n";
+	buildFrameGraph();
 
 	addEarth();
+	for (const OrbitEphemeris& o : sceneOrbits()) {
+		addSatellite(o, true, true);
+	}
+	std::cout << "Satellites added.\n";
+	addEquatorLinePlane();
+	std::cout << "Plane added.\n";
+	//same mesh as a Satellite
+	instanceModel = std::make_unique<InstancedSphereModel>(0.03f, 9, 18);
+	auto instanceShader = std::make_unique<PhongShaderInstanced>();
+	instanceModel->setShader(std::move(instanceShader));
+	instanceModel->transform(Matrix());
+	reserveInstances();
+	fillInstances();
+	std::cout << "Instancer added.\n";
+}
+
+void Manager::precompileShaders()
+{
+	//earth and satellites, all of them at once, the orbit lines and the equator plane
+	PhongShaderInstanced::precompile();
+	FlatColorShader::precompile();
+}
+
+std::vector<OrbitEphemeris> Manager::sceneOrbits()
+{
+	std::vector<OrbitEphemeris> orbits;
+	//Params: semi Major Axis, longitude of ascending node, inclination, argument of periapsis, eccentricity, true Anomaly (degrees), the line flags are not used here
+	const auto addSatellite = [&orbits](double semiA, double lAscN, double incli, double argP, double ecc = 0.0, double trueAnom = 0.0, bool = true, bool = true) {
+		orbits.push_back(OrbitEphemeris(semiA, ecc, DEG_TO_RAD(incli), DEG_TO_RAD(lAscN), DEG_TO_RAD(argP), DEG_TO_RAD(trueAnom)));
+	};
 	double t = 0.01;
 	/*
 	for (auto i = 0; i < 1000; ++i) {
@@ -121,15 +174,7 @@ Manager::Manager(GLFWwindow* pWin) : pWindow(pWin), Cam(pWin)
 	//addSatellite(9164.0f, 0.0f, 90.0f, 0.0f, 0.2f);
 
 	/**/
-	std::cout << "Satellites added.\n";
-	addEquatorLinePlane();
-	std::cout << "Plane added.\n";
-	instanceModel = std::make_unique<TriangleSphereModel>(0.03, 12, 24);
-	auto instanceShader = std::make_unique<PhongShaderInstanced>();
-	instanceModel->setShader(std::move(instanceShader));
-	instanceModel->transform(Matrix());
-	instanceModel->instanced = true;
-	std::cout << "Instancer added.\n";
+	return orbits;
 }
 
 //addSat Params: semi Major Axis, longitude of ascending node, inclination, argument of periapsis, eccentricity, true Anomaly, orbitVisualisation, fullLine
@@ -142,17 +187,15 @@ void Manager::addSatellite(double semiA, double lAscN, double incli, double argP
 
 void Manager::addSatellite(OrbitEphemeris o, bool orbitVis, bool fullLine, Color satColor)
 {
-	unique_ptr<PhongShader> uShader = std::make_unique<PhongShader>();
-	//auto uShader = std::make_unique<PhongShaderInstanced>();
-	uShader->diffuseColor(satColor);
-	std::unique_ptr<Satellite> sat = std::make_unique<Satellite>(0.03f,o);
-	sat->setShader(std::move(uShader));
+	std::unique_ptr<Satellite> sat = std::make_unique<Satellite>(0.03f, constellation, o);
+	//drawn instanced, the mesh and the shader (a program each) are only needed for drawing it on its own
+	if (!instancedSatellites) {
+		buildSatelliteModel(*sat, satColor);
+	}
+	satelliteColors.push_back(satColor);
 	if (orbitVis == true) {
-		std::vector<Vector> resOrbit = sat->calcOrbitVis();
-		unique_ptr<FlatColorShader> uCShader = std::make_unique<FlatColorShader>(Color(0.9f, 0.2f, 0));
-		unique_ptr<StandardModel> uModel = std::make_unique<OrbitLineModel>(resOrbit,fullLine);
-		uModel->setShader(std::move(uCShader));
-		uModels.push_back(std::move(uModel));
+		//satellites are identified by their place in the scene (also in the ephemeris file), the line is built when it is first in view
+		orbitLines.add(satellites.size(), o, fullLine);
 	}
 	this->satellites.push_back(std::move(sat));
 }
@@ -196,21 +239,272 @@ void Manager::start()
 
 void Manager::update(double deltaT)
 {
-	deltaT *= timeScale;
+	simulate(deltaT);
+	buildRenderState();
+	Cam.update();
+}
+
+void Manager::simulate(double deltaT)
+{
+	const unsigned int ticks = clock.advance(deltaT);
+	// Positions are solved from each satellite's epoch, so only the last two ticks are needed for interpolation,
+	// no matter how many ticks (or how much simulated time) this frame covers.
+	if (ticks > 1 && !chebyshev) {
+		constellation.seek(clock.simulationTime() - clock.step());
+	}
+	if (ticks > 0) {
+		if (!chebyshev) {
+			constellation.propagateTo(clock.simulationTime());
+		}
+		if (catalog.size() > 0) {
+			catalog.propagateTo(clock.simulationTime());
+		}
+	}
+}
+
+bool Manager::loadCatalog(const char* path)
+{
+	TleCatalogLoader loader(&workers);
+	if (!loader.load(path, catalog)) {
+		return false;
+	}
+	const TleLoadStats& stats = loader.getStats();
+	if (stats.newestEpochJd > catalog.getReferenceJd()) {
+		catalog.setReferenceJd(stats.newestEpochJd);
+	}
+	catalog.propagateTo(clock.simulationTime());
+	cout << "Catalog " << path << ": " << stats.records << " satellites (" << catalog.getDeepSpaceCount() << " deep space) in "
+		<< stats.milliseconds << " ms\n";
+	return true;
+}
+
+void Manager::enableChebyshev(double toleranceKm)
+{
+	chebyshev = std::make_unique<ChebyshevEphemeris>(constellation);
+	chebyshev->setTolerance(toleranceKm);
+	chebyshev->setThreadPool(&workers);
+	chebyshev->fitNow(clock.simulationTime());
+	chebyshev->update(clock.simulationTime());
+	cout << "Chebyshev ephemeris: " << chebyshev->getStats().segments << " segments for " << chebyshev->size() << " satellites, largest error "
+		<< chebyshev->getStats().maxFitError << " km\n";
+}
+
+void Manager::buildRenderState()
+{
+	const double alpha = clock.interpolation();
 	int limit = satellites.size();
-	//#pragma omp parallel for 
-	for (int i = 0; i < limit; ++i)
-	{
-		satellites.at(i)->update(deltaT);
+	if (chebyshev) {
+		//the polynomials give the position at any time, no interpolation between ticks needed
+		chebyshev->addOrbits(constellation);
+		chebyshev->update(clock.simulationTime() - (1.0 - alpha) * clock.step());
+		for (int i = 0; i < limit; ++i)
+		{
+			satellites.at(i)->update(chebyshev->getR(satellites.at(i)->getStoreIndex()));
+		}
 	}
-	//For earth rotation. 
-	const double coeff = (deltaT / 86400.0)* DEG_TO_RAD(360.0);
-	for (unsigned int k = 0; k < planets.size(); k++) {
-		Matrix t = planets[k]->transform();
-		Matrix r = Matrix().rotationY(coeff);
-		planets[k]->transform(t * r);
+	else {
+		for (int i = 0; i < limit; ++i)
+		{
+			satellites.at(i)->update(alpha);
+		}
 	}
+	if (instancedSatellites) {
+		fillInstances();
+	}
+	updateEarthRotation();
+}
+
+void Manager::reserveInstances()
+{
+	if (instanceModel) {
+		instanceModel->reserve(satellites.size() + catalog.size());
+	}
+}
+
+void Manager::fillInstances()
+{
+	if (!instanceModel || instanceModel->instanceData() == nullptr) {
+		return;
+	}
+	//straight into the mapped stream buffer; satellites added since the space was reserved follow in the next frame
+	SphereInstance* instances = instanceModel->instanceData();
+	const size_t capacity = instanceModel->instanceCapacity();
+	const size_t own = std::min(satellites.size(), capacity);
+	for (size_t i = 0; i < own; ++i) {
+		const Vector r = satellites[i]->transform().translation();
+		const Color& c = satelliteColors[i];
+		instances[i] = SphereInstance{ r.X, r.Y, r.Z, c.R, c.G, c.B };
+	}
+	const size_t count = std::min(satellites.size() + catalog.size(), capacity);
+	for (size_t i = own; i < count; ++i) {
+		const Vector r = catalog.getR(i - satellites.size());
+		instances[i] = SphereInstance{ r.X, r.Y, r.Z, 0.6f, 0.7f, 1.0f };
+	}
+	instanceModel->setInstanceCount(count);
+}
+
+void Manager::setGpuDrivenLines(bool enabled)
+{
+	const bool gpu = orbitLines.setGpuDriven(enabled);
+	cout << "Orbit lines: " << (gpu ? "culled and drawn on the GPU (multi draw indirect)" : "culled on the CPU, one draw call each")
+		<< ((enabled && !gpu) ? ", the context has no compute shaders / indirect draws" : "") << "\n";
+}
+
+void Manager::setInstancedSatellites(bool instanced)
+{
+	instancedSatellites = instanced;
+	if (instanced) {
+		reserveInstances();
+		fillInstances();
+		return;
+	}
+	for (size_t i = 0; i < satellites.size(); ++i) {
+		buildSatelliteModel(*satellites[i], satelliteColors[i]);
+	}
+}
+
+void Manager::buildSatelliteModel(Satellite& sat, const Color& color)
+{
+	sat.buildMesh();
+	if (!sat.uShader) {
+		unique_ptr<PhongShader> uShader = std::make_unique<PhongShader>();
+		uShader->diffuseColor(color);
+		sat.setShader(std::move(uShader));
+	}
+}
+
+void Manager::benchmarkDraw(unsigned int satelliteCount, unsigned int frames)
+{
+	// Random orbits between LEO and GEO
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	for (unsigned int i = 0; i < satelliteCount; ++i) {
+		const double e = 0.3 * unit(rng);
+		addSatellite(OrbitEphemeris((6800.0 + 36000.0 * unit(rng)) / (1.0 - e), e, 3.14159 * unit(rng), 6.28318 * unit(rng), 6.28318 * unit(rng),
+			6.28318 * unit(rng)), false, false);
+	}
+	seek(clock.simulationTime());
 	Cam.update();
+	cout << "Drawing " << satellites.size() << " satellites";
+	if (catalog.size() > 0) {
+		cout << " and " << catalog.size() << " catalog satellites (instanced only)";
+	}
+	cout << ", " << frames << " frames each\n";
+	const bool wasInstanced = instancedSatellites;
+	for (int pass = 0; pass < 2; ++pass) {
+		setInstancedSatellites(pass == 1);
+		// warm up: shaders, buffers
+		for (int k = 0; k < 10; ++k) {
+			buildRenderState();
+			draw();
+		}
+		glFinish();
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned int k = 0; k < frames; ++k) {
+			buildRenderState();
+			draw();
+			glFinish();
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+		glfwSwapBuffers(pWindow);
+		cout << "  " << (instancedSatellites ? "instanced" : "one draw call per satellite") << ": " << satelliteDrawCalls << " draw calls for the satellites, "
+			<< ms << " ms per frame\n";
+	}
+	setInstancedSatellites(wasInstanced);
+}
+
+/*
+	Frame N on the main thread:		camera -> draw -> swap
+	Frame N+1 on a worker thread:	propagate -> render state (also after draw, it overwrites what draw reads)
+	Propagation only touches the ConstellationState, which draw does not read, so it overlaps with drawing and the buffer swap.
+	What is shown lags one frame behind the simulation.
+*/
+void Manager::buildFrameGraph()
+{
+	const TaskGraph::TaskId camera = frameGraph.addTask("camera", TaskGraph::Affinity::Main, [this] { Cam.update(); });
+	const TaskGraph::TaskId drawing = frameGraph.addTask("draw", TaskGraph::Affinity::Main, [this] { draw(); });
+	const TaskGraph::TaskId swap = frameGraph.addTask("swap", TaskGraph::Affinity::Main, [this] { glfwSwapBuffers(pWindow); });
+	const TaskGraph::TaskId propagate = frameGraph.addTask("propagate", TaskGraph::Affinity::Worker, [this] { simulate(frameDelta); });
+	const TaskGraph::TaskId renderState = frameGraph.addTask("render state", TaskGraph::Affinity::Worker, [this] { buildRenderState(); });
+	frameGraph.addDependency(camera, drawing);
+	frameGraph.addDependency(drawing, swap);
+	frameGraph.addDependency(propagate, renderState);
+	frameGraph.addDependency(drawing, renderState);
+}
+
+void Manager::frame(double deltaT)
+{
+	frameDelta = deltaT;
+	frameGraph.run();
+	const bool keyDown = glfwGetKey(pWindow, GLFW_KEY_T) == GLFW_PRESS;
+	if (keyDown && !timingKeyDown) {
+		frameGraph.dumpTimings(cout);
+		const StreamBuffer& stream = instanceModel->stream();
+		cout << "Satellites: " << (instancedSatellites ? "instanced, " : "one by one, ") << satelliteDrawCalls << " draw calls; instance stream "
+			<< (stream.isPersistent() ? "mapped" : "copied") << ", " << stream.regionBytes() / 1024 << " KB a region, " << stream.getStalls()
+			<< " waits for the GPU (" << stream.getStallMilliseconds() << " ms)\n";
+		cout << "Shader programs: " << ShaderProgramRegistry::programCount() << " (" << ShaderProgramRegistry::linkedCount() << " linked, "
+			<< ShaderProgramRegistry::sharedCount() << " times shared)\n";
+		orbitLines.readGpuStats();
+		const OrbitLineStats& lines = orbitLines.getStats();
+		cout << "Orbit lines: " << lines.visible << " in view, " << lines.drawn << " drawn (" << lines.vertices << " vertices, "
+			<< lines.levelShift << " levels coarser for the budget), " << lines.created << " built, " << lines.deferred
+			<< " deferred; " << lines.resident << " of " << orbitLines.size() << " on the GPU (" << lines.bytes / 1024 << " of "
+			<< orbitLines.getBudget() / 1024 << " KB)" << (lines.gpuDriven ? ", GPU driven" : "") << "\n";
+		if (ephemeris.isOpen()) {
+			cout << "Ephemeris file: " << ephemeris.getHits() << " found, " << ephemeris.getMisses() << " missing, " << ephemeris.getStale()
+				<< " stale, " << ephemeris.getCorrupt() << " corrupt\n";
+		}
+	}
+	timingKeyDown = keyDown;
+	const bool instancingDown = glfwGetKey(pWindow, GLFW_KEY_I) == GLFW_PRESS;
+	if (instancingDown && !instancingKeyDown) {
+		//after the frame graph, the render state task is done
+		setInstancedSatellites(!instancedSatellites);
+	}
+	instancingKeyDown = instancingDown;
+	const bool gpuLinesDown = glfwGetKey(pWindow, GLFW_KEY_G) == GLFW_PRESS;
+	if (gpuLinesDown && !gpuLinesKeyDown) {
+		setGpuDrivenLines(!orbitLines.isGpuDriven());
+	}
+	gpuLinesKeyDown = gpuLinesDown;
+}
+
+void Manager::seek(double simulationTime)
+{
+	clock.setSimulationTime(simulationTime);
+	if (catalog.size() > 0) {
+		catalog.propagateTo(simulationTime);
+	}
+	if (chebyshev) {
+		//times outside the fitted windows are solved directly and refitted in the background
+		chebyshev->addOrbits(constellation);
+		chebyshev->update(simulationTime);
+		for (unsigned int i = 0; i < satellites.size(); i++) {
+			satellites.at(i)->update(chebyshev->getR(satellites.at(i)->getStoreIndex()));
+		}
+	}
+	else {
+		constellation.seek(simulationTime);
+		for (unsigned int i = 0; i < satellites.size(); i++) {
+			satellites.at(i)->update(1.0);
+		}
+	}
+	if (instancedSatellites) {
+		reserveInstances();
+		fillInstances();
+	}
+	updateEarthRotation();
+}
+
+void Manager::updateEarthRotation()
+{
+	//For earth rotation, from the absolute time, so seeking works the same as running.
+	const double day = 86400.0;
+	const double coeff = (std::fmod(clock.simulationTime(), day) / day) * DEG_TO_RAD(360.0);
+	for (unsigned int k = 0; k < planets.size(); k++) {
+		planets[k]->transform(Matrix().rotationY(coeff));
+	}
 }
 
 void Manager::draw()
@@ -223,16 +517,24 @@ void Manager::draw()
 	for (unsigned int i = 0; i < uModels.size(); i++) {
 		uModels.at(i)->draw(Cam);
 	}
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(pWindow, &width, &height);
+	orbitLines.setViewportHeight(height);
+	orbitLines.draw(Cam);
 	//2.b) Draw Satellites
-	std::vector<Vector> satPositions;
-	for (unsigned int i = 0; i < satellites.size(); i++)
-	{
-		//satPositions.push_back(satellites.at(i)->getR());
-		//cout << satPositions[i].X << "; " << satPositions[i].Y << "; " << satPositions[i].Z << "\n";
-		satellites.at(i)->draw(Cam);
+	if (instancedSatellites) {
+		satelliteDrawCalls = (instanceModel->instanceCount() > 0) ? 1 : 0;
+		instanceModel->draw(Cam);
+		//the render state task of the next frame writes into it
+		reserveInstances();
+	}
+	else {
+		for (unsigned int i = 0; i < satellites.size(); i++)
+		{
+			satellites.at(i)->draw(Cam);
+		}
+		satelliteDrawCalls = static_cast<unsigned int>(satellites.size());
 	}
-	//reinterpret_cast<PhongShaderInstanced*>(instanceModel->uShader.get())->setInstancePositions(std::move(satPositions));
-	//instanceModel->draw(Cam);
 	
 	//2.c) Draw Planet(s)
 	for (unsigned int i = 0; i < planets.size(); i++)
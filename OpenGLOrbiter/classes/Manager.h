@@ -14,29 +14,99 @@
 #include "indexbuffer.h"
 #include "StandardModel.h"
 #include "Satellite.h"
+#include "ConstellationState.h"
+#include "Sgp4Constellation.h"
+#include "EphemerisFile.h"
+#include "ChebyshevEphemeris.h"
+#include "SimulationClock.h"
+#include "ThreadPool.h"
+#include "TaskGraph.h"
 #include "OrbitLineModel.h"
+#include "OrbitLinePool.h"
+#include "InstancedSphereModel.h"
 
 class Manager
 {
 public:
-  Manager(GLFWwindow* pWin);
+  // ephemerisPath: file of precomputed orbit lines (EphemerisFile), nullptr to compute all of them when they are first drawn
+  Manager(GLFWwindow* pWin, const char* ephemerisPath = nullptr);
+  // Orbits of the satellites the constructor adds, also used to write the ephemeris file without a window
+  static std::vector<OrbitEphemeris> sceneOrbits();
+  // Starts compiling the programs of all shaders the Manager creates, in parallel where the driver can (before the constructor)
+  static void precompileShaders();
   void start();
+  // Sequential frame: simulation, render state and camera, then draw() separately
   void update(double deltaT);
+  // Pipelined frame (task graph): draws and swaps the frame simulated by the previous call on this thread,
+  // while the next one is propagated and its render state built on a worker thread. Press T to dump the task timings
+  // and the orbit line counters.
+  void frame(double deltaT);
+  // Jumps to an absolute simulation time (seconds), backwards or forwards
+  void seek(double simulationTime);
+  // Adds a TLE/3LE catalog file, propagated with SGP4 from its newest epoch on (simulation time 0). Returns false if it can not be read.
+  bool loadCatalog(const char* path);
+  // Positions the scene satellites from Chebyshev fits within toleranceKm instead of solving Kepler's equation every tick
+  void enableChebyshev(double toleranceKm);
+  // GPU memory for the orbit lines (bytes), the ones drawn least recently are dropped beyond it
+  void setOrbitLineBudget(size_t bytes) { orbitLines.setBudget(bytes); }
+  // Orbit line vertices per frame, more lines in view are drawn at coarser levels
+  void setOrbitLineVertexBudget(size_t vertices) { orbitLines.setVertexBudget(vertices); }
+  // Orbit lines culled and drawn on the GPU (compute pass, one multi draw indirect call) where the context can, or one call each.
+  // Press G to switch.
+  void setGpuDrivenLines(bool enabled);
+  // All satellites (and the catalog) in one instanced draw call, or every scene satellite drawn on its own. Press I to switch.
+  void setInstancedSatellites(bool instanced);
+  // Adds satelliteCount random satellites (no orbit lines) and prints draw calls and ms per frame (render state, draw, glFinish)
+  // of both satellite paths, frames each
+  void benchmarkDraw(unsigned int satelliteCount, unsigned int frames);
   void draw();
   void end();
 protected:
   Camera Cam;
+	// Propagates the constellation in chunks, declared before it so it is still there while the constellation is destroyed
+	ThreadPool workers;
+	ConstellationState constellation;
+	EphemerisFile ephemeris;
+	// Set by enableChebyshev, then the constellation is no longer propagated
+	std::unique_ptr<ChebyshevEphemeris> chebyshev;
+	// Satellites of a loaded catalog (drawn with the instanced satellites)
+	Sgp4Constellation catalog{ 0.0 };
 	std::vector<std::unique_ptr<Satellite>> satellites;
 	GLFWwindow* pWindow;
 	std::vector<std::unique_ptr<StandardModel>> uModels;
+	// Orbit lines of the satellites, built when they come into view
+	OrbitLinePool orbitLines;
 	std::vector<std::unique_ptr<TriangleSphereModel>> planets;
-	std::unique_ptr<TriangleSphereModel> instanceModel{};
-	float timeScale = 1.0f;
+	// One sphere mesh drawn at every satellite's position
+	std::unique_ptr<InstancedSphereModel> instanceModel{};
+	// Diffuse color of every satellite, for the instances and the shaders of the other path
+	std::vector<Color> satelliteColors;
+	bool instancedSatellites = true;
+	unsigned int satelliteDrawCalls = 0;
+	bool instancingKeyDown = false;
+	bool gpuLinesKeyDown = false;
+	// Propagation runs in fixed ticks, independent of the frame rate
+	SimulationClock clock;
+	TaskGraph frameGraph{ 1 };
+	double frameDelta = 0.0;
+	bool timingKeyDown = false;
 	
 	void addEarth();
 	void addSatellite(double semiA, double lAscN, double incli, double argP, double ecc = 0.0f, double trueAnom = 0.0, bool orbitVis = true, bool fullLine = true);
 	void addSatellite(OrbitEphemeris o, bool orbitVis = true, bool fullLine = true, Color satColor = Color(1.0f,.1f,.1f));
 	void addEquatorLinePlane();
+	// Sphere mesh and shader of a satellite drawn on its own (not instanced), built the first time it is
+	void buildSatelliteModel(Satellite& sat, const Color& color);
+	void updateEarthRotation();
+	// Clock and propagation
+	void simulate(double deltaT);
+	// Everything draw() reads of the simulation: satellite transforms (interpolated) and the earth rotation
+	void buildRenderState();
+	// Space in the instance stream for the next frame's satellites (on the main thread, may wait for the GPU)
+	void reserveInstances();
+	// Positions and colors of the scene satellites and the catalog for the instanced draw, written into the reserved space
+	void fillInstances();
+	void buildFrameGraph();
 };
 
 #endif /* Manager_hpp */
@@ -0,0 +1,123 @@
+//Author: Bernhard Luedtke
+
+#include "MappedFile.h"
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char* path)
+{
+	close();
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Can not open " << path << " (error " << GetLastError() << ")" << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		std::cerr << "Can not get the size of " << path << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	opened = true;
+	if (fileSize.QuadPart == 0) {
+		// Empty files can not be mapped
+		return true;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* mapped = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (mapped == nullptr) {
+		std::cerr << "Can not map " << path << " (error " << GetLastError() << ")" << std::endl;
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+	view = static_cast<const char*>(mapped);
+	length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr) {
+		CloseHandle(fileHandle);
+	}
+	view = nullptr;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+	length = 0;
+	opened = false;
+}
+#else
+bool MappedFile::open(const char* path)
+{
+	close();
+	const int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		std::cerr << "Can not open " << path << std::endl;
+		return false;
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0) {
+		std::cerr << "Can not get the size of " << path << std::endl;
+		::close(file);
+		return false;
+	}
+	opened = true;
+	if (status.st_size > 0) {
+		void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped == MAP_FAILED) {
+			std::cerr << "Can not map " << path << std::endl;
+			::close(file);
+			opened = false;
+			return false;
+		}
+		// The whole file is read front to back (or in a few large blocks)
+		madvise(mapped, static_cast<size_t>(status.st_size), MADV_WILLNEED);
+		view = static_cast<const char*>(mapped);
+		length = static_cast<size_t>(status.st_size);
+	}
+	// The mapping stays valid without the descriptor
+	::close(file);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (view != nullptr) {
+		munmap(const_cast<char*>(view), length);
+	}
+	view = nullptr;
+	length = 0;
+	opened = false;
+}
+#endif
@@ -0,0 +1,33 @@
+//Author: Bernhard Luedtke
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+#include <stddef.h>
+
+// Read only view of a whole file, mapped into memory (no copy, pages are read by the OS on first access).
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the file, closing a previously mapped one. Returns false (and reports why) if it can not be opened.
+	// An empty file is mapped successfully, with data() == nullptr.
+	bool open(const char* path);
+	void close();
+	bool isOpen() const noexcept { return opened; }
+	const char* data() const noexcept { return view; }
+	size_t size() const noexcept { return length; }
+
+private:
+	const char* view = nullptr;
+	size_t length = 0;
+	bool opened = false;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
+
+#endif /* MappedFile_hpp */
@@ -0,0 +1,16 @@
+//Author: Bernhard Luedtke
+#ifndef OrbitConstants_hpp
+#define OrbitConstants_hpp
+
+// Standard gravitational parameter of earth.
+// This uses the unit km^3/s^2, NOT m^3/s^2!!
+constexpr double mu = 398600.0;
+// sqrt(mu), precomputed because it appears in almost every term of the universal variable formulation
+constexpr double sqMU = 631.34776470658387846982160428348675796819064249894744823745763911;
+// Equatorial radius of earth in km and its second zonal harmonic (oblateness), for the J2 secular rates
+constexpr double earthRadius = 6378.137;
+constexpr double j2 = 1.08262668e-3;
+//All calculations are performed in "real" scale (1 unit = 1km), but the coordinate system is not to scale (1 unit = 6378.0km)
+constexpr double sizeFactor = 1.0 / 6378.0;
+
+#endif /* OrbitConstants_hpp */
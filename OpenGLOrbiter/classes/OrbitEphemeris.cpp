@@ -4,13 +4,7 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
-#ifndef mu
-// This uses the unit km/s, NOT m/s!!
-#define mu (double)398600
-#endif // !mu
-#ifndef sizeFactor
-#define sizeFactor 1.0f/6378.0f
-#endif // !sizeFactor
+#include "OrbitConstants.h"
 
 
 
@@ -43,30 +37,22 @@ double OrbitEphemeris::getEllipseOrbitalPeriod(bool forceReCalc)
 	return orbitalperiod;
 }
 
-//This is simplified by assuming that the satellite is at its perigeee at start.
-// For more complicated setups, this'll need improvement. Can be worked around by rotating manually.
+//r0 and v0 at the true anomaly T, in the orbital plane spanned by P and Q (Bate et al. 2.6)
 void OrbitEphemeris::calcR0V0()
 {
-	try
-	{
-		//Construct P and Q (see 'Fundamentals of Astrodynamics', R. Bate et al.)
-		Matrix pqw = this->calcPQWMatrix();
-		Vector P = pqw.right();
-		Vector Q = pqw.backward();
-		double semiLatRect = semiMajorA * (1.0 - pow(eccentricity, 2.0));
-		float rScal = static_cast<float>(semiLatRect / (1.0 + eccentricity * 1.0));
-		r0 = P * rScal;
-		//r0 = P * rScal * 1.0f;	//Unsure about origin of the *1.0f there TODO Re-check in the book
+	//Construct P and Q (see 'Fundamentals of Astrodynamics', R. Bate et al.)
+	Matrix pqw = this->calcPQWMatrix();
+	Vector P = pqw.right();
+	Vector Q = pqw.backward();
+	const double cosT = std::cos(trueAnomaly);
+	const double sinT = std::sin(trueAnomaly);
+	double semiLatRect = semiMajorA * (1.0 - pow(eccentricity, 2.0));
+	double rScal = semiLatRect / (1.0 + eccentricity * cosT);
+	r0 = P * static_cast<float>(rScal * cosT) + Q * static_cast<float>(rScal * sinT);
 
-		Vector temp = Q * static_cast<float>(this->eccentricity + 1.0);
-		v0 = temp * static_cast<float>(std::sqrt(mu / semiLatRect));
-		doR0V0exist = true;
-	}
-	catch (const std::exception& e)
-	{
-		doR0V0exist = false;
-		std::cout << e.what() << std::endl;
-	}
+	const double vScal = std::sqrt(mu / semiLatRect);
+	v0 = P * static_cast<float>(-sinT * vScal) + Q * static_cast<float>((this->eccentricity + cosT) * vScal);
+	doR0V0exist = true;
 }
 //Provides the currently saved value for R0, calculates it anew if no value is present
 Vector OrbitEphemeris::getR0()
@@ -105,18 +91,10 @@ void OrbitEphemeris::updateR0V0(Vector nextR0, Vector nextV0)
 //Calculates the matrix that can be used to infer the plane that the orbit lies in
 Matrix OrbitEphemeris::calcPQWMatrix()
 {
-	try
-	{
-		Matrix a = Matrix().rotationY(longitudeAsc);
-		Matrix b = Matrix().rotationX(inclination);
-		Matrix c = Matrix().rotationAxis(Vector(0, 1, 0), argPeriaps);
-		pqw = Matrix();
-		pqw = pqw * a * b * c;
-		return pqw;
-	}
-	catch (const std::exception& e)
-	{
-		std::cerr << e.what() << std::endl;
-		return Matrix();
-	}
+	Matrix a = Matrix().rotationY(longitudeAsc);
+	Matrix b = Matrix().rotationX(inclination);
+	Matrix c = Matrix().rotationAxis(Vector(0, 1, 0), argPeriaps);
+	pqw = Matrix();
+	pqw = pqw * a * b * c;
+	return pqw;
 }
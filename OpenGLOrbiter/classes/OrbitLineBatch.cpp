@@ -0,0 +1,435 @@
+//Author: Bernhard Luedtke
+
+#include "OrbitLineBatch.h"
+#include "OrbitLineModel.h"
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
+static_assert(sizeof(float) == sizeof(GLuint), "the slot table is read as std430");
+
+// Pass 0: frustum test and level of every slot, vertices for every shift of the levels counted.
+// Pass 1: the smallest shift within the budget, one DrawElementsIndirectCommand per slot.
+const char *BatchCullShaderCode =
+"#version 430\n"
+"layout(local_size_x = 64) in;"
+"struct LineObject {"
+"    vec4 Sphere;"
+"    uint First[8];"
+"    uint Count[8];"
+"    float Error[8];"
+"    uint BaseVertex;"
+"    uint Levels;"
+"    uint Selected;"
+"    uint Pad;"
+"};"
+"layout(std430, binding = 0) readonly buffer Objects { LineObject Lines[]; };"
+"layout(std430, binding = 1) buffer Chosen { uint Level[]; };"
+"layout(std430, binding = 2) buffer Counters { uint Vertices[8]; };"
+"layout(std430, binding = 3) writeonly buffer Commands { uint Command[]; };"
+"uniform vec4 Planes[6];"
+"uniform vec3 Eye;"
+"uniform float PixelsAtOne;"
+"uniform float PixelError;"
+"uniform uint LineCount;"
+"uniform uint VertexBudget;"
+"uniform uint MaxShift;"
+"uniform int Pass;"
+"const uint Culled = 0xffffffffu;"
+"void main()"
+"{"
+"    uint i = gl_GlobalInvocationID.x;"
+"    if (i >= LineCount) return;"
+"    uint levels = Lines[i].Levels;"
+"    if (Pass == 0) {"
+"        uint level = Culled;"
+"        vec4 sphere = Lines[i].Sphere;"
+"        bool inside = levels > 0u;"
+"        for (int k = 0; k < 6 && inside && Lines[i].Selected == 0u; ++k) {"
+"            inside = dot(Planes[k].xyz, sphere.xyz) + Planes[k].w >= -sphere.w;"
+"        }"
+"        if (inside) {"
+"            float pixelsPerUnit = PixelsAtOne / max(length(sphere.xyz - Eye) - sphere.w, 0.05);"
+"            level = 0u;"
+"            while (level + 1u < levels && Lines[i].Error[level + 1u] * pixelsPerUnit <= PixelError) {"
+"                ++level;"
+"            }"
+"            for (uint s = 0u; s < 8u; ++s) {"
+"                atomicAdd(Vertices[s], Lines[i].Count[min(level + s, levels - 1u)]);"
+"            }"
+"        }"
+"        Level[i] = level;"
+"        return;"
+"    }"
+"    uint shift = 0u;"
+"    while (VertexBudget > 0u && Vertices[shift] > VertexBudget && shift < MaxShift) {"
+"        ++shift;"
+"    }"
+"    uint level = Level[i];"
+"    uint l = (level == Culled) ? 0u : min(level + shift, levels - 1u);"
+"    uint c = 5u * i;"
+"    Command[c] = (level == Culled) ? 0u : Lines[i].Count[l];"
+"    Command[c + 1u] = (level == Culled) ? 0u : 1u;"
+"    Command[c + 2u] = Lines[i].First[l];"
+"    Command[c + 3u] = Lines[i].BaseVertex;"
+"    Command[c + 4u] = 0u;"
+"}";
+
+bool OrbitLineBatch::isSupported()
+{
+#ifdef __APPLE__
+	return false;
+#else
+	return GLEW_VERSION_4_3 || (GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_multi_draw_indirect);
+#endif
+}
+
+OrbitLineBatch::OrbitLineBatch() : SlotCapacity(0), Program(0), VAO(0), LineBuffer(0), LevelBuffer(0), CounterBuffer(0), CommandBuffer(0),
+	PlanesLoc(-1), EyeLoc(-1), PixelsAtOneLoc(-1), PixelErrorLoc(-1), LineCountLoc(-1), VertexBudgetLoc(-1), MaxShiftLoc(-1), PassLoc(-1), VertexArrayDirty(true),
+	LastVertexBudget(0), LastMaxShift(0)
+{
+	VertexArena.ElementSize = 3 * sizeof(float);
+	IndexArena.ElementSize = sizeof(GLuint);
+	if (!isSupported()) {
+		return;
+	}
+#ifndef __APPLE__
+	GLuint CS = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(CS, 1, &BatchCullShaderCode, NULL);
+	glCompileShader(CS);
+	GLint Success = 0;
+	glGetShaderiv(CS, GL_COMPILE_STATUS, &Success);
+	const unsigned int LogSize = 8 * 1024;
+	char ShaderLog[LogSize];
+	if (Success == GL_FALSE) {
+		glGetShaderInfoLog(CS, LogSize, NULL, ShaderLog);
+		std::cout << "OrbitLineBatch: CS: " << ShaderLog << std::endl;
+		glDeleteShader(CS);
+		return;
+	}
+	Program = glCreateProgram();
+	glAttachShader(Program, CS);
+	glDeleteShader(CS);
+	glLinkProgram(Program);
+	glGetProgramiv(Program, GL_LINK_STATUS, &Success);
+	if (Success == GL_FALSE) {
+		glGetProgramInfoLog(Program, LogSize, NULL, ShaderLog);
+		std::cout << "OrbitLineBatch: " << ShaderLog << std::endl;
+		glDeleteProgram(Program);
+		Program = 0;
+		return;
+	}
+	PlanesLoc = glGetUniformLocation(Program, "Planes");
+	EyeLoc = glGetUniformLocation(Program, "Eye");
+	PixelsAtOneLoc = glGetUniformLocation(Program, "PixelsAtOne");
+	PixelErrorLoc = glGetUniformLocation(Program, "PixelError");
+	LineCountLoc = glGetUniformLocation(Program, "LineCount");
+	VertexBudgetLoc = glGetUniformLocation(Program, "VertexBudget");
+	MaxShiftLoc = glGetUniformLocation(Program, "MaxShift");
+	PassLoc = glGetUniformLocation(Program, "Pass");
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &CounterBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, CounterBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, maxLevels * sizeof(GLuint), NULL, GL_DYNAMIC_READ);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	VertexArena.grow(64 * 1024);
+	IndexArena.grow(256 * 1024);
+	reserveSlots(256);
+#endif
+}
+
+OrbitLineBatch::~OrbitLineBatch()
+{
+	const GLuint buffers[] = { VertexArena.Buffer, IndexArena.Buffer, LineBuffer, LevelBuffer, CounterBuffer, CommandBuffer };
+	for (GLuint buffer : buffers) {
+		if (buffer != 0) {
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+	if (VAO != 0) {
+		glDeleteVertexArrays(1, &VAO);
+	}
+	if (Program != 0) {
+		glDeleteProgram(Program);
+	}
+}
+
+size_t OrbitLineBatch::Arena::allocate(size_t count)
+{
+	if (count == 0) {
+		return 0;
+	}
+	for (;;) {
+		for (size_t k = 0; k < Free.size(); ++k) {
+			if (Free[k].second >= count) {
+				const size_t first = Free[k].first;
+				Free[k].first += count;
+				Free[k].second -= count;
+				if (Free[k].second == 0) {
+					Free.erase(Free.begin() + k);
+				}
+				return first;
+			}
+		}
+		grow(std::max(2 * Capacity, Capacity + count));
+	}
+}
+
+void OrbitLineBatch::Arena::release(size_t first, size_t count)
+{
+	if (count == 0) {
+		return;
+	}
+	auto it = std::lower_bound(Free.begin(), Free.end(), std::make_pair(first, size_t(0)));
+	it = Free.insert(it, std::make_pair(first, count));
+	// Merge with the neighbours
+	if (it + 1 != Free.end() && it->first + it->second == (it + 1)->first) {
+		it->second += (it + 1)->second;
+		Free.erase(it + 1);
+	}
+	if (it != Free.begin() && (it - 1)->first + (it - 1)->second == it->first) {
+		(it - 1)->second += it->second;
+		Free.erase(it);
+	}
+}
+
+void OrbitLineBatch::Arena::grow(size_t minimum)
+{
+	if (minimum <= Capacity) {
+		return;
+	}
+	GLuint larger = 0;
+	glGenBuffers(1, &larger);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, larger);
+	glBufferData(GL_COPY_WRITE_BUFFER, minimum * ElementSize, NULL, GL_STATIC_DRAW);
+	if (Buffer != 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, Buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, Capacity * ElementSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &Buffer);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	Buffer = larger;
+	release(Capacity, minimum - Capacity);
+	Capacity = minimum;
+}
+
+void OrbitLineBatch::reserveSlots(size_t slots)
+{
+	if (slots <= SlotCapacity) {
+		return;
+	}
+	const size_t capacity = std::max(slots, 2 * SlotCapacity);
+	// Levels and commands are written again every frame, only the table is kept
+	GLuint table = 0;
+	glGenBuffers(1, &table);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, table);
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(GpuLine), NULL, GL_DYNAMIC_DRAW);
+	if (LineBuffer != 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, LineBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, SlotCapacity * sizeof(GpuLine));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &LineBuffer);
+		glDeleteBuffers(1, &LevelBuffer);
+		glDeleteBuffers(1, &CommandBuffer);
+	}
+	LineBuffer = table;
+	glGenBuffers(1, &LevelBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, LevelBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+	glGenBuffers(1, &CommandBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, CommandBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity * 5 * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	SlotCapacity = capacity;
+}
+
+void OrbitLineBatch::uploadSlot(size_t slot)
+{
+	glBindBuffer(GL_COPY_WRITE_BUFFER, LineBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, slot * sizeof(GpuLine), sizeof(GpuLine), &Lines[slot]);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Indices of a level's segments, in the order OrbitLineModel::addLine adds their vertices (closed: last point to the first)
+static void addSegments(const std::vector<unsigned int>& level, bool fullLine, std::vector<GLuint>& indices)
+{
+	if (level.empty()) {
+		return;
+	}
+	for (size_t i = 1; i < level.size(); ++i) {
+		if (fullLine) {
+			indices.push_back(level[i - 1]);
+		}
+		indices.push_back(level[i]);
+	}
+	indices.push_back(level.back());
+	indices.push_back(level.front());
+}
+
+size_t OrbitLineBatch::lineBytes(size_t count, const std::vector<std::vector<unsigned int>>& levels, bool fullLine)
+{
+	size_t indices = 0;
+	for (size_t l = 0; l < levels.size() && l < maxLevels; ++l) {
+		indices += fullLine ? 2 * levels[l].size() : levels[l].size() + 1;
+	}
+	return count * 3 * sizeof(float) + indices * sizeof(GLuint);
+}
+
+size_t OrbitLineBatch::add(const float* xyz, size_t count, const std::vector<std::vector<unsigned int>>& levels, float baseError, bool fullLine,
+	const Vector& center, float radius)
+{
+	size_t slot = Lines.size();
+	if (!FreeSlots.empty()) {
+		slot = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else {
+		Lines.push_back(GpuLine());
+		Allocations.push_back(Allocation());
+		reserveSlots(Lines.size());
+	}
+	GpuLine& line = Lines[slot];
+	memset(&line, 0, sizeof(GpuLine));
+	Allocation& a = Allocations[slot];
+	std::vector<GLuint> indices;
+	const size_t levelCount = std::min<size_t>(levels.size(), maxLevels);
+	for (size_t l = 0; l < levelCount; ++l) {
+		line.First[l] = static_cast<GLuint>(indices.size());
+		addSegments(levels[l], fullLine, indices);
+		line.Count[l] = static_cast<GLuint>(indices.size()) - line.First[l];
+		line.Error[l] = OrbitLineModel::errorOfLevel(baseError, l);
+	}
+	const GLuint vertexBuffer = VertexArena.Buffer;
+	const GLuint indexBuffer = IndexArena.Buffer;
+	a.Vertices = count;
+	a.FirstVertex = VertexArena.allocate(count);
+	a.Indices = indices.size();
+	a.FirstIndex = IndexArena.allocate(indices.size());
+	// A grown arena is a new buffer
+	VertexArrayDirty = VertexArrayDirty || vertexBuffer != VertexArena.Buffer || indexBuffer != IndexArena.Buffer;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VertexArena.Buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, a.FirstVertex * VertexArena.ElementSize, count * VertexArena.ElementSize, xyz);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, IndexArena.Buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, a.FirstIndex * sizeof(GLuint), indices.size() * sizeof(GLuint), indices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	for (size_t l = 0; l < levelCount; ++l) {
+		line.First[l] += static_cast<GLuint>(a.FirstIndex);
+	}
+	line.Sphere[0] = center.X;
+	line.Sphere[1] = center.Y;
+	line.Sphere[2] = center.Z;
+	line.Sphere[3] = radius;
+	line.BaseVertex = static_cast<GLuint>(a.FirstVertex);
+	line.Levels = static_cast<GLuint>(levelCount);
+	uploadSlot(slot);
+	return slot;
+}
+
+void OrbitLineBatch::remove(size_t slot)
+{
+	if (slot >= Lines.size() || Lines[slot].Levels == 0) {
+		return;
+	}
+	Allocation& a = Allocations[slot];
+	VertexArena.release(a.FirstVertex, a.Vertices);
+	IndexArena.release(a.FirstIndex, a.Indices);
+	a = Allocation();
+	memset(&Lines[slot], 0, sizeof(GpuLine));
+	uploadSlot(slot);
+	FreeSlots.push_back(slot);
+}
+
+void OrbitLineBatch::setSelected(size_t slot, bool selected)
+{
+	if (slot >= Lines.size() || Lines[slot].Levels == 0 || (Lines[slot].Selected != 0) == selected) {
+		return;
+	}
+	Lines[slot].Selected = selected ? 1 : 0;
+	uploadSlot(slot);
+}
+
+void OrbitLineBatch::bindVertexArray()
+{
+	glBindVertexArray(VAO);
+	if (VertexArrayDirty) {
+		glBindBuffer(GL_ARRAY_BUFFER, VertexArena.Buffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), BUFFER_OFFSET(0));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexArena.Buffer);
+		VertexArrayDirty = false;
+	}
+}
+
+void OrbitLineBatch::draw(const BaseCamera& Cam, StandardShader& shader, const float planes[6][4], float pixelsAtOne, float pixelError, size_t vertexBudget,
+	unsigned int maxShift)
+{
+	if (!valid() || Lines.size() == FreeSlots.size()) {
+		return;
+	}
+#ifndef __APPLE__
+	const GLuint slots = static_cast<GLuint>(Lines.size());
+	LastVertexBudget = vertexBudget;
+	LastMaxShift = std::min(maxShift, maxLevels - 1);
+	// The shader classes skip glUseProgram for the one they think is bound, so it is bound again afterwards
+	GLint previous = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+	const GLuint zero[maxLevels] = {};
+	glBindBuffer(GL_COPY_WRITE_BUFFER, CounterBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(zero), zero);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glUseProgram(Program);
+	glUniform4fv(PlanesLoc, 6, &planes[0][0]);
+	const Vector eye = Cam.position();
+	glUniform3f(EyeLoc, eye.X, eye.Y, eye.Z);
+	glUniform1f(PixelsAtOneLoc, pixelsAtOne);
+	glUniform1f(PixelErrorLoc, pixelError);
+	glUniform1ui(LineCountLoc, slots);
+	glUniform1ui(VertexBudgetLoc, static_cast<GLuint>(std::min<size_t>(vertexBudget, 0xffffffffu)));
+	glUniform1ui(MaxShiftLoc, LastMaxShift);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, LineBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, LevelBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, CounterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, CommandBuffer);
+	const GLuint groups = (slots + 63) / 64;
+	glUniform1i(PassLoc, 0);
+	glDispatchCompute(groups, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glUniform1i(PassLoc, 1);
+	glDispatchCompute(groups, 1, 1);
+	// Commands for the draw below, counters for glGetBufferSubData in readStats()
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	glUseProgram(previous);
+
+	shader.modelTransform(Matrix().identity());
+	shader.activate(Cam);
+	bindVertexArray();
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, CommandBuffer);
+	glMultiDrawElementsIndirect(GL_LINES, GL_UNSIGNED_INT, BUFFER_OFFSET(0), slots, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+#endif
+}
+
+void OrbitLineBatch::readStats(size_t& vertices, unsigned int& levelShift) const
+{
+	vertices = 0;
+	levelShift = 0;
+	if (!valid()) {
+		return;
+	}
+	GLuint counters[maxLevels] = {};
+	glBindBuffer(GL_COPY_READ_BUFFER, CounterBuffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	// As the second pass chose it
+	while (LastVertexBudget > 0 && counters[levelShift] > LastVertexBudget && levelShift < LastMaxShift) {
+		++levelShift;
+	}
+	vertices = counters[levelShift];
+}
@@ -0,0 +1,121 @@
+//Author: Bernhard Luedtke
+
+#ifndef OrbitLineBatch_hpp
+#define OrbitLineBatch_hpp
+#ifdef WIN32
+#include <GL/glew.h>
+#include <glfw/glfw3.h>
+#else
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#define GLFW_INCLUDE_GLEXT
+#include <glfw/glfw3.h>
+#else
+#include "GL\glew.h"
+#include "GLFW\glfw3.h"
+#endif
+#endif
+#include <vector>
+#include <stddef.h>
+#include "vector.h"
+#include "camera.h"
+#include "StandardShader.h"
+
+/*
+	Orbit lines drawn by the GPU (GL 4.3: compute shaders, shader storage buffers, glMultiDrawElementsIndirect).
+	The points of all lines share one vertex buffer and their levels (OrbitLineModel::buildLevelIndices) one index buffer, both
+	suballocated (first fit). Every line has a slot in a table on the GPU: bounding sphere, first index, index count and error of
+	each level. Each frame a compute pass tests every slot against the frustum and picks its level like OrbitLinePool does on the
+	CPU (projected error below the pixel error, then all lines coarser until they fit into the vertex budget); a second pass writes
+	one DrawElementsIndirectCommand per slot (culled ones with no instances). One glMultiDrawElementsIndirect draws all of them.
+*/
+class OrbitLineBatch
+{
+public:
+	// True if the context has everything needed: GL 4.3, or compute shaders, shader storage buffers and multi draw indirect as
+	// extensions (never on macOS, GL 4.1)
+	static bool isSupported();
+	// Needs the GL context. valid() is false if the compute shader does not compile.
+	OrbitLineBatch();
+	~OrbitLineBatch();
+	OrbitLineBatch(const OrbitLineBatch&) = delete;
+	OrbitLineBatch& operator=(const OrbitLineBatch&) = delete;
+	bool valid() const noexcept { return Program != 0; }
+
+	// Uploads a closed line (count points, 3 floats each) in the given levels, segments drawn like OrbitLineModel does.
+	// Returns its slot.
+	size_t add(const float* xyz, size_t count, const std::vector<std::vector<unsigned int>>& levels, float baseError, bool fullLine,
+		const Vector& center, float radius);
+	void remove(size_t slot);
+	// Drawn wherever the camera looks
+	void setSelected(size_t slot, bool selected);
+	// GPU memory a line of count points and these levels takes
+	static size_t lineBytes(size_t count, const std::vector<std::vector<unsigned int>>& levels, bool fullLine);
+
+	// Culls, picks the levels and draws all lines with shader (planes: frustum, a*x + b*y + c*z + d >= 0 inside; pixelsAtOne:
+	// pixels per render unit at distance 1; vertexBudget 0: no limit; maxShift: levels coarser at most for the budget)
+	void draw(const BaseCamera& Cam, StandardShader& shader, const float planes[6][4], float pixelsAtOne, float pixelError, size_t vertexBudget,
+		unsigned int maxShift);
+	// Vertices of the last draw() and how many levels coarser all lines were, read back from the GPU (waits for it)
+	void readStats(size_t& vertices, unsigned int& levelShift) const;
+	size_t lineCount() const noexcept { return Lines.size() - FreeSlots.size(); }
+
+	// Levels a line may have, and the coarser steps the vertex budget can take
+	static const unsigned int maxLevels = 8;
+
+private:
+	// A growing buffer, suballocated in elements of elementSize bytes
+	struct Arena {
+		GLuint Buffer = 0;
+		size_t ElementSize = 0;
+		size_t Capacity = 0;
+		// Free ranges (first, count), sorted by first
+		std::vector<std::pair<size_t, size_t>> Free;
+		size_t allocate(size_t count);
+		void release(size_t first, size_t count);
+		void grow(size_t minimum);
+	};
+	// One slot in the table, std430 layout of LineObject in the compute shader
+	struct GpuLine {
+		float Sphere[4];
+		GLuint First[maxLevels];
+		GLuint Count[maxLevels];
+		float Error[maxLevels];
+		GLuint BaseVertex;
+		// 0: free slot
+		GLuint Levels;
+		GLuint Selected;
+		GLuint Pad;
+	};
+	// Where a line's data is, to free it again
+	struct Allocation {
+		size_t FirstVertex = 0;
+		size_t Vertices = 0;
+		size_t FirstIndex = 0;
+		size_t Indices = 0;
+	};
+	void uploadSlot(size_t slot);
+	// Buffers of the slot table, levels and commands for at least slots
+	void reserveSlots(size_t slots);
+	void bindVertexArray();
+
+	Arena VertexArena;
+	Arena IndexArena;
+	std::vector<GpuLine> Lines;
+	std::vector<Allocation> Allocations;
+	std::vector<size_t> FreeSlots;
+	size_t SlotCapacity;
+	GLuint Program;
+	GLuint VAO;
+	GLuint LineBuffer;
+	GLuint LevelBuffer;
+	GLuint CounterBuffer;
+	GLuint CommandBuffer;
+	GLint PlanesLoc, EyeLoc, PixelsAtOneLoc, PixelErrorLoc, LineCountLoc, VertexBudgetLoc, MaxShiftLoc, PassLoc;
+	bool VertexArrayDirty;
+	// Of the last draw(), for readStats()
+	size_t LastVertexBudget;
+	unsigned int LastMaxShift;
+};
+
+#endif /* OrbitLineBatch_hpp */
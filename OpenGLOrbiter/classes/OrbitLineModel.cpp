@@ -1,6 +1,8 @@
 //Author: Bernhard Luedtke
 
 #include "OrbitLineModel.h"
+#include <algorithm>
+#include <math.h>
 
 OrbitLineModel::OrbitLineModel(std::vector<Vector> points, bool fullLine)
 {
@@ -27,45 +29,184 @@ OrbitLineModel::OrbitLineModel(std::vector<Vector> points, Matrix transform, boo
 	this->transform(transform);
 }
 
+OrbitLineModel::OrbitLineModel(const float* xyz, size_t count, bool fullLine)
+{
+	this->evaluatePoints(xyz, count, fullLine, Color(0.0f, 0.6f, 0.0f));
+	Matrix standard = Matrix();
+	standard.translation(0.0f, 0.0f, 0.0f);
+	transform(standard);
+}
+
+OrbitLineModel::OrbitLineModel(const std::vector<std::vector<Vector>>& levels, float baseError, bool fullLine)
+{
+	try
+	{
+		VB.begin();
+		VB.addColor(Color(0.0f, 0.6f, 0.0f));
+		for (const std::vector<Vector>& level : levels) {
+			levelFirst.push_back(VB.vertexCount());
+			addLine(level.empty() ? nullptr : &level[0].X, level.size(), fullLine);
+			levelVertices.push_back(VB.vertexCount() - levelFirst.back());
+			levelErrors.push_back(errorOfLevel(baseError, levelErrors.size()));
+		}
+		VB.end();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+	}
+	Matrix standard = Matrix();
+	standard.translation(0.0f, 0.0f, 0.0f);
+	transform(standard);
+}
+
+// Distance of p from the segment a-b
+static float segmentDistance(const Vector& p, const Vector& a, const Vector& b)
+{
+	const Vector ab = b - a;
+	const Vector ap = p - a;
+	const float length2 = ab.lengthSquared();
+	const float along = (length2 > 0.0f) ? std::max(0.0f, std::min(1.0f, ap.dot(ab) / length2)) : 0.0f;
+	return (ap - ab * along).length();
+}
+
+std::vector<std::vector<Vector>> OrbitLineModel::buildLevels(const float* xyz, size_t count, float baseError, unsigned int maxLevels)
+{
+	static_assert(sizeof(Vector) == 3 * sizeof(float), "Vector is read as 3 floats");
+	const Vector* fine = reinterpret_cast<const Vector*>(xyz);
+	const std::vector<std::vector<unsigned int>> indices = buildLevelIndices(xyz, count, baseError, maxLevels);
+	std::vector<std::vector<Vector>> levels(indices.size());
+	for (size_t l = 0; l < indices.size(); ++l) {
+		levels[l].resize(indices[l].size());
+		for (size_t i = 0; i < indices[l].size(); ++i) {
+			levels[l][i] = fine[indices[l][i]];
+		}
+	}
+	return levels;
+}
+
+std::vector<std::vector<unsigned int>> OrbitLineModel::buildLevelIndices(const float* xyz, size_t count, float baseError, unsigned int maxLevels)
+{
+	std::vector<std::vector<unsigned int>> levels;
+	if (count == 0 || maxLevels == 0) {
+		return levels;
+	}
+	const Vector* fine = reinterpret_cast<const Vector*>(xyz);
+	// Indices into level 0 of the points of the last level, and of the next one
+	std::vector<unsigned int> kept(count);
+	for (size_t i = 0; i < count; ++i) {
+		kept[i] = static_cast<unsigned int>(i);
+	}
+	levels.push_back(kept);
+	std::vector<unsigned int> next;
+	float error = baseError;
+	while (levels.size() < maxLevels) {
+		// Every level is measured against the points of level 0, which are baseError from the orbit, its chords may be step^k * baseError
+		// from them. Skipping every other point of a line sampled by curvature makes the chords about 4 times farther away,
+		// so a step of 5 keeps a bit less than half of the points of the level before.
+		error *= levelErrorStep;
+		// Only points of the last level are kept: from every kept one as far along as all points of level 0 in between stay
+		// within error of the chord, closed (position m is point 0 again)
+		const size_t m = kept.size();
+		next.clear();
+		next.push_back(kept[0]);
+		size_t anchor = 0;
+		while (anchor < m) {
+			size_t end = anchor + 1;
+			while (end < m) {
+				const size_t candidate = end + 1;
+				const Vector& a = fine[kept[anchor]];
+				const Vector& b = fine[(candidate < m) ? kept[candidate] : 0];
+				const size_t last = (candidate < m) ? kept[candidate] : count;
+				bool within = true;
+				for (size_t k = kept[anchor] + 1; k < last && within; ++k) {
+					within = segmentDistance(fine[k], a, b) <= error;
+				}
+				if (!within) {
+					break;
+				}
+				end = candidate;
+			}
+			if (end >= m) {
+				break;
+			}
+			next.push_back(kept[end]);
+			anchor = end;
+		}
+		if (next.size() < 8 || next.size() * 10 > m * 9) {
+			break;
+		}
+		kept.swap(next);
+		levels.push_back(kept);
+	}
+	return levels;
+}
+
+float OrbitLineModel::errorOfLevel(float baseError, size_t level)
+{
+	return (level == 0) ? baseError : baseError + baseError * powf(levelErrorStep, static_cast<float>(level));
+}
+
 
 void OrbitLineModel::draw(const BaseCamera & Cam)
 {
 	StandardModel::draw(Cam);
+	drawLines();
+}
+
+void OrbitLineModel::drawLines(unsigned int level)
+{
+	if (level >= levelVertices.size()) {
+		return;
+	}
 	VB.activate();
 	//glDrawArrays(GL_LINE_STRIP, 0, VB.vertexCount());
-	glDrawArrays(GL_LINES, 0, VB.vertexCount());
+	glDrawArrays(GL_LINES, levelFirst[level], levelVertices[level]);
 
 	VB.deactivate();
 }
 
 void OrbitLineModel::evaluatePoints(bool fullLine, Color c)
+{
+	static_assert(sizeof(Vector) == 3 * sizeof(float), "Vector is read as 3 floats");
+	evaluatePoints(points.empty() ? nullptr : &points[0].X, points.size(), fullLine, c);
+}
+
+void OrbitLineModel::evaluatePoints(const float* xyz, size_t count, bool fullLine, Color c)
 {
 	try
 	{
 		VB.begin();
 		VB.addColor(c);
-
-		if (points.size() > 0) {
-			for (unsigned int i = 1; i < points.size(); i++) {
-				if (fullLine) {
-					Vector p0 = points[i - 1];
-					VB.addVertex(p0.X, p0.Y, p0.Z);
-				}
-				Vector p1 = points[i];				
-				VB.addVertex(p1.X, p1.Y, p1.Z);
-			}
-			Vector p1 = points[points.size()-1];
-			VB.addVertex(p1.X, p1.Y, p1.Z);
-			p1 = points[0];
-			VB.addVertex(p1.X, p1.Y, p1.Z);
-		}
-		else {
-			std::cout << "NO POINTS TO DRAW THE ORBIT" << std::endl;
-		}
+		addLine(xyz, count, fullLine);
 		VB.end();
+		levelFirst.assign(1, 0);
+		levelVertices.assign(1, VB.vertexCount());
+		levelErrors.assign(1, 0.0f);
 	}
 	catch (const std::exception& e)
 	{
 		std::cerr << e.what() << std::endl;
 	}
 }
+
+void OrbitLineModel::addLine(const float* xyz, size_t count, bool fullLine)
+{
+	if (count > 0) {
+		for (size_t i = 1; i < count; i++) {
+			if (fullLine) {
+				const float* p0 = xyz + 3 * (i - 1);
+				VB.addVertex(p0[0], p0[1], p0[2]);
+			}
+			const float* p1 = xyz + 3 * i;
+			VB.addVertex(p1[0], p1[1], p1[2]);
+		}
+		const float* p1 = xyz + 3 * (count - 1);
+		VB.addVertex(p1[0], p1[1], p1[2]);
+		p1 = xyz;
+		VB.addVertex(p1[0], p1[1], p1[2]);
+	}
+	else {
+		std::cout << "NO POINTS TO DRAW THE ORBIT" << std::endl;
+	}
+}
@@ -4,6 +4,7 @@
 #define OrbitLineModel_hpp
 
 #include <stdio.h>
+#include <vector>
 #include "StandardModel.h"
 #include "vertexbuffer.h"
 
@@ -13,13 +14,41 @@ public:
 	OrbitLineModel(std::vector<Vector> points, bool fullLine = true);
 	OrbitLineModel(std::vector<Vector> points, Color c, bool fullLine = true);
 	OrbitLineModel(std::vector<Vector> points, Matrix transform, bool fullLine = true);
+	// Straight from memory (e.g. a mapped EphemerisFile), 3 floats per point; points stays empty
+	OrbitLineModel(const float* xyz, size_t count, bool fullLine = true);
+	// Several resolutions of the same line in one vertex buffer (see buildLevels), level k is within baseError * (1 + levelErrorStep^k)
+	// (render units, level 0: baseError) of the orbit; points stays empty
+	OrbitLineModel(const std::vector<std::vector<Vector>>& levels, float baseError, bool fullLine = true);
 	virtual ~OrbitLineModel() {}
 	virtual void draw(const BaseCamera& Cam);
+	// Only the lines of one level, with whatever shader is active (several lines sharing one shader, see OrbitLinePool)
+	void drawLines(unsigned int level = 0);
+	// Size of the vertex buffer on the GPU
+	size_t bufferBytes() { return VB.vertexCount() * 8 * sizeof(float); }
+	unsigned int levelCount() const { return static_cast<unsigned int>(levelVertices.size()); }
+	unsigned int levelVertexCount(unsigned int level) const { return levelVertices[level]; }
+	float levelError(unsigned int level) const { return levelErrors[level]; }
+
+	// Coarser copies of a closed line: level 0 are the points themselves, every further level keeps the points of the one before
+	// that are needed to stay within baseError * levelErrorStep^k of them (at least 8 points).
+	// Stops early once a level keeps (nearly) everything of the one before.
+	static std::vector<std::vector<Vector>> buildLevels(const float* xyz, size_t count, float baseError, unsigned int maxLevels);
+	// The same as indices into xyz, ascending (level 0: every point)
+	static std::vector<std::vector<unsigned int>> buildLevelIndices(const float* xyz, size_t count, float baseError, unsigned int maxLevels);
+	// Largest distance of a level from the orbit (render units), for levels of buildLevels
+	static float errorOfLevel(float baseError, size_t level);
+	static constexpr float levelErrorStep = 5.0f;
 	
 	std::vector<Vector> points;
 protected:
 	VertexBuffer VB;
+	// First vertex and vertex count of every level in VB, and its largest distance from the orbit
+	std::vector<unsigned int> levelFirst;
+	std::vector<unsigned int> levelVertices;
+	std::vector<float> levelErrors;
 	void evaluatePoints(bool fullLine,Color c = Color(0.0f,0.6f,0.0f));
+	void evaluatePoints(const float* xyz, size_t count, bool fullLine, Color c);
+	void addLine(const float* xyz, size_t count, bool fullLine);
 };
 
 #endif /* OrbitLineModel_hpp */
@@ -0,0 +1,264 @@
+//Author: Bernhard Luedtke
+
+#include "OrbitLinePool.h"
+#include "ConstellationState.h"
+#include "CompiledOrbit.h"
+#include "EphemerisFile.h"
+#include "OrbitConstants.h"
+#include "Satellite.h"
+#include <math.h>
+#include <algorithm>
+
+OrbitLinePool::OrbitLinePool() : shader(std::make_unique<FlatColorShader>(Color(0.9f, 0.2f, 0)))
+{
+}
+
+size_t OrbitLinePool::add(uint64_t satelliteId, const OrbitEphemeris& eph, bool fullLine)
+{
+	Line line;
+	line.eph = eph;
+	line.satelliteId = satelliteId;
+	line.fullLine = fullLine;
+	// Ellipses: centered a*e behind the focus (the earth) against the periapsis, radius a. Open orbits end at openConicRadius.
+	const CompiledOrbit o = CompiledOrbit::compile(eph, 0.0);
+	if (o.valid && o.alpha > 0.0) {
+		const double a = 1.0 / o.alpha;
+		const double back = -a * o.eccentricity * sizeFactor;
+		line.center = Vector(static_cast<float>(back * o.p[0]), static_cast<float>(back * o.p[1]), static_cast<float>(back * o.p[2]));
+		line.radius = static_cast<float>(a * sizeFactor);
+	}
+	else {
+		line.center = Vector(0.0f, 0.0f, 0.0f);
+		line.radius = static_cast<float>(ConstellationState::openConicRadius * sizeFactor);
+	}
+	lines.push_back(std::move(line));
+	return lines.size() - 1;
+}
+
+void OrbitLinePool::setSelected(size_t line, bool selected)
+{
+	if (line < lines.size()) {
+		lines[line].selected = selected;
+		if (lines[line].slot != noSlot) {
+			batch->setSelected(lines[line].slot, selected);
+		}
+	}
+}
+
+void OrbitLinePool::evict(size_t index)
+{
+	Line& line = lines[index];
+	lru.erase(line.lruPosition);
+	residentBytes -= line.bytes;
+	line.bytes = 0;
+	line.model.reset();
+	if (line.slot != noSlot) {
+		batch->remove(line.slot);
+		line.slot = noSlot;
+	}
+	++stats.evicted;
+}
+
+bool OrbitLinePool::freeSpace(size_t extraBytes)
+{
+	while (residentBytes + extraBytes > budget && !lru.empty()) {
+		const size_t oldest = lru.back();
+		if (lines[oldest].lastFrame == frame) {
+			//everything left is needed in this frame
+			return false;
+		}
+		evict(oldest);
+	}
+	return residentBytes + extraBytes <= budget;
+}
+
+bool OrbitLinePool::makeResident(size_t index)
+{
+	if (budgetFull || (creationsPerFrame > 0 && stats.created >= creationsPerFrame)) {
+		return false;
+	}
+	Line& line = lines[index];
+	size_t pointCount = 0;
+	const float* points = (ephemeris != nullptr && ephemeris->isOpen())
+		? ephemeris->findTrack(line.satelliteId, EphemerisFile::hashElements(line.eph), pointCount) : nullptr;
+	std::vector<Vector> sampled;
+	if (points == nullptr) {
+		sampled = ConstellationState::sampleConic(line.eph, Satellite::orbitVisTolerance);
+		pointCount = sampled.size();
+	}
+	if (pointCount == 0) {
+		return false;
+	}
+	const float baseError = static_cast<float>(Satellite::orbitVisTolerance * sizeFactor);
+	const float* xyz = (points != nullptr) ? points : &sampled[0].X;
+	if (gpuDriven) {
+		const std::vector<std::vector<unsigned int>> indices = OrbitLineModel::buildLevelIndices(xyz, pointCount, baseError, levels);
+		line.bytes = OrbitLineBatch::lineBytes(pointCount, indices, line.fullLine);
+		if (!freeSpace(line.bytes)) {
+			line.bytes = 0;
+			budgetFull = true;
+			return false;
+		}
+		line.slot = batch->add(xyz, pointCount, indices, baseError, line.fullLine, line.center, line.radius);
+		batch->setSelected(line.slot, line.selected);
+	}
+	else {
+		const std::vector<std::vector<Vector>> resolutions = OrbitLineModel::buildLevels(xyz, pointCount, baseError, levels);
+		// Vertices OrbitLineModel makes of them (every segment on its own, or a strip), 8 floats each
+		size_t vertices = 0;
+		for (const std::vector<Vector>& level : resolutions) {
+			vertices += line.fullLine ? 2 * level.size() : level.size() + 1;
+		}
+		if (!freeSpace(vertices * 8 * sizeof(float))) {
+			budgetFull = true;
+			return false;
+		}
+		line.model = std::make_unique<OrbitLineModel>(resolutions, baseError, line.fullLine);
+		line.bytes = line.model->bufferBytes();
+	}
+	residentBytes += line.bytes;
+	lru.push_front(index);
+	line.lruPosition = lru.begin();
+	line.lastFrame = frame;
+	++stats.created;
+	return true;
+}
+
+void OrbitLinePool::draw(const BaseCamera& Cam)
+{
+	++frame;
+	stats = OrbitLineStats();
+	budgetFull = false;
+	// Frustum planes (a, b, c, d) of the view projection matrix, inside where a*x + b*y + c*z + d >= 0 (Gribb, Hartmann)
+	const Matrix viewProj = Cam.getProjectionMatrix() * Cam.getViewMatrix();
+	const float* m = viewProj.m;
+	float planes[6][4];
+	for (int k = 0; k < 6; ++k) {
+		const int row = k / 2;
+		const float sign = (k % 2 == 0) ? 1.0f : -1.0f;
+		float length = 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			planes[k][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+			length += (c < 3) ? planes[k][c] * planes[k][c] : 0.0f;
+		}
+		length = (length > 0.0f) ? 1.0f / sqrtf(length) : 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			planes[k][c] *= length;
+		}
+	}
+	// Selected lines first, so they get the budget before the others
+	needed.clear();
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (lines[i].selected) {
+			needed.push_back(i);
+		}
+	}
+	for (size_t i = 0; i < lines.size(); ++i) {
+		const Line& line = lines[i];
+		if (line.selected) {
+			continue;
+		}
+		bool inside = true;
+		for (int k = 0; k < 6 && inside; ++k) {
+			inside = planes[k][0] * line.center.X + planes[k][1] * line.center.Y + planes[k][2] * line.center.Z + planes[k][3] >= -line.radius;
+		}
+		if (inside) {
+			needed.push_back(i);
+		}
+	}
+	stats.visible = needed.size();
+	// Lines already there are marked first, building the others never drops one of them
+	for (size_t index : needed) {
+		Line& line = lines[index];
+		if (line.resident()) {
+			line.lastFrame = frame;
+			lru.splice(lru.begin(), lru, line.lruPosition);
+		}
+	}
+	drawList.clear();
+	drawLevels.clear();
+	for (size_t index : needed) {
+		if (!lines[index].resident() && !makeResident(index)) {
+			++stats.deferred;
+			continue;
+		}
+		drawList.push_back(index);
+	}
+	// Pixels per render unit at distance 1: half the viewport height over tan(fovy / 2)
+	const float pixelsAtOne = 0.5f * static_cast<float>(viewportHeight) * Cam.getProjectionMatrix().m[5];
+	stats.drawn = drawList.size();
+	if (gpuDriven) {
+		// The same test and levels, for every line on the GPU
+		batch->draw(Cam, *shader, planes, pixelsAtOne, pixelError, vertexBudget, levels);
+		stats.gpuDriven = true;
+		trimToBudget();
+		return;
+	}
+	const Vector eye = Cam.position();
+	size_t vertices = 0;
+	for (size_t index : drawList) {
+		const Line& line = lines[index];
+		const float distance = std::max((line.center - eye).length() - line.radius, 0.05f);
+		const float pixelsPerUnit = pixelsAtOne / distance;
+		unsigned int level = 0;
+		while (level + 1 < line.model->levelCount() && line.model->levelError(level + 1) * pixelsPerUnit <= pixelError) {
+			++level;
+		}
+		drawLevels.push_back(level);
+		vertices += line.model->levelVertexCount(level);
+	}
+	// Too many: every line one level coarser (about half its vertices) until they fit
+	unsigned int shift = 0;
+	while (vertexBudget > 0 && vertices > vertexBudget && shift < levels) {
+		++shift;
+		vertices = 0;
+		for (size_t k = 0; k < drawList.size(); ++k) {
+			const OrbitLineModel& model = *lines[drawList[k]].model;
+			vertices += model.levelVertexCount(std::min(drawLevels[k] + shift, model.levelCount() - 1));
+		}
+	}
+	for (size_t k = 0; k < drawList.size(); ++k) {
+		OrbitLineModel& model = *lines[drawList[k]].model;
+		if (k == 0) {
+			shader->modelTransform(Matrix().identity());
+			shader->activate(Cam);
+		}
+		model.drawLines(std::min(drawLevels[k] + shift, model.levelCount() - 1));
+	}
+	stats.vertices = vertices;
+	stats.levelShift = shift;
+	trimToBudget();
+}
+
+void OrbitLinePool::trimToBudget()
+{
+	// Only after a smaller setBudget(), the builds stay within it
+	while (residentBytes > budget && !lru.empty()) {
+		evict(lru.back());
+	}
+	stats.resident = lru.size();
+	stats.bytes = residentBytes;
+}
+
+bool OrbitLinePool::setGpuDriven(bool enabled)
+{
+	if (enabled && !batch && OrbitLineBatch::isSupported()) {
+		batch = std::make_unique<OrbitLineBatch>();
+	}
+	enabled = enabled && batch && batch->valid();
+	if (enabled != gpuDriven) {
+		// Built for the other way of drawing
+		while (!lru.empty()) {
+			evict(lru.back());
+		}
+		gpuDriven = enabled;
+	}
+	return gpuDriven;
+}
+
+void OrbitLinePool::readGpuStats()
+{
+	if (gpuDriven && stats.gpuDriven) {
+		batch->readStats(stats.vertices, stats.levelShift);
+	}
+}
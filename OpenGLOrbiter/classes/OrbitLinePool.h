@@ -0,0 +1,137 @@
+//Author: Bernhard Luedtke
+#ifndef OrbitLinePool_hpp
+#define OrbitLinePool_hpp
+
+#include <vector>
+#include <list>
+#include <memory>
+#include <stdint.h>
+#include "OrbitLineModel.h"
+#include "OrbitLineBatch.h"
+#include "OrbitEphemeris.h"
+#include "FlatColorShader.h"
+#include "camera.h"
+
+class EphemerisFile;
+
+// Counters of the last draw(), and of the lines on the GPU after it
+struct OrbitLineStats {
+	// Orbits in the view frustum or selected, lines drawn, built, dropped for the budget, left for a later frame
+	size_t visible = 0;
+	size_t drawn = 0;
+	size_t created = 0;
+	size_t evicted = 0;
+	size_t deferred = 0;
+	size_t resident = 0;
+	size_t bytes = 0;
+	// Line vertices drawn, and how many levels every line was made coarser to stay within the vertex budget
+	size_t vertices = 0;
+	unsigned int levelShift = 0;
+	// Culled and drawn by an OrbitLineBatch; vertices and levelShift are only known after readGpuStats()
+	bool gpuDriven = false;
+};
+
+/*
+	Orbit lines that are only built once they are needed: when the orbit's bounding sphere is in the view frustum, or the line is selected.
+	add() keeps nothing but the elements. A line is taken from the EphemerisFile if it has it, otherwise sampled from the conic
+	(ConstellationState::sampleConic), and uploaded into its own vertex buffer; all lines share one FlatColorShader.
+	The buffers are kept in least recently drawn order. Once they need more than the budget, the lines that have not been drawn
+	for the longest time are dropped (and built again when they come back into view). Lines that are needed in the same frame
+	are never dropped for each other: what does not fit is left out (selected lines first) and counted as deferred.
+	Every line holds several resolutions (OrbitLineModel::buildLevels). Each frame draws the coarsest one whose error, projected at
+	the distance of the orbit's nearest point to the camera, is below the pixel error. If the lines together would have more vertices
+	than the vertex budget, all of them are made coarser level by level until they fit, so the vertices per frame stay about the
+	same however many orbits are in view.
+	With setGpuDriven(true) the lines are kept in an OrbitLineBatch instead of a vertex buffer each: the GPU tests them against the
+	frustum, picks their levels the same way and draws all of them with one call. The budget and the building stay the same.
+*/
+class OrbitLinePool {
+public:
+	// Needs the GL context (the shader is compiled here)
+	OrbitLinePool();
+	OrbitLinePool(const OrbitLinePool&) = delete;
+	OrbitLinePool& operator=(const OrbitLinePool&) = delete;
+
+	// Lines are looked up there first (nullptr: always sampled). The file has to stay open while lines are built.
+	void setEphemerisFile(EphemerisFile* file) { ephemeris = file; }
+	// Orbit line of satellite satelliteId (its id in the EphemerisFile). Returns the line's index, nothing is built yet.
+	size_t add(uint64_t satelliteId, const OrbitEphemeris& eph, bool fullLine = true);
+	// Selected lines are drawn wherever the camera looks, and before all others
+	void setSelected(size_t line, bool selected);
+	bool isSelected(size_t line) const { return lines[line].selected; }
+	// GPU memory for all vertex buffers together (bytes)
+	void setBudget(size_t bytes) { budget = bytes; }
+	size_t getBudget() const noexcept { return budget; }
+	// Lines built per frame at most, the others follow in the next frames (0: no limit)
+	void setCreationsPerFrame(unsigned int count) { creationsPerFrame = count; }
+	void setColor(const Color& c) { shader->color(c); }
+	// Largest distance of a drawn line from its orbit on screen (pixels), for the height of the viewport
+	void setPixelError(float pixels) { pixelError = pixels; }
+	void setViewportHeight(int pixels) { viewportHeight = pixels; }
+	// Line vertices per frame (0: no limit)
+	void setVertexBudget(size_t vertices) { vertexBudget = vertices; }
+	// Resolutions per line built from now on (1: only the full one)
+	void setLevels(unsigned int count) { levels = (count > 0) ? count : 1; }
+	// Lines culled and drawn on the GPU if it can (OrbitLineBatch::isSupported), otherwise one draw call each.
+	// Switching drops all lines on the GPU. Returns whether the GPU does it now.
+	bool setGpuDriven(bool enabled);
+	bool isGpuDriven() const noexcept { return gpuDriven; }
+	// Builds the missing lines of visible and selected orbits (within the budget) and draws them
+	void draw(const BaseCamera& Cam);
+	const OrbitLineStats& getStats() const noexcept { return stats; }
+	// Reads the vertices and level shift of the last draw() back from the GPU (waits for it)
+	void readGpuStats();
+	size_t size() const noexcept { return lines.size(); }
+
+private:
+	struct Line {
+		OrbitEphemeris eph;
+		uint64_t satelliteId = 0;
+		// Bounding sphere of the whole line in the render frame
+		Vector center;
+		float radius = 0.0f;
+		bool fullLine = true;
+		bool selected = false;
+		std::unique_ptr<OrbitLineModel> model;
+		// Slot in the batch if gpuDriven
+		size_t slot = noSlot;
+		bool resident() const { return model || slot != noSlot; }
+		size_t bytes = 0;
+		uint64_t lastFrame = 0;
+		// Position in lru, valid while model is set
+		std::list<size_t>::iterator lruPosition;
+	};
+	// Builds the line and frees space for it; false if it does not fit or no more lines may be built this frame
+	bool makeResident(size_t index);
+	void evict(size_t index);
+	// Removes lines not drawn this frame until extraBytes more fit into the budget
+	bool freeSpace(size_t extraBytes);
+	// Drops the least recently drawn lines while over the budget, then takes the counts
+	void trimToBudget();
+
+	std::vector<Line> lines;
+	// Resident lines, most recently drawn first
+	std::list<size_t> lru;
+	std::unique_ptr<FlatColorShader> shader;
+	std::unique_ptr<OrbitLineBatch> batch;
+	bool gpuDriven = false;
+	static const size_t noSlot = ~size_t(0);
+	EphemerisFile* ephemeris = nullptr;
+	size_t budget = 64 * 1024 * 1024;
+	size_t residentBytes = 0;
+	unsigned int creationsPerFrame = 64;
+	float pixelError = 1.0f;
+	int viewportHeight = 720;
+	size_t vertexBudget = 1000000;
+	unsigned int levels = 6;
+	uint64_t frame = 0;
+	// Set when a line did not fit, no more are built in this frame
+	bool budgetFull = false;
+	std::vector<size_t> needed;
+	// Lines to draw this frame and the level of each
+	std::vector<size_t> drawList;
+	std::vector<unsigned int> drawLevels;
+	OrbitLineStats stats;
+};
+
+#endif /* OrbitLinePool_hpp */
@@ -4,6 +4,7 @@
 
 
 #include "PhongShader.h"
+#include "ShaderProgramRegistry.h"
 
 const char *VertexShaderCode =
 "#version 400\n"
@@ -64,15 +65,17 @@ PhongShader::PhongShader() :
 	DiffuseTexture(Texture::defaultTex()),
 	UpdateState(0xFFFFFFFF)
 {
-	std::cout << "Constructor PhongShader\n";
 	cvCode = std::make_unique<std::string>(VertexShaderCode);
 	cfCode = std::make_unique<std::string>(FragmentShaderCode);
 	//std::string* cv = new std::string(VertexShaderCode);
 	//std::string* cf = new std::string(FragmentShaderCode);
 	ShaderProgram = createShaderProgram(cvCode.get(), cfCode.get());
-	std::cout << "   Shaderprogram: " << ShaderProgram << "\n";
 	assignLocations(); //Handles initialisation of Locations
 }
+void PhongShader::precompile()
+{
+	ShaderProgramRegistry::precompile(VertexShaderCode, FragmentShaderCode);
+}
 void PhongShader::assignLocations()
 {
 	DiffuseColorLoc = glGetUniformLocation(ShaderProgram, "DiffuseColor");
@@ -89,6 +92,9 @@ void PhongShader::assignLocations()
 void PhongShader::activate(const BaseCamera& Cam) const
 {
 	StandardShader::activate(Cam);
+	// the program is shared (ShaderProgramRegistry), its uniforms may be another shader's
+	if (ShaderProgramRegistry::claim(ShaderProgram, this))
+		UpdateState = 0xFFFFFFFF;
 
 	// update uniforms if necessary
 	if (UpdateState&DIFF_COLOR_CHANGED)
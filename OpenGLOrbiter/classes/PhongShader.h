@@ -36,6 +36,8 @@ class PhongShader : public StandardShader
 public:
 	PhongShader();
 	virtual ~PhongShader() {};
+	// Starts compiling the program of all PhongShaders (ShaderProgramRegistry::precompile)
+	static void precompile();
 	// setter
 	void diffuseColor(const Color& c);
 	void ambientColor(const Color& c);
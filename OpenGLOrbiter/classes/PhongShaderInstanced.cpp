@@ -4,25 +4,30 @@
 
 
 #include "PhongShaderInstanced.h"
+#include "ShaderProgramRegistry.h"
 
+// Per instance (attribute divisor 1, see InstancedSphereModel): the position of the sphere's center and its color
 const char* VertexShaderCodeX =
 "#version 400\n"
 "layout(location=0) in vec4 VertexPos;"
 "layout(location=1) in vec4 VertexNormal;"
 "layout(location=2) in vec2 VertexTexcoord;"
+"layout(location=4) in vec3 InstancePos;"
+"layout(location=5) in vec3 InstanceColor;"
 "out vec3 Position;"
 "out vec3 Normal;"
 "out vec2 Texcoord;"
+"out vec3 Color;"
 "uniform mat4 ModelMat;"
-"uniform mat4 ModelViewProjMat;"
-"uniform vec4 VOffsets[128];"
+"uniform mat4 ViewProjMat;"
 "void main()"
 "{"
-"    vec4 vPosOffset = VertexPos + VOffsets[gl_InstanceID];"
-"    Position = (ModelMat * vPosOffset).xyz;"
+"    vec4 WorldPos = ModelMat * VertexPos + vec4(InstancePos, 0.0);"
+"    Position = WorldPos.xyz;"
 "    Normal =  (ModelMat * VertexNormal).xyz;"
 "    Texcoord = VertexTexcoord;"
-"    gl_Position = ModelViewProjMat * VertexPos;"
+"    Color = InstanceColor;"
+"    gl_Position = ViewProjMat * WorldPos;"
 "}";
 
 
@@ -31,7 +36,6 @@ const char *FragmentShaderCodeX =
 "uniform vec3 EyePos;"
 "uniform vec3 LightPos;"
 "uniform vec3 LightColor;"
-"uniform vec3 DiffuseColor;"
 "uniform vec3 SpecularColor;"
 "uniform vec3 AmbientColor;"
 "uniform float SpecularExp;"
@@ -39,6 +43,7 @@ const char *FragmentShaderCodeX =
 "in vec3 Position;"
 "in vec3 Normal;"
 "in vec2 Texcoord;"
+"in vec3 Color;"
 "out vec4 FragColor;"
 "float sat( in float a)"
 "{"
@@ -51,37 +56,32 @@ const char *FragmentShaderCodeX =
 "    vec3 E = normalize(EyePos-Position);"
 "    vec3 R = reflect(-L,N);"
 "    vec3 DiffTex = texture( DiffuseTexture, Texcoord).rgb;"
-"    vec3 DiffuseComponent = LightColor * DiffuseColor * sat(dot(N,L));"
+"    vec3 DiffuseComponent = LightColor * Color * sat(dot(N,L));"
 "    vec3 SpecularComponent = LightColor * SpecularColor * pow( sat(dot(R,E)), SpecularExp);"
 "    FragColor = vec4((DiffuseComponent + AmbientColor)*DiffTex + SpecularComponent ,0);"
 "}";
 
 PhongShaderInstanced::PhongShaderInstanced()
 {
-	std::cout << "Constructor PhongShaderInstanced\n";
 	cvCode = std::make_unique<std::string>(VertexShaderCodeX);
 	cfCode = std::make_unique<std::string>(FragmentShaderCodeX);
-	//std::string* cv = new std::string(VertexShaderCode);
-	//std::string* cf = new std::string(FragmentShaderCode);
 	ShaderProgram = createShaderProgram(cvCode.get(), cfCode.get());
-	std::cout << "   Shaderprogram: " << ShaderProgram << "\n";
 	assignLocations(); //Handles initialisation of Locations
-	glUseProgram(ShaderProgram);
-	glEnableVertexAttribArray(VOffsetsLoc);
-	//glVertexAttribDivisor(VOffsetsLoc, 1);
-	glVertexAttribDivisor(VOffsetsLoc, 1);
-	//TODO CONTINUE HERE/ABOVE; THAT DIDNT REALLY WORK
-	glUseProgram(0);
+}
+
+void PhongShaderInstanced::precompile()
+{
+	PhongShader::precompile();
+	ShaderProgramRegistry::precompile(VertexShaderCodeX, FragmentShaderCodeX);
 }
 
 
 void PhongShaderInstanced::activate(const BaseCamera& Cam) const
 {
-	//std::cout << "Instanced Shader Activated\n";
 	StandardShader::activate(Cam);
-	// update uniforms if necessary
-	if (UpdateState & DIFF_COLOR_CHANGED)
-		glUniform3f(DiffuseColorLoc, DiffuseColor.R, DiffuseColor.G, DiffuseColor.B);
+	if (ShaderProgramRegistry::claim(ShaderProgram, this))
+		UpdateState = 0xFFFFFFFF;
+	// update uniforms if necessary, the diffuse color comes with every instance
 	if (UpdateState & AMB_COLOR_CHANGED)
 		glUniform3f(AmbientColorLoc, AmbientColor.R, AmbientColor.G, AmbientColor.B);
 	if (UpdateState & SPEC_COLOR_CHANGED)
@@ -98,21 +98,10 @@ void PhongShaderInstanced::activate(const BaseCamera& Cam) const
 	if (UpdateState & LIGHT_POS_CHANGED)
 		glUniform3f(LightPosLoc, LightPos.X, LightPos.Y, LightPos.Z);
 
-	if (UpdateState & POSITIONS_CHANGED) {
-		for (auto i = 0; i < instancePositions.size(); ++i) {
-			glUniform4f(glGetUniformLocation(ShaderProgram, ("VOffsets[" + std::to_string(i) + "]").c_str()), instancePositions.at(i).X, instancePositions.at(i).Y, instancePositions.at(i).Z, 0.0f);
-			//glUniform4f(glGetUniformLocation(ShaderProgram, ("VOffsets["+ std::to_string(i)+"]").c_str()), 2.0f, 2.0f, 2.0f, 2.0f);
-		}
-	}
-	//GLint instAttrib = glGetUniformLocation(ShaderProgram, "VOffsets[0]");
-	//std::cout << "VOffsetsLoc: " << VOffsetsLoc << "\n";
-	
-
-
 	// always update matrices
-	Matrix ModelViewProj = Cam.getProjectionMatrix() * Cam.getViewMatrix() * modelTransform();
+	Matrix ViewProj = Cam.getProjectionMatrix() * Cam.getViewMatrix();
 	glUniformMatrix4fv(ModelMatLoc, 1, GL_FALSE, modelTransform().m);
-	glUniformMatrix4fv(ModelViewProjLoc, 1, GL_FALSE, ModelViewProj.m);
+	glUniformMatrix4fv(ViewProjLoc, 1, GL_FALSE, ViewProj.m);
 
 	Vector EyePos = Cam.position();
 	glUniform3f(EyePosLoc, EyePos.X, EyePos.Y, EyePos.Z);
@@ -120,16 +109,8 @@ void PhongShaderInstanced::activate(const BaseCamera& Cam) const
 	UpdateState = 0x0;
 }
 
-void PhongShaderInstanced::setInstancePositions(std::vector<Vector>&& __instance_Positions)
-{
-	//std::cout << "New Positions are being set\n";
-	this->instancePositions = std::move(__instance_Positions);
-	UpdateState |= POSITIONS_CHANGED;
-}
-
 void PhongShaderInstanced::assignLocations()
 {
-	DiffuseColorLoc = glGetUniformLocation(ShaderProgram, "DiffuseColor");
 	AmbientColorLoc = glGetUniformLocation(ShaderProgram, "AmbientColor");
 	SpecularColorLoc = glGetUniformLocation(ShaderProgram, "SpecularColor");
 	SpecularExpLoc = glGetUniformLocation(ShaderProgram, "SpecularExp");
@@ -138,10 +119,7 @@ void PhongShaderInstanced::assignLocations()
 	LightColorLoc = glGetUniformLocation(ShaderProgram, "LightColor");
 	EyePosLoc = glGetUniformLocation(ShaderProgram, "EyePos");
 	ModelMatLoc = glGetUniformLocation(ShaderProgram, "ModelMat");
-	ModelViewProjLoc = glGetUniformLocation(ShaderProgram, "ModelViewProjMat");
-	VOffsetsLoc = glGetUniformLocation(ShaderProgram, "VOffsets");
-	std::cout << "offsetsLoc " << VOffsetsLoc << "\n";
-
+	ViewProjLoc = glGetUniformLocation(ShaderProgram, "ViewProjMat");
 }
 
 
@@ -31,21 +31,21 @@
 #include "texture.h"
 #include "PhongShader.h"
 
+// Phong shading of many copies of one mesh in a single draw call: every instance is moved by its position and has its own
+// diffuse color, both read from vertex attributes 4 and 5 with divisor 1 (InstancedSphereModel sets them up)
 class PhongShaderInstanced : public PhongShader
 {
 public:
 	PhongShaderInstanced();
 	virtual ~PhongShaderInstanced() {};
+	// Starts compiling its program and the one of PhongShader it is built from
+	static void precompile();
 	virtual void activate(const BaseCamera& Cam) const;
-	void setInstancePositions(std::vector<Vector> && __instance_Positions);
+	static const GLuint instancePositionAttribute = 4;
+	static const GLuint instanceColorAttribute = 5;
 protected:
 	void assignLocations();
-	std::vector<Vector> instancePositions{};
-	GLint VOffsetsLoc;
-	enum UPDATESTATES
-	{
-		POSITIONS_CHANGED = 1 << 7
-	};
+	GLint ViewProjLoc;
 };
 
 #endif /* PhongShaderInstanced_hpp */
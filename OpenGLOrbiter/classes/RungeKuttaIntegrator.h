@@ -0,0 +1,219 @@
+//Author: Bernhard Luedtke
+#ifndef RungeKuttaIntegrator_hpp
+#define RungeKuttaIntegrator_hpp
+
+#include <vector>
+#include <iostream>
+#include <cmath>
+#include "KeplerKernels.h"
+#include "Timeline.h"
+#include "OrbitEphemeris.h"
+#include "CompiledOrbit.h"
+#include "Accelerations.h"
+#include "RungeKuttaKernels.h"
+
+/*
+	Embedded Runge-Kutta (Fehlberg 4(5)) integration of many satellites at once, for force models without a closed form solution.
+	Satellites are integrated in lane groups (SSE2/AVX2/AVX-512, see getSimdLevel), each with its own adaptive step size.
+	The steps do not depend on the times the integrator is asked for: advanceTo(t) steps every satellite until its last step covers t
+	and evaluates the dense output there (quintic Hermite interpolation of r, v and a at both ends of the step, 5th order like the step).
+	As a TimelinePropagator a checkpoint holds the start of each satellite's last step (11 doubles per satellite).
+*/
+template <class Force>
+class RungeKuttaIntegrator : public TimelinePropagator {
+public:
+	explicit RungeKuttaIntegrator(double startTime = 0.0) : currentTime(startTime) {}
+
+	// Adds a satellite with the state (km, km/s) at the current time, returns its index
+	size_t add(const double r[3], const double v[3]);
+	// Adds a satellite with the elements valid at the current time
+	size_t add(const OrbitEphemeris& eph);
+	size_t size() const noexcept { return tB.size(); }
+
+	void setSettings(const RungeKuttaSettings& s) { settings = s; }
+	const RungeKuttaSettings& getSettings() const noexcept { return settings; }
+	const RungeKuttaStats& getStats() const noexcept { return stats; }
+	void resetStats() { stats = RungeKuttaStats(); }
+
+	// Integrates forwards to t >= getTime()
+	void advanceTo(double t) override;
+	double getTime() const override { return currentTime; }
+	// State at getTime() in km and km/s
+	void getStateKm(size_t i, double r[3], double v[3]) const;
+
+	size_t stateSize() const override { return 11 * size(); }
+	double saveState(double* state) const override;
+	void restoreState(const double* state, double t) override;
+
+private:
+	RungeKuttaArrays arrays();
+	void evaluateDense(double t);
+
+	RungeKuttaSettings settings;
+	RungeKuttaStats stats;
+	double currentTime;
+	std::vector<double> rA[3], vA[3], aA[3];
+	std::vector<double> rB[3], vB[3], aB[3];
+	std::vector<double> tA, hA, tB, hNext;
+	// Dense output at currentTime
+	std::vector<double> r[3], v[3];
+};
+
+template <class Force>
+size_t RungeKuttaIntegrator<Force>::add(const double r0[3], const double v0[3])
+{
+	double a0[3];
+	accelerationScalar<Force>(r0, a0);
+	for (int k = 0; k < 3; ++k) {
+		rA[k].push_back(r0[k]); vA[k].push_back(v0[k]); aA[k].push_back(a0[k]);
+		rB[k].push_back(r0[k]); vB[k].push_back(v0[k]); aB[k].push_back(a0[k]);
+		r[k].push_back(r0[k]); v[k].push_back(v0[k]);
+	}
+	tA.push_back(currentTime);
+	hA.push_back(0.0);
+	tB.push_back(currentTime);
+	// A first guess of 1/600 of an orbit at this radius, the error control takes over from there
+	const double rLength = std::sqrt(r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2]);
+	hNext.push_back(0.01 * std::sqrt(rLength * rLength * rLength / mu));
+	return size() - 1;
+}
+
+template <class Force>
+size_t RungeKuttaIntegrator<Force>::add(const OrbitEphemeris& eph)
+{
+	const CompiledOrbit o = CompiledOrbit::compile(eph, currentTime);
+	return add(o.r0, o.v0);
+}
+
+template <class Force>
+RungeKuttaArrays RungeKuttaIntegrator<Force>::arrays()
+{
+	RungeKuttaArrays a;
+	for (int k = 0; k < 3; ++k) {
+		a.rA[k] = rA[k].data(); a.vA[k] = vA[k].data(); a.aA[k] = aA[k].data();
+		a.rB[k] = rB[k].data(); a.vB[k] = vB[k].data(); a.aB[k] = aB[k].data();
+	}
+	a.tA = tA.data(); a.hA = hA.data();
+	a.tB = tB.data(); a.hNext = hNext.data();
+	return a;
+}
+
+template <class Force>
+void RungeKuttaIntegrator<Force>::advanceTo(double t)
+{
+	if (t < currentTime) {
+		std::cerr << "RungeKuttaIntegrator can only integrate forwards, use a Timeline to go back" << std::endl;
+		return;
+	}
+	const RungeKuttaArrays a = arrays();
+	const size_t n = size();
+	size_t done = 0;
+#ifdef KEPLER_KERNELS_X86
+	switch (getSimdLevel()) {
+	case SimdLevel::AVX512:
+		done = advanceRungeKuttaAVX512<Force>(a, 0, n, t, settings, stats);
+		break;
+	case SimdLevel::AVX2:
+		done = advanceRungeKuttaAVX2<Force>(a, 0, n, t, settings, stats);
+		break;
+	case SimdLevel::SSE2:
+		done = advanceRungeKuttaSSE2<Force>(a, 0, n, t, settings, stats);
+		break;
+	default:
+		break;
+	}
+#endif
+	advanceRungeKuttaScalar<Force>(a, done, n, t, settings, stats);
+	evaluateDense(t);
+	currentTime = t;
+}
+
+/*
+	Quintic Hermite interpolation on the step from A to B with s = (t - tA) / hA:
+	r(s) = H0*rA + H1*h*vA + H2*h^2*aA + H3*h^2*aB + H4*h*vB + H5*rB, v = dr/ds / h
+*/
+template <class Force>
+void RungeKuttaIntegrator<Force>::evaluateDense(double t)
+{
+	for (size_t i = 0; i < size(); ++i) {
+		const double h = hA[i];
+		if (h == 0.0 || t >= tB[i]) {
+			for (int k = 0; k < 3; ++k) {
+				r[k][i] = rB[k][i];
+				v[k][i] = vB[k][i];
+			}
+			continue;
+		}
+		const double s = (t - tA[i]) / h;
+		const double s2 = s * s, s3 = s2 * s, s4 = s3 * s, s5 = s4 * s;
+		const double h0 = 1.0 - 10.0 * s3 + 15.0 * s4 - 6.0 * s5;
+		const double h1 = s - 6.0 * s3 + 8.0 * s4 - 3.0 * s5;
+		const double h2 = 0.5 * (s2 - 3.0 * s3 + 3.0 * s4 - s5);
+		const double h3 = 0.5 * (s3 - 2.0 * s4 + s5);
+		const double h4 = -4.0 * s3 + 7.0 * s4 - 3.0 * s5;
+		const double h5 = 10.0 * s3 - 15.0 * s4 + 6.0 * s5;
+		const double d0 = -30.0 * s2 + 60.0 * s3 - 30.0 * s4;
+		const double d1 = 1.0 - 18.0 * s2 + 32.0 * s3 - 15.0 * s4;
+		const double d2 = 0.5 * (2.0 * s - 9.0 * s2 + 12.0 * s3 - 5.0 * s4);
+		const double d3 = 0.5 * (3.0 * s2 - 8.0 * s3 + 5.0 * s4);
+		const double d4 = -12.0 * s2 + 28.0 * s3 - 15.0 * s4;
+		for (int k = 0; k < 3; ++k) {
+			r[k][i] = h0 * rA[k][i] + h * (h1 * vA[k][i] + h4 * vB[k][i]) + h * h * (h2 * aA[k][i] + h3 * aB[k][i]) + h5 * rB[k][i];
+			v[k][i] = d0 * (rA[k][i] - rB[k][i]) / h + d1 * vA[k][i] + d4 * vB[k][i] + h * (d2 * aA[k][i] + d3 * aB[k][i]);
+		}
+	}
+}
+
+template <class Force>
+void RungeKuttaIntegrator<Force>::getStateKm(size_t i, double rOut[3], double vOut[3]) const
+{
+	for (int k = 0; k < 3; ++k) {
+		rOut[k] = r[k][i];
+		vOut[k] = v[k][i];
+	}
+}
+
+// Per satellite rA, vA, aA, tA and the step from A: the step that got to B, or the one to try first if there was none yet.
+// The time is the latest tA, every satellite can be evaluated there after restoring.
+template <class Force>
+double RungeKuttaIntegrator<Force>::saveState(double* state) const
+{
+	double latest = currentTime;
+	bool first = true;
+	for (size_t i = 0; i < size(); ++i) {
+		double* row = state + 11 * i;
+		for (int k = 0; k < 3; ++k) {
+			row[k] = rA[k][i];
+			row[3 + k] = vA[k][i];
+			row[6 + k] = aA[k][i];
+		}
+		row[9] = tA[i];
+		row[10] = (hA[i] > 0.0) ? hA[i] : hNext[i];
+		latest = (first || tA[i] > latest) ? tA[i] : latest;
+		first = false;
+	}
+	return latest;
+}
+
+// Every satellite starts over at its A with the step it took from there, so it takes the same steps as before
+template <class Force>
+void RungeKuttaIntegrator<Force>::restoreState(const double* state, double t)
+{
+	double earliest = t;
+	for (size_t i = 0; i < size(); ++i) {
+		const double* row = state + 11 * i;
+		for (int k = 0; k < 3; ++k) {
+			rA[k][i] = rB[k][i] = row[k];
+			vA[k][i] = vB[k][i] = row[3 + k];
+			aA[k][i] = aB[k][i] = row[6 + k];
+		}
+		tA[i] = tB[i] = row[9];
+		hA[i] = 0.0;
+		hNext[i] = row[10];
+		earliest = (row[9] < earliest) ? row[9] : earliest;
+	}
+	currentTime = earliest;
+	advanceTo(t);
+}
+
+#endif /* RungeKuttaIntegrator_hpp */
@@ -0,0 +1,24 @@
+//Author: Bernhard Luedtke
+
+#include "RungeKuttaKernels.h"
+#include "RungeKuttaKernelsLanes.h"
+#include "Accelerations.h"
+#include "LanesScalar.h"
+
+template <class Force>
+size_t advanceRungeKuttaScalar(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats)
+{
+	return advanceRungeKuttaLanes<LanesScalar, Force>(a, begin, end, t, settings, stats);
+}
+
+template <class Force>
+void accelerationScalar(const double r[3], double a[3])
+{
+	Force::template acceleration<LanesScalar>(r[0], r[1], r[2], a[0], a[1], a[2]);
+}
+
+template size_t advanceRungeKuttaScalar<TwoBodyAcceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+template size_t advanceRungeKuttaScalar<J2Acceleration>(const RungeKuttaArrays&, size_t, size_t, double, const RungeKuttaSettings&, RungeKuttaStats&);
+template void accelerationScalar<TwoBodyAcceleration>(const double[3], double[3]);
+template void accelerationScalar<J2Acceleration>(const double[3], double[3]);
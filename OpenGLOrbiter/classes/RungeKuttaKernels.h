@@ -0,0 +1,48 @@
+//Author: Bernhard Luedtke
+#ifndef RungeKuttaKernels_hpp
+#define RungeKuttaKernels_hpp
+
+#include <stddef.h>
+
+// Error control of the RungeKuttaIntegrator: a step is accepted if every component of its error estimate is below
+// absolute + relativeTolerance * |value|, with positionTolerance (km) for r and velocityTolerance (km/s) for v.
+// Steps down to minStep (s) are accepted regardless, so a satellite can not get stuck.
+struct RungeKuttaSettings {
+	double relativeTolerance = 1e-10;
+	double positionTolerance = 1e-6;
+	double velocityTolerance = 1e-9;
+	double minStep = 1e-3;
+};
+
+// Counters since the last resetStats()
+struct RungeKuttaStats {
+	size_t accepted = 0;
+	size_t rejected = 0;
+	// Accepted at minStep although the error was too large
+	size_t forced = 0;
+	size_t evaluations = 0;
+};
+
+// Arrays of a RungeKuttaIntegrator, one entry per satellite. A is the start of the last accepted step, B its end,
+// where the next one (of size hNext) starts. hA is the size of the step from A to B, 0 before the first one.
+struct RungeKuttaArrays {
+	double* rA[3]; double* vA[3]; double* aA[3];
+	double* rB[3]; double* vB[3]; double* aB[3];
+	double* tA; double* hA;
+	double* tB; double* hNext;
+};
+
+// Steps the satellites in [begin, end) until their last step ends at or after t (RungeKuttaKernelsLanes.h).
+// Instantiated per force model; the instruction set versions only handle complete lane groups and return how many satellites they did.
+template <class Force> size_t advanceRungeKuttaScalar(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats);
+template <class Force> size_t advanceRungeKuttaSSE2(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats);
+template <class Force> size_t advanceRungeKuttaAVX2(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats);
+template <class Force> size_t advanceRungeKuttaAVX512(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats);
+// Force::acceleration for a single satellite, to start it
+template <class Force> void accelerationScalar(const double r[3], double a[3]);
+
+#endif /* RungeKuttaKernels_hpp */
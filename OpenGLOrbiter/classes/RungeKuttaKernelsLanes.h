@@ -0,0 +1,136 @@
+//Author: Bernhard Luedtke
+#ifndef RungeKuttaKernelsLanes_hpp
+#define RungeKuttaKernelsLanes_hpp
+
+// Lane group version of the RKF45 step, same rules as KeplerKernelsLanes.h: included by the instruction set specific
+// translation units (and RungeKuttaKernels.cpp for the scalar one), no standard library calls in here.
+
+#include <stddef.h>
+#include "RungeKuttaKernels.h"
+#include "LaneMasks.h"
+
+// Fehlberg's 4(5) pair (Hairer, Norsett, Wanner, Solving Ordinary Differential Equations I, table 5.1).
+// The fifth order solution is kept, the fourth order one only gives the error estimate.
+constexpr double rungeKuttaA[6][5] = {
+	{ 0.0, 0.0, 0.0, 0.0, 0.0 },
+	{ 1.0 / 4.0, 0.0, 0.0, 0.0, 0.0 },
+	{ 3.0 / 32.0, 9.0 / 32.0, 0.0, 0.0, 0.0 },
+	{ 1932.0 / 2197.0, -7200.0 / 2197.0, 7296.0 / 2197.0, 0.0, 0.0 },
+	{ 439.0 / 216.0, -8.0, 3680.0 / 513.0, -845.0 / 4104.0, 0.0 },
+	{ -8.0 / 27.0, 2.0, -3544.0 / 2565.0, 1859.0 / 4104.0, -11.0 / 40.0 }
+};
+constexpr double rungeKuttaB[6] = { 16.0 / 135.0, 0.0, 6656.0 / 12825.0, 28561.0 / 56430.0, -9.0 / 50.0, 2.0 / 55.0 };
+// Fifth minus fourth order weights
+constexpr double rungeKuttaE[6] = { 1.0 / 360.0, 0.0, -128.0 / 4275.0, -2197.0 / 75240.0, 1.0 / 50.0, 2.0 / 55.0 };
+
+/*
+	Steps every satellite of the complete lane groups in [begin, end) until its last step ends at or after t, returns how many satellites that were.
+	The state y = (r, v) has the derivative (v, a(r)), so the stages of r are the v of the stages.
+	Every lane has its own step size: an attempt is accepted where the error norm err <= 1 (or the step is down to minStep),
+	and the next size is h * 0.9 / err^(1/4), limited to [h/5, 5h] (the fourth root instead of the fifth keeps it within the lane operations).
+	Lanes that are done keep their values while the others go on.
+*/
+template <class L, class Force>
+static size_t advanceRungeKuttaLanes(const RungeKuttaArrays& a, size_t begin, size_t end, double t,
+	const RungeKuttaSettings& settings, RungeKuttaStats& stats)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const size_t groups = end - ((end - begin) % L::width);
+	const reg target = L::set1(t);
+	const reg zero = L::set1(0.0);
+	const reg one = L::set1(1.0);
+	const reg minStep = L::set1(settings.minStep);
+	const reg relative = L::set1(settings.relativeTolerance);
+	const reg absolute[2] = { L::set1(settings.positionTolerance), L::set1(settings.velocityTolerance) };
+	alignas(64) double counts[3][L::width];
+	for (size_t i = begin; i < groups; i += L::width) {
+		reg rA[3], vA[3], aA[3], rB[3], vB[3], aB[3];
+		for (int k = 0; k < 3; ++k) {
+			rA[k] = L::load(a.rA[k] + i); vA[k] = L::load(a.vA[k] + i); aA[k] = L::load(a.aA[k] + i);
+			rB[k] = L::load(a.rB[k] + i); vB[k] = L::load(a.vB[k] + i); aB[k] = L::load(a.aB[k] + i);
+		}
+		reg tA = L::load(a.tA + i), hA = L::load(a.hA + i);
+		reg tB = L::load(a.tB + i), h = L::load(a.hNext + i);
+		reg attempts = zero, accepted = zero, forced = zero;
+		mask active = L::cmplt(tB, target);
+		while (L::any(active)) {
+			reg kr[6][3], kv[6][3];
+			for (int k = 0; k < 3; ++k) {
+				kr[0][k] = vB[k];
+				kv[0][k] = aB[k];
+			}
+			for (int s = 1; s < 6; ++s) {
+				reg rs[3];
+				for (int k = 0; k < 3; ++k) {
+					reg sumR = zero, sumV = zero;
+					for (int j = 0; j < s; ++j) {
+						sumR = L::add(sumR, L::mul(L::set1(rungeKuttaA[s][j]), kr[j][k]));
+						sumV = L::add(sumV, L::mul(L::set1(rungeKuttaA[s][j]), kv[j][k]));
+					}
+					rs[k] = L::add(rB[k], L::mul(h, sumR));
+					kr[s][k] = L::add(vB[k], L::mul(h, sumV));
+				}
+				Force::template acceleration<L>(rs[0], rs[1], rs[2], kv[s][0], kv[s][1], kv[s][2]);
+			}
+			reg rN[3], vN[3];
+			reg err = zero;
+			for (int k = 0; k < 3; ++k) {
+				reg sumR = zero, sumV = zero, errR = zero, errV = zero;
+				for (int j = 0; j < 6; ++j) {
+					sumR = L::add(sumR, L::mul(L::set1(rungeKuttaB[j]), kr[j][k]));
+					sumV = L::add(sumV, L::mul(L::set1(rungeKuttaB[j]), kv[j][k]));
+					errR = L::add(errR, L::mul(L::set1(rungeKuttaE[j]), kr[j][k]));
+					errV = L::add(errV, L::mul(L::set1(rungeKuttaE[j]), kv[j][k]));
+				}
+				rN[k] = L::add(rB[k], L::mul(h, sumR));
+				vN[k] = L::add(vB[k], L::mul(h, sumV));
+				const reg eR = L::div(L::abs(L::mul(h, errR)), L::add(absolute[0], L::mul(relative, L::abs(rN[k]))));
+				const reg eV = L::div(L::abs(L::mul(h, errV)), L::add(absolute[1], L::mul(relative, L::abs(vN[k]))));
+				err = L::blend(err, eR, L::cmplt(err, eR));
+				err = L::blend(err, eV, L::cmplt(err, eV));
+			}
+			// err <= 1 is also true for NaN: a broken lane is taken once and then stops, its time is NaN as well
+			const mask small = L::andNot(L::allLanes(), L::cmplt(minStep, h));
+			const mask within = L::andNot(L::allLanes(), L::cmplt(one, err));
+			const mask take = maskAnd<L>(active, maskOr<L>(within, small));
+			reg aN[3];
+			Force::template acceleration<L>(rN[0], rN[1], rN[2], aN[0], aN[1], aN[2]);
+			for (int k = 0; k < 3; ++k) {
+				rA[k] = L::blend(rA[k], rB[k], take); vA[k] = L::blend(vA[k], vB[k], take); aA[k] = L::blend(aA[k], aB[k], take);
+				rB[k] = L::blend(rB[k], rN[k], take); vB[k] = L::blend(vB[k], vN[k], take); aB[k] = L::blend(aB[k], aN[k], take);
+			}
+			tA = L::blend(tA, tB, take);
+			hA = L::blend(hA, h, take);
+			tB = L::blend(tB, L::add(tB, h), take);
+
+			reg factor = L::div(L::set1(0.9), L::sqrt(L::sqrt(err)));
+			factor = L::blend(factor, L::set1(0.2), L::cmplt(factor, L::set1(0.2)));
+			factor = L::blend(factor, L::set1(5.0), L::cmplt(L::set1(5.0), factor));
+			h = L::blend(h, L::mul(h, factor), active);
+			attempts = L::blend(attempts, L::add(attempts, one), active);
+			accepted = L::blend(accepted, L::add(accepted, one), take);
+			forced = L::blend(forced, L::add(forced, one), L::andNot(take, within));
+			active = L::cmplt(tB, target);
+		}
+		for (int k = 0; k < 3; ++k) {
+			L::store(a.rA[k] + i, rA[k]); L::store(a.vA[k] + i, vA[k]); L::store(a.aA[k] + i, aA[k]);
+			L::store(a.rB[k] + i, rB[k]); L::store(a.vB[k] + i, vB[k]); L::store(a.aB[k] + i, aB[k]);
+		}
+		L::store(a.tA + i, tA); L::store(a.hA + i, hA);
+		L::store(a.tB + i, tB); L::store(a.hNext + i, h);
+		L::store(counts[0], attempts);
+		L::store(counts[1], accepted);
+		L::store(counts[2], forced);
+		for (int l = 0; l < L::width; ++l) {
+			stats.accepted += static_cast<size_t>(counts[1][l]);
+			stats.rejected += static_cast<size_t>(counts[0][l] - counts[1][l]);
+			stats.forced += static_cast<size_t>(counts[2][l]);
+			// Five stages and the acceleration at the end of the step
+			stats.evaluations += 6 * static_cast<size_t>(counts[0][l]);
+		}
+	}
+	return groups - begin;
+}
+
+#endif /* RungeKuttaKernelsLanes_hpp */
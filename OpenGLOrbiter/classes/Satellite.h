@@ -5,60 +5,46 @@
 #include "TriangleSphereModel.h"
 #include "OrbitLineModel.h"
 #include "OrbitEphemeris.h"
+#include "ConstellationState.h"
 
+// A satellite is only a handle into the ConstellationState that holds (and propagates) its orbit.
+// Its own sphere mesh is only built by buildMesh(), for drawing it on its own; instanced satellites only need the transform.
 class Satellite : public TriangleSphereModel {
 	
 public:
-	Satellite(float Radius, int Stacks = 9, int Slices = 18);
-	Satellite(float Radius, OrbitEphemeris eph, int Stacks = 9, int Slices = 18);
-
-	Satellite();
+	Satellite(float Radius, ConstellationState& store, OrbitEphemeris eph, int Stacks = 9, int Slices = 18);
 	~Satellite();
 
-	void update(double dtime);
-	void calcKeplerProblem(double timePassed, double t0);
-	void calcKeplerProblem_experimental(double timePassed, double t0);
+	// Call this every frame after the store has been propagated.
+	// alpha: position of the frame between the last two simulated states (see SimulationClock::interpolation)
+	void update(double alpha = 1.0);
+	// Places the satellite at a position computed elsewhere (e.g. ChebyshevEphemeris::getR)
+	void update(const Vector& position);
+	// Vertex and index buffer of the sphere, once
+	void buildMesh();
+	bool hasMesh() const noexcept { return meshBuilt; }
+	// Nothing is drawn before buildMesh()
+	void draw(const BaseCamera& Cam) override;
 
 	Vector getV() const;
 	Vector getR() const;
 	OrbitEphemeris getEphemeris() const;
+	size_t getStoreIndex() const noexcept { return storeIndex; }
+	// Two body only, or with the secular J2 drift of node, periapsis and mean anomaly
+	void setForceModel(ForceModel model);
+	ForceModel getForceModel() const;
 
+	// Points of the orbit's conic, no chord farther than orbitVisTolerance (km) from it (see EphemerisFile for precomputed ones)
 	std::vector<Vector> calcOrbitVis();
+	static constexpr double orbitVisTolerance = 2.0;
 
 private:
-	Vector v;
-	Vector r;
-	OrbitEphemeris ephemeris;
-
-	double totalTime = 0.0;
-	//stupid hack
-	double savedTime = 0.0;
-
-	//counts completed orbits
-	unsigned int orbits = 0;
-	float lastOrbitV0Length = 0.f;
-	float lastOrbitR0Length = 0.f;
-
-	double computeXfirstGuess(double t);
-	double computeZ(double x);
-
-	double xnNewtonIteration(double xn, double t, double tn, double zn);
-	double xnNewtonIteration_DEV(double xn, double t, double tn, double r0Length);
-
-	double computeNewDtDx(double xn);
-	double computeNewDtDx_DEV(double xn, double r0Length);
-	double computeTnByXn(double x, double z);
-	
-	double computeSmallF(double x);
-	double computeSmallG(double x, double t);
-	double computeSmallFDerivative(double x, double rLength);
-	double computeSmallGDerivative(double x, double rLength);
-
-	Vector computeRVec(double f, double g);
-	Vector computeVVec(double fD, double gD);
-	
-	double computeCseries(double z);
-	double computeSseries(double z);
+	ConstellationState* store;
+	size_t storeIndex;
+	float radius;
+	int stacks;
+	int slices;
+	bool meshBuilt = false;
 };
 
 #endif /* Satellite_hpp */
@@ -0,0 +1,317 @@
+//Author: Bernhard Luedtke
+
+#include "Sgp4.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+static constexpr double twoPi = 2.0 * M_PI;
+static constexpr double x2o3 = 2.0 / 3.0;
+
+double greenwichSiderealTime(double jdut1)
+{
+	const double tut1 = (jdut1 - 2451545.0) / 36525.0;
+	double temp = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1 + (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+	// seconds of time to rad (360 deg / 86400 s)
+	temp = fmod(temp * (M_PI / 180.0) / 240.0, twoPi);
+	if (temp < 0.0) {
+		temp += twoPi;
+	}
+	return temp;
+}
+
+/*
+	Un-Kozai's the mean motion and derives everything the propagation needs at the epoch (sgp4init and initl of the reference code).
+	The drag terms depend on the perigee height: below 156 km the atmosphere density parameter s is lowered, below 220 km
+	the higher order drag terms are dropped (simplified).
+*/
+bool sgp4Init(const TwoLineElements& tle, Sgp4Record& rec)
+{
+	rec = Sgp4Record();
+	rec.catalogNumber = tle.catalogNumber;
+	rec.epochJd = tle.epochJd;
+	rec.bstar = tle.bstar;
+	rec.ecco = tle.eccentricity;
+	rec.argpo = tle.argPerigee;
+	rec.inclo = tle.inclination;
+	rec.mo = tle.meanAnomaly;
+	rec.nodeo = tle.rightAscension;
+	const double epoch1950 = tle.epochJd - 2433281.5;
+
+	// initl
+	const double eccsq = rec.ecco * rec.ecco;
+	const double omeosq = 1.0 - eccsq;
+	const double rteosq = sqrt(omeosq);
+	rec.cosio = cos(rec.inclo);
+	const double cosio2 = rec.cosio * rec.cosio;
+	const double ak = pow(sgp4Xke / tle.meanMotion, x2o3);
+	const double d1 = 0.75 * sgp4J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+	double del = d1 / (ak * ak);
+	const double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+	del = d1 / (adel * adel);
+	rec.no = tle.meanMotion / (1.0 + del);
+	rec.ao = pow(sgp4Xke / rec.no, x2o3);
+	rec.sinio = sin(rec.inclo);
+	const double po = rec.ao * omeosq;
+	const double con42 = 1.0 - 5.0 * cosio2;
+	rec.con41 = -con42 - cosio2 - cosio2;
+	const double posq = po * po;
+	const double rp = rec.ao * (1.0 - rec.ecco);
+	rec.gsto = greenwichSiderealTime(tle.epochJd);
+
+	if (omeosq < 0.0 && rec.no < 0.0) {
+		rec.error = 2;
+		return false;
+	}
+	rec.simplified = rp < (220.0 / sgp4EarthRadius + 1.0);
+	// Atmosphere density parameters of the drag model
+	const double ss = 78.0 / sgp4EarthRadius + 1.0;
+	double sfour = ss;
+	double qzms24 = pow((120.0 - 78.0) / sgp4EarthRadius, 4.0);
+	const double perige = (rp - 1.0) * sgp4EarthRadius;
+	if (perige < 156.0) {
+		sfour = perige - 78.0;
+		if (perige < 98.0) {
+			sfour = 20.0;
+		}
+		qzms24 = pow((120.0 - sfour) / sgp4EarthRadius, 4.0);
+		sfour = sfour / sgp4EarthRadius + 1.0;
+	}
+	const double pinvsq = 1.0 / posq;
+	const double tsi = 1.0 / (rec.ao - sfour);
+	rec.eta = rec.ao * rec.ecco * tsi;
+	const double etasq = rec.eta * rec.eta;
+	const double eeta = rec.ecco * rec.eta;
+	const double psisq = fabs(1.0 - etasq);
+	const double coef = qzms24 * pow(tsi, 4.0);
+	const double coef1 = coef / pow(psisq, 3.5);
+	const double cc2 = coef1 * rec.no * (rec.ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq))
+		+ 0.375 * sgp4J2 * tsi / psisq * rec.con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+	rec.cc1 = rec.bstar * cc2;
+	double cc3 = 0.0;
+	if (rec.ecco > 1.0e-4) {
+		cc3 = -2.0 * coef * tsi * sgp4J3oJ2 * rec.no * rec.sinio / rec.ecco;
+	}
+	rec.x1mth2 = 1.0 - cosio2;
+	rec.cc4 = 2.0 * rec.no * coef1 * rec.ao * omeosq * (rec.eta * (2.0 + 0.5 * etasq) + rec.ecco * (0.5 + 2.0 * etasq)
+		- sgp4J2 * tsi / (rec.ao * psisq) * (-3.0 * rec.con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta))
+			+ 0.75 * rec.x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * cos(2.0 * rec.argpo)));
+	rec.cc5 = 2.0 * coef1 * rec.ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+	const double cosio4 = cosio2 * cosio2;
+	const double temp1 = 1.5 * sgp4J2 * pinvsq * rec.no;
+	const double temp2 = 0.5 * temp1 * sgp4J2 * pinvsq;
+	const double temp3 = -0.46875 * sgp4J4 * pinvsq * pinvsq * rec.no;
+	rec.mdot = rec.no + 0.5 * temp1 * rteosq * rec.con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+	rec.argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4)
+		+ temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+	const double xhdot1 = -temp1 * rec.cosio;
+	rec.nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * rec.cosio;
+	rec.omgcof = rec.bstar * cc3 * cos(rec.argpo);
+	rec.xmcof = 0.0;
+	if (rec.ecco > 1.0e-4) {
+		rec.xmcof = -x2o3 * coef * rec.bstar / eeta;
+	}
+	rec.nodecf = 3.5 * omeosq * xhdot1 * rec.cc1;
+	rec.t2cof = 1.5 * rec.cc1;
+	// Avoids the division by zero at i = 180 deg
+	const double cosioPlus1 = (fabs(rec.cosio + 1.0) > 1.5e-12) ? 1.0 + rec.cosio : 1.5e-12;
+	rec.xlcof = -0.25 * sgp4J3oJ2 * rec.sinio * (3.0 + 5.0 * rec.cosio) / cosioPlus1;
+	rec.aycof = -0.5 * sgp4J3oJ2 * rec.sinio;
+	const double delmotemp = 1.0 + rec.eta * cos(rec.mo);
+	rec.delmo = delmotemp * delmotemp * delmotemp;
+	rec.sinmao = sin(rec.mo);
+	rec.x7thm1 = 7.0 * cosio2 - 1.0;
+
+	if (twoPi / rec.no >= sgp4DeepSpacePeriod) {
+		rec.deepSpace = true;
+		rec.simplified = true;
+		sgp4DeepSpaceInit(rec, epoch1950);
+	}
+	if (!rec.simplified) {
+		const double cc1sq = rec.cc1 * rec.cc1;
+		rec.d2 = 4.0 * rec.ao * tsi * cc1sq;
+		const double temp = rec.d2 * tsi * rec.cc1 / 3.0;
+		rec.d3 = (17.0 * rec.ao + sfour) * temp;
+		rec.d4 = 0.5 * temp * rec.ao * tsi * (221.0 * rec.ao + 31.0 * sfour) * rec.cc1;
+		rec.t3cof = rec.d2 + 2.0 * cc1sq;
+		rec.t4cof = 0.25 * (3.0 * rec.d3 + rec.cc1 * (12.0 * rec.d2 + 10.0 * cc1sq));
+		rec.t5cof = 0.2 * (3.0 * rec.d4 + 12.0 * rec.cc1 * rec.d3 + 6.0 * rec.d2 * rec.d2 + 15.0 * cc1sq * (2.0 * rec.d2 + cc1sq));
+	}
+	double r[3], v[3];
+	return sgp4(rec, 0.0, r, v) == 0;
+}
+
+/*
+	Secular gravity and drag on the mean elements, then (deep space) the lunar/solar terms, then the long period periodics,
+	Kepler's equation in the equinoctial-like variables axnl = e cos(w), aynl = e sin(w), and the short period periodics.
+*/
+int sgp4(Sgp4Record& rec, double tsince, double r[3], double v[3])
+{
+	const double t = tsince;
+	rec.error = 0;
+
+	// Secular gravity and atmospheric drag
+	const double xmdf = rec.mo + rec.mdot * t;
+	const double argpdf = rec.argpo + rec.argpdot * t;
+	const double nodedf = rec.nodeo + rec.nodedot * t;
+	double argpm = argpdf;
+	double mm = xmdf;
+	const double t2 = t * t;
+	double nodem = nodedf + rec.nodecf * t2;
+	double tempa = 1.0 - rec.cc1 * t;
+	double tempe = rec.bstar * rec.cc4 * t;
+	double templ = rec.t2cof * t2;
+	if (!rec.simplified) {
+		const double delomg = rec.omgcof * t;
+		const double delmtemp = 1.0 + rec.eta * cos(xmdf);
+		const double delm = rec.xmcof * (delmtemp * delmtemp * delmtemp - rec.delmo);
+		const double temp = delomg + delm;
+		mm = xmdf + temp;
+		argpm = argpdf - temp;
+		const double t3 = t2 * t;
+		const double t4 = t3 * t;
+		tempa = tempa - rec.d2 * t2 - rec.d3 * t3 - rec.d4 * t4;
+		tempe = tempe + rec.bstar * rec.cc5 * (sin(mm) - rec.sinmao);
+		templ = templ + rec.t3cof * t3 + t4 * (rec.t4cof + t * rec.t5cof);
+	}
+	double nm = rec.no;
+	double em = rec.ecco;
+	double inclm = rec.inclo;
+	if (rec.deepSpace) {
+		sgp4DeepSpaceSecular(rec, t, em, argpm, inclm, mm, nodem, nm);
+	}
+	if (nm <= 0.0) {
+		rec.error = 2;
+		return rec.error;
+	}
+	const double am = pow(sgp4Xke / nm, x2o3) * tempa * tempa;
+	nm = sgp4Xke / pow(am, 1.5);
+	em = em - tempe;
+	if (em >= 1.0 || em < -0.001) {
+		rec.error = 1;
+		return rec.error;
+	}
+	if (em < 1.0e-6) {
+		em = 1.0e-6;
+	}
+	mm = mm + rec.no * templ;
+	double xlm = mm + argpm + nodem;
+	nodem = fmod(nodem, twoPi);
+	argpm = fmod(argpm, twoPi);
+	xlm = fmod(xlm, twoPi);
+	mm = fmod(xlm - argpm - nodem, twoPi);
+
+	// Lunar/solar periodics
+	double ep = em;
+	double xincp = inclm;
+	double argpp = argpm;
+	double nodep = nodem;
+	double mp = mm;
+	double sinip = rec.sinio;
+	double cosip = rec.cosio;
+	double aycof = rec.aycof;
+	double xlcof = rec.xlcof;
+	double con41 = rec.con41;
+	double x1mth2 = rec.x1mth2;
+	double x7thm1 = rec.x7thm1;
+	if (rec.deepSpace) {
+		sgp4DeepSpacePeriodics(rec, t, ep, xincp, nodep, argpp, mp);
+		if (xincp < 0.0) {
+			xincp = -xincp;
+			nodep = nodep + M_PI;
+			argpp = argpp - M_PI;
+		}
+		if (ep < 0.0 || ep > 1.0) {
+			rec.error = 3;
+			return rec.error;
+		}
+		sinip = sin(xincp);
+		cosip = cos(xincp);
+		aycof = -0.5 * sgp4J3oJ2 * sinip;
+		const double cosipPlus1 = (fabs(cosip + 1.0) > 1.5e-12) ? 1.0 + cosip : 1.5e-12;
+		xlcof = -0.25 * sgp4J3oJ2 * sinip * (3.0 + 5.0 * cosip) / cosipPlus1;
+		const double cosisq = cosip * cosip;
+		con41 = 3.0 * cosisq - 1.0;
+		x1mth2 = 1.0 - cosisq;
+		x7thm1 = 7.0 * cosisq - 1.0;
+	}
+
+	// Long period periodics
+	const double axnl = ep * cos(argpp);
+	double temp = 1.0 / (am * (1.0 - ep * ep));
+	const double aynl = ep * sin(argpp) + temp * aycof;
+	const double xl = mp + argpp + nodep + temp * xlcof * axnl;
+
+	// Kepler's equation, Newton with the step limited to 0.95
+	const double u = fmod(xl - nodep, twoPi);
+	double eo1 = u;
+	double tem5 = 9999.9;
+	double sineo1 = 0.0;
+	double coseo1 = 0.0;
+	for (int ktr = 1; fabs(tem5) >= 1.0e-12 && ktr <= 10; ++ktr) {
+		sineo1 = sin(eo1);
+		coseo1 = cos(eo1);
+		tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+		tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+		if (fabs(tem5) >= 0.95) {
+			tem5 = (tem5 > 0.0) ? 0.95 : -0.95;
+		}
+		eo1 = eo1 + tem5;
+	}
+
+	// Short period periodics
+	const double ecose = axnl * coseo1 + aynl * sineo1;
+	const double esine = axnl * sineo1 - aynl * coseo1;
+	const double el2 = axnl * axnl + aynl * aynl;
+	const double pl = am * (1.0 - el2);
+	if (pl < 0.0) {
+		rec.error = 4;
+		return rec.error;
+	}
+	const double rl = am * (1.0 - ecose);
+	const double rdotl = sqrt(am) * esine / rl;
+	const double rvdotl = sqrt(pl) / rl;
+	const double betal = sqrt(1.0 - el2);
+	temp = esine / (1.0 + betal);
+	const double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+	const double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+	double su = atan2(sinu, cosu);
+	const double sin2u = (cosu + cosu) * sinu;
+	const double cos2u = 1.0 - 2.0 * sinu * sinu;
+	temp = 1.0 / pl;
+	const double temp1 = 0.5 * sgp4J2 * temp;
+	const double temp2 = temp1 * temp;
+
+	const double mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) + 0.5 * temp1 * x1mth2 * cos2u;
+	su = su - 0.25 * temp2 * x7thm1 * sin2u;
+	const double xnode = nodep + 1.5 * temp2 * cosip * sin2u;
+	const double xinc = xincp + 1.5 * temp2 * cosip * sinip * cos2u;
+	const double mvt = rdotl - nm * temp1 * x1mth2 * sin2u / sgp4Xke;
+	const double rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u + 1.5 * con41) / sgp4Xke;
+
+	// Orientation vectors
+	const double sinsu = sin(su);
+	const double cossu = cos(su);
+	const double snod = sin(xnode);
+	const double cnod = cos(xnode);
+	const double sini = sin(xinc);
+	const double cosi = cos(xinc);
+	const double xmx = -snod * cosi;
+	const double xmy = cnod * cosi;
+	const double ux = xmx * sinsu + cnod * cossu;
+	const double uy = xmy * sinsu + snod * cossu;
+	const double uz = sini * sinsu;
+	const double vx = xmx * cossu - cnod * sinsu;
+	const double vy = xmy * cossu - snod * sinsu;
+	const double vz = sini * cossu;
+
+	r[0] = (mrt * ux) * sgp4EarthRadius;
+	r[1] = (mrt * uy) * sgp4EarthRadius;
+	r[2] = (mrt * uz) * sgp4EarthRadius;
+	v[0] = (mvt * ux + rvdot * vx) * sgp4KmPerSec;
+	v[1] = (mvt * uy + rvdot * vy) * sgp4KmPerSec;
+	v[2] = (mvt * uz + rvdot * vz) * sgp4KmPerSec;
+	if (mrt < 1.0) {
+		rec.error = 6;
+	}
+	return rec.error;
+}
@@ -0,0 +1,83 @@
+//Author: Bernhard Luedtke
+#ifndef Sgp4_hpp
+#define Sgp4_hpp
+
+#include "TwoLineElements.h"
+
+/*
+	SGP4/SDP4, the analytical theory the two line element sets are generated with. Positions from TLEs are only as good as
+	the theory they were fitted to, so they have to be propagated with exactly this model (not with the Kepler solver).
+	Follows Vallado, Crawford, Hujsak, Kelso: Revisiting Spacetrack Report #3 (AIAA 2006-6753) and its reference code,
+	in the "improved" operation mode, with the WGS-72 constants. Units as there: earth radii and minutes inside, km and km/s outside.
+	Near earth orbits (period < 225 min) are also computed in lane groups, see Sgp4Kernels.h.
+*/
+
+// WGS-72, the constants of the element sets
+constexpr double sgp4Mu = 398600.8;
+constexpr double sgp4EarthRadius = 6378.135;
+// sqrt(mu / earth radius^3) in 1/min
+constexpr double sgp4Xke = 0.07436691613317342;
+constexpr double sgp4J2 = 0.001082616;
+constexpr double sgp4J3 = -0.00000253881;
+constexpr double sgp4J4 = -0.00000165597;
+constexpr double sgp4J3oJ2 = sgp4J3 / sgp4J2;
+// Earth radii per minute to km/s
+constexpr double sgp4KmPerSec = sgp4EarthRadius * sgp4Xke / 60.0;
+// Orbits with a longer period get the lunar/solar (deep space) terms
+constexpr double sgp4DeepSpacePeriod = 225.0;
+
+// Everything sgp4() needs of one satellite, computed once by sgp4Init
+struct Sgp4Record {
+	unsigned int catalogNumber = 0;
+	double epochJd = 0.0;
+	// 0 or the error of the last call: 1 eccentricity out of range, 2 mean motion <= 0, 3 deep space eccentricity out of range,
+	// 4 semi latus rectum < 0, 6 the satellite has decayed (below the surface)
+	int error = 0;
+	bool deepSpace = false;
+	// Perigee below 220 km: the drag terms above second order are left out
+	bool simplified = false;
+
+	// Mean elements at the epoch (no is the un-Kozai'd mean motion in rad/min) and their secular rates
+	double bstar = 0.0, ecco = 0.0, argpo = 0.0, inclo = 0.0, mo = 0.0, nodeo = 0.0, no = 0.0;
+	double mdot = 0.0, argpdot = 0.0, nodedot = 0.0;
+	// Semi major axis at the epoch (earth radii) and functions of the inclination
+	double ao = 0.0, sinio = 0.0, cosio = 0.0, con41 = 0.0, x1mth2 = 0.0, x7thm1 = 0.0;
+	// Drag
+	double eta = 0.0, cc1 = 0.0, cc4 = 0.0, cc5 = 0.0, d2 = 0.0, d3 = 0.0, d4 = 0.0;
+	double delmo = 0.0, sinmao = 0.0, omgcof = 0.0, xmcof = 0.0, nodecf = 0.0;
+	double t2cof = 0.0, t3cof = 0.0, t4cof = 0.0, t5cof = 0.0;
+	// Long period periodics (J3)
+	double aycof = 0.0, xlcof = 0.0;
+	// Greenwich sidereal time at the epoch
+	double gsto = 0.0;
+
+	// Deep space: lunar/solar periodics
+	double e3 = 0.0, ee2 = 0.0, se2 = 0.0, se3 = 0.0, sgh2 = 0.0, sgh3 = 0.0, sgh4 = 0.0, sh2 = 0.0, sh3 = 0.0;
+	double si2 = 0.0, si3 = 0.0, sl2 = 0.0, sl3 = 0.0, sl4 = 0.0, xgh2 = 0.0, xgh3 = 0.0, xgh4 = 0.0;
+	double xh2 = 0.0, xh3 = 0.0, xi2 = 0.0, xi3 = 0.0, xl2 = 0.0, xl3 = 0.0, xl4 = 0.0, zmol = 0.0, zmos = 0.0;
+	// Deep space: secular rates and resonance (irez 1: 24 h synchronous, 2: 12 h with e >= 0.5)
+	int irez = 0;
+	double dedt = 0.0, didt = 0.0, dmdt = 0.0, dnodt = 0.0, domdt = 0.0;
+	double d2201 = 0.0, d2211 = 0.0, d3210 = 0.0, d3222 = 0.0, d4410 = 0.0, d4422 = 0.0;
+	double d5220 = 0.0, d5232 = 0.0, d5421 = 0.0, d5433 = 0.0;
+	double del1 = 0.0, del2 = 0.0, del3 = 0.0, xfact = 0.0, xlamo = 0.0;
+	// State of the resonance integrator (720 min steps from the epoch), moved along by every call
+	double atime = 0.0, xli = 0.0, xni = 0.0;
+};
+
+// Initializes rec from the elements. Returns false (rec.error set) if the elements can not be propagated.
+bool sgp4Init(const TwoLineElements& tle, Sgp4Record& rec);
+// Position (km) and velocity (km/s) in the TEME frame, tsince minutes after the epoch. Returns rec.error, 0 if fine.
+// Not const: deep space resonant orbits keep their integrator state in rec.
+int sgp4(Sgp4Record& rec, double tsince, double r[3], double v[3]);
+// Greenwich mean sidereal time (rad) at the UT1 Julian date, IAU 1982
+double greenwichSiderealTime(double jdut1);
+
+// Deep space part (Sgp4DeepSpace.cpp). epoch1950: days since 1950 Jan 0.0
+void sgp4DeepSpaceInit(Sgp4Record& rec, double epoch1950);
+// Secular lunar/solar rates and the resonance at t minutes, on the mean elements (nm out)
+void sgp4DeepSpaceSecular(Sgp4Record& rec, double t, double& em, double& argpm, double& inclm, double& mm, double& nodem, double& nm);
+// Lunar/solar periodics at t minutes, on the mean elements
+void sgp4DeepSpacePeriodics(const Sgp4Record& rec, double t, double& ep, double& inclp, double& nodep, double& argpp, double& mp);
+
+#endif /* Sgp4_hpp */
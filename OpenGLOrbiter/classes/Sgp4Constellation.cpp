@@ -0,0 +1,145 @@
+//Author: Bernhard Luedtke
+
+#include "Sgp4Constellation.h"
+#include "Sgp4Kernels.h"
+#include "OrbitConstants.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
+
+Sgp4Constellation::Sgp4Constellation(double referenceJd) : referenceJd(referenceJd)
+{
+	;
+}
+
+Sgp4Constellation::~Sgp4Constellation()
+{
+	;
+}
+
+void Sgp4Constellation::reserve(size_t n)
+{
+	for (std::vector<double>& c : columns) {
+		c.reserve(n);
+	}
+	epochOffset.reserve(n);
+	tsince.reserve(n);
+	rX.reserve(n); rY.reserve(n); rZ.reserve(n);
+	vX.reserve(n); vY.reserve(n); vZ.reserve(n);
+	error.reserve(n);
+	records.reserve(n);
+}
+
+bool Sgp4Constellation::add(const TwoLineElements& tle)
+{
+	Sgp4Record rec;
+	if (!sgp4Init(tle, rec)) {
+		++rejectedCount;
+		lastRejectError = rec.error;
+		return false;
+	}
+	addRecord(rec);
+	return true;
+}
+
+void Sgp4Constellation::addRecord(const Sgp4Record& rec)
+{
+	const double values[ColumnCount] = {
+		rec.mo, rec.mdot, rec.argpo, rec.argpdot, rec.nodeo, rec.nodedot, rec.nodecf, rec.cc1, rec.bstar * rec.cc4, rec.bstar * rec.cc5,
+		rec.t2cof, rec.t3cof, rec.t4cof, rec.t5cof, rec.d2, rec.d3, rec.d4, rec.omgcof, rec.xmcof, rec.eta, rec.delmo, rec.sinmao,
+		rec.ao, rec.ecco, rec.no, rec.inclo, rec.sinio, rec.cosio, rec.aycof, rec.xlcof, rec.con41, rec.x1mth2, rec.x7thm1
+	};
+	for (int c = 0; c < ColumnCount; ++c) {
+		columns[c].push_back(values[c]);
+	}
+	// Simplified records skip these terms in sgp4(), zero makes the lanes skip them as well
+	if (rec.simplified) {
+		for (Column c : { BstarCc5, T3cof, T4cof, T5cof, D2, D3, D4, Omgcof, Xmcof }) {
+			columns[c].back() = 0.0;
+		}
+	}
+	if (rec.deepSpace) {
+		deepSpaceIndex.push_back(records.size());
+	}
+	epochOffset.push_back((rec.epochJd - referenceJd) * 1440.0);
+	tsince.push_back(0.0);
+	rX.push_back(0.0); rY.push_back(0.0); rZ.push_back(0.0);
+	vX.push_back(0.0); vY.push_back(0.0); vZ.push_back(0.0);
+	error.push_back(0.0);
+	records.push_back(rec);
+}
+
+void Sgp4Constellation::setReferenceJd(double jd)
+{
+	referenceJd = jd;
+	for (size_t i = 0; i < records.size(); ++i) {
+		epochOffset[i] = (records[i].epochJd - referenceJd) * 1440.0;
+	}
+}
+
+void Sgp4Constellation::propagateTo(double t)
+{
+	const size_t n = size();
+	const double minutes = t / 60.0;
+	// Each chunk only writes its own satellites
+	const std::function<void(size_t, size_t, size_t)> body = [this, minutes](size_t begin, size_t end, size_t) {
+		propagateRange(begin, end, minutes);
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(n, chunkSize, body);
+	}
+	else {
+		for (size_t begin = 0; begin < n; begin += chunkSize) {
+			body(begin, (begin + chunkSize < n) ? begin + chunkSize : n, begin / chunkSize);
+		}
+	}
+	currentTime = t;
+}
+
+void Sgp4Constellation::propagateRange(size_t begin, size_t end, double minutes)
+{
+	for (size_t i = begin; i < end; ++i) {
+		tsince[i] = minutes - epochOffset[i];
+	}
+	Sgp4Arrays a;
+	a.mo = columns[Mo].data(); a.mdot = columns[Mdot].data();
+	a.argpo = columns[Argpo].data(); a.argpdot = columns[Argpdot].data();
+	a.nodeo = columns[Nodeo].data(); a.nodedot = columns[Nodedot].data(); a.nodecf = columns[Nodecf].data();
+	a.cc1 = columns[Cc1].data(); a.bstarCc4 = columns[BstarCc4].data(); a.bstarCc5 = columns[BstarCc5].data();
+	a.t2cof = columns[T2cof].data(); a.t3cof = columns[T3cof].data(); a.t4cof = columns[T4cof].data(); a.t5cof = columns[T5cof].data();
+	a.d2 = columns[D2].data(); a.d3 = columns[D3].data(); a.d4 = columns[D4].data();
+	a.omgcof = columns[Omgcof].data(); a.xmcof = columns[Xmcof].data(); a.eta = columns[Eta].data();
+	a.delmo = columns[Delmo].data(); a.sinmao = columns[Sinmao].data();
+	a.ao = columns[Ao].data(); a.ecco = columns[Ecco].data(); a.no = columns[No].data();
+	a.inclo = columns[Inclo].data(); a.sinio = columns[Sinio].data(); a.cosio = columns[Cosio].data();
+	a.aycof = columns[Aycof].data(); a.xlcof = columns[Xlcof].data();
+	a.con41 = columns[Con41].data(); a.x1mth2 = columns[X1mth2].data(); a.x7thm1 = columns[X7thm1].data();
+	a.tsince = tsince.data();
+	a.r[0] = rX.data(); a.r[1] = rY.data(); a.r[2] = rZ.data();
+	a.v[0] = vX.data(); a.v[1] = vY.data(); a.v[2] = vZ.data();
+	a.error = error.data();
+	// Deep space satellites are computed as if they were near earth as well (a wasted lane each), then overwritten
+	propagateSgp4Batch(a, begin, end);
+	std::vector<size_t>::const_iterator d = std::lower_bound(deepSpaceIndex.begin(), deepSpaceIndex.end(), begin);
+	for (; d != deepSpaceIndex.end() && *d < end; ++d) {
+		const size_t i = *d;
+		double r[3], v[3];
+		const int code = sgp4(records[i], tsince[i], r, v);
+		const bool failed = code != 0 && code != 6;
+		rX[i] = failed ? 0.0 : r[0]; rY[i] = failed ? 0.0 : r[1]; rZ[i] = failed ? 0.0 : r[2];
+		vX[i] = failed ? 0.0 : v[0]; vY[i] = failed ? 0.0 : v[1]; vZ[i] = failed ? 0.0 : v[2];
+		error[i] = static_cast<double>(code);
+	}
+}
+
+void Sgp4Constellation::getStateKm(size_t i, double r[3], double v[3]) const
+{
+	r[0] = rX[i]; r[1] = rY[i]; r[2] = rZ[i];
+	v[0] = vX[i]; v[1] = vY[i]; v[2] = vZ[i];
+}
+
+Vector Sgp4Constellation::getR(size_t i) const
+{
+	// TEME (x, y, z) to the render frame (x, z, -y)
+	return Vector(static_cast<float>(rX[i] * sizeFactor), static_cast<float>(rZ[i] * sizeFactor), static_cast<float>(-rY[i] * sizeFactor));
+}
@@ -0,0 +1,83 @@
+//Author: Bernhard Luedtke
+#ifndef Sgp4Constellation_hpp
+#define Sgp4Constellation_hpp
+
+#include <vector>
+#include "Vector.h"
+#include "Sgp4.h"
+
+class ThreadPool;
+
+// Satellites from two line element sets, propagated with SGP4 (the counterpart of ConstellationState for catalogs).
+// Every TLE is initialized once (sgp4Init); the constants the near earth propagation reads are kept as structure of arrays
+// and computed in lane groups (propagateSgp4Batch), deep space satellites go through the scalar sgp4() afterwards.
+// Times are seconds since a reference Julian date shared by all satellites, each satellite's own epoch is an offset to it.
+class Sgp4Constellation {
+public:
+	// referenceJd: UTC Julian date of t = 0
+	explicit Sgp4Constellation(double referenceJd);
+	~Sgp4Constellation();
+
+	// Returns false (and adds nothing) if SGP4 can not propagate the elements. Nothing is printed,
+	// the rejection is counted and the caller reports it (as TleCatalogLoader does in its summary).
+	bool add(const TwoLineElements& tle);
+	// Adds a record sgp4Init() succeeded for (initialized elsewhere, e.g. in parallel by TleCatalogLoader)
+	void addRecord(const Sgp4Record& rec);
+	size_t size() const noexcept { return records.size(); }
+	size_t getDeepSpaceCount() const noexcept { return deepSpaceIndex.size(); }
+	// Element sets add() turned down, and the sgp4Init error code of the last one (0 if none)
+	size_t getRejectedCount() const noexcept { return rejectedCount; }
+	int getLastRejectError() const noexcept { return lastRejectError; }
+	void reserve(size_t n);
+
+	// Computes every satellite at t seconds after the reference date
+	void propagateTo(double t);
+	double getTime() const noexcept { return currentTime; }
+	double getReferenceJd() const noexcept { return referenceJd; }
+	// Moves t = 0 to another date (positions are those of the last propagateTo until the next one)
+	void setReferenceJd(double jd);
+	// Same chunking as ConstellationState: results do not depend on the number of threads
+	void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+	void setChunkSize(size_t satellites) { chunkSize = (satellites > 0) ? satellites : 1; }
+
+	// TEME state in km and km/s, 0 if the satellite could not be computed
+	void getStateKm(size_t i, double r[3], double v[3]) const;
+	// 0 or the error code of sgp4() at the last propagation
+	int getError(size_t i) const { return static_cast<int>(error[i]); }
+	// Position in the (scaled down) coordinate system used for rendering (y is the polar axis there, z in TEME)
+	Vector getR(size_t i) const;
+	const Sgp4Record& getRecord(size_t i) const { return records[i]; }
+
+private:
+	void propagateRange(size_t begin, size_t end, double minutes);
+
+	// Columns of the near earth constants, in the order of Sgp4Arrays
+	enum Column {
+		Mo, Mdot, Argpo, Argpdot, Nodeo, Nodedot, Nodecf, Cc1, BstarCc4, BstarCc5, T2cof, T3cof, T4cof, T5cof,
+		D2, D3, D4, Omgcof, Xmcof, Eta, Delmo, Sinmao, Ao, Ecco, No, Inclo, Sinio, Cosio, Aycof, Xlcof, Con41, X1mth2, X7thm1,
+		ColumnCount
+	};
+	std::vector<double> columns[ColumnCount];
+	// Minutes from the reference date to each satellite's epoch
+	std::vector<double> epochOffset;
+	// Scratch: minutes since the epoch at the current propagation
+	std::vector<double> tsince;
+	// State at currentTime (TEME)
+	std::vector<double> rX, rY, rZ;
+	std::vector<double> vX, vY, vZ;
+	std::vector<double> error;
+	// Satellites with deep space terms (ascending), they are computed from their record
+	std::vector<size_t> deepSpaceIndex;
+	// Whole records, for deep space satellites (which also keep their resonance state in there) and reference
+	std::vector<Sgp4Record> records;
+
+	size_t rejectedCount = 0;
+	int lastRejectError = 0;
+
+	double referenceJd;
+	double currentTime = 0.0;
+	ThreadPool* threadPool = nullptr;
+	size_t chunkSize = 1024;
+};
+
+#endif /* Sgp4Constellation_hpp */
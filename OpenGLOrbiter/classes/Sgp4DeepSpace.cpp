@@ -0,0 +1,482 @@
+//Author: Bernhard Luedtke
+// Deep space part of SGP4 (SDP4): lunar/solar perturbations and the 12 h / 24 h resonances, for orbits with a period of 225 min or more.
+// dscom, dsinit, dspace and dpper of the reference code (Vallado et al., AIAA 2006-6753).
+
+#include "Sgp4.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+static constexpr double twoPi = 2.0 * M_PI;
+// Eccentricities and mean motions (rad/min) of the sun and the moon
+static constexpr double zes = 0.01675;
+static constexpr double zel = 0.05490;
+static constexpr double zns = 1.19459e-5;
+static constexpr double znl = 1.5835218e-4;
+// Earth rotation in rad/min
+static constexpr double rptim = 4.37526908801129966e-3;
+
+// Values of dscom that dsinit needs besides the ones kept in the record
+struct DeepSpaceCommon {
+	double sinim, cosim, emsq;
+	double s1, s2, s3, s4, s5, ss1, ss2, ss3, ss4, ss5;
+	double sz1, sz3, sz11, sz13, sz21, sz23, sz31, sz33;
+	double z1, z3, z11, z13, z21, z23, z31, z33;
+};
+
+// dscom: lunar/solar terms at the epoch. The solar and the lunar pass only differ in the orientation of the perturbing body's orbit.
+static void deepSpaceCommon(Sgp4Record& rec, double epoch1950, DeepSpaceCommon& dc)
+{
+	const double c1ss = 2.9864797e-6;
+	const double c1l = 4.7968065e-7;
+	const double zsinis = 0.39785416;
+	const double zcosis = 0.91744867;
+	const double zcosgs = 0.1945905;
+	const double zsings = -0.98088458;
+
+	const double nm = rec.no;
+	const double em = rec.ecco;
+	const double snodm = sin(rec.nodeo);
+	const double cnodm = cos(rec.nodeo);
+	const double sinomm = sin(rec.argpo);
+	const double cosomm = cos(rec.argpo);
+	dc.sinim = sin(rec.inclo);
+	dc.cosim = cos(rec.inclo);
+	dc.emsq = em * em;
+	const double betasq = 1.0 - dc.emsq;
+	const double rtemsq = sqrt(betasq);
+
+	// Orientation of the moon's orbit at the epoch
+	const double day = epoch1950 + 18261.5;
+	const double xnodce = fmod(4.5236020 - 9.2422029e-4 * day, twoPi);
+	const double stem = sin(xnodce);
+	const double ctem = cos(xnodce);
+	const double zcosil = 0.91375164 - 0.03568096 * ctem;
+	const double zsinil = sqrt(1.0 - zcosil * zcosil);
+	const double zsinhl = 0.089683511 * stem / zsinil;
+	const double zcoshl = sqrt(1.0 - zsinhl * zsinhl);
+	const double gam = 5.8351514 + 0.0019443680 * day;
+	double zx = 0.39785416 * stem / zsinil;
+	const double zy = zcoshl * ctem + 0.91744867 * zsinhl * stem;
+	zx = atan2(zx, zy);
+	zx = gam + zx - xnodce;
+	const double zcosgl = cos(zx);
+	const double zsingl = sin(zx);
+
+	// Sun first, then the moon
+	double zcosg = zcosgs;
+	double zsing = zsings;
+	double zcosi = zcosis;
+	double zsini = zsinis;
+	double zcosh = cnodm;
+	double zsinh = snodm;
+	double cc = c1ss;
+	const double xnoi = 1.0 / nm;
+	double s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0, s5 = 0.0, s6 = 0.0, s7 = 0.0;
+	double z1 = 0.0, z2 = 0.0, z3 = 0.0, z11 = 0.0, z12 = 0.0, z13 = 0.0, z21 = 0.0, z22 = 0.0, z23 = 0.0, z31 = 0.0, z32 = 0.0, z33 = 0.0;
+	double ss6 = 0.0, ss7 = 0.0, sz2 = 0.0, sz12 = 0.0, sz22 = 0.0, sz32 = 0.0;
+	for (int lsflg = 1; lsflg <= 2; ++lsflg) {
+		const double a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+		const double a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+		const double a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+		const double a8 = zsing * zsini;
+		const double a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+		const double a10 = zcosg * zsini;
+		const double a2 = dc.cosim * a7 + dc.sinim * a8;
+		const double a4 = dc.cosim * a9 + dc.sinim * a10;
+		const double a5 = -dc.sinim * a7 + dc.cosim * a8;
+		const double a6 = -dc.sinim * a9 + dc.cosim * a10;
+
+		const double x1 = a1 * cosomm + a2 * sinomm;
+		const double x2 = a3 * cosomm + a4 * sinomm;
+		const double x3 = -a1 * sinomm + a2 * cosomm;
+		const double x4 = -a3 * sinomm + a4 * cosomm;
+		const double x5 = a5 * sinomm;
+		const double x6 = a6 * sinomm;
+		const double x7 = a5 * cosomm;
+		const double x8 = a6 * cosomm;
+
+		z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+		z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+		z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+		z1 = 3.0 * (a1 * a1 + a2 * a2) + z31 * dc.emsq;
+		z2 = 6.0 * (a1 * a3 + a2 * a4) + z32 * dc.emsq;
+		z3 = 3.0 * (a3 * a3 + a4 * a4) + z33 * dc.emsq;
+		z11 = -6.0 * a1 * a5 + dc.emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+		z12 = -6.0 * (a1 * a6 + a3 * a5) + dc.emsq * (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+		z13 = -6.0 * a3 * a6 + dc.emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+		z21 = 6.0 * a2 * a5 + dc.emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+		z22 = 6.0 * (a4 * a5 + a2 * a6) + dc.emsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+		z23 = 6.0 * a4 * a6 + dc.emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+		z1 = z1 + z1 + betasq * z31;
+		z2 = z2 + z2 + betasq * z32;
+		z3 = z3 + z3 + betasq * z33;
+		s3 = cc * xnoi;
+		s2 = -0.5 * s3 / rtemsq;
+		s4 = s3 * rtemsq;
+		s1 = -15.0 * em * s4;
+		s5 = x1 * x3 + x2 * x4;
+		s6 = x2 * x3 + x1 * x4;
+		s7 = x2 * x4 - x1 * x3;
+
+		if (lsflg == 1) {
+			dc.ss1 = s1; dc.ss2 = s2; dc.ss3 = s3; dc.ss4 = s4; dc.ss5 = s5; ss6 = s6; ss7 = s7;
+			dc.sz1 = z1; sz2 = z2; dc.sz3 = z3;
+			dc.sz11 = z11; sz12 = z12; dc.sz13 = z13;
+			dc.sz21 = z21; sz22 = z22; dc.sz23 = z23;
+			dc.sz31 = z31; sz32 = z32; dc.sz33 = z33;
+			zcosg = zcosgl;
+			zsing = zsingl;
+			zcosi = zcosil;
+			zsini = zsinil;
+			zcosh = zcoshl * cnodm + zsinhl * snodm;
+			zsinh = snodm * zcoshl - cnodm * zsinhl;
+			cc = c1l;
+		}
+	}
+	dc.s1 = s1; dc.s2 = s2; dc.s3 = s3; dc.s4 = s4; dc.s5 = s5;
+	dc.z1 = z1; dc.z3 = z3; dc.z11 = z11; dc.z13 = z13; dc.z21 = z21; dc.z23 = z23; dc.z31 = z31; dc.z33 = z33;
+
+	rec.zmol = fmod(4.7199672 + 0.22997150 * day - gam, twoPi);
+	rec.zmos = fmod(6.2565837 + 0.017201977 * day, twoPi);
+
+	// Solar terms
+	rec.se2 = 2.0 * dc.ss1 * ss6;
+	rec.se3 = 2.0 * dc.ss1 * ss7;
+	rec.si2 = 2.0 * dc.ss2 * sz12;
+	rec.si3 = 2.0 * dc.ss2 * (dc.sz13 - dc.sz11);
+	rec.sl2 = -2.0 * dc.ss3 * sz2;
+	rec.sl3 = -2.0 * dc.ss3 * (dc.sz3 - dc.sz1);
+	rec.sl4 = -2.0 * dc.ss3 * (-21.0 - 9.0 * dc.emsq) * zes;
+	rec.sgh2 = 2.0 * dc.ss4 * sz32;
+	rec.sgh3 = 2.0 * dc.ss4 * (dc.sz33 - dc.sz31);
+	rec.sgh4 = -18.0 * dc.ss4 * zes;
+	rec.sh2 = -2.0 * dc.ss2 * sz22;
+	rec.sh3 = -2.0 * dc.ss2 * (dc.sz23 - dc.sz21);
+	// Lunar terms
+	rec.ee2 = 2.0 * s1 * s6;
+	rec.e3 = 2.0 * s1 * s7;
+	rec.xi2 = 2.0 * s2 * z12;
+	rec.xi3 = 2.0 * s2 * (z13 - z11);
+	rec.xl2 = -2.0 * s3 * z2;
+	rec.xl3 = -2.0 * s3 * (z3 - z1);
+	rec.xl4 = -2.0 * s3 * (-21.0 - 9.0 * dc.emsq) * zel;
+	rec.xgh2 = 2.0 * s4 * z32;
+	rec.xgh3 = 2.0 * s4 * (z33 - z31);
+	rec.xgh4 = -18.0 * s4 * zel;
+	rec.xh2 = -2.0 * s2 * z22;
+	rec.xh3 = -2.0 * s2 * (z23 - z21);
+}
+
+// dsinit: secular lunar/solar rates and the resonance coefficients
+void sgp4DeepSpaceInit(Sgp4Record& rec, double epoch1950)
+{
+	DeepSpaceCommon dc;
+	deepSpaceCommon(rec, epoch1950, dc);
+
+	const double q22 = 1.7891679e-6;
+	const double q31 = 2.1460748e-6;
+	const double q33 = 2.2123015e-7;
+	const double root22 = 1.7891679e-6;
+	const double root44 = 7.3636953e-9;
+	const double root54 = 2.1765803e-9;
+	const double root32 = 3.7393792e-7;
+	const double root52 = 1.1428639e-7;
+	const double nm = rec.no;
+	const double inclm = rec.inclo;
+
+	rec.irez = 0;
+	if (nm < 0.0052359877 && nm > 0.0034906585) {
+		rec.irez = 1;
+	}
+	if (nm >= 8.26e-3 && nm <= 9.24e-3 && rec.ecco >= 0.5) {
+		rec.irez = 2;
+	}
+
+	// Solar terms
+	const double ses = dc.ss1 * zns * dc.ss5;
+	const double sis = dc.ss2 * zns * (dc.sz11 + dc.sz13);
+	const double sls = -zns * dc.ss3 * (dc.sz1 + dc.sz3 - 14.0 - 6.0 * dc.emsq);
+	const double sghs = dc.ss4 * zns * (dc.sz31 + dc.sz33 - 6.0);
+	double shs = -zns * dc.ss2 * (dc.sz21 + dc.sz23);
+	// The node is undefined close to the equator
+	const bool equatorial = inclm < 5.2359877e-2 || inclm > M_PI - 5.2359877e-2;
+	if (equatorial) {
+		shs = 0.0;
+	}
+	if (dc.sinim != 0.0) {
+		shs = shs / dc.sinim;
+	}
+	const double sgs = sghs - dc.cosim * shs;
+
+	// Lunar terms
+	rec.dedt = ses + dc.s1 * znl * dc.s5;
+	rec.didt = sis + dc.s2 * znl * (dc.z11 + dc.z13);
+	rec.dmdt = sls - znl * dc.s3 * (dc.z1 + dc.z3 - 14.0 - 6.0 * dc.emsq);
+	const double sghl = dc.s4 * znl * (dc.z31 + dc.z33 - 6.0);
+	double shll = -znl * dc.s2 * (dc.z21 + dc.z23);
+	if (equatorial) {
+		shll = 0.0;
+	}
+	rec.domdt = sgs + sghl;
+	rec.dnodt = shs;
+	if (dc.sinim != 0.0) {
+		rec.domdt = rec.domdt - dc.cosim / dc.sinim * shll;
+		rec.dnodt = rec.dnodt + shll / dc.sinim;
+	}
+
+	// Resonance terms
+	if (rec.irez == 0) {
+		return;
+	}
+	const double theta = fmod(rec.gsto, twoPi);
+	const double aonv = pow(nm / sgp4Xke, 2.0 / 3.0);
+	const double cosim = dc.cosim;
+	const double sinim = dc.sinim;
+	if (rec.irez == 2) {
+		// 12 hour, geopotential terms up to degree 5
+		const double cosisq = cosim * cosim;
+		const double em = rec.ecco;
+		const double emsq = em * em;
+		const double eoc = em * emsq;
+		const double g201 = -0.306 - (em - 0.64) * 0.440;
+		double g211, g310, g322, g410, g422, g520, g521, g532, g533;
+		if (em <= 0.65) {
+			g211 = 3.616 - 13.2470 * em + 16.2900 * emsq;
+			g310 = -19.302 + 117.3900 * em - 228.4190 * emsq + 156.5910 * eoc;
+			g322 = -18.9068 + 109.7927 * em - 214.6334 * emsq + 146.5816 * eoc;
+			g410 = -41.122 + 242.6940 * em - 471.0940 * emsq + 313.9530 * eoc;
+			g422 = -146.407 + 841.8800 * em - 1629.014 * emsq + 1083.4350 * eoc;
+			g520 = -532.114 + 3017.977 * em - 5740.032 * emsq + 3708.2760 * eoc;
+		}
+		else {
+			g211 = -72.099 + 331.819 * em - 508.738 * emsq + 266.724 * eoc;
+			g310 = -346.844 + 1582.851 * em - 2415.925 * emsq + 1246.113 * eoc;
+			g322 = -342.585 + 1554.908 * em - 2366.899 * emsq + 1215.972 * eoc;
+			g410 = -1052.797 + 4758.686 * em - 7193.992 * emsq + 3651.957 * eoc;
+			g422 = -3581.690 + 16178.110 * em - 24462.770 * emsq + 12422.520 * eoc;
+			if (em > 0.715) {
+				g520 = -5149.66 + 29936.92 * em - 54087.36 * emsq + 31324.56 * eoc;
+			}
+			else {
+				g520 = 1464.74 - 4664.75 * em + 3763.64 * emsq;
+			}
+		}
+		if (em < 0.7) {
+			g533 = -919.22770 + 4988.6100 * em - 9064.7700 * emsq + 5542.21 * eoc;
+			g521 = -822.71072 + 4568.6173 * em - 8491.4146 * emsq + 5337.524 * eoc;
+			g532 = -853.66600 + 4690.2500 * em - 8624.7700 * emsq + 5341.4 * eoc;
+		}
+		else {
+			g533 = -37995.780 + 161616.52 * em - 229838.20 * emsq + 109377.94 * eoc;
+			g521 = -51752.104 + 218913.95 * em - 309468.16 * emsq + 146349.42 * eoc;
+			g532 = -40023.880 + 170470.89 * em - 242699.48 * emsq + 115605.82 * eoc;
+		}
+		const double sini2 = sinim * sinim;
+		const double f220 = 0.75 * (1.0 + 2.0 * cosim + cosisq);
+		const double f221 = 1.5 * sini2;
+		const double f321 = 1.875 * sinim * (1.0 - 2.0 * cosim - 3.0 * cosisq);
+		const double f322 = -1.875 * sinim * (1.0 + 2.0 * cosim - 3.0 * cosisq);
+		const double f441 = 35.0 * sini2 * f220;
+		const double f442 = 39.3750 * sini2 * sini2;
+		const double f522 = 9.84375 * sinim * (sini2 * (1.0 - 2.0 * cosim - 5.0 * cosisq) + 0.33333333 * (-2.0 + 4.0 * cosim + 6.0 * cosisq));
+		const double f523 = sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * cosim + 10.0 * cosisq) + 6.56250012 * (1.0 + 2.0 * cosim - 3.0 * cosisq));
+		const double f542 = 29.53125 * sinim * (2.0 - 8.0 * cosim + cosisq * (-12.0 + 8.0 * cosim + 10.0 * cosisq));
+		const double f543 = 29.53125 * sinim * (-2.0 - 8.0 * cosim + cosisq * (12.0 + 8.0 * cosim - 10.0 * cosisq));
+		const double xno2 = nm * nm;
+		const double ainv2 = aonv * aonv;
+		double temp1 = 3.0 * xno2 * ainv2;
+		double temp = temp1 * root22;
+		rec.d2201 = temp * f220 * g201;
+		rec.d2211 = temp * f221 * g211;
+		temp1 = temp1 * aonv;
+		temp = temp1 * root32;
+		rec.d3210 = temp * f321 * g310;
+		rec.d3222 = temp * f322 * g322;
+		temp1 = temp1 * aonv;
+		temp = 2.0 * temp1 * root44;
+		rec.d4410 = temp * f441 * g410;
+		rec.d4422 = temp * f442 * g422;
+		temp1 = temp1 * aonv;
+		temp = temp1 * root52;
+		rec.d5220 = temp * f522 * g520;
+		rec.d5232 = temp * f523 * g532;
+		temp = 2.0 * temp1 * root54;
+		rec.d5421 = temp * f542 * g521;
+		rec.d5433 = temp * f543 * g533;
+		rec.xlamo = fmod(rec.mo + rec.nodeo + rec.nodeo - theta - theta, twoPi);
+		rec.xfact = rec.mdot + rec.dmdt + 2.0 * (rec.nodedot + rec.dnodt - rptim) - rec.no;
+	}
+	else {
+		// 24 hour (geosynchronous), degree 2 and 3 terms
+		const double emsq = dc.emsq;
+		const double g200 = 1.0 + emsq * (-2.5 + 0.8125 * emsq);
+		const double g310 = 1.0 + 2.0 * emsq;
+		const double g300 = 1.0 + emsq * (-6.0 + 6.60937 * emsq);
+		const double f220 = 0.75 * (1.0 + cosim) * (1.0 + cosim);
+		const double f311 = 0.9375 * sinim * sinim * (1.0 + 3.0 * cosim) - 0.75 * (1.0 + cosim);
+		double f330 = 1.0 + cosim;
+		f330 = 1.875 * f330 * f330 * f330;
+		const double del1 = 3.0 * nm * nm * aonv * aonv;
+		rec.del2 = 2.0 * del1 * f220 * g200 * q22;
+		rec.del3 = 3.0 * del1 * f330 * g300 * q33 * aonv;
+		rec.del1 = del1 * f311 * g310 * q31 * aonv;
+		rec.xlamo = fmod(rec.mo + rec.nodeo + rec.argpo - theta, twoPi);
+		rec.xfact = rec.mdot + (rec.argpdot + rec.nodedot) - rptim + rec.dmdt + rec.domdt + rec.dnodt - rec.no;
+	}
+	rec.xli = rec.xlamo;
+	rec.xni = rec.no;
+	rec.atime = 0.0;
+}
+
+// dspace: secular rates, and for resonant orbits the numerical integration of the mean longitude and mean motion in 720 min steps.
+// The integrator restarts from the epoch when t lies on the other side of it or closer to it than the last state.
+void sgp4DeepSpaceSecular(Sgp4Record& rec, double t, double& em, double& argpm, double& inclm, double& mm, double& nodem, double& nm)
+{
+	const double fasx2 = 0.13130908;
+	const double fasx4 = 2.8843198;
+	const double fasx6 = 0.37448087;
+	const double g22 = 5.7686396;
+	const double g32 = 0.95240898;
+	const double g44 = 1.8014998;
+	const double g52 = 1.0508330;
+	const double g54 = 4.4108898;
+	const double stepp = 720.0;
+	const double stepn = -720.0;
+	const double step2 = 259200.0;
+
+	const double theta = fmod(rec.gsto + t * rptim, twoPi);
+	em = em + rec.dedt * t;
+	inclm = inclm + rec.didt * t;
+	argpm = argpm + rec.domdt * t;
+	nodem = nodem + rec.dnodt * t;
+	mm = mm + rec.dmdt * t;
+	if (rec.irez == 0) {
+		return;
+	}
+	if (rec.atime == 0.0 || t * rec.atime <= 0.0 || fabs(t) < fabs(rec.atime)) {
+		rec.atime = 0.0;
+		rec.xni = rec.no;
+		rec.xli = rec.xlamo;
+	}
+	const double delt = (t > 0.0) ? stepp : stepn;
+	double xndt = 0.0;
+	double xldot = 0.0;
+	double xnddt = 0.0;
+	double ft = 0.0;
+	for (;;) {
+		if (rec.irez != 2) {
+			xndt = rec.del1 * sin(rec.xli - fasx2) + rec.del2 * sin(2.0 * (rec.xli - fasx4)) + rec.del3 * sin(3.0 * (rec.xli - fasx6));
+			xldot = rec.xni + rec.xfact;
+			xnddt = rec.del1 * cos(rec.xli - fasx2) + 2.0 * rec.del2 * cos(2.0 * (rec.xli - fasx4))
+				+ 3.0 * rec.del3 * cos(3.0 * (rec.xli - fasx6));
+			xnddt = xnddt * xldot;
+		}
+		else {
+			const double xomi = rec.argpo + rec.argpdot * rec.atime;
+			const double x2omi = xomi + xomi;
+			const double x2li = rec.xli + rec.xli;
+			xndt = rec.d2201 * sin(x2omi + rec.xli - g22) + rec.d2211 * sin(rec.xli - g22)
+				+ rec.d3210 * sin(xomi + rec.xli - g32) + rec.d3222 * sin(-xomi + rec.xli - g32)
+				+ rec.d4410 * sin(x2omi + x2li - g44) + rec.d4422 * sin(x2li - g44)
+				+ rec.d5220 * sin(xomi + rec.xli - g52) + rec.d5232 * sin(-xomi + rec.xli - g52)
+				+ rec.d5421 * sin(xomi + x2li - g54) + rec.d5433 * sin(-xomi + x2li - g54);
+			xldot = rec.xni + rec.xfact;
+			xnddt = rec.d2201 * cos(x2omi + rec.xli - g22) + rec.d2211 * cos(rec.xli - g22)
+				+ rec.d3210 * cos(xomi + rec.xli - g32) + rec.d3222 * cos(-xomi + rec.xli - g32)
+				+ rec.d5220 * cos(xomi + rec.xli - g52) + rec.d5232 * cos(-xomi + rec.xli - g52)
+				+ 2.0 * (rec.d4410 * cos(x2omi + x2li - g44) + rec.d4422 * cos(x2li - g44)
+					+ rec.d5421 * cos(xomi + x2li - g54) + rec.d5433 * cos(-xomi + x2li - g54));
+			xnddt = xnddt * xldot;
+		}
+		if (fabs(t - rec.atime) < stepp) {
+			ft = t - rec.atime;
+			break;
+		}
+		rec.xli = rec.xli + xldot * delt + xndt * step2;
+		rec.xni = rec.xni + xndt * delt + xnddt * step2;
+		rec.atime = rec.atime + delt;
+	}
+	nm = rec.xni + xndt * ft + xnddt * ft * ft * 0.5;
+	const double xl = rec.xli + xldot * ft + xndt * ft * ft * 0.5;
+	if (rec.irez != 1) {
+		mm = xl - 2.0 * nodem + 2.0 * theta;
+	}
+	else {
+		mm = xl - nodem - argpm + theta;
+	}
+	// As in the reference code (the change of the mean motion, added back), keeps the results identical to it
+	const double dndt = nm - rec.no;
+	nm = rec.no + dndt;
+}
+
+// dpper: lunar/solar periodics. Below 0.2 rad inclination they are applied to the equinoctial elements
+// (Lyddane's modification), the node and perigee would be ill defined.
+void sgp4DeepSpacePeriodics(const Sgp4Record& rec, double t, double& ep, double& inclp, double& nodep, double& argpp, double& mp)
+{
+	// Solar
+	double zm = rec.zmos + zns * t;
+	double zf = zm + 2.0 * zes * sin(zm);
+	double sinzf = sin(zf);
+	double f2 = 0.5 * sinzf * sinzf - 0.25;
+	double f3 = -0.5 * sinzf * cos(zf);
+	const double ses = rec.se2 * f2 + rec.se3 * f3;
+	const double sis = rec.si2 * f2 + rec.si3 * f3;
+	const double sls = rec.sl2 * f2 + rec.sl3 * f3 + rec.sl4 * sinzf;
+	const double sghs = rec.sgh2 * f2 + rec.sgh3 * f3 + rec.sgh4 * sinzf;
+	const double shs = rec.sh2 * f2 + rec.sh3 * f3;
+	// Lunar
+	zm = rec.zmol + znl * t;
+	zf = zm + 2.0 * zel * sin(zm);
+	sinzf = sin(zf);
+	f2 = 0.5 * sinzf * sinzf - 0.25;
+	f3 = -0.5 * sinzf * cos(zf);
+	const double sel = rec.ee2 * f2 + rec.e3 * f3;
+	const double sil = rec.xi2 * f2 + rec.xi3 * f3;
+	const double sll = rec.xl2 * f2 + rec.xl3 * f3 + rec.xl4 * sinzf;
+	const double sghl = rec.xgh2 * f2 + rec.xgh3 * f3 + rec.xgh4 * sinzf;
+	const double shll = rec.xh2 * f2 + rec.xh3 * f3;
+
+	const double pe = ses + sel;
+	const double pinc = sis + sil;
+	const double pl = sls + sll;
+	double pgh = sghs + sghl;
+	double ph = shs + shll;
+
+	inclp = inclp + pinc;
+	ep = ep + pe;
+	const double sinip = sin(inclp);
+	const double cosip = cos(inclp);
+	if (inclp >= 0.2) {
+		ph = ph / sinip;
+		pgh = pgh - cosip * ph;
+		argpp = argpp + pgh;
+		nodep = nodep + ph;
+		mp = mp + pl;
+	}
+	else {
+		const double sinop = sin(nodep);
+		const double cosop = cos(nodep);
+		double alfdp = sinip * sinop;
+		double betdp = sinip * cosop;
+		const double dalf = ph * cosop + pinc * cosip * sinop;
+		const double dbet = -ph * sinop + pinc * cosip * cosop;
+		alfdp = alfdp + dalf;
+		betdp = betdp + dbet;
+		nodep = fmod(nodep, twoPi);
+		double xls = mp + argpp + cosip * nodep;
+		const double dls = pl + pgh - pinc * nodep * sinip;
+		xls = xls + dls;
+		const double xnoh = nodep;
+		nodep = atan2(alfdp, betdp);
+		if (fabs(xnoh - nodep) > M_PI) {
+			if (nodep < xnoh) {
+				nodep = nodep + twoPi;
+			}
+			else {
+				nodep = nodep - twoPi;
+			}
+		}
+		mp = mp + pl;
+		argpp = xls - mp - cosip * nodep;
+	}
+}
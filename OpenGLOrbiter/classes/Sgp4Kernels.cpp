@@ -0,0 +1,27 @@
+//Author: Bernhard Luedtke
+
+#include "Sgp4Kernels.h"
+#include "Sgp4KernelsLanes.h"
+#include "KeplerKernels.h"
+#include "LanesScalar.h"
+
+void propagateSgp4Batch(const Sgp4Arrays& a, size_t begin, size_t end)
+{
+	size_t done = 0;
+#ifdef KEPLER_KERNELS_X86
+	switch (getSimdLevel()) {
+	case SimdLevel::AVX512:
+		done = propagateSgp4AVX512(a, begin, end);
+		break;
+	case SimdLevel::AVX2:
+		done = propagateSgp4AVX2(a, begin, end);
+		break;
+	case SimdLevel::SSE2:
+		done = propagateSgp4SSE2(a, begin, end);
+		break;
+	default:
+		break;
+	}
+#endif
+	propagateSgp4Lanes<LanesScalar>(a, begin + done, end);
+}
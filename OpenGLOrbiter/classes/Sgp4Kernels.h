@@ -0,0 +1,40 @@
+//Author: Bernhard Luedtke
+#ifndef Sgp4Kernels_hpp
+#define Sgp4Kernels_hpp
+
+#include <stddef.h>
+
+// Near earth SGP4 for many satellites at once. One entry per satellite in every array, the constants are the ones of its
+// Sgp4Record (see sgp4Init). Simplified records (low perigee) have d2..d4, t3cof..t5cof, omgcof, xmcof and bstarCc5 zeroed,
+// which turns the higher order drag terms off without a branch.
+struct Sgp4Arrays {
+	const double* mo; const double* mdot;
+	const double* argpo; const double* argpdot;
+	const double* nodeo; const double* nodedot; const double* nodecf;
+	const double* cc1; const double* bstarCc4; const double* bstarCc5;
+	const double* t2cof; const double* t3cof; const double* t4cof; const double* t5cof;
+	const double* d2; const double* d3; const double* d4;
+	const double* omgcof; const double* xmcof; const double* eta; const double* delmo; const double* sinmao;
+	const double* ao; const double* ecco; const double* no;
+	const double* inclo; const double* sinio; const double* cosio;
+	const double* aycof; const double* xlcof; const double* con41; const double* x1mth2; const double* x7thm1;
+	// Minutes since each satellite's epoch
+	const double* tsince;
+	// TEME position (km) and velocity (km/s); the error code of sgp4() as a double (0 fine)
+	double* r[3];
+	double* v[3];
+	double* error;
+};
+
+// The vector versions differ from sgp4() by the polynomial sine/cosine (< 2 ulp) and by not reducing the angles mod 2 pi in between,
+// positions by well below this (km), for propagations over days.
+constexpr double sgp4SimdTolerance = 1e-6;
+
+// Computes the satellites in [begin, end) at their tsince (Sgp4KernelsLanes.h). The instruction set versions only handle
+// complete lane groups and return how many satellites they did; propagateSgp4Batch picks one by getSimdLevel() and does the rest.
+size_t propagateSgp4SSE2(const Sgp4Arrays& a, size_t begin, size_t end);
+size_t propagateSgp4AVX2(const Sgp4Arrays& a, size_t begin, size_t end);
+size_t propagateSgp4AVX512(const Sgp4Arrays& a, size_t begin, size_t end);
+void propagateSgp4Batch(const Sgp4Arrays& a, size_t begin, size_t end);
+
+#endif /* Sgp4Kernels_hpp */
@@ -0,0 +1,216 @@
+//Author: Bernhard Luedtke
+#ifndef Sgp4KernelsLanes_hpp
+#define Sgp4KernelsLanes_hpp
+
+// Lane group version of near earth SGP4, same rules as KeplerKernelsLanes.h: included by the instruction set specific
+// translation units (and Sgp4Kernels.cpp for the scalar one), no standard library calls in here.
+
+#include <stddef.h>
+#include "Sgp4.h"
+#include "Sgp4Kernels.h"
+#include "LaneMasks.h"
+
+// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer (|x| < 2^51, round to nearest mode)
+constexpr double laneRoundMagic = 6755399441055744.0;
+// pi/2 in three parts of 33 bits each (fdlibm), k * part is exact for the k of any angle SGP4 produces
+constexpr double lanePio2Part1 = 1.57079632673412561417e+00;
+constexpr double lanePio2Part2 = 6.07710050630396597660e-11;
+constexpr double lanePio2Part3 = 2.02226624871116645580e-21;
+constexpr double laneTwoOverPi = 6.36619772367581382433e-01;
+// fdlibm's minimax polynomials of __kernel_sin and __kernel_cos on [-pi/4, pi/4]
+constexpr double laneSinCoefficients[6] = { -1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+	2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10 };
+constexpr double laneCosCoefficients[6] = { 4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+	-2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11 };
+
+template <class L>
+static typename L::reg roundLanes(typename L::reg x)
+{
+	return L::sub(L::add(x, L::set1(laneRoundMagic)), L::set1(laneRoundMagic));
+}
+
+// sin(x) and cos(x): x = k * pi/2 + r with |r| <= pi/4, the polynomials for r, then swapped/negated by the quadrant k mod 4
+template <class L>
+static void sinCosLanes(typename L::reg x, typename L::reg& sinX, typename L::reg& cosX)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const reg k = roundLanes<L>(L::mul(x, L::set1(laneTwoOverPi)));
+	// k mod 4 as -2..2
+	const reg q = L::sub(k, L::mul(L::set1(4.0), roundLanes<L>(L::mul(k, L::set1(0.25)))));
+	reg r = L::sub(x, L::mul(k, L::set1(lanePio2Part1)));
+	r = L::sub(r, L::mul(k, L::set1(lanePio2Part2)));
+	r = L::sub(r, L::mul(k, L::set1(lanePio2Part3)));
+	const reg z = L::mul(r, r);
+	reg ps = L::set1(laneSinCoefficients[5]);
+	reg pc = L::set1(laneCosCoefficients[5]);
+	for (int c = 4; c >= 0; --c) {
+		ps = L::add(L::mul(ps, z), L::set1(laneSinCoefficients[c]));
+		pc = L::add(L::mul(pc, z), L::set1(laneCosCoefficients[c]));
+	}
+	const reg sinR = L::add(r, L::mul(L::mul(r, z), ps));
+	const reg cosR = L::add(L::sub(L::set1(1.0), L::mul(L::set1(0.5), z)), L::mul(L::mul(z, z), pc));
+	// Quadrants 1 and 3 swap sine and cosine, the sine is negative in 2 and 3, the cosine in 1 and 2
+	const reg absQ = L::abs(q);
+	const mask odd = maskAnd<L>(L::cmplt(L::set1(0.5), absQ), L::cmplt(absQ, L::set1(1.5)));
+	const mask sinNegative = maskOr<L>(L::cmplt(L::set1(1.5), q), L::cmplt(q, L::set1(-0.5)));
+	const mask cosNegative = maskOr<L>(L::cmplt(L::set1(0.5), q), L::cmplt(q, L::set1(-1.5)));
+	const reg s = L::blend(sinR, cosR, odd);
+	const reg c = L::blend(cosR, sinR, odd);
+	const reg zero = L::set1(0.0);
+	sinX = L::blend(s, L::sub(zero, s), sinNegative);
+	cosX = L::blend(c, L::sub(zero, c), cosNegative);
+}
+
+/*
+	Near earth part of sgp4() for every complete lane group in [begin, end), returns how many satellites that were.
+	The same formulas in the same order, except:
+	- the mean angles are not reduced mod 2 pi one by one, only the argument of latitude before Kepler's equation (to [-pi, pi]),
+	- atan2 for the argument of latitude is left out: the short period correction is a rotation of (sin u, cos u) by a small angle,
+	- a lane whose Newton step is below 1e-12 keeps its eccentric anomaly while the others of its group go on,
+	- an error does not stop a lane; it gets the error code and a zero state.
+*/
+template <class L>
+static size_t propagateSgp4Lanes(const Sgp4Arrays& a, size_t begin, size_t end)
+{
+	typedef typename L::reg reg;
+	typedef typename L::mask mask;
+	const size_t groups = end - ((end - begin) % L::width);
+	const reg zero = L::set1(0.0);
+	const reg one = L::set1(1.0);
+	const reg half = L::set1(0.5);
+	const reg onePointFive = L::set1(1.5);
+	const reg xke = L::set1(sgp4Xke);
+	const reg j2Half = L::set1(0.5 * sgp4J2);
+	for (size_t i = begin; i < groups; i += L::width) {
+		const reg t = L::load(a.tsince + i);
+
+		// Secular gravity and atmospheric drag
+		const reg xmdf = L::add(L::load(a.mo + i), L::mul(L::load(a.mdot + i), t));
+		const reg argpdf = L::add(L::load(a.argpo + i), L::mul(L::load(a.argpdot + i), t));
+		const reg nodedf = L::add(L::load(a.nodeo + i), L::mul(L::load(a.nodedot + i), t));
+		const reg t2 = L::mul(t, t);
+		const reg nodem = L::add(nodedf, L::mul(L::load(a.nodecf + i), t2));
+		reg tempa = L::sub(one, L::mul(L::load(a.cc1 + i), t));
+		reg tempe = L::mul(L::load(a.bstarCc4 + i), t);
+		reg templ = L::mul(L::load(a.t2cof + i), t2);
+		const reg delomg = L::mul(L::load(a.omgcof + i), t);
+		reg sinX, cosX;
+		sinCosLanes<L>(xmdf, sinX, cosX);
+		const reg delmtemp = L::add(one, L::mul(L::load(a.eta + i), cosX));
+		const reg delm = L::mul(L::load(a.xmcof + i), L::sub(L::mul(L::mul(delmtemp, delmtemp), delmtemp), L::load(a.delmo + i)));
+		const reg temp = L::add(delomg, delm);
+		reg mm = L::add(xmdf, temp);
+		const reg argpm = L::sub(argpdf, temp);
+		const reg t3 = L::mul(t2, t);
+		const reg t4 = L::mul(t3, t);
+		tempa = L::sub(L::sub(L::sub(tempa, L::mul(L::load(a.d2 + i), t2)), L::mul(L::load(a.d3 + i), t3)), L::mul(L::load(a.d4 + i), t4));
+		sinCosLanes<L>(mm, sinX, cosX);
+		tempe = L::add(tempe, L::mul(L::load(a.bstarCc5 + i), L::sub(sinX, L::load(a.sinmao + i))));
+		templ = L::add(L::add(templ, L::mul(L::load(a.t3cof + i), t3)),
+			L::mul(t4, L::add(L::load(a.t4cof + i), L::mul(t, L::load(a.t5cof + i)))));
+
+		const reg am = L::mul(L::mul(L::load(a.ao + i), tempa), tempa);
+		const reg nm = L::div(xke, L::mul(am, L::sqrt(am)));
+		reg em = L::sub(L::load(a.ecco + i), tempe);
+		const mask eccentricityError = maskOr<L>(L::andNot(L::allLanes(), L::cmpnge(em, one)), L::cmplt(em, L::set1(-0.001)));
+		em = L::blend(em, L::set1(1.0e-6), L::cmplt(em, L::set1(1.0e-6)));
+		mm = L::add(mm, L::mul(L::load(a.no + i), templ));
+
+		// Long period periodics
+		reg sinArgp, cosArgp;
+		sinCosLanes<L>(argpm, sinArgp, cosArgp);
+		const reg axnl = L::mul(em, cosArgp);
+		const reg tempP = L::div(one, L::mul(am, L::sub(one, L::mul(em, em))));
+		const reg aynl = L::add(L::mul(em, sinArgp), L::mul(tempP, L::load(a.aycof + i)));
+		reg u = L::add(L::add(mm, argpm), L::mul(L::mul(tempP, L::load(a.xlcof + i)), axnl));
+		// To [-pi, pi], in two parts of 2 pi
+		const reg turns = roundLanes<L>(L::mul(u, L::set1(0.5 * laneTwoOverPi)));
+		u = L::sub(L::sub(u, L::mul(turns, L::set1(4.0 * lanePio2Part1))), L::mul(turns, L::set1(4.0 * lanePio2Part2)));
+
+		// Kepler's equation, Newton with the step limited to 0.95
+		reg eo1 = u;
+		reg sineo1 = zero;
+		reg coseo1 = one;
+		mask active = L::allLanes();
+		for (int ktr = 1; ktr <= 10 && L::any(active); ++ktr) {
+			reg s, c;
+			sinCosLanes<L>(eo1, s, c);
+			const reg denominator = L::sub(L::sub(one, L::mul(c, axnl)), L::mul(s, aynl));
+			reg tem5 = L::div(L::sub(L::add(L::sub(u, L::mul(aynl, c)), L::mul(axnl, s)), eo1), denominator);
+			tem5 = L::blend(tem5, L::set1(0.95), L::cmplt(L::set1(0.95), tem5));
+			tem5 = L::blend(tem5, L::set1(-0.95), L::cmplt(tem5, L::set1(-0.95)));
+			sineo1 = L::blend(sineo1, s, active);
+			coseo1 = L::blend(coseo1, c, active);
+			eo1 = L::blend(eo1, L::add(eo1, tem5), active);
+			active = L::andNot(active, L::cmplt(L::abs(tem5), L::set1(1.0e-12)));
+		}
+
+		// Short period periodics
+		const reg ecose = L::add(L::mul(axnl, coseo1), L::mul(aynl, sineo1));
+		const reg esine = L::sub(L::mul(axnl, sineo1), L::mul(aynl, coseo1));
+		const reg el2 = L::add(L::mul(axnl, axnl), L::mul(aynl, aynl));
+		const reg pl = L::mul(am, L::sub(one, el2));
+		const mask latusError = L::cmplt(pl, zero);
+		const reg rl = L::mul(am, L::sub(one, ecose));
+		const reg rdotl = L::div(L::mul(L::sqrt(am), esine), rl);
+		const reg rvdotl = L::div(L::sqrt(pl), rl);
+		const reg betal = L::sqrt(L::sub(one, el2));
+		const reg tempE = L::div(esine, L::add(one, betal));
+		const reg amOverRl = L::div(am, rl);
+		const reg sinu = L::mul(amOverRl, L::sub(L::sub(sineo1, aynl), L::mul(axnl, tempE)));
+		const reg cosu = L::mul(amOverRl, L::add(L::sub(coseo1, axnl), L::mul(aynl, tempE)));
+		const reg sin2u = L::mul(L::add(cosu, cosu), sinu);
+		const reg cos2u = L::sub(one, L::mul(L::mul(L::set1(2.0), sinu), sinu));
+		const reg invPl = L::div(one, pl);
+		const reg temp1 = L::mul(j2Half, invPl);
+		const reg temp2 = L::mul(temp1, invPl);
+
+		const reg con41 = L::load(a.con41 + i);
+		const reg x1mth2 = L::load(a.x1mth2 + i);
+		const reg cosio = L::load(a.cosio + i);
+		const reg sinio = L::load(a.sinio + i);
+		const reg mrt = L::add(L::mul(rl, L::sub(one, L::mul(L::mul(L::mul(onePointFive, temp2), betal), con41))),
+			L::mul(L::mul(L::mul(half, temp1), x1mth2), cos2u));
+		const reg delta = L::mul(L::mul(L::mul(L::set1(-0.25), temp2), L::load(a.x7thm1 + i)), sin2u);
+		const reg xnode = L::add(nodem, L::mul(L::mul(L::mul(onePointFive, temp2), cosio), sin2u));
+		const reg xinc = L::add(L::load(a.inclo + i), L::mul(L::mul(L::mul(L::mul(onePointFive, temp2), cosio), sinio), cos2u));
+		const reg nmTemp1 = L::mul(nm, temp1);
+		const reg mvt = L::sub(rdotl, L::div(L::mul(L::mul(nmTemp1, x1mth2), sin2u), xke));
+		const reg rvdot = L::add(rvdotl, L::div(L::mul(nmTemp1, L::add(L::mul(x1mth2, cos2u), L::mul(onePointFive, con41))), xke));
+
+		// Orientation vectors, su = u + delta by rotating (sin u, cos u)
+		reg sinDelta, cosDelta, snod, cnod, sini, cosi;
+		sinCosLanes<L>(delta, sinDelta, cosDelta);
+		sinCosLanes<L>(xnode, snod, cnod);
+		sinCosLanes<L>(xinc, sini, cosi);
+		const reg sinsu = L::add(L::mul(sinu, cosDelta), L::mul(cosu, sinDelta));
+		const reg cossu = L::sub(L::mul(cosu, cosDelta), L::mul(sinu, sinDelta));
+		const reg xmx = L::mul(L::sub(zero, snod), cosi);
+		const reg xmy = L::mul(cnod, cosi);
+		const reg ux = L::add(L::mul(xmx, sinsu), L::mul(cnod, cossu));
+		const reg uy = L::add(L::mul(xmy, sinsu), L::mul(snod, cossu));
+		const reg uz = L::mul(sini, sinsu);
+		const reg vx = L::sub(L::mul(xmx, cossu), L::mul(cnod, sinsu));
+		const reg vy = L::sub(L::mul(xmy, cossu), L::mul(snod, sinsu));
+		const reg vz = L::mul(sini, cossu);
+
+		// Codes as in sgp4(): eccentricity first, then the semi latus rectum, then decay
+		reg error = L::blend(zero, L::set1(6.0), L::cmplt(mrt, one));
+		error = L::blend(error, L::set1(4.0), latusError);
+		error = L::blend(error, one, eccentricityError);
+		const mask failed = maskOr<L>(eccentricityError, latusError);
+		const reg radius = L::set1(sgp4EarthRadius);
+		const reg speed = L::set1(sgp4KmPerSec);
+		L::store(a.r[0] + i, L::blend(L::mul(L::mul(mrt, ux), radius), zero, failed));
+		L::store(a.r[1] + i, L::blend(L::mul(L::mul(mrt, uy), radius), zero, failed));
+		L::store(a.r[2] + i, L::blend(L::mul(L::mul(mrt, uz), radius), zero, failed));
+		L::store(a.v[0] + i, L::blend(L::mul(L::add(L::mul(mvt, ux), L::mul(rvdot, vx)), speed), zero, failed));
+		L::store(a.v[1] + i, L::blend(L::mul(L::add(L::mul(mvt, uy), L::mul(rvdot, vy)), speed), zero, failed));
+		L::store(a.v[2] + i, L::blend(L::mul(L::add(L::mul(mvt, uz), L::mul(rvdot, vz)), speed), zero, failed));
+		L::store(a.error + i, error);
+	}
+	return groups - begin;
+}
+
+#endif /* Sgp4KernelsLanes_hpp */
@@ -0,0 +1,439 @@
+//Author: Bernhard Luedtke
+
+#include "ShaderProgramRegistry.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+static const char shaderCacheMagic[8] = { 'O', 'G', 'L', 'O', 'S', 'H', 'C', '\0' };
+static const uint32_t shaderCacheVersion = 1;
+
+std::unordered_map<uint64_t, std::vector<ShaderProgramRegistry::Entry>>& ShaderProgramRegistry::entries()
+{
+	static std::unordered_map<uint64_t, std::vector<Entry>> Entries;
+	return Entries;
+}
+
+ShaderProgramRegistry::Stats& ShaderProgramRegistry::stats()
+{
+	static Stats Counters;
+	return Counters;
+}
+
+ShaderProgramRegistry::Cache& ShaderProgramRegistry::cache()
+{
+	static Cache Binaries;
+	return Binaries;
+}
+
+uint64_t ShaderProgramRegistry::hashSources(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	// FNV-1a over both, with the terminating zero of the first in between
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i <= vertexSource.size(); ++i) {
+		hash = (hash ^ static_cast<unsigned char>(vertexSource.c_str()[i])) * 1099511628211ull;
+	}
+	for (size_t i = 0; i < fragmentSource.size(); ++i) {
+		hash = (hash ^ static_cast<unsigned char>(fragmentSource[i])) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ShaderProgramRegistry::binariesSupported()
+{
+#ifdef __APPLE__
+	return false;
+#else
+	static const bool supported = []() {
+		if (!(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)) {
+			return false;
+		}
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}();
+	return supported;
+#endif
+}
+
+GLuint ShaderProgramRegistry::acquire(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	const uint64_t hash = hashSources(vertexSource, fragmentSource);
+	auto it = entries().find(hash);
+	if (it != entries().end()) {
+		for (size_t k = 0; k < it->second.size(); ++k) {
+			Entry& e = it->second[k];
+			if (e.VertexSource != vertexSource || e.FragmentSource != fragmentSource) {
+				continue;
+			}
+			if (e.Pending && !finish(hash, k)) {
+				break;
+			}
+			// precompile() made it without a user
+			Entry& ready = entries()[hash][k];
+			if (ready.Users++ > 0) {
+				++stats().Shared;
+			}
+			return ready.Program;
+		}
+	}
+	const GLuint program = loadCached(hash);
+	if (program != 0) {
+		Entry e;
+		e.VertexSource = vertexSource;
+		e.FragmentSource = fragmentSource;
+		e.Program = program;
+		e.Users = 1;
+		entries()[hash].push_back(std::move(e));
+	}
+	return program;
+}
+
+void ShaderProgramRegistry::prepareLink(GLuint program)
+{
+#ifndef __APPLE__
+	if (cache().Open && binariesSupported()) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+#endif
+}
+
+void ShaderProgramRegistry::add(const std::string& vertexSource, const std::string& fragmentSource, GLuint program, double milliseconds)
+{
+	Entry e;
+	e.VertexSource = vertexSource;
+	e.FragmentSource = fragmentSource;
+	e.Program = program;
+	e.Users = 1;
+	const uint64_t hash = hashSources(vertexSource, fragmentSource);
+	entries()[hash].push_back(std::move(e));
+	++stats().Linked;
+	stats().CompileMilliseconds += milliseconds;
+	storeBinary(hash, program, milliseconds);
+}
+
+ShaderProgramRegistry::Entry* ShaderProgramRegistry::findSources(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	auto it = entries().find(hashSources(vertexSource, fragmentSource));
+	if (it == entries().end()) {
+		return nullptr;
+	}
+	for (Entry& e : it->second) {
+		if (e.VertexSource == vertexSource && e.FragmentSource == fragmentSource) {
+			return &e;
+		}
+	}
+	return nullptr;
+}
+
+void ShaderProgramRegistry::precompile(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	if (findSources(vertexSource, fragmentSource) != nullptr) {
+		return;
+	}
+	const uint64_t hash = hashSources(vertexSource, fragmentSource);
+	Entry e;
+	e.VertexSource = vertexSource;
+	e.FragmentSource = fragmentSource;
+	e.Program = loadCached(hash);
+	if (e.Program == 0) {
+#ifndef __APPLE__
+		// As many driver threads as it likes; without the extension the driver may still compile in the background
+		if (!stats().ParallelCompile && GLEW_KHR_parallel_shader_compile) {
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			stats().ParallelCompile = true;
+		}
+#endif
+		e.Started = std::chrono::steady_clock::now();
+		const GLchar* vertexCode = vertexSource.c_str();
+		const GLint vertexLength = static_cast<GLint>(vertexSource.size());
+		const GLchar* fragmentCode = fragmentSource.c_str();
+		const GLint fragmentLength = static_cast<GLint>(fragmentSource.size());
+		const GLuint VS = glCreateShader(GL_VERTEX_SHADER);
+		const GLuint FS = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(VS, 1, &vertexCode, &vertexLength);
+		glShaderSource(FS, 1, &fragmentCode, &fragmentLength);
+		glCompileShader(VS);
+		glCompileShader(FS);
+		// No status queries until finish(), they would wait for the driver
+		e.Program = glCreateProgram();
+		glAttachShader(e.Program, VS);
+		glDeleteShader(VS);
+		glAttachShader(e.Program, FS);
+		glDeleteShader(FS);
+		prepareLink(e.Program);
+		glLinkProgram(e.Program);
+		e.Pending = true;
+	}
+	entries()[hash].push_back(std::move(e));
+}
+
+bool ShaderProgramRegistry::finish(uint64_t hash, size_t index)
+{
+	std::vector<Entry>& bucket = entries()[hash];
+	Entry& e = bucket[index];
+	GLint linked = GL_FALSE;
+	glGetProgramiv(e.Program, GL_LINK_STATUS, &linked);
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - e.Started).count();
+	e.Pending = false;
+	if (linked == GL_FALSE) {
+		std::cerr << "ShaderProgramRegistry: a precompiled program did not link, its shaders compile it again\n";
+		glDeleteProgram(e.Program);
+		bucket.erase(bucket.begin() + index);
+		if (bucket.empty()) {
+			entries().erase(hash);
+		}
+		return false;
+	}
+	++stats().Linked;
+	stats().CompileMilliseconds += milliseconds;
+	storeBinary(hash, e.Program, milliseconds);
+	return true;
+}
+
+void ShaderProgramRegistry::finishPending()
+{
+	for (;;) {
+		bool pending = false;
+		bool finished = false;
+		for (auto& bucket : entries()) {
+			for (size_t k = 0; k < bucket.second.size(); ++k) {
+				if (!bucket.second[k].Pending) {
+					continue;
+				}
+				pending = true;
+				// The ones the driver is done with first; without the extension in order, each query waits
+				GLint done = GL_TRUE;
+#ifndef __APPLE__
+				if (stats().ParallelCompile) {
+					glGetProgramiv(bucket.second[k].Program, GL_COMPLETION_STATUS_KHR, &done);
+				}
+#endif
+				if (done == GL_TRUE) {
+					finish(bucket.first, k);
+					finished = true;
+					break;
+				}
+			}
+			// finish() may have erased the bucket
+			if (finished) {
+				break;
+			}
+		}
+		if (!pending) {
+			return;
+		}
+		if (!finished) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+GLuint ShaderProgramRegistry::loadCached(uint64_t hash)
+{
+	Cache& c = cache();
+	if (!c.Open) {
+		return 0;
+	}
+	auto it = c.Binaries.find(std::make_pair(hash, c.Driver));
+	if (it == c.Binaries.end()) {
+		return 0;
+	}
+	GLuint program = 0;
+#ifndef __APPLE__
+	const auto start = std::chrono::steady_clock::now();
+	program = glCreateProgram();
+	glProgramBinary(program, it->second.Format, it->second.Data.data(), static_cast<GLsizei>(it->second.Data.size()));
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE) {
+		// Another driver build under the same version string, or a damaged file: compiled again and replaced
+		glDeleteProgram(program);
+		c.Binaries.erase(it);
+		c.Changed = true;
+		++stats().CacheRejected;
+		return 0;
+	}
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	++stats().CacheHits;
+	stats().LoadMilliseconds += milliseconds;
+	stats().SavedMilliseconds += std::max(0.0, it->second.CompileMilliseconds - milliseconds);
+#endif
+	return program;
+}
+
+void ShaderProgramRegistry::storeBinary(uint64_t hash, GLuint program, double milliseconds)
+{
+	Cache& c = cache();
+	if (!c.Open) {
+		return;
+	}
+#ifndef __APPLE__
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	Binary b;
+	b.Data.resize(static_cast<size_t>(length));
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &b.Format, b.Data.data());
+	if (written <= 0) {
+		return;
+	}
+	b.Data.resize(static_cast<size_t>(written));
+	b.CompileMilliseconds = static_cast<float>(milliseconds);
+	c.Binaries[std::make_pair(hash, c.Driver)] = std::move(b);
+	c.Changed = true;
+#endif
+}
+
+void ShaderProgramRegistry::openCache(const std::string& path)
+{
+	Cache& c = cache();
+	c.Path = path;
+	c.Binaries.clear();
+	c.Changed = false;
+	c.Open = binariesSupported();
+	if (!c.Open) {
+		std::cout << "Shader cache: the driver has no program binaries, every program is compiled\n";
+		return;
+	}
+	const auto glString = [](GLenum name) {
+		const GLubyte* s = glGetString(name);
+		return std::string(s != nullptr ? reinterpret_cast<const char*>(s) : "");
+	};
+	// Binaries only fit the driver that made them
+	c.Driver = hashSources(glString(GL_VENDOR), glString(GL_RENDERER) + "\n" + glString(GL_VERSION));
+	FILE* in = std::fopen(path.c_str(), "rb");
+	if (in == nullptr) {
+		return;
+	}
+	char magic[sizeof(shaderCacheMagic)];
+	uint32_t version = 0;
+	uint32_t count = 0;
+	bool ok = std::fread(magic, sizeof(magic), 1, in) == 1 && std::memcmp(magic, shaderCacheMagic, sizeof(magic)) == 0
+		&& std::fread(&version, sizeof(version), 1, in) == 1 && version == shaderCacheVersion
+		&& std::fread(&count, sizeof(count), 1, in) == 1;
+	// Per binary: source hash, driver hash, format, bytes, compile time, data
+	for (uint32_t i = 0; ok && i < count; ++i) {
+		uint64_t source = 0;
+		uint64_t driver = 0;
+		uint32_t format = 0;
+		uint32_t bytes = 0;
+		Binary b;
+		ok = std::fread(&source, sizeof(source), 1, in) == 1 && std::fread(&driver, sizeof(driver), 1, in) == 1
+			&& std::fread(&format, sizeof(format), 1, in) == 1 && std::fread(&bytes, sizeof(bytes), 1, in) == 1
+			&& std::fread(&b.CompileMilliseconds, sizeof(b.CompileMilliseconds), 1, in) == 1 && bytes > 0 && bytes < (64u << 20);
+		if (ok) {
+			b.Format = format;
+			b.Data.resize(bytes);
+			ok = std::fread(b.Data.data(), 1, bytes, in) == bytes;
+		}
+		if (ok) {
+			c.Binaries[std::make_pair(source, driver)] = std::move(b);
+		}
+	}
+	std::fclose(in);
+	if (!ok) {
+		std::cerr << "Shader cache: " << path << " is damaged, " << c.Binaries.size() << " programs read\n";
+		c.Changed = true;
+	}
+}
+
+void ShaderProgramRegistry::saveCache()
+{
+	Cache& c = cache();
+	if (!c.Open || !c.Changed) {
+		return;
+	}
+	FILE* out = std::fopen(c.Path.c_str(), "wb");
+	if (out == nullptr) {
+		std::cerr << "Shader cache: cannot write " << c.Path << "\n";
+		return;
+	}
+	const uint32_t count = static_cast<uint32_t>(c.Binaries.size());
+	bool ok = std::fwrite(shaderCacheMagic, sizeof(shaderCacheMagic), 1, out) == 1
+		&& std::fwrite(&shaderCacheVersion, sizeof(shaderCacheVersion), 1, out) == 1 && std::fwrite(&count, sizeof(count), 1, out) == 1;
+	for (const auto& binary : c.Binaries) {
+		const Binary& b = binary.second;
+		const uint32_t format = b.Format;
+		const uint32_t bytes = static_cast<uint32_t>(b.Data.size());
+		ok = ok && std::fwrite(&binary.first.first, sizeof(uint64_t), 1, out) == 1 && std::fwrite(&binary.first.second, sizeof(uint64_t), 1, out) == 1
+			&& std::fwrite(&format, sizeof(format), 1, out) == 1 && std::fwrite(&bytes, sizeof(bytes), 1, out) == 1
+			&& std::fwrite(&b.CompileMilliseconds, sizeof(b.CompileMilliseconds), 1, out) == 1 && std::fwrite(b.Data.data(), 1, bytes, out) == bytes;
+	}
+	ok = (std::fclose(out) == 0) && ok;
+	if (!ok) {
+		std::cerr << "Shader cache: writing " << c.Path << " failed\n";
+		std::remove(c.Path.c_str());
+		return;
+	}
+	c.Changed = false;
+}
+
+void ShaderProgramRegistry::printStartupReport()
+{
+	const Stats& s = stats();
+	std::cout << "Shader programs: " << s.CacheHits << " from the cache (" << s.LoadMilliseconds << " ms), " << s.Linked << " compiled ("
+		<< s.CompileMilliseconds << " ms, " << (s.ParallelCompile ? "in parallel" : "one after another") << "), the cache saved about "
+		<< s.SavedMilliseconds << " ms";
+	if (s.CacheRejected > 0) {
+		std::cout << "; " << s.CacheRejected << " cached binaries no longer fit the driver";
+	}
+	std::cout << "\n";
+}
+
+ShaderProgramRegistry::Entry* ShaderProgramRegistry::find(GLuint program)
+{
+	for (auto& bucket : entries()) {
+		for (Entry& e : bucket.second) {
+			if (e.Program == program) {
+				return &e;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void ShaderProgramRegistry::release(GLuint program)
+{
+	for (auto it = entries().begin(); it != entries().end(); ++it) {
+		std::vector<Entry>& bucket = it->second;
+		for (size_t k = 0; k < bucket.size(); ++k) {
+			if (bucket[k].Program != program) {
+				continue;
+			}
+			if (--bucket[k].Users == 0) {
+				glDeleteProgram(program);
+				bucket.erase(bucket.begin() + k);
+				if (bucket.empty()) {
+					entries().erase(it);
+				}
+			}
+			return;
+		}
+	}
+}
+
+bool ShaderProgramRegistry::claim(GLuint program, const void* user)
+{
+	Entry* e = find(program);
+	if (e == nullptr || e->LastUser == user) {
+		return false;
+	}
+	const bool other = e->LastUser != nullptr;
+	e->LastUser = user;
+	return other;
+}
+
+size_t ShaderProgramRegistry::programCount()
+{
+	size_t count = 0;
+	for (const auto& bucket : entries()) {
+		count += bucket.second.size();
+	}
+	return count;
+}
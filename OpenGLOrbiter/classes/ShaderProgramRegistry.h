@@ -0,0 +1,121 @@
+//Author: Bernhard Luedtke
+
+#ifndef ShaderProgramRegistry_hpp
+#define ShaderProgramRegistry_hpp
+#ifdef WIN32
+#include <GL/glew.h>
+#include <glfw/glfw3.h>
+#else
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#define GLFW_INCLUDE_GLEXT
+#include <glfw/glfw3.h>
+#else
+#include "GL\glew.h"
+#include "GLFW\glfw3.h"
+#endif
+#endif
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <chrono>
+#include <stdint.h>
+
+/*
+	The linked GL programs of all shaders, keyed by a hash of their vertex and fragment source. Shader objects with the same
+	source share one program (StandardShader::createShaderProgram asks here first), so a thousand PhongShaders are compiled
+	and linked once. Programs are counted and deleted with their last shader.
+	Shared programs share their uniforms too: a shader that keeps them between draws (PhongShader) has to set all of its own
+	again when another one used the program in between, see claim(). Only from the thread with the GL context.
+
+	Binaries of linked programs (glGetProgramBinary, GL 4.1 / ARB_get_program_binary) are kept in one cache file, under the
+	hash of the sources and of the driver (vendor, renderer, version string); acquire() loads a program from there before anything
+	is compiled. A binary the driver no longer takes is compiled again and replaced. At startup, precompile() hands all programs of
+	the scene to the driver at once, which compiles them on its own threads with GL_KHR_parallel_shader_compile.
+*/
+class ShaderProgramRegistry
+{
+public:
+	// The program linked from these sources (or loaded from the cache), with one more user; 0 if there is none yet
+	static GLuint acquire(const std::string& vertexSource, const std::string& fragmentSource);
+	// Before glLinkProgram of a program that goes to add(), so its binary can be cached
+	static void prepareLink(GLuint program);
+	// A program just linked from these sources in milliseconds, with one user
+	static void add(const std::string& vertexSource, const std::string& fragmentSource, GLuint program, double milliseconds);
+	// One user less, the program is deleted with the last one
+	static void release(GLuint program);
+	// Marks user as the one that set the program's uniforms. True if that was another shader object before.
+	static bool claim(GLuint program, const void* user);
+
+	// Starts compiling and linking a program for shaders created later, without waiting for the driver. Nothing if it is there already.
+	static void precompile(const std::string& vertexSource, const std::string& fragmentSource);
+	// Waits for all programs of precompile(); ones that do not link are dropped (their shaders compile them again and report why)
+	static void finishPending();
+
+	// Reads the binaries of an earlier run (a missing file is an empty cache). Needs the GL context.
+	static void openCache(const std::string& path);
+	// Writes the cache file if programs were linked since it was read
+	static void saveCache();
+	// Programs taken from the cache and compiled so far, with the time it took and the time the cache saved
+	static void printStartupReport();
+
+	// Programs alive, programs linked, and shaders that got an existing one
+	static size_t programCount();
+	static size_t linkedCount() { return stats().Linked; }
+	static size_t sharedCount() { return stats().Shared; }
+	static size_t cacheHits() { return stats().CacheHits; }
+	static uint64_t hashSources(const std::string& vertexSource, const std::string& fragmentSource);
+
+private:
+	struct Entry {
+		std::string VertexSource;
+		std::string FragmentSource;
+		GLuint Program = 0;
+		unsigned int Users = 0;
+		const void* LastUser = nullptr;
+		// Started by precompile(), link status not known yet
+		bool Pending = false;
+		std::chrono::steady_clock::time_point Started;
+	};
+	// A program binary of the cache file
+	struct Binary {
+		GLenum Format = 0;
+		// Compiling and linking took this long when it was made, what loading it saves
+		float CompileMilliseconds = 0.0f;
+		std::vector<char> Data;
+	};
+	struct Cache {
+		std::string Path;
+		// Source hash and driver hash
+		std::map<std::pair<uint64_t, uint64_t>, Binary> Binaries;
+		uint64_t Driver = 0;
+		bool Open = false;
+		bool Changed = false;
+	};
+	struct Stats {
+		size_t Linked = 0;
+		size_t Shared = 0;
+		size_t CacheHits = 0;
+		size_t CacheRejected = 0;
+		double LoadMilliseconds = 0.0;
+		double CompileMilliseconds = 0.0;
+		double SavedMilliseconds = 0.0;
+		// precompile() asked the driver for its compiler threads (GL_KHR_parallel_shader_compile)
+		bool ParallelCompile = false;
+	};
+	// Entries of a hash (more than one only if different sources collide)
+	static std::unordered_map<uint64_t, std::vector<Entry>>& entries();
+	static Entry* find(GLuint program);
+	static Entry* findSources(const std::string& vertexSource, const std::string& fragmentSource);
+	static Stats& stats();
+	static Cache& cache();
+	static bool binariesSupported();
+	// Link status of a precompiled program, keeps its binary. False: the entry is gone.
+	static bool finish(uint64_t hash, size_t index);
+	// A program made of the cached binary of these sources, 0 if there is none or the driver does not take it
+	static GLuint loadCached(uint64_t hash);
+	static void storeBinary(uint64_t hash, GLuint program, double milliseconds);
+};
+
+#endif /* ShaderProgramRegistry_hpp */
@@ -0,0 +1,51 @@
+//Author: Bernhard Luedtke
+
+#include "SimulationClock.h"
+#include <iostream>
+
+SimulationClock::SimulationClock(double tickSeconds, double timeScale) : tick(tickSeconds), timeScale(timeScale)
+{
+	;
+}
+
+void SimulationClock::setTick(double seconds)
+{
+	if (seconds <= 0.0) {
+		std::cerr << "SimulationClock: tick has to be > 0" << std::endl;
+		return;
+	}
+	tick = seconds;
+}
+
+void SimulationClock::setTimeScale(double scale)
+{
+	timeScale = scale;
+}
+
+void SimulationClock::setSimulationTime(double seconds)
+{
+	simTime = seconds;
+	accumulator = 0.0;
+}
+
+void SimulationClock::setMaxTicksPerFrame(unsigned int ticks)
+{
+	maxTicksPerFrame = ticks > 0 ? ticks : 1;
+}
+
+unsigned int SimulationClock::advance(double frameSeconds)
+{
+	accumulator += frameSeconds;
+	unsigned int ticks = 0;
+	while (accumulator >= tick) {
+		if (ticks == maxTicksPerFrame) {
+			// Drop what can't be caught up with, the simulation runs slower than real time for this frame
+			accumulator = 0.0;
+			break;
+		}
+		accumulator -= tick;
+		++ticks;
+	}
+	simTime += ticks * step();
+	return ticks;
+}
@@ -0,0 +1,40 @@
+//Author: Bernhard Luedtke
+#ifndef SimulationClock_hpp
+#define SimulationClock_hpp
+
+// Fixed timestep clock: the frame time is collected and handed out in ticks of constant length,
+// so propagation does not depend on the frame rate. The remainder that does not fill a whole tick
+// is used to interpolate between the last two simulated states when drawing.
+class SimulationClock {
+public:
+	SimulationClock(double tickSeconds = 1.0 / 60.0, double timeScale = 1.0);
+
+	// Length of one tick in real seconds
+	void setTick(double seconds);
+	double getTick() const noexcept { return tick; }
+	//speedup, higher timescale = faster
+	void setTimeScale(double scale);
+	double getTimeScale() const noexcept { return timeScale; }
+	// Upper limit of ticks per frame, so a long frame (e.g. window dragged) can't stall the following ones
+	void setMaxTicksPerFrame(unsigned int ticks);
+
+	// Adds the real time that passed since the last frame, returns how many ticks have to be simulated now
+	unsigned int advance(double frameSeconds);
+	// Simulated seconds per tick (tick * timeScale)
+	double step() const noexcept { return tick * timeScale; }
+	// Position of the current frame between the previous (0) and the latest (1) simulated state
+	double interpolation() const noexcept { return accumulator / tick; }
+	// Simulated seconds since start
+	double simulationTime() const noexcept { return simTime; }
+	// Jumps to an absolute simulation time; the partial tick collected so far is dropped
+	void setSimulationTime(double seconds);
+
+private:
+	double tick;
+	double timeScale;
+	double accumulator = 0.0;
+	double simTime = 0.0;
+	unsigned int maxTicksPerFrame = 8;
+};
+
+#endif /* SimulationClock_hpp */
@@ -4,6 +4,8 @@
 
 
 #include "StandardShader.h"
+#include "ShaderProgramRegistry.h"
+#include <chrono>
 #ifdef WIN32
 #include <GL/glew.h>
 #include <glfw/glfw3.h>
@@ -20,11 +22,27 @@
 
 const StandardShader* StandardShader::ShaderNowPiped = NULL;
 
-StandardShader::StandardShader()
+StandardShader::StandardShader() : ShaderProgram(0)
 {
 	ModelTransform.identity();
 }
 
+StandardShader::~StandardShader()
+{
+	releaseProgram();
+	if (ShaderNowPiped == this) {
+		ShaderNowPiped = NULL;
+	}
+}
+
+void StandardShader::releaseProgram()
+{
+	if (ShaderProgram != 0) {
+		ShaderProgramRegistry::release(ShaderProgram);
+		ShaderProgram = 0;
+	}
+}
+
 
 GLuint StandardShader::createShaderProgram(std::string* VS_String, std::string* FS_String)
 {
@@ -34,6 +52,15 @@ GLuint StandardShader::createShaderProgram(std::string* VS_String, std::string*
 	GLsizei WrittenToLog = 0;
 	GLint Success = 0;
 
+	// Shaders of the same source share one program, which may come from the binary cache of an earlier run
+	const GLuint Shared = ShaderProgramRegistry::acquire(*VS_String, *FS_String);
+	releaseProgram();
+	if (Shared != 0) {
+		ShaderProgram = Shared;
+		return ShaderProgram;
+	}
+	const auto CompileStart = std::chrono::steady_clock::now();
+
 
 	GLuint VS = glCreateShader(GL_VERTEX_SHADER);
 	GLuint FS = glCreateShader(GL_FRAGMENT_SHADER);
@@ -88,6 +115,7 @@ GLuint StandardShader::createShaderProgram(std::string* VS_String, std::string*
 	glDeleteShader(VS);
 	glAttachShader(ShaderProgram, FS);
 	glDeleteShader(FS);
+	ShaderProgramRegistry::prepareLink(ShaderProgram);
 	glLinkProgram(ShaderProgram);
 
 	glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &Success);
@@ -105,6 +133,8 @@ GLuint StandardShader::createShaderProgram(std::string* VS_String, std::string*
 		throw std::exception();
 	}
 
+	ShaderProgramRegistry::add(*VS_String, *FS_String, ShaderProgram,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - CompileStart).count());
 	return ShaderProgram;
 }
 
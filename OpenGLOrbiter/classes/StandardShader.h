@@ -31,7 +31,7 @@ class StandardShader
 {
 public:
     StandardShader();
-    virtual ~StandardShader() {}
+    virtual ~StandardShader();
     virtual const Matrix& modelTransform() const { return ModelTransform; }
     virtual void modelTransform(const Matrix& m) { ModelTransform = m; }
     virtual void deactivate() const;
@@ -39,7 +39,10 @@ public:
 
 protected:    
   GLuint ShaderProgram;
+	// Compiles and links the program, or takes the one of a shader with the same source (ShaderProgramRegistry)
 	GLuint createShaderProgram(std::string* VS_String, std::string* FS_String);
+	// This shader no longer uses ShaderProgram
+	void releaseProgram();
   Matrix ModelTransform;
   static const StandardShader* ShaderNowPiped;
 };
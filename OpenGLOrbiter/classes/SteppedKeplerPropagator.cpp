@@ -0,0 +1,53 @@
+//Author: Bernhard Luedtke
+
+#include "SteppedKeplerPropagator.h"
+#include "ConstellationState.h"
+#include <algorithm>
+
+SteppedKeplerPropagator::SteppedKeplerPropagator(ConstellationState& store, double stepSeconds)
+	: store(store), step(stepSeconds > 0.0 ? stepSeconds : 1.0), start(store.getTime())
+{
+	// The next step must not depend on the times solved in between (a warm start from them), only on the anchor
+	store.setWarmStart(false);
+	anchor.resize(stateSize());
+	store.copyStateKm(anchor.data());
+	store.restartFromState(anchor.data(), start);
+}
+
+size_t SteppedKeplerPropagator::stateSize() const
+{
+	return 6 * store.size();
+}
+
+double SteppedKeplerPropagator::saveState(double* state) const
+{
+	std::copy(anchor.begin(), anchor.end(), state);
+	return start + anchorStep * step;
+}
+
+void SteppedKeplerPropagator::restoreState(const double* state, double t)
+{
+	start = t;
+	anchorStep = 0;
+	std::copy(state, state + anchor.size(), anchor.begin());
+	store.restartFromState(state, t);
+}
+
+double SteppedKeplerPropagator::getTime() const
+{
+	return store.getTime();
+}
+
+void SteppedKeplerPropagator::advanceTo(double t)
+{
+	for (double next = start + (anchorStep + 1) * step; next <= t; next = start + (anchorStep + 1) * step) {
+		store.propagateTo(next);
+		store.rebaseEpochs();
+		store.copyStateKm(anchor.data());
+		++anchorStep;
+		++steps;
+	}
+	if (t != store.getTime()) {
+		store.propagateTo(t);
+	}
+}
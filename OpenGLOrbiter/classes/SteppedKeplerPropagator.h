@@ -0,0 +1,36 @@
+//Author: Bernhard Luedtke
+#ifndef SteppedKeplerPropagator_hpp
+#define SteppedKeplerPropagator_hpp
+
+#include <vector>
+#include "Timeline.h"
+
+class ConstellationState;
+
+// Drives a ConstellationState like an integrator for the Timeline: every stepSeconds the current state becomes the new epoch
+// (ConstellationState::rebaseEpochs), times in between are solved from the last step without changing it.
+// Still two body motion, but reached step by step from a restart state, as a perturbed propagator would be.
+class SteppedKeplerPropagator : public TimelinePropagator {
+public:
+	SteppedKeplerPropagator(ConstellationState& store, double stepSeconds);
+
+	size_t stateSize() const override;
+	double saveState(double* state) const override;
+	void restoreState(const double* state, double t) override;
+	double getTime() const override;
+	void advanceTo(double t) override;
+
+	size_t getSteps() const noexcept { return steps; }
+
+private:
+	ConstellationState& store;
+	double step;
+	// Time of the last restart, steps are counted from it so the anchors are the same on every pass
+	double start;
+	size_t anchorStep = 0;
+	// Anchor state (at start + anchorStep * step), kept because the store may already be past it
+	std::vector<double> anchor;
+	size_t steps = 0;
+};
+
+#endif /* SteppedKeplerPropagator_hpp */
@@ -0,0 +1,144 @@
+//Author: Bernhard Luedtke
+
+#include "StreamBuffer.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+StreamBuffer::StreamBuffer(GLenum Target, size_t RegionBytes, unsigned int Regions) : Target(Target), Buffer(0), Regions(std::max(Regions, 1u)),
+	RegionBytes(0), Persistent(false), Mapped(nullptr), Current(0), Used(0), RegionReady(false), Stalls(0), StallMilliseconds(0.0)
+{
+#ifndef __APPLE__
+	Persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+#endif
+	if (!Persistent) {
+		std::cout << "StreamBuffer: no persistent mapping (ARB_buffer_storage), data is copied\n";
+	}
+	create(std::max(RegionBytes, alignment));
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	destroy();
+}
+
+void StreamBuffer::create(size_t regionBytes)
+{
+	RegionBytes = (regionBytes + alignment - 1) / alignment * alignment;
+	Fences.assign(Regions, GLsync(0));
+	Current = 0;
+	Used = 0;
+	RegionReady = true;
+	glGenBuffers(1, &Buffer);
+	glBindBuffer(Target, Buffer);
+#ifndef __APPLE__
+	if (Persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(Target, RegionBytes * Regions, NULL, flags);
+		Mapped = static_cast<char*>(glMapBufferRange(Target, 0, RegionBytes * Regions, flags));
+		if (Mapped == nullptr) {
+			std::cerr << "StreamBuffer: mapping " << RegionBytes * Regions << " bytes failed, data is copied\n";
+			Persistent = false;
+			glDeleteBuffers(1, &Buffer);
+			glGenBuffers(1, &Buffer);
+			glBindBuffer(Target, Buffer);
+		}
+	}
+#endif
+	if (!Persistent) {
+		// Only the current region is ever used, the storage is orphaned on every commit instead
+		Regions = 1;
+		Fences.assign(Regions, GLsync(0));
+		Staging.resize(RegionBytes);
+		glBufferData(Target, RegionBytes, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(Target, 0);
+}
+
+void StreamBuffer::destroy()
+{
+	for (GLsync& fence : Fences) {
+		if (fence != 0) {
+			glDeleteSync(fence);
+			fence = 0;
+		}
+	}
+	if (Buffer != 0) {
+		if (Mapped != nullptr) {
+			glBindBuffer(Target, Buffer);
+			glUnmapBuffer(Target);
+			glBindBuffer(Target, 0);
+			Mapped = nullptr;
+		}
+		// The GPU may still read it, GL deletes it once it is done
+		glDeleteBuffers(1, &Buffer);
+		Buffer = 0;
+	}
+}
+
+void StreamBuffer::waitForRegion(unsigned int region)
+{
+	GLsync& fence = Fences[region];
+	if (fence == 0) {
+		return;
+	}
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		++Stalls;
+		const auto start = std::chrono::steady_clock::now();
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		StallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "StreamBuffer: waiting for region " << region << " failed\n";
+	}
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+StreamBuffer::Range StreamBuffer::allocate(size_t bytes)
+{
+	const size_t aligned = (bytes + alignment - 1) / alignment * alignment;
+	if (Used + aligned > RegionBytes) {
+		// Larger regions, in a new buffer
+		destroy();
+		create(std::max(aligned, 2 * RegionBytes));
+	}
+	if (!RegionReady) {
+		waitForRegion(Current);
+		RegionReady = true;
+	}
+	Range r;
+	r.offset = Current * RegionBytes + Used;
+	r.bytes = bytes;
+	r.data = Persistent ? static_cast<void*>(Mapped + r.offset) : static_cast<void*>(Staging.data() + Used);
+	Used += aligned;
+	return r;
+}
+
+void StreamBuffer::commit(const Range& r, size_t bytes)
+{
+	glBindBuffer(Target, Buffer);
+	if (!Persistent && bytes > 0) {
+		// Orphan on the first upload of the frame, the GPU may still read the old storage
+		if (r.offset == 0) {
+			glBufferData(Target, RegionBytes, NULL, GL_STREAM_DRAW);
+		}
+		glBufferSubData(Target, r.offset, std::min(bytes, r.bytes), r.data);
+	}
+}
+
+void StreamBuffer::endFrame()
+{
+	if (Used == 0) {
+		return;
+	}
+	if (Persistent) {
+		Fences[Current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	Current = (Current + 1) % Regions;
+	Used = 0;
+	RegionReady = false;
+}
@@ -0,0 +1,91 @@
+//Author: Bernhard Luedtke
+
+#ifndef StreamBuffer_hpp
+#define StreamBuffer_hpp
+#ifdef WIN32
+#include <GL/glew.h>
+#include <glfw/glfw3.h>
+#else
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#define GLFW_INCLUDE_GLEXT
+#include <glfw/glfw3.h>
+#else
+#include "GL\glew.h"
+#include "GLFW\glfw3.h"
+#endif
+#endif
+#include <vector>
+#include <stddef.h>
+
+/*
+	A buffer for data that changes every frame (instance positions and the like), split into regions (3 by default) used in turn.
+	With GL 4.4 / ARB_buffer_storage the buffer is created once with glBufferStorage and stays mapped (persistent, coherent):
+	allocate() hands out a pointer straight into the memory the GPU reads, which any thread may fill. endFrame() puts a fence
+	behind the draw calls of the current region and moves on to the next one; a region is only handed out again once its fence
+	is signaled, so nothing the GPU still reads is overwritten and the driver never has to synchronize.
+	Without it (macOS: GL 4.1), allocate() returns memory of a copy in RAM, and commit() uploads it into orphaned storage.
+
+	Per frame, on the thread with the GL context: allocate() -> write (any thread) -> commit() -> draw -> endFrame().
+*/
+class StreamBuffer
+{
+public:
+	// Part of the buffer for one frame's data. data is valid until the region is used again (regions - 1 endFrame() calls later).
+	struct Range {
+		void* data = nullptr;
+		// Bytes from the start of buffer(), for glVertexAttribPointer and the like
+		size_t offset = 0;
+		size_t bytes = 0;
+	};
+	// Needs the GL context
+	StreamBuffer(GLenum Target = GL_ARRAY_BUFFER, size_t RegionBytes = 1024 * 1024, unsigned int Regions = 3);
+	~StreamBuffer();
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// bytes more of the current region. If they do not fit, the buffer is made larger; Ranges handed out before that are not drawn then.
+	// Waits only if the GPU still reads the region, (with 3 regions) two frames after it was drawn.
+	Range allocate(size_t bytes);
+	// The first bytes of r are written and may be drawn (binds buffer())
+	void commit(const Range& r, size_t bytes);
+	void commit(const Range& r) { commit(r, r.bytes); }
+	// After the last draw call reading the current region
+	void endFrame();
+
+	GLuint buffer() const noexcept { return Buffer; }
+	GLenum target() const noexcept { return Target; }
+	// True if allocate() points into the mapped buffer, false if commit() copies
+	bool isPersistent() const noexcept { return Persistent; }
+	size_t regionBytes() const noexcept { return RegionBytes; }
+	// allocate() calls that had to wait for the GPU, and for how long in total (ms)
+	unsigned int getStalls() const noexcept { return Stalls; }
+	double getStallMilliseconds() const noexcept { return StallMilliseconds; }
+
+	// Start of allocations, in bytes (largest uniform buffer offset alignment in practice)
+	static constexpr size_t alignment = 256;
+
+private:
+	void create(size_t regionBytes);
+	void destroy();
+	void waitForRegion(unsigned int region);
+
+	GLenum Target;
+	GLuint Buffer;
+	unsigned int Regions;
+	size_t RegionBytes;
+	bool Persistent;
+	char* Mapped;
+	// Copy in RAM without persistent mapping
+	std::vector<char> Staging;
+	// One per region, 0 if the GPU is done with it
+	std::vector<GLsync> Fences;
+	unsigned int Current;
+	// Bytes of the current region handed out, and whether it waited for its fence yet
+	size_t Used;
+	bool RegionReady;
+	unsigned int Stalls;
+	double StallMilliseconds;
+};
+
+#endif /* StreamBuffer_hpp */
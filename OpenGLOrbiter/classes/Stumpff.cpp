@@ -0,0 +1,160 @@
+//Author: Bernhard Luedtke
+
+#include "Stumpff.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <cmath>
+
+constexpr long long factorial(int n)
+{
+	return (n == 1 || n == 0) ? 1 : factorial(n - 1) * n;
+}
+
+//4.4-10
+double stumpffC(double z)
+{
+	// NaN stays NaN, the series branch below would take it for z = 0
+	if (std::isnan(z)) {
+		return z;
+	}
+	double cz = 0.0;
+	if (z > 0.0) {
+		cz = (1.0 - cos(std::sqrt(z))) / z;
+	}
+	else if (z < 0.0) {
+		cz = (1.0 - cosh(std::sqrt(-z))) / z;
+	}
+	else {
+		// This is a form of stumpff's formulas which can be used if z is exactly zero to avoid div by zero.
+		// Limited to k 0 - 9, because with k=10 we'd have an overflow in the factorial function
+		for (unsigned int k = 0; k < 10; k++) {
+			double res = (pow((-z), (double)k) / factorial(2 * k + 2));
+			if (std::abs(res) != 0.0 && !std::isnan(cz + res)) {
+				cz += res;
+			} else {
+				break;
+			}
+		}
+	}
+	return cz;
+}
+
+//4.4-11
+double stumpffS(double z)
+{
+	// NaN stays NaN, the series branch below would take it for z = 0
+	if (std::isnan(z)) {
+		return z;
+	}
+	double sz = 0.0;
+	if (z > 0.0) {
+		const double sqZ = std::sqrt(z);
+		sz = (sqZ - sin(sqZ)) / (z * sqZ);
+	}
+	else if (z < 0.0) {
+		const double sqZ = std::sqrt(-z);
+		sz = (sinh(sqZ) - sqZ) / (-z * sqZ);
+	}
+	else {
+		// This is a form of stumpff's formulas.
+		// Limited to k 0 - 8, because with k=9 we'd have an overflow in the factorial function
+		for (unsigned int k = 0; k < 9; k++) {
+			double res = (pow((-z), (double)k) / factorial(2 * k + 3));
+			if (std::abs(res) != 0.0 && !std::isnan(sz + res)) {
+				sz += res;
+			} else {
+				break;
+			}
+		}
+	}
+	return sz;
+}
+
+static StumpffMode activeMode = StumpffMode::Chebyshev;
+
+void setStumpffMode(StumpffMode mode)
+{
+	activeMode = mode;
+}
+
+StumpffMode getStumpffMode()
+{
+	return activeMode;
+}
+
+const char* stumpffModeName(StumpffMode mode)
+{
+	switch (mode) {
+	case StumpffMode::Series: return "series";
+	case StumpffMode::Chebyshev: return "Chebyshev";
+	default: return "exact";
+	}
+}
+
+void stumpffSeriesCS(double z, double& c, double& s)
+{
+	const StumpffValues v = stumpffReduced(z);
+	c = v.c;
+	s = v.s;
+}
+
+void stumpffChebyshevCS(double z, double& c, double& s)
+{
+	if (!(z >= stumpffChebyshevMin && z <= stumpffChebyshevMax)) {
+		c = stumpffC(z);
+		s = stumpffS(z);
+		return;
+	}
+	//Clenshaw's recurrence
+	const double t = z * stumpffChebyshevScale - stumpffChebyshevShift;
+	const double t2 = 2.0 * t;
+	double c1 = 0.0, c2 = 0.0;
+	double s1 = 0.0, s2 = 0.0;
+	for (int k = stumpffChebyshevTerms - 1; k >= 1; --k) {
+		const double cK = (t2 * c1 - c2) + stumpffChebyshev.c[k];
+		const double sK = (t2 * s1 - s2) + stumpffChebyshev.s[k];
+		c2 = c1;
+		c1 = cK;
+		s2 = s1;
+		s1 = sK;
+	}
+	c = (t * c1 - c2) + stumpffChebyshev.c[0];
+	s = (t * s1 - s2) + stumpffChebyshev.s[0];
+}
+
+void stumpffCS(double z, double& c, double& s)
+{
+	switch (activeMode) {
+	case StumpffMode::Chebyshev:
+		stumpffChebyshevCS(z, c, s);
+		break;
+	case StumpffMode::Exact:
+		c = stumpffC(z);
+		s = stumpffS(z);
+		break;
+	default:
+		stumpffSeriesCS(z, c, s);
+		break;
+	}
+}
+
+//Stumpff function for testing purposes mostly
+/*
+double stumpff(double x, unsigned int order) {
+	double total = 0.0;
+	for (unsigned int i = 0; i < 5; i++) {
+		double upper = pow(-1.0, i) * pow(x, i);
+		double lower = factorial(order + 2 * i);
+		double res = upper / lower;
+		if (isnan(res)) {
+			break;
+		}
+		double s = total;
+		total += res;
+		if (isnan(total)) {
+			total = s;
+			break;
+		}
+	}
+	return total;
+}*/
@@ -0,0 +1,141 @@
+//Author: Bernhard Luedtke
+#ifndef Stumpff_hpp
+#define Stumpff_hpp
+
+// Stumpff functions C(z) and S(z) used by the universal variable formulation of Kepler's problem.
+// See 'Fundamentals of Astrodynamics', R. Bate et al., 4.4-10 and 4.4-11
+double stumpffC(double z);
+double stumpffS(double z);
+
+// How stumpffCS evaluates C(z) and S(z):
+// Series     power series on |z| <= stumpffReduceLimit, reduced by quadrupling (no transcendental functions)
+// Chebyshev  Chebyshev expansion on [stumpffChebyshevMin, stumpffChebyshevMax], the exact forms 4.4-10/11 outside
+// Exact      stumpffC/stumpffS, trig/hyperbolic functions everywhere (reference, loses precision near z = 0)
+// The vectorized Kepler kernels (KeplerKernels.h) do exactly the same operations per lane for Series and Chebyshev.
+// They can not call trig functions, lanes outside the Chebyshev range use Series and Exact runs scalar.
+enum class StumpffMode { Series = 0, Chebyshev = 1, Exact = 2 };
+
+void setStumpffMode(StumpffMode mode);
+StumpffMode getStumpffMode();
+const char* stumpffModeName(StumpffMode mode);
+
+// C(z) and S(z) at once, in the mode set by setStumpffMode
+void stumpffCS(double z, double& c, double& s);
+void stumpffSeriesCS(double z, double& c, double& s);
+void stumpffChebyshevCS(double z, double& c, double& s);
+
+// Series: z is divided by 4 until |z| <= stumpffReduceLimit, the power series is evaluated there, and the result is brought back with
+//   C(4z) = (1 - z*S(z))^2 / 2
+//   S(4z) = (C(z) + (1 - z*C(z)) * S(z)) / 4
+constexpr double stumpffReduceLimit = 1.0;
+constexpr int stumpffSeriesTerms = 10;
+
+// Coefficients of the power series, sign already included: C(z) = sum c[k] * z^k, S(z) = sum s[k] * z^k
+struct StumpffSeries {
+	double c[stumpffSeriesTerms];
+	double s[stumpffSeriesTerms];
+};
+
+constexpr double stumpffInverseFactorial(int n)
+{
+	return (n <= 1) ? 1.0 : stumpffInverseFactorial(n - 1) / n;
+}
+
+constexpr StumpffSeries makeStumpffSeries()
+{
+	StumpffSeries series{};
+	for (int k = 0; k < stumpffSeriesTerms; ++k) {
+		const double sign = (k % 2 == 0) ? 1.0 : -1.0;
+		series.c[k] = sign * stumpffInverseFactorial(2 * k + 2);
+		series.s[k] = sign * stumpffInverseFactorial(2 * k + 3);
+	}
+	return series;
+}
+
+constexpr StumpffSeries stumpffSeries = makeStumpffSeries();
+
+struct StumpffValues {
+	double c;
+	double s;
+};
+
+// The Series mode, usable in constant expressions (the Chebyshev table below is built from it).
+// NaN for a z that is not finite (z - z is NaN for inf and NaN), quartering inf would never get below the limit.
+constexpr StumpffValues stumpffReduced(double z)
+{
+	if (!(z - z == 0.0)) {
+		return StumpffValues{ z - z, z - z };
+	}
+	double zr = z;
+	int steps = 0;
+	while (zr > stumpffReduceLimit || zr < -stumpffReduceLimit) {
+		zr *= 0.25;
+		++steps;
+	}
+	double c = stumpffSeries.c[stumpffSeriesTerms - 1];
+	double s = stumpffSeries.s[stumpffSeriesTerms - 1];
+	for (int k = stumpffSeriesTerms - 2; k >= 0; --k) {
+		c = c * zr + stumpffSeries.c[k];
+		s = s * zr + stumpffSeries.s[k];
+	}
+	for (; steps > 0; --steps) {
+		const double s4 = (c + (1.0 - zr * c) * s) * 0.25;
+		const double t = 1.0 - zr * s;
+		const double c4 = (0.5 * t) * t;
+		c = c4;
+		s = s4;
+		zr *= 4.0;
+	}
+	return StumpffValues{ c, s };
+}
+
+// Range of the Chebyshev expansion. For closed orbits z = dE^2 (change of eccentric anomaly), with the time of flight
+// reduced to half a period |dE| stays below about 5, so Newton steps of bound orbits never leave this range.
+// C(z) has its first zero at 4*pi^2, keep well below it for a small relative error.
+constexpr double stumpffChebyshevMin = -4.0;
+constexpr double stumpffChebyshevMax = 25.0;
+constexpr int stumpffChebyshevTerms = 16;
+// z -> t in [-1, 1]: t = z * stumpffChebyshevScale - stumpffChebyshevShift
+constexpr double stumpffChebyshevScale = 2.0 / (stumpffChebyshevMax - stumpffChebyshevMin);
+constexpr double stumpffChebyshevShift = (stumpffChebyshevMax + stumpffChebyshevMin) / (stumpffChebyshevMax - stumpffChebyshevMin);
+
+// C(z) = sum c[k] * T_k(t), S(z) = sum s[k] * T_k(t), with the first coefficient already halved
+struct StumpffChebyshev {
+	double c[stumpffChebyshevTerms];
+	double s[stumpffChebyshevTerms];
+};
+
+// Interpolation at the Chebyshev nodes t_j = cos(pi*(j + 1/2)/N), c_k = 2/N * sum f(z(t_j)) * T_k(t_j).
+// cos(x) = 1 - x^2 * C(x^2), T_k(t_j) by the recurrence T_k+1 = 2t*T_k - T_k-1, so no trig functions are needed at compile time.
+constexpr StumpffChebyshev makeStumpffChebyshev()
+{
+	StumpffChebyshev table{};
+	const double pi = 3.14159265358979323846;
+	const int n = stumpffChebyshevTerms;
+	for (int j = 0; j < n; ++j) {
+		const double angle = pi * (j + 0.5) / n;
+		const double t = 1.0 - angle * angle * stumpffReduced(angle * angle).c;
+		const StumpffValues f = stumpffReduced((t + stumpffChebyshevShift) / stumpffChebyshevScale);
+		double tPrev = 1.0;
+		double tK = t;
+		table.c[0] += f.c;
+		table.s[0] += f.s;
+		for (int k = 1; k < n; ++k) {
+			table.c[k] += f.c * tK;
+			table.s[k] += f.s * tK;
+			const double tNext = 2.0 * t * tK - tPrev;
+			tPrev = tK;
+			tK = tNext;
+		}
+	}
+	for (int k = 0; k < n; ++k) {
+		const double scale = (k == 0) ? 1.0 / n : 2.0 / n;
+		table.c[k] *= scale;
+		table.s[k] *= scale;
+	}
+	return table;
+}
+
+constexpr StumpffChebyshev stumpffChebyshev = makeStumpffChebyshev();
+
+#endif /* Stumpff_hpp */
@@ -0,0 +1,179 @@
+//Author: Bernhard Luedtke
+
+#include "TaskGraph.h"
+#include <iomanip>
+#include <string>
+
+TaskGraph::TaskGraph(unsigned int workerThreads)
+{
+	for (unsigned int k = 0; k < workerThreads; ++k) {
+		threads.emplace_back(&TaskGraph::workerLoop, this, k + 1);
+	}
+}
+
+TaskGraph::~TaskGraph()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+TaskGraph::TaskId TaskGraph::addTask(const char* name, Affinity affinity, std::function<void()> work)
+{
+	Task task;
+	task.name = name;
+	// Without worker threads everything runs on the calling thread
+	task.affinity = threads.empty() ? Affinity::Main : affinity;
+	task.work = std::move(work);
+	tasks.push_back(std::move(task));
+	timings.push_back(TaskTiming{ name, 0.0, 0.0, 0, false });
+	validated = false;
+	return tasks.size() - 1;
+}
+
+void TaskGraph::addDependency(TaskId before, TaskId after)
+{
+	tasks[before].successors.push_back(after);
+	++tasks[after].dependencies;
+	validated = false;
+}
+
+// Kahn's algorithm: a cycle leaves tasks that never get to zero dependencies
+bool TaskGraph::hasCycle() const
+{
+	std::vector<unsigned int> left(tasks.size());
+	std::vector<TaskId> ready;
+	for (TaskId id = 0; id < tasks.size(); ++id) {
+		left[id] = tasks[id].dependencies;
+		if (left[id] == 0) {
+			ready.push_back(id);
+		}
+	}
+	size_t visited = 0;
+	while (!ready.empty()) {
+		const TaskId id = ready.back();
+		ready.pop_back();
+		++visited;
+		for (TaskId next : tasks[id].successors) {
+			if (--left[next] == 0) {
+				ready.push_back(next);
+			}
+		}
+	}
+	return visited != tasks.size();
+}
+
+void TaskGraph::run()
+{
+	if (!validated) {
+		cyclic = hasCycle();
+		validated = true;
+		if (cyclic) {
+			std::cerr << "TaskGraph: the dependencies contain a cycle, the graph is not run" << std::endl;
+		}
+	}
+	if (cyclic || tasks.empty()) {
+		return;
+	}
+	std::unique_lock<std::mutex> guard(lock);
+	runStart = std::chrono::steady_clock::now();
+	finished = 0;
+	for (TaskId id = 0; id < tasks.size(); ++id) {
+		Task& task = tasks[id];
+		task.waitingFor = task.dependencies;
+		task.released = false;
+		timings[id].critical = false;
+		if (task.dependencies == 0) {
+			(task.affinity == Affinity::Main ? readyMain : readyWorker).push_back(id);
+		}
+	}
+	running = true;
+	changed.notify_all();
+	while (finished < tasks.size()) {
+		if (!readyMain.empty()) {
+			const TaskId id = readyMain.front();
+			readyMain.pop_front();
+			execute(id, 0, guard);
+		}
+		else {
+			changed.wait(guard);
+		}
+	}
+	running = false;
+	lastRunMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+	markCriticalPath();
+}
+
+void TaskGraph::workerLoop(unsigned int thread)
+{
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;) {
+		changed.wait(guard, [&] { return stopping || (running && !readyWorker.empty()); });
+		if (stopping) {
+			return;
+		}
+		const TaskId id = readyWorker.front();
+		readyWorker.pop_front();
+		execute(id, thread, guard);
+	}
+}
+
+void TaskGraph::execute(TaskId id, unsigned int thread, std::unique_lock<std::mutex>& guard)
+{
+	Task& task = tasks[id];
+	guard.unlock();
+	const auto start = std::chrono::steady_clock::now();
+	task.work();
+	const auto end = std::chrono::steady_clock::now();
+	guard.lock();
+	TaskTiming& timing = timings[id];
+	timing.startMs = std::chrono::duration<double, std::milli>(start - runStart).count();
+	timing.endMs = std::chrono::duration<double, std::milli>(end - runStart).count();
+	timing.thread = thread;
+	for (TaskId next : task.successors) {
+		Task& successor = tasks[next];
+		// The last dependency to finish is the one that held the successor back
+		successor.releasedBy = id;
+		successor.released = true;
+		if (--successor.waitingFor == 0) {
+			(successor.affinity == Affinity::Main ? readyMain : readyWorker).push_back(next);
+		}
+	}
+	++finished;
+	changed.notify_all();
+}
+
+// Walks back from the task that finished last, always to the dependency that finished last
+void TaskGraph::markCriticalPath()
+{
+	TaskId last = 0;
+	for (TaskId id = 1; id < timings.size(); ++id) {
+		if (timings[id].endMs > timings[last].endMs) {
+			last = id;
+		}
+	}
+	TaskId id = last;
+	for (;;) {
+		timings[id].critical = true;
+		if (!tasks[id].released) {
+			break;
+		}
+		id = tasks[id].releasedBy;
+	}
+}
+
+void TaskGraph::dumpTimings(std::ostream& out) const
+{
+	out << "Frame tasks, " << std::fixed << std::setprecision(3) << lastRunMs << " ms (* = critical path)\n";
+	for (const TaskTiming& t : timings) {
+		const std::string thread = (t.thread == 0) ? "main" : "worker " + std::to_string(t.thread);
+		out << (t.critical ? " * " : "   ") << std::left << std::setw(16) << t.name << std::setw(10) << thread << std::right
+			<< std::setw(9) << t.startMs << " - " << std::setw(9) << t.endMs << " ms  (" << std::setw(8) << t.endMs - t.startMs << " ms)\n";
+	}
+	out << std::defaultfloat << std::setprecision(6);
+}
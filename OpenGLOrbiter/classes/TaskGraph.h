@@ -0,0 +1,88 @@
+//Author: Bernhard Luedtke
+#ifndef TaskGraph_hpp
+#define TaskGraph_hpp
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <iostream>
+
+// Small scheduler for the tasks of one frame. Tasks and the dependencies between them are declared once,
+// run() then executes the whole graph (every frame): a task starts as soon as all tasks it depends on are done.
+// Main tasks run on the thread calling run() (the thread owning the GL context), Worker tasks on the graph's own threads.
+// Worker tasks may use a ThreadPool for data parallel loops.
+class TaskGraph {
+public:
+	enum class Affinity { Main, Worker };
+	typedef size_t TaskId;
+
+	// Duration of a task in the last run, in ms since run() was called
+	struct TaskTiming {
+		const char* name;
+		double startMs;
+		double endMs;
+		// 0 = main thread, k = worker thread k
+		unsigned int thread;
+		bool critical;
+	};
+
+	explicit TaskGraph(unsigned int workerThreads = 1);
+	~TaskGraph();
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	// name has to outlive the graph (string literal)
+	TaskId addTask(const char* name, Affinity affinity, std::function<void()> work);
+	// after starts only when before is done
+	void addDependency(TaskId before, TaskId after);
+
+	// Runs every task once and returns when all are done. Does nothing (and reports it) if the dependencies contain a cycle.
+	void run();
+
+	const std::vector<TaskTiming>& getTimings() const noexcept { return timings; }
+	double getLastRunMs() const noexcept { return lastRunMs; }
+	// Table of the last run; tasks on the critical path (the chain of dependencies that ended last) are marked with *
+	void dumpTimings(std::ostream& out) const;
+
+private:
+	struct Task {
+		const char* name;
+		Affinity affinity;
+		std::function<void()> work;
+		std::vector<TaskId> successors;
+		unsigned int dependencies = 0;
+		// Left to finish in the current run
+		unsigned int waitingFor = 0;
+		// The dependency that finished last and released this task, for the critical path
+		TaskId releasedBy = 0;
+		bool released = false;
+	};
+
+	bool hasCycle() const;
+	void workerLoop(unsigned int thread);
+	// Runs a task and releases its successors, lock is held on entry and exit but not while the task runs
+	void execute(TaskId id, unsigned int thread, std::unique_lock<std::mutex>& lock);
+	void markCriticalPath();
+
+	std::vector<Task> tasks;
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<TaskId> readyMain;
+	std::deque<TaskId> readyWorker;
+	size_t finished = 0;
+	bool running = false;
+	bool stopping = false;
+	bool validated = false;
+	bool cyclic = false;
+
+	std::chrono::steady_clock::time_point runStart;
+	std::vector<TaskTiming> timings;
+	double lastRunMs = 0.0;
+};
+
+#endif /* TaskGraph_hpp */
@@ -0,0 +1,167 @@
+//Author: Bernhard Luedtke
+
+#include "ThreadPool.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ThreadPool::ThreadPool(unsigned int workers, bool pinThreads) : pinned(pinThreads)
+{
+	if (workers == 0) {
+		const unsigned int hardware = std::thread::hardware_concurrency();
+		workers = (hardware > 1) ? hardware - 1 : 0;
+	}
+	for (unsigned int k = 0; k <= workers; ++k) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	threads.reserve(workers);
+	for (unsigned int k = 0; k < workers; ++k) {
+		threads.emplace_back(&ThreadPool::workerLoop, this, k + 1);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(jobLock);
+		stopping = true;
+	}
+	jobReady.notify_all();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+void ThreadPool::pinCurrentThread(unsigned int cpu)
+{
+#ifdef _WIN32
+	if (cpu < 64) {
+		SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+	}
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)cpu;
+#endif
+}
+
+void ThreadPool::workerLoop(unsigned int participant)
+{
+	if (pinned) {
+		pinCurrentThread(participant);
+	}
+	size_t seen = 0;
+	for (;;) {
+		Job current;
+		{
+			std::unique_lock<std::mutex> guard(jobLock);
+			jobReady.wait(guard, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+			// The caller clears the job once every chunk is done, a worker that wakes up that late has nothing to do
+			if (job.body == nullptr) {
+				continue;
+			}
+			current = job;
+			++busyWorkers;
+		}
+		while (runOneChunk(participant, current)) {
+			;
+		}
+		--busyWorkers;
+	}
+}
+
+bool ThreadPool::runOneChunk(unsigned int participant, const Job& current)
+{
+	size_t chunk = 0;
+	bool found = false;
+	{
+		WorkQueue& own = *queues[participant];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (own.head < own.tail) {
+			chunk = own.head++;
+			found = true;
+		}
+	}
+	// Steal from the back of the others, starting with the next participant so thieves spread out
+	const size_t participants = queues.size();
+	for (size_t k = 1; !found && k < participants; ++k) {
+		WorkQueue& victim = *queues[(participant + k) % participants];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (victim.head < victim.tail) {
+			chunk = --victim.tail;
+			found = true;
+			++steals;
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	const size_t begin = chunk * current.chunkSize;
+	const size_t end = (begin + current.chunkSize < current.n) ? begin + current.chunkSize : current.n;
+	(*current.body)(begin, end, chunk);
+	--chunksLeft;
+	return true;
+}
+
+void ThreadPool::parallelFor(size_t n, size_t chunkSize, const std::function<void(size_t, size_t, size_t)>& body)
+{
+	if (n == 0) {
+		return;
+	}
+	if (chunkSize == 0) {
+		chunkSize = n;
+	}
+	const size_t chunks = (n + chunkSize - 1) / chunkSize;
+	if (threads.empty() || chunks == 1) {
+		for (size_t c = 0; c < chunks; ++c) {
+			const size_t begin = c * chunkSize;
+			body(begin, (begin + chunkSize < n) ? begin + chunkSize : n, c);
+		}
+		return;
+	}
+	std::lock_guard<std::mutex> call(callLock);
+	{
+		std::lock_guard<std::mutex> guard(jobLock);
+		// Contiguous blocks per thread: neighbouring chunks (and their memory) stay on one thread unless they are stolen
+		const size_t participants = queues.size();
+		for (size_t p = 0; p < participants; ++p) {
+			WorkQueue& q = *queues[p];
+			std::lock_guard<std::mutex> queueGuard(q.lock);
+			q.head = chunks * p / participants;
+			q.tail = chunks * (p + 1) / participants;
+		}
+		chunksLeft = chunks;
+		job.body = &body;
+		job.n = n;
+		job.chunkSize = chunkSize;
+		++generation;
+	}
+	jobReady.notify_all();
+	const Job current = job;
+	while (runOneChunk(0, current)) {
+		;
+	}
+	// Chunks still running on workers
+	while (chunksLeft.load() != 0) {
+		std::this_thread::yield();
+	}
+	{
+		std::lock_guard<std::mutex> guard(jobLock);
+		job = Job();
+	}
+	// body goes out of scope after returning, no worker may still hold it
+	while (busyWorkers.load() != 0) {
+		std::this_thread::yield();
+	}
+}
@@ -0,0 +1,76 @@
+//Author: Bernhard Luedtke
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Work stealing pool for data parallel loops (propagation of satellite chunks).
+// parallelFor splits [0, n) into chunks of a fixed size. Every thread (the workers and the calling thread) starts with
+// a contiguous block of chunks and takes them from the front; a thread that runs out steals chunks from the back of another one.
+// Which thread runs a chunk is not deterministic, the chunks themselves are: they only depend on n and the chunk size.
+// Results that are written per chunk (or per index) are therefore the same for every number of threads.
+class ThreadPool {
+public:
+	// workers: threads besides the calling one, 0 = one less than std::thread::hardware_concurrency()
+	// pinThreads: worker k runs only on logical cpu k + 1 (the calling thread is not pinned)
+	explicit ThreadPool(unsigned int workers = 0, bool pinThreads = false);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int getWorkerCount() const noexcept { return static_cast<unsigned int>(threads.size()); }
+	// Workers plus the calling thread
+	unsigned int getThreadCount() const noexcept { return getWorkerCount() + 1; }
+	bool isPinned() const noexcept { return pinned; }
+	// Chunks taken from another thread's queue since the pool was created
+	size_t getSteals() const noexcept { return steals.load(); }
+
+	// Calls body(begin, end, chunk) for every chunk [chunk * chunkSize, min(n, (chunk + 1) * chunkSize)) and returns once all of them are done.
+	// Calls from several threads are run one after the other. Not reentrant: body must not call parallelFor of the same pool.
+	void parallelFor(size_t n, size_t chunkSize, const std::function<void(size_t, size_t, size_t)>& body);
+
+private:
+	// Chunk indices [head, tail) still to do. The owner takes head, thieves take tail - 1.
+	struct WorkQueue {
+		std::mutex lock;
+		size_t head = 0;
+		size_t tail = 0;
+		// Queues are allocated one by one, keep the next one off this cache line
+		char padding[64];
+	};
+	struct Job {
+		const std::function<void(size_t, size_t, size_t)>* body = nullptr;
+		size_t n = 0;
+		size_t chunkSize = 0;
+	};
+
+	void workerLoop(unsigned int participant);
+	// Runs one chunk of the own queue or a stolen one, false when there is nothing left anywhere
+	bool runOneChunk(unsigned int participant, const Job& job);
+	static void pinCurrentThread(unsigned int cpu);
+
+	std::vector<std::thread> threads;
+	// One per participant, index 0 is the thread calling parallelFor
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	bool pinned = false;
+
+	// Held by the thread in parallelFor, the pool runs one loop at a time
+	std::mutex callLock;
+	std::mutex jobLock;
+	std::condition_variable jobReady;
+	Job job;
+	size_t generation = 0;
+	bool stopping = false;
+	std::atomic<size_t> chunksLeft{ 0 };
+	// Workers that picked up the current job and may still touch it
+	std::atomic<unsigned int> busyWorkers{ 0 };
+	std::atomic<size_t> steals{ 0 };
+};
+
+#endif /* ThreadPool_hpp */
@@ -0,0 +1,116 @@
+//Author: Bernhard Luedtke
+
+#include "Timeline.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+Timeline::Timeline(TimelinePropagator& propagator, double checkpointInterval, size_t memoryBudgetBytes)
+	: propagator(propagator), interval(checkpointInterval > 0.0 ? checkpointInterval : 1.0), spacing(interval), budget(memoryBudgetBytes)
+{
+	scratch.resize(propagator.stateSize());
+	origin = propagator.saveState(scratch.data());
+	checkpoints[origin] = scratch;
+}
+
+size_t Timeline::checkpointBytes() const
+{
+	// State plus roughly what a map node costs
+	return propagator.stateSize() * sizeof(double) + 64;
+}
+
+void Timeline::advanceTo(double t)
+{
+	if (t < propagator.getTime()) {
+		seek(t);
+		return;
+	}
+	// Checkpoints on the grid origin + k * spacing, counted instead of summed so the times are the same on every pass
+	double k = std::floor((propagator.getTime() - origin) / spacing) + 1.0;
+	for (double next = origin + k * spacing; next <= t; next = origin + (++k) * spacing) {
+		propagator.advanceTo(next);
+		record();
+	}
+	propagator.advanceTo(t);
+}
+
+void Timeline::seek(double t)
+{
+	const auto start = std::chrono::steady_clock::now();
+	lastSeek.target = t;
+	lastSeek.restored = false;
+	lastSeek.from = propagator.getTime();
+	// Last checkpoint at or before t
+	auto it = checkpoints.upper_bound(t);
+	if (it != checkpoints.begin()) {
+		--it;
+		// Going on from the current state is cheaper if it lies between the checkpoint and t
+		if (t < propagator.getTime() || it->first > propagator.getTime()) {
+			propagator.restoreState(it->second.data(), it->first);
+			lastSeek.from = it->first;
+			lastSeek.restored = true;
+		}
+	}
+	else {
+		propagator.restoreState(checkpoints.begin()->second.data(), checkpoints.begin()->first);
+		lastSeek.from = checkpoints.begin()->first;
+		lastSeek.restored = true;
+	}
+	// Before the first checkpoint the propagator can not go, it stays there
+	if (t > propagator.getTime()) {
+		advanceTo(t);
+	}
+	lastSeek.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Timeline::setMemoryBudget(size_t bytes)
+{
+	budget = bytes;
+	evict();
+}
+
+double Timeline::getLargestGap() const
+{
+	double gap = 0.0;
+	auto previous = checkpoints.begin();
+	for (auto it = std::next(previous); it != checkpoints.end(); previous = it++) {
+		gap = std::max(gap, it->first - previous->first);
+	}
+	return gap;
+}
+
+void Timeline::record()
+{
+	const double t = propagator.saveState(scratch.data());
+	if (checkpoints.find(t) != checkpoints.end()) {
+		return;
+	}
+	checkpoints[t] = scratch;
+	evict();
+}
+
+// The checkpoint written for origin + k * interval lies at or a little before that time (on the propagator's last anchor).
+// It stays on the grid while k is a multiple of spacing / interval (a power of two, exact like k).
+bool Timeline::onGrid(double t) const
+{
+	const double k = std::ceil((t - origin) / interval - 1e-6);
+	return std::fmod(k, spacing / interval) == 0.0;
+}
+
+void Timeline::evict()
+{
+	// Each round doubles the spacing and drops the checkpoints between the new grid points, about every other one.
+	// A checkpoint at origin + k * interval is off the grid once 2^rounds does not divide k, so this ends with the origin at the latest.
+	while (checkpoints.size() > 1 && getMemoryUsage() > budget) {
+		spacing *= 2.0;
+		for (auto it = std::next(checkpoints.begin()); it != checkpoints.end();) {
+			if (onGrid(it->first)) {
+				++it;
+				continue;
+			}
+			it = checkpoints.erase(it);
+			++evictions;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+//Author: Bernhard Luedtke
+#ifndef Timeline_hpp
+#define Timeline_hpp
+
+#include <map>
+#include <vector>
+#include <stddef.h>
+
+// A propagator that can only integrate forwards from a state (anything beyond the two body solution from the epoch).
+// It advances in steps from an anchor state; positions between two steps are evaluated from the last anchor without moving it,
+// so the trajectory does not depend on the times it was asked for, only on where it was restarted.
+class TimelinePropagator {
+public:
+	virtual ~TimelinePropagator() {}
+	// Number of doubles in a saved state
+	virtual size_t stateSize() const = 0;
+	// Writes the anchor state (the one the next step starts from) and returns its time, which may lie before getTime()
+	virtual double saveState(double* state) const = 0;
+	// Continues from a state written by saveState at time t
+	virtual void restoreState(const double* state, double t) = 0;
+	virtual double getTime() const = 0;
+	// Integrates forwards to t >= getTime()
+	virtual void advanceTo(double t) = 0;
+};
+
+// Lets the time line be scrubbed although the propagator can only go forwards: the state is stored every checkpointInterval seconds
+// of simulated time, a seek restores the last checkpoint before the target and integrates only from there.
+// Checkpoints are kept within a memory budget; when it is exceeded every other one is dropped and the spacing doubles (the first one,
+// the initial state, is never dropped). The checkpoints stay on a uniform grid, so the largest gap a seek has to integrate is the
+// spacing: at most twice the visited time divided by the number of checkpoints that fit, however long the time line gets.
+class Timeline {
+public:
+	struct SeekInfo {
+		double latencyMs = 0.0;
+		double target = 0.0;
+		// Time the propagator continued from: a checkpoint, or where it already was
+		double from = 0.0;
+		bool restored = false;
+	};
+
+	// checkpointInterval should be a multiple of the propagator's step, so checkpoints fall on its anchors
+	Timeline(TimelinePropagator& propagator, double checkpointInterval, size_t memoryBudgetBytes);
+
+	// Forwards from the current time, writing the checkpoints on the way; t before the current time is a seek
+	void advanceTo(double t);
+	// Puts the propagator at t from the closest state before t, either a checkpoint or the current one
+	void seek(double t);
+	double getTime() const { return propagator.getTime(); }
+
+	// Drops checkpoints until the budget is met
+	void setMemoryBudget(size_t bytes);
+	const SeekInfo& getLastSeek() const noexcept { return lastSeek; }
+	size_t getCheckpointCount() const noexcept { return checkpoints.size(); }
+	size_t getMemoryUsage() const noexcept { return checkpoints.size() * checkpointBytes(); }
+	size_t getEvictions() const noexcept { return evictions; }
+	// Largest span of simulated time a seek may have to integrate
+	double getLargestGap() const;
+	// Current distance of the checkpoints: checkpointInterval times a power of two
+	double getSpacing() const noexcept { return spacing; }
+
+private:
+	size_t checkpointBytes() const;
+	void record();
+	void evict();
+	bool onGrid(double t) const;
+
+	TimelinePropagator& propagator;
+	double interval;
+	double spacing;
+	size_t budget;
+	double origin;
+	std::map<double, std::vector<double>> checkpoints;
+	std::vector<double> scratch;
+	size_t evictions = 0;
+	SeekInfo lastSeek;
+};
+
+#endif /* Timeline_hpp */
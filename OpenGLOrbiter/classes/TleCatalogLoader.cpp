@@ -0,0 +1,219 @@
+//Author: Bernhard Luedtke
+
+#include "TleCatalogLoader.h"
+#include "TwoLineElements.h"
+#include "Sgp4Constellation.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+// Start of the line after the one at pos (size at the end)
+static inline size_t nextLine(const char* data, size_t size, size_t pos)
+{
+	const void* newline = std::memchr(data + pos, '\n', size - pos);
+	return (newline != nullptr) ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+}
+
+// Length of the line starting at pos, without the line end ("\n" or "\r\n")
+static inline size_t lineLength(const char* data, size_t pos, size_t next)
+{
+	size_t end = next;
+	while (end > pos && (data[end - 1] == '\n' || data[end - 1] == '\r')) {
+		--end;
+	}
+	return end - pos;
+}
+
+static inline bool isElementLine(const char* data, size_t pos, size_t length, char number)
+{
+	return length >= 2 && data[pos] == number && data[pos + 1] == ' ';
+}
+
+TleCatalogLoader::TleCatalogLoader(ThreadPool* pool) : threadPool(pool)
+{
+	;
+}
+
+TleCatalogLoader::~TleCatalogLoader()
+{
+	;
+}
+
+size_t TleCatalogLoader::findSetStart(const char* data, size_t size, size_t offset)
+{
+	// Begin at a line start
+	size_t pos = (offset == 0) ? 0 : nextLine(data, size, offset - 1);
+	while (pos < size) {
+		const size_t next = nextLine(data, size, pos);
+		if (isElementLine(data, pos, lineLength(data, pos, next), '1') && next < size
+			&& isElementLine(data, next, lineLength(data, next, nextLine(data, size, next)), '2')) {
+			return pos;
+		}
+		pos = next;
+	}
+	return size;
+}
+
+void TleCatalogLoader::parseChunk(const char* data, size_t size, Chunk& chunk)
+{
+	chunk.records.clear();
+	chunk.names.clear();
+	chunk.nameEnds.clear();
+	chunk.checksumErrors = 0;
+	chunk.malformed = 0;
+	chunk.rejected = 0;
+	chunk.newestEpochJd = 0.0;
+	// A 3LE set takes about 165 bytes, a TLE one 140
+	chunk.records.reserve((chunk.end - chunk.begin) / 140 + 1);
+	chunk.nameEnds.reserve((chunk.end - chunk.begin) / 140 + 1);
+	// The line before the current one (the title of a 3LE set), the block start is a line start
+	size_t previous = chunk.begin;
+	size_t previousLength = 0;
+	if (chunk.begin > 0) {
+		previous = chunk.begin - 1;
+		while (previous > 0 && data[previous - 1] != '\n') {
+			--previous;
+		}
+		previousLength = lineLength(data, previous, chunk.begin);
+	}
+	TwoLineElements tle;
+	Sgp4Record rec;
+	size_t pos = chunk.begin;
+	while (pos < chunk.end) {
+		const size_t next = nextLine(data, size, pos);
+		const size_t length = lineLength(data, pos, next);
+		if (!isElementLine(data, pos, length, '1')) {
+			// Titles, blank lines; a line 2 here has no line 1
+			if (isElementLine(data, pos, length, '2')) {
+				++chunk.malformed;
+			}
+			previous = pos;
+			previousLength = length;
+			pos = next;
+			continue;
+		}
+		const size_t next2 = nextLine(data, size, next);
+		const size_t length2 = (next < size) ? lineLength(data, next, next2) : 0;
+		if (!isElementLine(data, next, length2, '2')) {
+			++chunk.malformed;
+			previous = pos;
+			previousLength = length;
+			pos = next;
+			continue;
+		}
+		const TleStatus status = TwoLineElements::parse(data + pos, length, data + next, length2, tle);
+		if (status == TleStatus::Checksum) {
+			++chunk.checksumErrors;
+		}
+		else if (status != TleStatus::Ok) {
+			++chunk.malformed;
+		}
+		else if (!sgp4Init(tle, rec)) {
+			++chunk.rejected;
+		}
+		else {
+			chunk.records.push_back(rec);
+			chunk.newestEpochJd = (rec.epochJd > chunk.newestEpochJd) ? rec.epochJd : chunk.newestEpochJd;
+			// Title: the line before, unless that is the line 2 of the set before (plain TLE)
+			if (previousLength > 0 && !isElementLine(data, previous, previousLength, '2') && !isElementLine(data, previous, previousLength, '1')) {
+				size_t first = previous;
+				size_t last = previous + previousLength;
+				// "0 " marks the title line in the Space-Track 3LE format
+				if (previousLength >= 2 && data[first] == '0' && data[first + 1] == ' ') {
+					first += 2;
+				}
+				while (last > first && data[last - 1] == ' ') {
+					--last;
+				}
+				chunk.names.insert(chunk.names.end(), data + first, data + last);
+			}
+			chunk.nameEnds.push_back(chunk.names.size());
+		}
+		previous = next;
+		previousLength = length2;
+		pos = next2;
+	}
+}
+
+size_t TleCatalogLoader::parse(const char* data, size_t size, Sgp4Constellation& store)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	stats = TleLoadStats();
+	stats.bytes = size;
+	stats.firstIndex = store.size();
+	names.clear();
+	nameEnds.clear();
+	// Block boundaries: only a few lines are looked at for each
+	const size_t chunkCount = (size + chunkBytes - 1) / chunkBytes;
+	if (chunks.size() < chunkCount) {
+		chunks.resize(chunkCount);
+	}
+	size_t begin = (chunkCount > 0) ? findSetStart(data, size, 0) : size;
+	for (size_t c = 0; c < chunkCount; ++c) {
+		const size_t end = (c + 1 < chunkCount) ? findSetStart(data, size, (c + 1) * chunkBytes) : size;
+		chunks[c].begin = begin;
+		chunks[c].end = (end > begin) ? end : begin;
+		begin = chunks[c].end;
+	}
+	// Sets before the first line 1 (a line 2 without one) are not parsed, they can only be malformed
+	const std::function<void(size_t, size_t, size_t)> body = [this, data, size](size_t first, size_t last, size_t) {
+		for (size_t c = first; c < last; ++c) {
+			parseChunk(data, size, chunks[c]);
+		}
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(chunkCount, 1, body);
+	}
+	else {
+		body(0, chunkCount, 0);
+	}
+	// In file order, so the store does not depend on the number of threads
+	size_t added = 0;
+	for (size_t c = 0; c < chunkCount; ++c) {
+		added += chunks[c].records.size();
+	}
+	store.reserve(store.size() + added);
+	nameEnds.reserve(added);
+	for (size_t c = 0; c < chunkCount; ++c) {
+		const Chunk& chunk = chunks[c];
+		const size_t nameBase = names.size();
+		for (size_t k = 0; k < chunk.records.size(); ++k) {
+			store.addRecord(chunk.records[k]);
+			nameEnds.push_back(nameBase + chunk.nameEnds[k]);
+		}
+		names.insert(names.end(), chunk.names.begin(), chunk.names.end());
+		stats.checksumErrors += chunk.checksumErrors;
+		stats.malformed += chunk.malformed;
+		stats.rejected += chunk.rejected;
+		stats.newestEpochJd = (chunk.newestEpochJd > stats.newestEpochJd) ? chunk.newestEpochJd : stats.newestEpochJd;
+	}
+	stats.records = added;
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return added;
+}
+
+bool TleCatalogLoader::load(const char* path, Sgp4Constellation& store)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.open(path)) {
+		stats = TleLoadStats();
+		return false;
+	}
+	parse(file.data(), file.size(), store);
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (stats.checksumErrors + stats.malformed + stats.rejected > 0) {
+		std::cerr << path << ": skipped " << stats.checksumErrors << " element sets with checksum errors, " << stats.malformed
+			<< " malformed, " << stats.rejected << " SGP4 can not propagate" << std::endl;
+	}
+	return true;
+}
+
+std::string TleCatalogLoader::getName(size_t i) const
+{
+	const size_t first = (i > 0) ? nameEnds[i - 1] : 0;
+	return std::string(names.data() + first, nameEnds[i] - first);
+}
@@ -0,0 +1,77 @@
+//Author: Bernhard Luedtke
+#ifndef TleCatalogLoader_hpp
+#define TleCatalogLoader_hpp
+
+#include <vector>
+#include <string>
+#include <stddef.h>
+#include "Sgp4.h"
+
+class ThreadPool;
+class Sgp4Constellation;
+
+// Outcome of the last load
+struct TleLoadStats {
+	// Element sets added to the store
+	size_t records = 0;
+	// Skipped element sets: checksum mismatch, unreadable fields (or line 1 without line 2), sgp4Init() failed
+	size_t checksumErrors = 0;
+	size_t malformed = 0;
+	size_t rejected = 0;
+	// Index of the first added satellite in the store
+	size_t firstIndex = 0;
+	size_t bytes = 0;
+	double milliseconds = 0.0;
+	// Latest epoch of the added element sets (Julian date), 0 if there are none
+	double newestEpochJd = 0.0;
+};
+
+// Reads catalogs of two line element sets (plain TLE or 3LE with a title line before each set, as served by CelesTrak or
+// Space-Track) into an Sgp4Constellation. The file is memory mapped and cut into blocks of about setChunkBytes(); each block
+// starts at a line 1 that is followed by a line 2, so no element set is split. The blocks are parsed and initialized
+// (sgp4Init) in parallel on the thread pool, without streams and without allocations per line, and added to the store in file order.
+class TleCatalogLoader {
+public:
+	// pool may be nullptr (the blocks are parsed one after the other)
+	explicit TleCatalogLoader(ThreadPool* pool = nullptr);
+	~TleCatalogLoader();
+
+	// Appends the element sets of the file to store. Returns false if the file can not be read, bad element sets are only counted.
+	bool load(const char* path, Sgp4Constellation& store);
+	// Same for a catalog already in memory (size bytes, need not be terminated); returns the number of added satellites
+	size_t parse(const char* data, size_t size, Sgp4Constellation& store);
+	const TleLoadStats& getStats() const noexcept { return stats; }
+	// Title of the i-th satellite added by the last load (store index getStats().firstIndex + i), empty for plain TLE
+	std::string getName(size_t i) const;
+
+	void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+	void setChunkBytes(size_t bytes) { chunkBytes = (bytes > 256) ? bytes : 256; }
+
+private:
+	// Results of one block, kept between loads so their memory is reused
+	struct Chunk {
+		size_t begin = 0;
+		size_t end = 0;
+		std::vector<Sgp4Record> records;
+		// Titles, one after the other, nameEnds[k] is where the one of records[k] ends
+		std::vector<char> names;
+		std::vector<size_t> nameEnds;
+		size_t checksumErrors = 0;
+		size_t malformed = 0;
+		size_t rejected = 0;
+		double newestEpochJd = 0.0;
+	};
+
+	// First line at or after offset that is a line 1 followed by a line 2 (size if there is none)
+	static size_t findSetStart(const char* data, size_t size, size_t offset);
+	static void parseChunk(const char* data, size_t size, Chunk& chunk);
+
+	ThreadPool* threadPool;
+	size_t chunkBytes = 256 * 1024;
+	std::vector<Chunk> chunks;
+	TleLoadStats stats;
+	std::vector<char> names;
+	std::vector<size_t> nameEnds;
+};
+
+#endif /* TleCatalogLoader_hpp */
@@ -7,6 +7,11 @@
 #include <math.h>
 
 TriangleSphereModel::TriangleSphereModel( float Radius, int Stacks, int Slices )
+{
+    build(Radius, Stacks, Slices);
+}
+
+void TriangleSphereModel::build( float Radius, int Stacks, int Slices )
 {
     VB.begin();
     for( int i=0; i<Stacks; ++i)
@@ -51,20 +56,7 @@ void TriangleSphereModel::draw(const BaseCamera& Cam)
     
     VB.activate();
     IB.activate();
-    if (instanced) {
-      //glVertexAttribPointer()
-      //glDrawArraysInstanced(GL_TRIANGLES, )
-      //GLint instAttrib = glGetAttribLocation(uShader->ShaderProgram, "VOffsets[]");
-      //std::cout << "Instattrib: " << instAttrib << "\n";
-      //glEnableVertexAttribArray(instAttrib);
-      //glVertexAttribPointer(instAttrib, 1000, , GL_FALSE, sizeof(float), 0);
-      //glVertexAttribDivisor(instAttrib, 1);
-      glDrawElementsInstanced(GL_TRIANGLES, IB.indexCount(), IB.indexFormat(), (void*)0, 50);
-      //glDrawArraysInstanced(GL_TRIANGLES, IB.indexCount(), IB.indexFormat(), 1000);
-    }
-    else {
-      glDrawElements(GL_TRIANGLES, IB.indexCount(), IB.indexFormat(), 0);
-    }
+    glDrawElements(GL_TRIANGLES, IB.indexCount(), IB.indexFormat(), 0);
     IB.deactivate();
     VB.deactivate();
 }
@@ -18,8 +18,10 @@ public:
 	  void recalcBuffers(float radius);
     virtual ~TriangleSphereModel() {}
     virtual void draw(const BaseCamera& Cam);
-    bool instanced;
 protected:
+    // No buffers yet, build() fills them
+    TriangleSphereModel() {}
+    void build( float Radius, int Stacks, int Slices );
     VertexBuffer VB;
     IndexBuffer IB;
 };
@@ -0,0 +1,167 @@
+//Author: Bernhard Luedtke
+
+#include "TwoLineElements.h"
+#include <iostream>
+#include <cstring>
+#include <string>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+int TwoLineElements::checksum(const char* line)
+{
+	int sum = 0;
+	for (int k = 0; k < 68; ++k) {
+		if (line[k] >= '0' && line[k] <= '9') {
+			sum += line[k] - '0';
+		}
+		else if (line[k] == '-') {
+			sum += 1;
+		}
+	}
+	return sum % 10;
+}
+
+static const double powersOfTen[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Columns first..last (1 based, inclusive) as a number. implied: the field has an implied leading decimal point,
+// exponent: the last two characters are a signed power of ten (" 12345-4" = 0.12345e-4). Blanks around the number are allowed.
+static bool readField(const char* line, int first, int last, bool implied, bool exponent, double& value)
+{
+	int k = first - 1;
+	const int mantissaEnd = exponent ? last - 2 : last;
+	while (k < mantissaEnd && line[k] == ' ') {
+		++k;
+	}
+	bool negative = false;
+	if (k < mantissaEnd && (line[k] == '-' || line[k] == '+')) {
+		negative = line[k] == '-';
+		++k;
+	}
+	long long mantissa = 0;
+	int digits = 0;
+	int fractionDigits = 0;
+	bool fraction = implied;
+	for (; k < mantissaEnd && line[k] != ' '; ++k) {
+		if (line[k] == '.' && !fraction) {
+			fraction = true;
+		}
+		else if (line[k] >= '0' && line[k] <= '9') {
+			mantissa = mantissa * 10 + (line[k] - '0');
+			++digits;
+			fractionDigits += fraction ? 1 : 0;
+		}
+		else {
+			return false;
+		}
+	}
+	for (; k < mantissaEnd; ++k) {
+		if (line[k] != ' ') {
+			return false;
+		}
+	}
+	if (digits == 0 || digits > 15) {
+		return false;
+	}
+	int power = -fractionDigits;
+	if (exponent) {
+		const char sign = line[last - 2];
+		const char digit = line[last - 1];
+		if ((sign != '-' && sign != '+' && sign != ' ') || digit < '0' || digit > '9') {
+			return false;
+		}
+		power += (sign == '-') ? -(digit - '0') : (digit - '0');
+	}
+	// Both operands are exact, so the one rounding of the division/multiplication is the only one
+	const double m = static_cast<double>(mantissa);
+	value = (power < 0) ? m / powersOfTen[-power] : m * powersOfTen[power];
+	if (negative) {
+		value = -value;
+	}
+	return true;
+}
+
+// Columns 3-7, five digits or Alpha-5 (a letter for the two leading digits 10-33, I and O are skipped)
+static bool readCatalogNumber(const char* line, unsigned int& number)
+{
+	char lead = line[2];
+	unsigned int value = 0;
+	if (lead >= 'A' && lead <= 'Z' && lead != 'I' && lead != 'O') {
+		value = 10 + (lead - 'A') - ((lead > 'I') ? 1 : 0) - ((lead > 'O') ? 1 : 0);
+	}
+	else if (lead >= '0' && lead <= '9') {
+		value = lead - '0';
+	}
+	else if (lead != ' ') {
+		return false;
+	}
+	for (int k = 3; k < 7; ++k) {
+		if (line[k] < '0' || line[k] > '9') {
+			return false;
+		}
+		value = value * 10 + (line[k] - '0');
+	}
+	number = value;
+	return true;
+}
+
+TleStatus TwoLineElements::parse(const char* line1, size_t length1, const char* line2, size_t length2, TwoLineElements& out)
+{
+	if (length1 < 69 || length2 < 69) {
+		return TleStatus::TooShort;
+	}
+	if (line1[0] != '1' || line2[0] != '2') {
+		return TleStatus::Malformed;
+	}
+	if (checksum(line1) != line1[68] - '0' || checksum(line2) != line2[68] - '0') {
+		return TleStatus::Checksum;
+	}
+	unsigned int number, number2;
+	double year, day, ndot, nddot, bstar, incl, node, ecc, argp, mean, motion;
+	const bool ok = readCatalogNumber(line1, number) && readCatalogNumber(line2, number2) && number == number2
+		&& readField(line1, 19, 20, false, false, year)
+		&& readField(line1, 21, 32, false, false, day) && readField(line1, 34, 43, false, false, ndot)
+		&& readField(line1, 45, 52, true, true, nddot) && readField(line1, 54, 61, true, true, bstar)
+		&& readField(line2, 9, 16, false, false, incl) && readField(line2, 18, 25, false, false, node)
+		&& readField(line2, 27, 33, true, false, ecc) && readField(line2, 35, 42, false, false, argp)
+		&& readField(line2, 44, 51, false, false, mean) && readField(line2, 53, 63, false, false, motion);
+	if (!ok) {
+		return TleStatus::Malformed;
+	}
+	const double degToRad = M_PI / 180.0;
+	// rev/day per rad/min
+	const double xpdotp = 1440.0 / (2.0 * M_PI);
+	out.catalogNumber = number;
+	// Two digit years: 57-99 are 1957-1999
+	const int fullYear = (year < 57.0) ? 2000 + static_cast<int>(year) : 1900 + static_cast<int>(year);
+	// Julian date of January 0 of that year (the day of year counts from 1)
+	const double jan1 = 367.0 * fullYear - std::floor(7.0 * fullYear * 0.25) + 31.0 + 1721013.5;
+	out.epochJd = jan1 - 1.0 + day;
+	out.ndot = ndot / (xpdotp * 1440.0);
+	out.nddot = nddot / (xpdotp * 1440.0 * 1440.0);
+	out.bstar = bstar;
+	out.inclination = incl * degToRad;
+	out.rightAscension = node * degToRad;
+	out.eccentricity = ecc;
+	out.argPerigee = argp * degToRad;
+	out.meanAnomaly = mean * degToRad;
+	out.meanMotion = motion / xpdotp;
+	return TleStatus::Ok;
+}
+
+bool TwoLineElements::parse(const char* line1, const char* line2, TwoLineElements& out)
+{
+	switch (parse(line1, std::strlen(line1), line2, std::strlen(line2), out)) {
+	case TleStatus::Ok:
+		return true;
+	case TleStatus::TooShort:
+		std::cerr << "TLE: lines too short" << std::endl;
+		return false;
+	case TleStatus::Checksum:
+		std::cerr << "TLE: checksum mismatch for " << std::string(line1 + 2, 5) << std::endl;
+		return false;
+	default:
+		std::cerr << "TLE: malformed field in " << std::string(line1 + 2, 5) << std::endl;
+		return false;
+	}
+}
@@ -0,0 +1,41 @@
+//Author: Bernhard Luedtke
+#ifndef TwoLineElements_hpp
+#define TwoLineElements_hpp
+
+#include <stddef.h>
+
+// Result of parsing one element set
+enum class TleStatus { Ok, TooShort, Checksum, Malformed };
+
+// Mean elements of one two line element set (TLE), converted to the units SGP4 works in.
+// Format: https://celestrak.org/columns/v04n03/ (fixed columns, implied decimal points, checksum in column 69).
+struct TwoLineElements {
+	// Alpha-5 numbers (A0000 = 100000, letters without I and O) are converted as well
+	unsigned int catalogNumber = 0;
+	// Julian date of the epoch (UTC)
+	double epochJd = 0.0;
+	// First and second derivative of the mean motion (rad/min^2, rad/min^3) and the drag term B* (1/earth radii)
+	double ndot = 0.0;
+	double nddot = 0.0;
+	double bstar = 0.0;
+	// Angles in rad
+	double inclination = 0.0;
+	double rightAscension = 0.0;
+	double eccentricity = 0.0;
+	double argPerigee = 0.0;
+	double meanAnomaly = 0.0;
+	// Kozai mean motion in rad/min
+	double meanMotion = 0.0;
+
+	// Parses the two element lines (the title line of the three line format not included).
+	// Lines may be longer than 69 characters (line ends are ignored). Returns false, and reports why, if a line is too short,
+	// a field is not a number or a checksum does not match.
+	static bool parse(const char* line1, const char* line2, TwoLineElements& out);
+	// Same for lines that are not terminated (e.g. in a mapped file), silent. Allocates nothing, fields are read as integers
+	// and scaled by one exact power of ten, which gives the same (correctly rounded) doubles as strtod.
+	static TleStatus parse(const char* line1, size_t length1, const char* line2, size_t length2, TwoLineElements& out);
+	// Modulo 10 sum of the digits in columns 1 to 68, '-' counts as 1
+	static int checksum(const char* line);
+};
+
+#endif /* TwoLineElements_hpp */